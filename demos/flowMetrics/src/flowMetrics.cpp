@@ -0,0 +1,94 @@
+/**
+ * \file flowMetrics.cpp
+ * \brief Prints the metrics page published by a flow filter process.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <exception>
+
+#include <flowfilter/metrics.h>
+
+using namespace std;
+using namespace flowfilter;
+
+
+void printMetrics(const metrics_t& metrics) {
+
+    cout << fixed << setprecision(3);
+    cout << "publish count: " << metrics.publishCount << endl;
+    cout << "timestamp (ns): " << metrics.timestamp << endl;
+    cout << "frames: " << metrics.frameCount << endl;
+    cout << "frame rate (Hz): " << metrics.frameRate << endl;
+
+    cout << endl << setw(24) << left << "stage" << setw(6) << "level"
+        << setw(9) << "samples" << setw(10) << "mean" << setw(10) << "p50"
+        << setw(10) << "p90" << setw(10) << "p99" << "max (ms)" << endl;
+
+    for(unsigned int s = 0; s < metrics.stageCount; s ++) {
+        const stageMetrics_t& stage = metrics.stages[s];
+        cout << setw(24) << left << stage.name << setw(6) << stage.level
+            << setw(9) << stage.samples << setw(10) << stage.mean
+            << setw(10) << stage.p50 << setw(10) << stage.p90
+            << setw(10) << stage.p99 << stage.max << endl;
+    }
+
+    if(metrics.queueCount > 0) {
+        cout << endl << setw(24) << left << "queue" << setw(8) << "depth"
+            << setw(10) << "capacity" << "drops" << endl;
+
+        for(unsigned int q = 0; q < metrics.queueCount; q ++) {
+            const queueMetrics_t& queue = metrics.queues[q];
+            cout << setw(24) << left << queue.name << setw(8) << queue.depth
+                << setw(10) << queue.capacity << queue.drops << endl;
+        }
+    }
+
+    cout << endl << "flow mean (px): [" << metrics.flow.meanX << ", " << metrics.flow.meanY << "]" << endl;
+    cout << "flow magnitude mean/max (px): " << metrics.flow.meanMagnitude
+        << " / " << metrics.flow.maxMagnitude << endl;
+}
+
+
+/**
+ * MODE OF USE
+ * ./flowMetrics [name] [interval]
+ *
+ * where [name] is the shared memory name of the metrics page,
+ * defaults to /flowfilter_metrics, and [interval] is the refresh
+ * interval in seconds. If interval is zero or not given, the
+ * page is printed once.
+ */
+int main(int argc, char** argv) {
+
+    string name = argc > 1? argv[1] : "/flowfilter_metrics";
+    float interval = argc > 2? atof(argv[2]) : 0.0f;
+
+    try {
+        MetricsReader reader(name);
+        metrics_t metrics;
+
+        do {
+            if(reader.read(metrics)) {
+                printMetrics(metrics);
+            } else {
+                cerr << "WARNING: could not read a consistent snapshot" << endl;
+            }
+
+            if(interval > 0.0f) {
+                cout << endl;
+                this_thread::sleep_for(chrono::duration<float>(interval));
+            }
+        } while(interval > 0.0f);
+
+    } catch(exception& e) {
+        cerr << "ERROR: " << e.what() << endl;
+        return -1;
+    }
+
+    return 0;
+}
@@ -6,12 +6,19 @@
  */
 
 #include <iostream>
+#include <iomanip>
+#include <fstream>
 #include <vector>
 
 #include <opencv2/opencv.hpp>
 
 #include <flowfilter/gpu/flowfilter.h>
 #include <flowfilter/gpu/display.h>
+#include <flowfilter/gpu/util.h>
+#include <flowfilter/gpu/footprint.h>
+#include <flowfilter/metrics.h>
+#include <flowfilter/synthetic.h>
+#include <flowfilter/evaluation.h>
 
 using namespace std;
 using namespace cv;
@@ -40,7 +47,7 @@ void wrapCVMat(Mat& cvMat, image_t& img) {
 int main(int argc, char** argv) {
 
     if(argc < 6) {
-        cerr << "ERROR: expecting 4 arguments: height, width, pyrLevels, maxFlow, iterations" << endl;
+        cerr << "ERROR: expecting 5 arguments: height, width, pyrLevels, maxFlow, iterations [, metricsRate [, outputLevel]]" << endl;
         return -1;
     }
     
@@ -50,11 +57,14 @@ int main(int argc, char** argv) {
     int pyrLevels = atoi(argv[3]);
     int maxFlow_i = atoi(argv[4]);
     int N = atoi(argv[5]);
+    float publishRate = argc > 6? atof(argv[6]) : 0.0f;
+    int outputLevel = argc > 7? atoi(argv[7]) : 0;
     
 
     cout << "image shape: [" << height << ", " << width << "]" << endl;
     cout << "pyramid levels: " << pyrLevels << endl;
     cout << "max flow (pixels): " << maxFlow_i << endl;
+    cout << "output level: " << outputLevel << endl;
 
     
 
@@ -79,24 +89,108 @@ int main(int argc, char** argv) {
     filter.setMaxFlow(maxflow);
     filter.setGamma(gamma);
     filter.setSmoothIterations(smoothIterations);
+    filter.setOutputLevel(outputLevel);
+
+    // with an output level, a full pyramid filter runs on the
+    // same frames to compare accuracy and runtime
+    PyramidalFlowFilter reference;
+    if(outputLevel > 0) {
+        reference = PyramidalFlowFilter(height, width, pyrLevels);
+        reference.setMaxFlow(maxflow);
+        reference.setGamma(gamma);
+        reference.setSmoothIterations(smoothIterations);
+    }
+
+    //#################################
+    // Memory footprint
+    //#################################
+    vector<bufferInfo_t> footprint = getMemoryFootprint(filter);
+    cout << "device memory (MB): " << footprintBytes(footprint) / 1e6 << endl;
+
+    ofstream("footprint.json") << footprintToJSON(footprint);
+    ofstream("footprint.dot") << footprintToGraphviz(footprint);
 
-    
     // host image
     Mat hostImage(height, width, CV_8UC1);
     image_t hostImageWrapped;
     wrapCVMat(hostImage, hostImageWrapped);
+
+    // synthetic noise plane seen by a slowly translating and
+    // rotating camera, so that the filter sees textured input
+    perspectiveCamera cam = createPerspectiveCamera(width, height, width, height, width);
+    SyntheticSequence sequence(height, width, cam);
+    cameraMotion_t motion = {{0.05f, 0.02f, 0.0f}, {0.0f, 0.0f, 0.002f}};
+    sequence.setMotion(motion);
     
+    // metrics page, see demos/flowMetrics for the reader
+    MetricsPublisher metrics("/flowfilter_metrics", publishRate);
+
+    Mat hostFlow(height, width, CV_32FC2);
+    image_t hostFlowWrapped;
+    wrapCVMat(hostFlow, hostFlowWrapped);
+
+    Mat groundTruth(height, width, CV_32FC2);
+    image_t groundTruthWrapped;
+    wrapCVMat(groundTruth, groundTruthWrapped);
+
+    FlowEvaluator evaluator;
+    FlowEvaluator referenceEvaluator;
+    float totalTime = 0.0f;
+    float referenceTime = 0.0f;
+
+    // accumulated per-stage runtime, in the order reported by getProfile()
+    vector<stageProfile_t> profile;
+    vector<float> accumTime;
+
     // Capture loop
     for(int i = 0; i < N; i ++) {
 
         
+        if(outputLevel > 0) {
+            sequence.nextFrame(hostImageWrapped, groundTruthWrapped);
+        } else {
+            sequence.nextFrame(hostImageWrapped);
+        }
+
         // transfer image to flow filter and compute
         filter.loadImage(hostImageWrapped);
         filter.compute();
+        totalTime += filter.elapsedTime();
+
+        if(outputLevel > 0) {
+            reference.loadImage(hostImageWrapped);
+            reference.compute();
+            referenceTime += reference.elapsedTime();
+
+            // the first frame has no flow to compare
+            if(i > 0) {
+                filter.downloadFlow(hostFlowWrapped);
+                evaluator.evaluate(hostFlowWrapped, groundTruthWrapped);
+
+                reference.downloadFlow(hostFlowWrapped);
+                referenceEvaluator.evaluate(hostFlowWrapped, groundTruthWrapped);
+            }
+        }
 
         // cout << "elapsed time: " << filter.elapsedTime() << " ms" << endl;
         cout << filter.elapsedTime() << endl;
 
+        profile = filter.getProfile();
+        accumTime.resize(profile.size(), 0.0f);
+        for(size_t s = 0; s < profile.size(); s ++) {
+            accumTime[s] += profile[s].elapsedTime;
+            metrics.recordStageLatency(profile[s].name, profile[s].level, profile[s].elapsedTime);
+        }
+
+        metrics.recordStageLatency("PyramidalFlowFilter", 0, filter.elapsedTime());
+        metrics.recordFrame();
+
+        if(metrics.publishDue()) {
+            filter.downloadFlow(hostFlowWrapped);
+            metrics.setFlowStatistics(computeFlowStatistics(hostFlowWrapped));
+            metrics.publish();
+        }
+
         // transfer the optical flow from GPU to
         // host memory allocated by flowHost cvMat.
         // After this, optical flow values
@@ -105,6 +199,47 @@ int main(int argc, char** argv) {
         // filter.downloadFlow(flowHostWrapper);
     }
 
-    // the camera will be deinitialized automatically in VideoCapture destructor
+    //#################################
+    // Bandwidth report
+    //#################################
+    float peakBandwidth = measurePeakBandwidth();
+
+    cout << endl << "peak device bandwidth: " << peakBandwidth << " GB/s" << endl;
+    cout << setw(24) << left << "stage" << setw(8) << "level"
+        << setw(12) << "time (ms)" << setw(12) << "MB"
+        << setw(12) << "GB/s" << "% peak" << endl;
+
+    for(size_t s = 0; s < profile.size(); s ++) {
+
+        float time = N > 0? accumTime[s] / N : 0.0f;
+        size_t bytes = profile[s].traffic.bytesRead + profile[s].traffic.bytesWritten;
+        float bandwidth = time > 0.0f? bytes / (time * 1e6f) : 0.0f;
+
+        cout << setw(24) << left << profile[s].name << setw(8) << profile[s].level
+            << setw(12) << time << setw(12) << bytes / 1e6f
+            << setw(12) << bandwidth << 100.0f * bandwidth / peakBandwidth << endl;
+    }
+
+    //#################################
+    // Output level trade-off
+    //#################################
+    if(outputLevel > 0 && N > 0) {
+
+        evaluation_t ev = evaluator.total();
+        evaluation_t evRef = referenceEvaluator.total();
+
+        cout << endl << "output level trade-off against the full pyramid" << endl;
+        cout << setw(24) << left << "filter" << setw(12) << "time (ms)"
+            << setw(12) << "frames/s" << setw(12) << "mean EPE" << "outliers" << endl;
+
+        cout << setw(24) << left << "full pyramid" << setw(12) << referenceTime / N
+            << setw(12) << 1000.0f * N / referenceTime << setw(12) << evRef.all.meanEPE
+            << evRef.all.outlierRatio << endl;
+
+        cout << setw(24) << left << ("output level " + to_string(outputLevel)) << setw(12) << totalTime / N
+            << setw(12) << 1000.0f * N / totalTime << setw(12) << ev.all.meanEPE
+            << ev.all.outlierRatio << endl;
+    }
+
     return 0;
 }
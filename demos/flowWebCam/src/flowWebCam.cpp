@@ -12,6 +12,7 @@
 
 #include <flowfilter/gpu/flowfilter.h>
 #include <flowfilter/gpu/display.h>
+#include <flowfilter/gpu/stagegraph.h>
 
 using namespace std;
 using namespace cv;
@@ -31,21 +32,29 @@ void wrapCVMat(Mat& cvMat, image_t& img) {
 
 /**
  * MODE OF USE
- * ./flowWebCam <cameraIndex>
+ * ./flowWebCam <cameraIndex> <display>
  *
  * where <cameraIndex> is an integer indicating the camera used
  * to capture images. Defaults to 0;
  *
+ * <display> is 1 to show the image and the color encoded flow,
+ * 0 to only compute flow. Defaults to 1.
+ *
  */
 int main(int argc, char** argv) {
 
     int cameraIndex = 0;
+    bool display = true;
 
     // if user provides camera index
     if(argc > 1) {
         cameraIndex = atoi(argv[1]);
     }
 
+    if(argc > 2) {
+        display = atoi(argv[2]) != 0;
+    }
+
     VideoCapture cap(cameraIndex); // open the default camera
     if(!cap.isOpened()){
         return -1;
@@ -96,8 +105,41 @@ int main(int argc, char** argv) {
     wrapCVMat(flowHost, flowHostWrapper);
     
 
-    // Color encoder connected to optical flow buffer in the GPU
-    FlowToColor flowColor(filter.getFlow(), maxflow);
+    //#################################
+    // Color encoder connected to
+    // optical flow buffer in the GPU.
+    // Without display, the color
+    // encoding is not required and
+    // the plan drops it.
+    //#################################
+    FlowToColor flowColor;
+    flowColor.setMaxFlow(maxflow);
+
+    const portType_t flowType = {height, width, 2, int(sizeof(float))};
+
+    StageGraph graph;
+    // the filter is configured at construction, the graph
+    // only reads its flow
+    graph.addNode("PyramidalFlowFilter", &filter, true);
+    graph.addNode("FlowToColor", &flowColor);
+
+    graph.addOutput("PyramidalFlowFilter", "flow", flowType,
+        [&filter]() { return filter.getFlow(); });
+
+    graph.addInput("FlowToColor", "inputFlow", flowType,
+        [&flowColor](GPUImage img) { flowColor.setInputFlow(img); });
+    graph.addOutput("FlowToColor", "colorFlow", {height, width, 4, int(sizeof(unsigned char))},
+        [&flowColor]() { return flowColor.getColorFlow(); });
+
+    graph.connect("PyramidalFlowFilter.flow", "FlowToColor.inputFlow");
+
+    graph.require("PyramidalFlowFilter.flow");
+    if(display) {
+        graph.require("FlowToColor.colorFlow");
+    }
+
+    stagePlan_t plan = graph.configure();
+    vector<Stage*> stages = {&filter, &flowColor};
 
 
     // Capture loop
@@ -106,11 +148,15 @@ int main(int argc, char** argv) {
         // capture a new frame from the camera
         // and convert it to gray scale (uint8)
         cap >> frame;
+        if(frame.empty()) break;
         cvtColor(frame, frameGray, CV_BGR2GRAY);
         
         // transfer image to flow filter and compute
+        // the stages of the plan
         filter.loadImage(hostImageGray);
-        filter.compute();
+        for(const int n : plan.order) {
+            stages[n]->compute();
+        }
 
         cout << "elapsed time: " << filter.elapsedTime() << " ms" << endl;
 
@@ -121,15 +167,17 @@ int main(int argc, char** argv) {
         // access methods.
         filter.downloadFlow(flowHostWrapper);
 
-        // computes color encoding (RGBA) and download it to host
-        flowColor.compute();
-        flowColor.downloadColorFlow(hostFlowColor);
-        cvtColor(fcolor, fcolor, CV_RGBA2BGRA);
+        if(display) {
+
+            // download color encoding (RGBA) to host
+            flowColor.downloadColorFlow(hostFlowColor);
+            cvtColor(fcolor, fcolor, CV_RGBA2BGRA);
 
-        imshow("image", frameGray);
-        imshow("optical flow", fcolor);
+            imshow("image", frameGray);
+            imshow("optical flow", fcolor);
 
-        if(waitKey(1) >= 0) break;
+            if(waitKey(1) >= 0) break;
+        }
     }
 
     // the camera will be deinitialized automatically in VideoCapture destructor
@@ -0,0 +1,222 @@
+/**
+ * \file evaluation.h
+ * \brief Optical flow error metrics against ground truth.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_EVALUATION_H_
+#define FLOWFILTER_EVALUATION_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/image.h"
+#include "flowfilter/mappedfile.h"
+
+namespace flowfilter {
+
+/** Tag at the start of Middlebury .flo files */
+const float FLO_TAG = 202021.25f;
+
+/** Flow components with magnitude above this value are unknown in .flo files */
+const float FLO_UNKNOWN_FLOW = 1e9f;
+
+/** Maximum number of ground truth magnitude buckets */
+const int EVALUATION_MAX_BUCKETS = 8;
+
+
+/**
+ * \brief Error statistics over a set of pixels.
+ */
+typedef struct {
+
+    /** number of valid pixels */
+    std::uint64_t pixels;
+
+    /** mean endpoint error, in pixels */
+    float meanEPE;
+
+    /** root mean square endpoint error, in pixels */
+    float rmsEPE;
+
+    /** mean angular error, in degrees */
+    float meanAE;
+
+    /** fraction of pixels with endpoint error above the outlier threshold */
+    float outlierRatio;
+} errorStats_t;
+
+
+/**
+ * \brief Error statistics of pixels whose ground truth
+ *      magnitude lies in [lower, upper).
+ */
+typedef struct {
+    float lower;
+    float upper;
+    errorStats_t stats;
+} magnitudeBucket_t;
+
+
+/**
+ * \brief Result of an evaluation.
+ */
+typedef struct {
+
+    /** statistics over all valid pixels */
+    errorStats_t all;
+
+    int bucketCount;
+    magnitudeBucket_t buckets[EVALUATION_MAX_BUCKETS];
+} evaluation_t;
+
+
+/**
+ * \brief Middlebury .flo file mapped in memory.
+ *
+ * The flow field is read directly from the mapping,
+ * without copying it to host memory.
+ */
+class FLOWFILTER_API FloFile {
+
+public:
+
+    /**
+     * \brief maps and validates the header of a .flo file.
+     *
+     * \throws std::runtime_error if the file cannot be mapped
+     *      or is not a valid .flo file.
+     */
+    FloFile(const std::string& path);
+
+public:
+
+    int height() const;
+    int width() const;
+
+    /**
+     * \brief returns the flow field of the file.
+     *
+     * The returned image points to read only memory and
+     * is valid while this object is alive.
+     */
+    flowfilter::image_t flow() const;
+
+private:
+    flowfilter::MappedFile __file;
+    int __height;
+    int __width;
+};
+
+
+/**
+ * \brief Computes endpoint and angular errors of optical flow fields.
+ *
+ * All metrics of a frame are computed in a single pass over
+ * the flow and ground truth, split in row bands processed in
+ * parallel. A pixel is valid if its ground truth is finite and
+ * known, its estimated flow is finite and, if given, its mask
+ * value is non zero.
+ *
+ * Besides the statistics of each frame, the evaluator accumulates
+ * the statistics of all frames evaluated since the last reset().
+ */
+class FLOWFILTER_API FlowEvaluator {
+
+public:
+
+    /**
+     * \brief creates an evaluator.
+     *
+     * \param threads number of threads. If zero, the number
+     *      of hardware threads is used.
+     */
+    FlowEvaluator(const int threads = 0);
+
+public:
+
+    /**
+     * \brief evaluates a flow field.
+     *
+     * \param flow estimated float flow with depth 2.
+     * \param groundTruth ground truth float flow with depth 2.
+     */
+    evaluation_t evaluate(const flowfilter::image_t& flow,
+        const flowfilter::image_t& groundTruth);
+
+    /**
+     * \brief evaluates a flow field over the non zero pixels of a mask.
+     *
+     * \param mask uint8 image with depth 1.
+     */
+    evaluation_t evaluate(const flowfilter::image_t& flow,
+        const flowfilter::image_t& groundTruth,
+        const flowfilter::image_t& mask);
+
+    /**
+     * \brief returns the statistics accumulated since the last reset.
+     */
+    evaluation_t total() const;
+
+    /**
+     * \brief clears the accumulated statistics.
+     */
+    void reset();
+
+    /**
+     * \brief sets the endpoint error above which a pixel is an outlier.
+     */
+    void setOutlierThreshold(const float threshold);
+    float getOutlierThreshold() const;
+
+    /**
+     * \brief sets the ground truth magnitude bucket edges.
+     *
+     * N increasing edges define N + 1 buckets: [0, e0), [e0, e1),
+     * ..., [eN-1, inf). Resets the accumulated statistics.
+     */
+    void setBucketEdges(const std::vector<float>& edges);
+    std::vector<float> getBucketEdges() const;
+
+    int threads() const;
+
+
+private:
+
+    /** sums of one bucket */
+    typedef struct {
+        std::uint64_t pixels;
+        std::uint64_t outliers;
+        double sumEPE;
+        double sumEPE2;
+        double sumAE;
+    } accumulator_t;
+
+    evaluation_t run(const flowfilter::image_t& flow,
+        const flowfilter::image_t& groundTruth,
+        const flowfilter::image_t* mask);
+
+    void evaluateRows(const int rowStart, const int rowEnd,
+        const flowfilter::image_t& flow,
+        const flowfilter::image_t& groundTruth,
+        const flowfilter::image_t* mask,
+        accumulator_t* acc) const;
+
+    evaluation_t summarize(const accumulator_t* acc) const;
+
+
+private:
+    int __threadCount;
+    float __outlierThreshold;
+    std::vector<float> __bucketEdges;
+
+    /** accumulated sums of each bucket */
+    std::vector<accumulator_t> __total;
+};
+
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_EVALUATION_H_
@@ -0,0 +1,113 @@
+/**
+ * \file frameclock.h
+ * \brief Frame timing of timestamped image streams.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_FRAMECLOCK_H_
+#define FLOWFILTER_FRAMECLOCK_H_
+
+#include <cstdint>
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/image.h"
+
+namespace flowfilter {
+
+/** Largest number of frame intervals between two accepted frames */
+const float FRAMECLOCK_MAX_TIME_STEP = 8.0f;
+
+/** Number of image rows hashed to detect repeated frames */
+const int FRAMECLOCK_HASH_ROWS = 32;
+
+
+/**
+ * \brief Tracks the time between the frames loaded into a filter.
+ *
+ * Each timestamped frame is either accepted or reported as a
+ * duplicate of the last accepted one. A frame is a duplicate if its
+ * timestamp is not greater than the last accepted timestamp or, for
+ * host images, if a hash of FRAMECLOCK_HASH_ROWS evenly spaced rows
+ * equals the one of the last accepted frame. Sensor noise makes two
+ * different camera frames differ in practically every row, so
+ * sampling rows is enough to recognize a resent buffer.
+ *
+ * For accepted frames, timeStep() is the time since the last accepted
+ * frame in units of the nominal frame interval, bounded to
+ * [1/FRAMECLOCK_MAX_TIME_STEP, FRAMECLOCK_MAX_TIME_STEP]. Frames loaded
+ * without timestamp are always accepted with a time step of 1.
+ */
+class FLOWFILTER_API FrameClock {
+
+public:
+    FrameClock();
+
+public:
+
+    /**
+     * \brief registers a frame in host memory.
+     *
+     * \return true if the frame is accepted, false if it is a duplicate.
+     */
+    bool tick(const double timestamp, const flowfilter::image_t& image);
+
+    /**
+     * \brief registers a frame without looking at its content.
+     *
+     * \return true if the frame is accepted, false if it is a duplicate.
+     */
+    bool tick(const double timestamp);
+
+    /**
+     * \brief registers a frame without timestamp, one frame interval
+     *      after the previous one.
+     */
+    void tick();
+
+    /**
+     * \brief forgets the last accepted frame.
+     */
+    void reset();
+
+    /**
+     * \brief sets the nominal frame interval, in timestamp units.
+     *
+     * \throws std::invalid_argument if interval is not greater than zero.
+     */
+    void setFrameInterval(const double interval);
+    double getFrameInterval() const;
+
+    /** frame intervals between the last two accepted frames */
+    float timeStep() const;
+
+    /** true if the last registered frame is a duplicate */
+    bool duplicate() const;
+
+    /** number of duplicate frames registered so far */
+    int duplicateCount() const;
+
+private:
+
+    /** registers a frame given its hash, if hashed */
+    bool accept(const double timestamp, const bool hashed, const std::uint64_t hash);
+
+private:
+    double __frameInterval;
+
+    /** true if a timestamped frame has been accepted */
+    bool __started;
+    double __timestamp;
+
+    /** true if the last accepted frame has been hashed */
+    bool __hashed;
+    std::uint64_t __hash;
+
+    float __timeStep;
+    bool __duplicate;
+    int __duplicateCount;
+};
+
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_FRAMECLOCK_H_
@@ -0,0 +1,179 @@
+/**
+ * \file blockmatching.h
+ * \brief Block matching seeding of large displacements.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_GPU_BLOCKMATCHING_H_
+#define FLOWFILTER_GPU_BLOCKMATCHING_H_
+
+#include <vector>
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/image.h"
+
+#include "flowfilter/gpu/pipeline.h"
+#include "flowfilter/gpu/image.h"
+#include "flowfilter/gpu/camera.h"
+
+
+namespace flowfilter {
+namespace gpu {
+
+/**
+ * \brief Seeds a prior flow field with block matching displacements.
+ *
+ * The input image is divided in cells of BLOCKMATCHING_PATCH pixels.
+ * The patch of each cell is matched against the input image of the
+ * previous compute() at integer displacements up to
+ * BLOCKMATCHING_RADIUS pixels, using the sum of absolute differences
+ * (SAD) of 4 pixels per instruction.
+ *
+ * The best match of a cell replaces the input flow over the cell,
+ * in place, when it is more than the threshold apart from the input
+ * flow at the cell center and its SAD is below BLOCKMATCHING_SAD_RATIO
+ * times both the SAD at the input flow and the worst SAD of the
+ * search. The second condition rejects cells without texture and
+ * cells where the input flow already explains the motion.
+ *
+ * The input flow can be the propagated flow of a filter, seeding
+ * it before the update. With an angular velocity set, matches are
+ * compared to, and written as, flow minus the rotational flow.
+ *
+ * The first compute() only stores the input image.
+ */
+class FLOWFILTER_API BlockMatchingSeeder : public Stage {
+
+public:
+    BlockMatchingSeeder();
+
+    BlockMatchingSeeder(flowfilter::gpu::GPUImage inputImage,
+        flowfilter::gpu::GPUImage inputFlow);
+
+    ~BlockMatchingSeeder();
+
+public:
+
+    /**
+     * \brief configures the stage.
+     *
+     * After configuration, calls to compute()
+     * are valid.
+     * Input buffers should not change after
+     * this method has been called.
+     */
+    void configure();
+
+    /**
+     * \brief matches the input image against the previous one and seeds the input flow.
+     */
+    void compute();
+
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
+    /**
+     * \brief forgets the previous image, the next compute() only stores the input image.
+     */
+    void reset();
+
+
+    //#########################
+    // Stage inputs
+    //#########################
+
+    /**
+     * \brief sets the input image, uint8 with depth 1.
+     */
+    void setInputImage(flowfilter::gpu::GPUImage inputImage);
+
+    /**
+     * \brief sets the flow seeded in place, float with depth 2.
+     */
+    void setInputFlow(flowfilter::gpu::GPUImage inputFlow);
+
+
+    //#########################
+    // Stage outputs
+    //#########################
+
+    /**
+     * \brief returns the best match of each cell, seeded or not.
+     */
+    flowfilter::gpu::GPUImage getSeeds();
+
+
+    //#########################
+    // Parameters
+    //#########################
+
+    /**
+     * \brief sets the distance in pixels between a match and the
+     *      input flow above which the match is seeded. Defaults to 2.
+     *
+     * \throws std::invalid_argument if threshold is negative.
+     */
+    void setThreshold(const float threshold);
+    float getThreshold() const;
+
+    /**
+     * \brief sets the time between the previous and the current
+     *      image, in frame intervals. Defaults to 1.
+     *
+     * Matches span the time step, while the input flow and the
+     * seeds are per frame interval.
+     *
+     * \throws std::invalid_argument if timeStep is not greater than zero.
+     */
+    void setTimeStep(const float timeStep);
+    float getTimeStep() const;
+
+    void setCamera(const perspectiveCamera& cam);
+
+    /**
+     * \brief sets the rotation between the previous and the current
+     *      image, in radians, that is, over the time step. Defaults to zero.
+     */
+    void setAngularVelocity(const float wx, const float wy, const float wz);
+
+private:
+    bool __configured;
+    bool __inputImageSet;
+    bool __inputFlowSet;
+
+    /** true if __inputImageOld holds the image of the previous compute() */
+    bool __imageOldSet;
+
+    float __threshold;
+    float __timeStep;
+    perspectiveCamera __camera;
+    float3 __angularVelocity;
+
+    // inputs
+    flowfilter::gpu::GPUImage __inputImage;
+    flowfilter::gpu::GPUImage __inputFlow;
+
+    flowfilter::gpu::GPUImage __inputImageOld;
+
+    // outputs
+    flowfilter::gpu::GPUImage __seeds;
+
+    dim3 __block;
+    dim3 __grid;
+};
+
+}; // namespace gpu
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_GPU_BLOCKMATCHING_H_
@@ -37,6 +37,16 @@ FLOWFILTER_API perspectiveCamera createPerspectiveCamera(
     const float focalLength, const int height, const int width,
     const float sensorHeight, const float sensorWidth);
 
+
+/**
+ * \brief returns the camera of an image pyramid level.
+ *
+ * Each level halves the resolution of the one below, level 0
+ * being the camera itself.
+ */
+FLOWFILTER_API perspectiveCamera pyramidLevelCamera(
+    const perspectiveCamera& cam, const int level);
+
 } // namespace gpu
 } // namespace flowfilter
 
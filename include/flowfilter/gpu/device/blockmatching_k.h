@@ -0,0 +1,66 @@
+/**
+ * \file blockmatching_k.h
+ * \brief Kernel declarations for block matching flow seeding.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_GPU_BLOCKMATCHING_K_H_
+#define FLOWFILTER_GPU_BLOCKMATCHING_K_H_
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include "flowfilter/gpu/image.h"
+#include "flowfilter/gpu/camera.h"
+
+
+namespace flowfilter {
+namespace gpu {
+
+
+/** Side of the square patches matched at each grid cell, multiple of 4 */
+const int BLOCKMATCHING_PATCH = 8;
+
+/** Largest displacement searched along each axis */
+const int BLOCKMATCHING_RADIUS = 12;
+
+/**
+ * Largest ratio between the SAD of the best match and the SAD
+ * at the prior flow, or the worst SAD in the search window,
+ * for a match to replace the prior flow.
+ */
+const float BLOCKMATCHING_SAD_RATIO = 0.5f;
+
+
+/**
+ * \brief block matching search at the cells of a sparse grid.
+ *
+ * Each thread block matches the BLOCKMATCHING_PATCH square patch of
+ * one grid cell of image against imageOld, one thread per candidate
+ * displacement. The thread block must be of size
+ * (2*BLOCKMATCHING_RADIUS + 1)^2.
+ *
+ * Matches are displacements over timeStep frame intervals, and w
+ * is the rotation over the same time. inputFlow and seeds are per
+ * frame interval. The best match, minus the rotational flow of w
+ * at the cell center and divided by timeStep, is written to seeds.
+ * If the match differs from the displacement predicted by inputFlow
+ * at the cell center by more than threshold and passes the
+ * BLOCKMATCHING_SAD_RATIO test, the seed replaces inputFlow over
+ * the cell.
+ */
+__global__ void blockMatchingSeed_k(gpuimage_t<unsigned char> image,
+                                    gpuimage_t<unsigned char> imageOld,
+                                    perspectiveCamera cam,
+                                    const float3 w,
+                                    const float timeStep,
+                                    const float threshold,
+                                    gpuimage_t<float2> inputFlow,
+                                    gpuimage_t<float2> seeds);
+
+
+}; // namespace gpu
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_GPU_BLOCKMATCHING_K_H_
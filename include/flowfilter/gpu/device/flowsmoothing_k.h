@@ -15,6 +15,10 @@
 namespace flowfilter {
 namespace gpu {
 
+/** block size of the median kernels */
+#define FLOW_MEDIAN_BLOCK_X 32
+#define FLOW_MEDIAN_BLOCK_Y 8
+
 __global__ void flowSmoothX_k(cudaTextureObject_t inputFlow,
                               gpuimage_t<float2> flowSmooth);
 
@@ -22,6 +26,65 @@ __global__ void flowSmoothX_k(cudaTextureObject_t inputFlow,
 __global__ void flowSmoothY_k(cudaTextureObject_t inputFlow,
                               gpuimage_t<float2> flowSmooth);
 
+
+__global__ void flowSmoothSupportX_k(cudaTextureObject_t inputFlow,
+                                     const int radius,
+                                     gpuimage_t<float2> flowSmooth);
+
+
+__global__ void flowSmoothSupportY_k(cudaTextureObject_t inputFlow,
+                                     const int radius,
+                                     gpuimage_t<float2> flowSmooth);
+
+
+/**
+ * \brief recursive domain transform filter along the rows.
+ *
+ * One thread per row runs a causal and an anticausal sweep.
+ * The feedback coefficient of each pixel is
+ * 2^(log2Feedback * (1 + ratio*|guide(x) - guide(x - 1)|)).
+ */
+__global__ void flowDomainTransformX_k(cudaTextureObject_t inputFlow,
+                                       gpuimage_t<float> guide,
+                                       const float log2Feedback,
+                                       const float ratio,
+                                       gpuimage_t<float2> flowSmooth);
+
+
+/**
+ * \brief recursive domain transform filter along the columns,
+ *      one thread per column.
+ */
+__global__ void flowDomainTransformY_k(gpuimage_t<float2> inputFlow,
+                                       gpuimage_t<float> guide,
+                                       const float log2Feedback,
+                                       const float ratio,
+                                       gpuimage_t<float2> flowSmooth);
+
+
+
+/**
+ * \brief 3x3 median of each flow component.
+ *
+ * Must be launched with FLOW_MEDIAN_BLOCK_X x FLOW_MEDIAN_BLOCK_Y
+ * blocks. Each 3 pixel column of the block tile is sorted once in
+ * shared memory and reused by the three pixels whose window
+ * contains it.
+ */
+__global__ void flowMedian3_k(cudaTextureObject_t inputFlow,
+                              gpuimage_t<float2> flowSmooth);
+
+
+/**
+ * \brief 5x5 median of each flow component.
+ *
+ * Must be launched with FLOW_MEDIAN_BLOCK_X x FLOW_MEDIAN_BLOCK_Y
+ * blocks. Each pixel runs a forgetful selection network over its
+ * window, read from the block tile in shared memory.
+ */
+__global__ void flowMedian5_k(cudaTextureObject_t inputFlow,
+                              gpuimage_t<float2> flowSmooth);
+
 }; // namespace gpu
 }; // namespace flowfilter
 
@@ -0,0 +1,32 @@
+/**
+ * \file history_k.h
+ * \brief Kernel declarations for the flow history.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_GPU_HISTORY_K_H_
+#define FLOWFILTER_GPU_HISTORY_K_H_
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include "flowfilter/gpu/image.h"
+
+
+namespace flowfilter {
+namespace gpu {
+
+
+/**
+ * \brief writes round(scale*inputFlow), saturated to the int16 range.
+ */
+__global__ void quantizeFlow_k(gpuimage_t<float2> inputFlow,
+                               const float scale,
+                               gpuimage_t<short2> quantizedFlow);
+
+
+}; // namespace gpu
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_GPU_HISTORY_K_H_
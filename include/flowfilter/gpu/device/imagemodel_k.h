@@ -10,6 +10,7 @@
 
 
 #include "flowfilter/gpu/image.h"
+#include "flowfilter/gpu/imagemodel.h"
 
 
 namespace flowfilter {
@@ -28,6 +29,21 @@ __global__ void imageModel_k(cudaTextureObject_t imgPrefiltered,
                              gpuimage_t<float> imgConstant,
                              gpuimage_t<float2> imgGradient);
 
+/**
+ * \brief imagePrefilter_k with a mask of arbitrary support.
+ */
+__global__ void imagePrefilterSupport_k(cudaTextureObject_t inputImage,
+                                        const imageModelMask_t mask,
+                                        gpuimage_t<float2> imgPrefiltered);
+
+/**
+ * \brief imageModel_k with masks of arbitrary support.
+ */
+__global__ void imageModelSupport_k(cudaTextureObject_t imgPrefiltered,
+                                    const imageModelMask_t mask,
+                                    gpuimage_t<float> imgConstant,
+                                    gpuimage_t<float2> imgGradient);
+
 }; // namespace gpu
 }; // namespace flowfilter
 
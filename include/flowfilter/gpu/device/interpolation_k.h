@@ -0,0 +1,44 @@
+/**
+ * \file interpolation_k.h
+ * \brief Kernel declarations for motion compensated frame interpolation.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_GPU_INTERPOLATION_K_H_
+#define FLOWFILTER_GPU_INTERPOLATION_K_H_
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include "flowfilter/gpu/image.h"
+
+
+namespace flowfilter {
+namespace gpu {
+
+
+/**
+ * \brief backward warps inputImage by (1 - t)*inputFlow.
+ */
+__global__ void warpImage_k(gpuimage_t<float2> inputFlow,
+                            cudaTextureObject_t inputImage,
+                            const float t,
+                            gpuimage_t<float> interpolatedImage);
+
+
+/**
+ * \brief blends inputImage warped by (1 - t)*inputFlow with
+ *      inputImageOld warped by -t*inputFlow.
+ */
+__global__ void warpBlendImage_k(gpuimage_t<float2> inputFlow,
+                                 cudaTextureObject_t inputImage,
+                                 cudaTextureObject_t inputImageOld,
+                                 const float t,
+                                 gpuimage_t<float> interpolatedImage);
+
+
+}; // namespace gpu
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_GPU_INTERPOLATION_K_H_
@@ -21,6 +21,14 @@ namespace gpu {
 __global__ void rotationalOpticalFlow_k(perspectiveCamera cam, 
     float3 w, gpuimage_t<float2> flowField);
 
+
+/**
+ * \brief adds the rotational optical flow generated by the angular
+ *  velocity to an input flow field.
+ */
+__global__ void addRotationalFlow_k(perspectiveCamera cam,
+    float3 w, gpuimage_t<float2> inputFlow, gpuimage_t<float2> flowField);
+
 } // namespace gpu
 } // namespace flowfilter
 
@@ -15,13 +15,21 @@
 namespace flowfilter {
 namespace gpu {
 
+/** number of bins of the brightness constancy residual histogram */
+const int RESIDUAL_HISTOGRAM_BINS = 256;
+
+
 __global__ void flowUpdate_k(gpuimage_t<float> newImage,
                              gpuimage_t<float2> newImageGradient,
                              gpuimage_t<float> oldImage,
                              gpuimage_t<float2> oldFlow,
                              gpuimage_t<float> imageUpdated,
                              gpuimage_t<float2> flowUpdated,
-                             const float gamma, const float maxflow);
+                             const float gamma, const float maxflow,
+                             const float timeStep,
+                             const bool computeResidual, const float residualRange,
+                             gpuimage_t<unsigned int> residualHistogram,
+                             gpuimage_t<float> residualSum);
 
 
 __global__ void deltaFlowUpdate_k(gpuimage_t<float> newImage,
@@ -32,7 +40,11 @@ __global__ void deltaFlowUpdate_k(gpuimage_t<float> newImage,
                                   gpuimage_t<float> imageUpdated,
                                   gpuimage_t<float2> deltaFlowUpdated,
                                   gpuimage_t<float2> flowUpdated,
-                                  const float gamma, const float maxflow);
+                                  const float gamma, const float maxflow,
+                                  const float timeStep,
+                                  const bool computeResidual, const float residualRange,
+                                  gpuimage_t<unsigned int> residualHistogram,
+                                  gpuimage_t<float> residualSum);
 }; // namespace gpu
 }; // namespace flowfilter
 
@@ -0,0 +1,45 @@
+/**
+ * \file upsampling_k.h
+ * \brief Kernel declarations for guided flow upsampling.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_GPU_UPSAMPLING_K_H_
+#define FLOWFILTER_GPU_UPSAMPLING_K_H_
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include "flowfilter/gpu/image.h"
+
+
+namespace flowfilter {
+namespace gpu {
+
+
+/**
+ * \brief joint bilateral upsampling of inputFlow to the resolution of guide.
+ *
+ * Each output pixel averages the 3x3 inputFlow pixels nearest to
+ * it, weighted by their spatial distance, in inputFlow pixels, and
+ * by the difference between guide at the output pixel and
+ * guideCoarse at the inputFlow pixel. The average is multiplied by
+ * scale, the ratio between the guide and inputFlow sizes.
+ *
+ * \param invSigmaSpace2 1 / sigmaSpace^2.
+ * \param invSigmaRange2 1 / sigmaRange^2, guides are read in [0, 1].
+ */
+__global__ void jointBilateralUpsample_k(gpuimage_t<float2> inputFlow,
+                                         gpuimage_t<unsigned char> guideCoarse,
+                                         gpuimage_t<unsigned char> guide,
+                                         const float2 scale,
+                                         const float invSigmaSpace2,
+                                         const float invSigmaRange2,
+                                         gpuimage_t<float2> upsampledFlow);
+
+
+}; // namespace gpu
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_GPU_UPSAMPLING_K_H_
@@ -44,6 +44,16 @@ public:
      */
     void compute();
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
 
     //#########################
     // Host load-download
@@ -8,6 +8,7 @@
 #ifndef FLOWFILTER_GPU_FLOWFILTER_H_
 #define FLOWFILTER_GPU_FLOWFILTER_H_
 
+#include <string>
 #include <vector>
 
 #include <cuda.h>
@@ -15,19 +16,66 @@
 
 #include "flowfilter/osconfig.h"
 #include "flowfilter/image.h"
+#include "flowfilter/frameclock.h"
 
 #include "flowfilter/gpu/image.h"
 #include "flowfilter/gpu/pipeline.h"
+#include "flowfilter/gpu/stagegraph.h"
 #include "flowfilter/gpu/imagemodel.h"
 #include "flowfilter/gpu/update.h"
 #include "flowfilter/gpu/propagation.h"
 #include "flowfilter/gpu/flowsmoothing.h"
 #include "flowfilter/gpu/pyramid.h"
+#include "flowfilter/gpu/camera.h"
+#include "flowfilter/gpu/rotation.h"
+#include "flowfilter/gpu/blockmatching.h"
+#include "flowfilter/gpu/upsampling.h"
+#include "flowfilter/gpu/snapshot.h"
+#include "flowfilter/gpu/history.h"
+#include "flowfilter/gpu/parameters.h"
 
 
 namespace flowfilter {
 namespace gpu {
 
+/**
+ * \brief Function called after each frame processed by processSequence().
+ *
+ * \param frame index of the frame just processed.
+ * \param userData pointer given to processSequence().
+ * \return false to stop processing the sequence.
+ */
+typedef bool (*sequenceCallback_t)(const int frame, void* userData);
+
+
+/**
+ * \brief Intermediate buffers of a filter exposed by getTap().
+ */
+typedef enum {
+
+    /** float image model constant, depth 1 */
+    TAP_IMAGE_CONSTANT = 0,
+
+    /** float image model gradient, depth 2 */
+    TAP_IMAGE_GRADIENT = 1,
+
+    /** image constant kept by the update stage for the next frame, depth 1 */
+    TAP_IMAGE_UPDATED = 2,
+
+    /** flow propagated from the previous frame, depth 2 */
+    TAP_PROPAGATED_FLOW = 3,
+
+    /** updated flow before smoothing, depth 2 */
+    TAP_UPDATED_FLOW = 4,
+
+    /** updated delta flow, depth 2. Only defined for DeltaFlowFilter */
+    TAP_DELTA_FLOW = 5,
+
+    /** smoothed flow, the filter output, depth 2 */
+    TAP_FLOW = 6
+} filterTap_t;
+
+
 class FLOWFILTER_API FlowFilter : public Stage {
 
 public:
@@ -56,6 +104,23 @@ public:
      */
     void compute();
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers of the filter and its inner stages
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
+    /**
+     * \brief returns runtime and memory traffic of each inner stage
+     *
+     * \param level pyramid level reported in the records.
+     */
+    std::vector<flowfilter::gpu::stageProfile_t> getProfile(const int level = 0) const;
+
     void computeImageModel();
     void computePropagation();
     void computeUpdate();
@@ -72,6 +137,82 @@ public:
 
     flowfilter::gpu::GPUImage getFlow();
 
+    /**
+     * \brief returns the image model outputs of the last call to compute().
+     */
+    flowfilter::gpu::GPUImage getImageConstant();
+    flowfilter::gpu::GPUImage getImageGradient();
+
+    /**
+     * \brief returns an intermediate buffer of the last call to compute().
+     *
+     * The returned image shares the filter buffer. It should be
+     * treated as read only and its content is valid until the
+     * next call to compute().
+     *
+     * \throws std::invalid_argument if the filter does not have the tap.
+     */
+    flowfilter::gpu::GPUImage getTap(const filterTap_t tap);
+
+
+    //#########################
+    // Flow snapshots
+    //#########################
+
+    /**
+     * \brief publishes the output flow to the snapshot buffer at the end of compute().
+     *
+     * Reader threads acquire the latest published flow from
+     * getSnapshotBuffer() while the next frame is being computed.
+     * Disabled by default.
+     */
+    void setPublishFlow(const bool publish);
+    bool getPublishFlow() const;
+
+    /**
+     * \brief returns the snapshot buffer. Copies share the filter buffer.
+     */
+    flowfilter::gpu::FlowSnapshotBuffer getSnapshotBuffer();
+
+
+    //#########################
+    // Flow history
+    //#########################
+
+    /**
+     * \brief keeps the last depth output flows in a FlowHistory.
+     *
+     * At the end of each compute(), the output flow is written into
+     * the oldest history slot, quantized to int16 if requested.
+     * Previous history content is discarded. A depth of zero, the
+     * default, disables the history.
+     *
+     * \throws std::invalid_argument if depth is negative.
+     * \throws std::logic_error if the filter is not configured.
+     */
+    void setHistoryDepth(const int depth, const bool quantized = false);
+    int getHistoryDepth() const;
+
+    /**
+     * \brief returns the flow history. Copies share the filter history.
+     */
+    flowfilter::gpu::FlowHistory getHistory();
+
+
+    //#########################
+    // Runtime parameters
+    //#########################
+
+    /**
+     * \brief returns the parameter buffer. Copies share the filter buffer.
+     *
+     * Parameters submitted to the buffer from a control thread
+     * are applied at the start of the next compute(), while the
+     * setters of this class should only be called from the thread
+     * running compute().
+     */
+    flowfilter::gpu::ParameterBuffer getParameterBuffer();
+
 
     //#########################
     // Host load-download
@@ -82,6 +223,50 @@ public:
      */
     void loadImage(flowfilter::image_t& image);
 
+    /**
+     * \brief load image stored in GPU memory space.
+     *
+     * The image is copied device to device, its pitch may
+     * differ from the one of the filter input.
+     */
+    void loadImage(flowfilter::gpu::GPUImage& image);
+
+    /**
+     * \brief load a timestamped image stored in CPU memory space.
+     *
+     * Duplicates of the last accepted frame, see FrameClock, are not
+     * uploaded and the next compute() returns immediately, keeping
+     * the current flow. Otherwise the next compute() propagates the
+     * flow over the frame intervals elapsed since the last accepted
+     * frame. Images loaded without timestamp are one frame interval
+     * apart.
+     */
+    void loadImage(flowfilter::image_t& image, const double timestamp);
+
+    /**
+     * \brief load a timestamped image stored in GPU memory space.
+     *
+     * Only the timestamp is used to detect duplicate frames.
+     */
+    void loadImage(flowfilter::gpu::GPUImage& image, const double timestamp);
+
+    /**
+     * \brief sets the nominal frame interval, in timestamp units. Defaults to 1.
+     */
+    void setFrameInterval(const double interval);
+    double getFrameInterval() const;
+
+    /**
+     * \brief returns true if the last loaded image is a duplicate,
+     *      in which case compute() does nothing.
+     */
+    bool getFrameSkipped() const;
+
+    /**
+     * \brief returns the number of duplicate images loaded so far.
+     */
+    int getSkippedFrames() const;
+
     /**
      * \brief returns the new estimate of optical flow
      */
@@ -93,16 +278,39 @@ public:
      */
     void downloadImage(flowfilter::image_t& image);
 
-    // // Image model outputs
-    // void downloadImageGradient(flowfilter::image_t& gradient);
-    // void downloadImageConstant(flowfilter::image_t& gradient);
+    /**
+     * \brief runs the filter over a sequence of images.
+     *
+     * For each frame t, loads frames[t], computes the filter and
+     * downloads the flow into flows[t]. If callback is not null, it
+     * is called after each frame and processing stops when it
+     * returns false.
+     *
+     * \return number of frames processed.
+     *
+     * \throws std::invalid_argument if frames and flows
+     *      have different sizes.
+     */
+    int processSequence(std::vector<flowfilter::image_t>& frames,
+        std::vector<flowfilter::image_t>& flows,
+        sequenceCallback_t callback = nullptr,
+        void* userData = nullptr);
+
+    /**
+     * \brief downloads an intermediate buffer, see getTap().
+     */
+    void downloadTap(const filterTap_t tap, flowfilter::image_t& image);
+
+    // Image model outputs
+    void downloadImageGradient(flowfilter::image_t& gradient);
+    void downloadImageConstant(flowfilter::image_t& image);
 
-    // // Update stage
-    // void downloadFlowUpdated(flowfilter::image_t& flow);
-    // void downloadImageUpdated(flowfilter::image_t& image);
+    // Update stage
+    void downloadFlowUpdated(flowfilter::image_t& flow);
+    void downloadImageUpdated(flowfilter::image_t& image);
 
-    // // Smooth stage
-    // void downloadSmoothedFlow(flowfilter::image_t& flow);
+    // Smooth stage
+    void downloadSmoothedFlow(flowfilter::image_t& flow);
 
     
     //#########################
@@ -115,17 +323,76 @@ public:
     float getMaxFlow() const;
     void setMaxFlow(const float maxflow);
 
+    /**
+     * \brief sets the frame intervals between the previous and the next image.
+     *
+     * The flow is propagated over timeStep frame intervals, with
+     * ceil(maxflow*timeStep) iterations, and stays in pixels per
+     * frame interval.
+     */
+    void setTimeStep(const float timeStep);
+    float getTimeStep() const;
+
     int getSmoothIterations() const;
     void setSmoothIterations(const int N);
 
+    /**
+     * \brief sets the smoothing filter, see FlowSmoother.
+     *
+     * SMOOTH_DOMAIN_TRANSFORM uses the image constant as guide.
+     */
+    void setSmoothMode(const smoothMode_t mode);
+    smoothMode_t getSmoothMode() const;
+
+    void setSmoothSigmaSpace(const float sigma);
+    float getSmoothSigmaSpace() const;
+
+    /**
+     * \brief sets the range standard deviation of the domain
+     *      transform, in units of images normalized to [0, 1].
+     */
+    void setSmoothSigmaRange(const float sigma);
+    float getSmoothSigmaRange() const;
+
     void setPropagationBorder(const int border);
     int getPropagationBorder() const;
 
     int getPropagationIterations() const;
 
+    /**
+     * \brief enables the brightness constancy residual in the update stage.
+     */
+    void setComputeResidual(const bool computeResidual);
+    bool getComputeResidual() const;
+
+    void setResidualRange(const float residualRange);
+    float getResidualRange() const;
+
+    /**
+     * \brief returns the residual statistics of last call to compute().
+     */
+    flowfilter::gpu::residualStats_t getResidualStats();
+
     int height() const;
     int width() const;
 
+    /**
+     * \brief returns the execution plan of the inner stages.
+     *
+     * Nodes are indexed as ImageModel, propagator, update
+     * and smoother. Stages of the same wave do not depend
+     * on each other.
+     */
+    const flowfilter::gpu::stagePlan_t& getPlan() const;
+
+
+private:
+
+    /** applies the parameters submitted to the parameter buffer */
+    void applyParameters(const filterParameters_t& params);
+
+    /** inner stages, indexed as the nodes of the stage graph */
+    std::vector<flowfilter::gpu::Stage*> stages();
 
 private:
     int __height;
@@ -142,6 +409,16 @@ private:
     flowfilter::gpu::FlowSmoother __smoother;
     flowfilter::gpu::FlowPropagator __propagator;
 
+    flowfilter::gpu::stagePlan_t __plan;
+
+    bool __publishFlow;
+    flowfilter::gpu::FlowSnapshotBuffer __snapshots;
+
+    flowfilter::gpu::FlowHistory __history;
+
+    flowfilter::gpu::ParameterBuffer __parameters;
+
+    flowfilter::FrameClock __clock;
 };
 
 
@@ -169,6 +446,23 @@ public:
      */
     void compute();
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers of the filter and its inner stages
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
+    /**
+     * \brief returns runtime and memory traffic of each inner stage
+     *
+     * \param level pyramid level reported in the records.
+     */
+    std::vector<flowfilter::gpu::stageProfile_t> getProfile(const int level = 0) const;
+
 
     void computeImageModel();
     void computePropagation();
@@ -188,6 +482,20 @@ public:
 
     flowfilter::gpu::GPUImage getFlow();
     flowfilter::gpu::GPUImage getImage();
+    flowfilter::gpu::GPUImage getDeltaFlow();
+    flowfilter::gpu::GPUImage getImageConstant();
+    flowfilter::gpu::GPUImage getImageGradient();
+
+    /**
+     * \brief returns an intermediate buffer of the last call to compute().
+     *
+     * The returned image shares the filter buffer. It should be
+     * treated as read only and its content is valid until the
+     * next call to compute().
+     *
+     * \throws std::invalid_argument if the filter does not have the tap.
+     */
+    flowfilter::gpu::GPUImage getTap(const filterTap_t tap);
 
 
     //#########################
@@ -200,17 +508,73 @@ public:
     float getMaxFlow() const;
     void setMaxFlow(const float maxflow);
 
+    /**
+     * \brief sets the frame intervals between the previous and the next image.
+     *
+     * The flow is propagated over timeStep frame intervals, with
+     * ceil(maxflow*timeStep) iterations, and stays in pixels per
+     * frame interval.
+     */
+    void setTimeStep(const float timeStep);
+    float getTimeStep() const;
+
     int getSmoothIterations() const;
     void setSmoothIterations(const int N);
 
+    /**
+     * \brief sets the smoothing filter, see FlowSmoother.
+     *
+     * SMOOTH_DOMAIN_TRANSFORM uses the image constant as guide.
+     */
+    void setSmoothMode(const smoothMode_t mode);
+    smoothMode_t getSmoothMode() const;
+
+    void setSmoothSigmaSpace(const float sigma);
+    float getSmoothSigmaSpace() const;
+
+    /**
+     * \brief sets the range standard deviation of the domain
+     *      transform, in units of images normalized to [0, 1].
+     */
+    void setSmoothSigmaRange(const float sigma);
+    float getSmoothSigmaRange() const;
+
     void setPropagationBorder(const int border);
     int getPropagationBorder() const;
 
     int getPropagationIterations() const;
 
+    /**
+     * \brief enables the brightness constancy residual in the update stage.
+     */
+    void setComputeResidual(const bool computeResidual);
+    bool getComputeResidual() const;
+
+    void setResidualRange(const float residualRange);
+    float getResidualRange() const;
+
+    /**
+     * \brief returns the residual statistics of last call to compute().
+     */
+    flowfilter::gpu::residualStats_t getResidualStats();
+
     int height() const;
     int width() const;
 
+    /**
+     * \brief returns the execution plan of the inner stages.
+     *
+     * Nodes are indexed as ImageModel, propagator, update
+     * and smoother. Stages of the same wave do not depend
+     * on each other.
+     */
+    const flowfilter::gpu::stagePlan_t& getPlan() const;
+
+
+private:
+
+    /** inner stages, indexed as the nodes of the stage graph */
+    std::vector<flowfilter::gpu::Stage*> stages();
 
 private:
     int __height;
@@ -232,6 +596,7 @@ private:
     flowfilter::gpu::FlowSmoother __smoother;
     flowfilter::gpu::FlowPropagatorPayload __propagator;
 
+    flowfilter::gpu::stagePlan_t __plan;
 };
 
 
@@ -259,6 +624,25 @@ public:
      */
     void compute();
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers of the filter and its inner stages
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
+    /**
+     * \brief returns runtime and memory traffic of each inner stage
+     *
+     * Records are ordered by execution: image pyramid,
+     * top level filter and lower levels, followed by the
+     * derotation and seeding stages when enabled.
+     */
+    std::vector<flowfilter::gpu::stageProfile_t> getProfile() const;
+
 
     //#########################
     // Stage outputs
@@ -266,6 +650,197 @@ public:
 
     flowfilter::gpu::GPUImage getFlow();
 
+    /**
+     * \brief returns the outputs of a pyramid level.
+     *
+     * Level 0 has the input image resolution. getDeltaFlow() is not
+     * defined at the top level, which estimates the flow directly.
+     *
+     * \throws std::invalid_argument if the level is out of range.
+     */
+    flowfilter::gpu::GPUImage getFlow(const int level);
+    flowfilter::gpu::GPUImage getDeltaFlow(const int level);
+    flowfilter::gpu::GPUImage getImageConstant(const int level);
+    flowfilter::gpu::GPUImage getImageGradient(const int level);
+
+    /**
+     * \brief returns an intermediate buffer of a pyramid level.
+     *
+     * The returned image shares the filter buffer. It should be
+     * treated as read only and its content is valid until the
+     * next call to compute(). TAP_DELTA_FLOW is not defined at
+     * the top level.
+     *
+     * \throws std::invalid_argument if the level is out of range
+     *      or the level filter does not have the tap.
+     */
+    flowfilter::gpu::GPUImage getTap(const filterTap_t tap, const int level);
+
+    /**
+     * \brief downloads an intermediate buffer of a pyramid level, see getTap().
+     */
+    void downloadTap(const filterTap_t tap, const int level, flowfilter::image_t& image);
+
+
+    //#########################
+    // Flow snapshots
+    //#########################
+
+    /**
+     * \brief publishes the output flow to the snapshot buffer at the end of compute().
+     *
+     * Reader threads acquire the latest published flow from
+     * getSnapshotBuffer() while the next frame is being computed.
+     * Disabled by default.
+     */
+    void setPublishFlow(const bool publish);
+    bool getPublishFlow() const;
+
+    /**
+     * \brief returns the snapshot buffer. Copies share the filter buffer.
+     */
+    flowfilter::gpu::FlowSnapshotBuffer getSnapshotBuffer();
+
+
+    //#########################
+    // Flow history
+    //#########################
+
+    /**
+     * \brief keeps the last depth output flows in a FlowHistory.
+     *
+     * At the end of each compute(), the output flow is written into
+     * the oldest history slot, quantized to int16 if requested.
+     * Previous history content is discarded. A depth of zero, the
+     * default, disables the history.
+     *
+     * \throws std::invalid_argument if depth is negative.
+     * \throws std::logic_error if the filter is not configured.
+     */
+    void setHistoryDepth(const int depth, const bool quantized = false);
+    int getHistoryDepth() const;
+
+    /**
+     * \brief returns the flow history. Copies share the filter history.
+     */
+    flowfilter::gpu::FlowHistory getHistory();
+
+
+    //#########################
+    // Derotation
+    //#########################
+
+    /**
+     * \brief sets the camera used for derotation, at the input image resolution.
+     */
+    void setCamera(const perspectiveCamera& cam);
+
+    /**
+     * \brief enables derotation.
+     *
+     * At the start of compute(), the image each level keeps from the
+     * previous frame is warped by the rotational flow of the angular
+     * velocity given to setAngularVelocity(), so the level filters
+     * only track the residual motion. The rotational flow is added
+     * back to the output flow, getFlow(). Flows and taps of the
+     * individual levels remain residual flows, and the residual
+     * flow field itself is not transported by the rotation.
+     *
+     * With derotation, maxflow only needs to bound the residual
+     * flow, which lowers the propagation iterations and the number
+     * of pyramid levels needed. Disabled by default.
+     *
+     * \throws std::logic_error if no camera has been set.
+     */
+    void setDerotate(const bool derotate);
+    bool getDerotate() const;
+
+    /**
+     * \brief sets the angular velocity of the camera for the next
+     *      compute(), in radians per frame interval.
+     *
+     * The previous images are warped by the angular velocity times
+     * the time step. Like the level flows, the rotational flow added
+     * to getFlow() is per frame interval, that is, it corresponds to
+     * the unscaled angular velocity.
+     */
+    void setAngularVelocity(const float wx, const float wy, const float wz);
+
+
+    //#########################
+    // Seeding
+    //#########################
+
+    /**
+     * \brief enables block matching seeding at the top level.
+     *
+     * After the top level propagation, a BlockMatchingSeeder matches
+     * the top level image against the one of the previous frame and
+     * replaces the propagated flow in the cells where the match
+     * disagrees with it. Displacements of up to BLOCKMATCHING_RADIUS
+     * top level pixels are found in a single frame, instead of being
+     * reached over several frames by the top level update.
+     *
+     * maxflow still bounds the flow, seeds above it are clamped by
+     * the update. Disabled by default.
+     */
+    void setSeeding(const bool seeding);
+    bool getSeeding() const;
+
+    /**
+     * \brief sets the seeding threshold, in pixels of the input image
+     *      resolution, see BlockMatchingSeeder::setThreshold().
+     */
+    void setSeedThreshold(const float threshold);
+    float getSeedThreshold() const;
+
+
+    //#########################
+    // Output level
+    //#########################
+
+    /**
+     * \brief sets the finest pyramid level computed by the filter.
+     *
+     * Levels below the output level are skipped. The output flow,
+     * getFlow(), is then the flow of the output level upsampled to
+     * the input resolution in a single JointBilateralUpsampler pass
+     * guided by the input image. Each skipped level removes about
+     * three quarters of the remaining cost, at the price of the flow
+     * detail finer than the output level. Outputs of skipped levels
+     * keep their last values, and levels enabled again converge over
+     * the following frames. Defaults to 0, computing all levels.
+     *
+     * \throws std::invalid_argument if the level is out of range.
+     */
+    void setOutputLevel(const int level);
+    int getOutputLevel() const;
+
+    /**
+     * \brief sets the spatial and range standard deviations of the
+     *      upsampling, see JointBilateralUpsampler.
+     */
+    void setUpsamplingSigmaSpace(const float sigma);
+    float getUpsamplingSigmaSpace() const;
+
+    void setUpsamplingSigmaRange(const float sigma);
+    float getUpsamplingSigmaRange() const;
+
+
+    //#########################
+    // Runtime parameters
+    //#########################
+
+    /**
+     * \brief returns the parameter buffer. Copies share the filter buffer.
+     *
+     * Parameters submitted to the buffer from a control thread
+     * are applied at the start of the next compute(), while the
+     * setters of this class should only be called from the thread
+     * running compute().
+     */
+    flowfilter::gpu::ParameterBuffer getParameterBuffer();
+
 
     //#########################
     // Host load-download
@@ -276,6 +851,50 @@ public:
      */
     void loadImage(flowfilter::image_t& image);
 
+    /**
+     * \brief load image stored in GPU memory space.
+     *
+     * The image is copied device to device, its pitch may
+     * differ from the one of the filter input.
+     */
+    void loadImage(flowfilter::gpu::GPUImage& image);
+
+    /**
+     * \brief load a timestamped image stored in CPU memory space.
+     *
+     * Duplicates of the last accepted frame, see FrameClock, are not
+     * uploaded and the next compute() returns immediately, keeping
+     * the current flow. Otherwise the next compute() propagates the
+     * flow over the frame intervals elapsed since the last accepted
+     * frame. Images loaded without timestamp are one frame interval
+     * apart.
+     */
+    void loadImage(flowfilter::image_t& image, const double timestamp);
+
+    /**
+     * \brief load a timestamped image stored in GPU memory space.
+     *
+     * Only the timestamp is used to detect duplicate frames.
+     */
+    void loadImage(flowfilter::gpu::GPUImage& image, const double timestamp);
+
+    /**
+     * \brief sets the nominal frame interval, in timestamp units. Defaults to 1.
+     */
+    void setFrameInterval(const double interval);
+    double getFrameInterval() const;
+
+    /**
+     * \brief returns true if the last loaded image is a duplicate,
+     *      in which case compute() does nothing.
+     */
+    bool getFrameSkipped() const;
+
+    /**
+     * \brief returns the number of duplicate images loaded so far.
+     */
+    int getSkippedFrames() const;
+
     /**
      * \brief returns the new estimate of optical flow
      */
@@ -287,6 +906,24 @@ public:
      */
     void downloadImage(flowfilter::image_t& image);
 
+    /**
+     * \brief runs the filter over a sequence of images.
+     *
+     * For each frame t, loads frames[t], computes the filter and
+     * downloads the flow into flows[t]. If callback is not null, it
+     * is called after each frame and processing stops when it
+     * returns false.
+     *
+     * \return number of frames processed.
+     *
+     * \throws std::invalid_argument if frames and flows
+     *      have different sizes.
+     */
+    int processSequence(std::vector<flowfilter::image_t>& frames,
+        std::vector<flowfilter::image_t>& flows,
+        sequenceCallback_t callback = nullptr,
+        void* userData = nullptr);
+
 
     //#########################
     // Parameters
@@ -299,20 +936,73 @@ public:
     float getMaxFlow() const;
     void setMaxFlow(const float maxflow);
 
+    /**
+     * \brief sets the time step of all levels, see FlowFilter::setTimeStep().
+     */
+    void setTimeStep(const float timeStep);
+    float getTimeStep() const;
+
     int getSmoothIterations(const int level) const;
     void setSmoothIterations(const int level, const int N);
     void setSmoothIterations(const std::vector<int>& iterations);
 
+    /**
+     * \brief sets the smoothing filter of all levels.
+     */
+    void setSmoothMode(const smoothMode_t mode);
+    smoothMode_t getSmoothMode() const;
+
+    void setSmoothSigmaSpace(const float sigma);
+    float getSmoothSigmaSpace() const;
+
+    void setSmoothSigmaRange(const float sigma);
+    float getSmoothSigmaRange() const;
+
     void setPropagationBorder(const int border);
     int getPropagationBorder() const;
     
     // int getPropagationIterations() const;
 
+    /**
+     * \brief enables the brightness constancy residual at all levels.
+     */
+    void setComputeResidual(const bool computeResidual);
+    bool getComputeResidual() const;
+
+    /**
+     * \brief sets the residual histogram range at all levels.
+     */
+    void setResidualRange(const float residualRange);
+    float getResidualRange() const;
+
+    /**
+     * \brief returns the residual statistics at a given pyramid level.
+     *
+     * At the top level, the residual is computed with the flow. At
+     * lower levels it is computed with the delta flow estimated at
+     * that level.
+     */
+    flowfilter::gpu::residualStats_t getResidualStats(const int level);
+
     int height() const;
     int width() const;
     int levels() const;
 
 
+private:
+
+    /** throws std::invalid_argument if level is out of range */
+    void checkLevel(const std::string& method, const int level) const;
+
+    /** applies the parameters submitted to the parameter buffer */
+    void applyParameters(const filterParameters_t& params);
+
+    /** warps the images of the previous frame by the rotational flow */
+    void derotate();
+
+    /** returns the flow at the input resolution, before adding rotation */
+    flowfilter::gpu::GPUImage baseFlow();
+
 private:
 
     bool __configured;
@@ -329,6 +1019,33 @@ private:
 
     std::vector<DeltaFlowFilter> __lowLevelFilters;
 
+    bool __publishFlow;
+    flowfilter::gpu::FlowSnapshotBuffer __snapshots;
+
+    flowfilter::gpu::FlowHistory __history;
+
+    flowfilter::gpu::ParameterBuffer __parameters;
+
+    flowfilter::FrameClock __clock;
+
+    bool __derotate;
+    bool __cameraSet;
+    perspectiveCamera __camera;
+    float3 __angularVelocity;
+
+    /** image predictor of each level, warping the images kept by the level filters */
+    std::vector<RotationalFlowImagePredictor> __derotators;
+    flowfilter::gpu::RotationalFlowAdder __rotationAdder;
+
+    bool __seeding;
+
+    /** seeds the top level propagated flow */
+    flowfilter::gpu::BlockMatchingSeeder __seeder;
+
+    int __outputLevel;
+
+    /** upsamples the flow of the output level, if not zero */
+    flowfilter::gpu::JointBilateralUpsampler __upsampler;
 };
 
 }; // namespace gpu
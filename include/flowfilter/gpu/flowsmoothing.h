@@ -18,6 +18,27 @@
 namespace flowfilter {
 namespace gpu {
 
+/**
+ * \brief Smoothing filter applied by FlowSmoother.
+ */
+typedef enum {
+
+    /** isotropic box filter */
+    SMOOTH_BOX = 0,
+
+    /**
+     * edge-aware recursive domain transform filter guided by
+     * the image constant. Runs in constant time per pixel.
+     */
+    SMOOTH_DOMAIN_TRANSFORM = 1,
+
+    /** 3x3 median of each flow component, robust to outliers */
+    SMOOTH_MEDIAN3 = 2,
+
+    /** 5x5 median of each flow component */
+    SMOOTH_MEDIAN5 = 3
+} smoothMode_t;
+
 
 class FLOWFILTER_API FlowSmoother : public Stage {
 
@@ -43,22 +64,86 @@ public:
      */
     void compute();
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
     int getIterations() const;
     void setIterations(const int N);
 
+    /**
+     * \brief sets the width of the box filter applied in each pass.
+     *
+     * The support must be odd and greater or equal 3. Defaults to 5.
+     */
+    int getSupport() const;
+    void setSupport(const int support);
+
+    /**
+     * \brief sets the smoothing filter. Defaults to SMOOTH_BOX.
+     *
+     * SMOOTH_DOMAIN_TRANSFORM requires a guide image. With the
+     * median modes, each iteration is one median pass and the
+     * support is not used.
+     */
+    smoothMode_t getMode() const;
+    void setMode(const smoothMode_t mode);
+
+    /**
+     * \brief sets the spatial standard deviation of the
+     *      domain transform filter, in pixels. Defaults to 5.
+     */
+    float getSigmaSpace() const;
+    void setSigmaSpace(const float sigma);
+
+    /**
+     * \brief sets the range standard deviation of the domain
+     *      transform filter, in guide image units. Defaults to 0.1.
+     */
+    float getSigmaRange() const;
+    void setSigmaRange(const float sigma);
+
     //#########################
     // Stage inputs
     //#########################
     void setInputFlow(flowfilter::gpu::GPUImage inputFlow);
 
+    /**
+     * \brief sets the float guide image of the domain transform
+     *      filter, with the same size as the input flow.
+     */
+    void setGuideImage(flowfilter::gpu::GPUImage guideImage);
+
     //#########################
     // Stage outputs
     //#########################
     flowfilter::gpu::GPUImage getSmoothedFlow();
 
+private:
+
+    /** runs one X and Y smoothing pass reading from inputFlow */
+    void smoothPass(cudaTextureObject_t inputFlow);
+
+    /** runs X and Y domain transform pass n of the __iterations passes */
+    void domainTransformPass(cudaTextureObject_t inputFlow, const int n);
+
+    /** runs the median passes, alternating between the X and Y buffers */
+    void medianPasses();
+
 private:
 
     int __iterations;
+    int __support;
+
+    smoothMode_t __mode;
+    float __sigmaSpace;
+    float __sigmaRange;
 
     /** tell if the stage has been configured */
     bool __configured;
@@ -66,9 +151,13 @@ private:
     /** tells if an input flow has been set */
     bool __inputFlowSet;
 
+    /** tells if a guide image has been set */
+    bool __guideImageSet;
+
     // inputs
     flowfilter::gpu::GPUImage __inputFlow;
     flowfilter::gpu::GPUTexture __inputFlowTexture;
+    flowfilter::gpu::GPUImage __guideImage;
 
     /** output of the smoothing in Y (row) direction */
     flowfilter::gpu::GPUImage __smoothedFlow_Y;
@@ -84,6 +173,16 @@ private:
     dim3 __block;
     dim3 __grid;
 
+    // block and grid size of the domain transform kernels,
+    // one thread per row or per column
+    dim3 __blockLine;
+    dim3 __gridRows;
+    dim3 __gridColumns;
+
+    // block and grid size of the median kernels
+    dim3 __blockMedian;
+    dim3 __gridMedian;
+
 };
 
 
@@ -0,0 +1,86 @@
+/**
+ * \file footprint.h
+ * \brief Device memory footprint introspection of pipeline stages.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_GPU_FOOTPRINT_H_
+#define FLOWFILTER_GPU_FOOTPRINT_H_
+
+#include <string>
+#include <vector>
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/gpu/image.h"
+#include "flowfilter/gpu/pipeline.h"
+
+namespace flowfilter {
+namespace gpu {
+
+
+/**
+ * \brief returns the description of a resident device buffer.
+ */
+FLOWFILTER_API bufferInfo_t describeBuffer(const std::string& stage,
+    const int level, const std::string& name,
+    flowfilter::gpu::GPUImage img, const bool persistent = false);
+
+
+/**
+ * \brief returns the description of a buffer allocated only during configure().
+ *
+ * The pitch of the released buffer is not known and is
+ * reported as the packed row size.
+ */
+FLOWFILTER_API bufferInfo_t describeConfigureBuffer(const std::string& stage,
+    const int level, const std::string& name,
+    const int height, const int width, const int depth, const int itemSize);
+
+
+/**
+ * \brief marks as persistent the buffers with the same device pointer as img.
+ */
+FLOWFILTER_API void markPersistent(std::vector<bufferInfo_t>& buffers,
+    flowfilter::gpu::GPUImage img);
+
+
+/**
+ * \brief walks a configured stage and returns its device buffers.
+ *
+ * Buffers shared among stages are reported once, by the first
+ * stage listing them.
+ */
+FLOWFILTER_API std::vector<bufferInfo_t> getMemoryFootprint(Stage& stage);
+
+
+/**
+ * \brief returns the total bytes of a list of buffers.
+ *
+ * \param buffers buffer list.
+ * \param residentOnly if true, buffers released after configure() are not counted.
+ */
+FLOWFILTER_API std::size_t footprintBytes(const std::vector<bufferInfo_t>& buffers,
+    const bool residentOnly = true);
+
+
+/**
+ * \brief exports a buffer list as a JSON document.
+ */
+FLOWFILTER_API std::string footprintToJSON(const std::vector<bufferInfo_t>& buffers);
+
+
+/**
+ * \brief exports a buffer list as a Graphviz digraph.
+ *
+ * Buffers are grouped in clusters by pyramid level and stage.
+ * Persistent buffers are drawn with bold outline and buffers
+ * released after configure() with dashed outline.
+ */
+FLOWFILTER_API std::string footprintToGraphviz(const std::vector<bufferInfo_t>& buffers);
+
+
+}; // namespace gpu
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_GPU_FOOTPRINT_H_
@@ -0,0 +1,124 @@
+/**
+ * \file history.h
+ * \brief Ring buffer of the last flow fields computed by a filter.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_GPU_HISTORY_H_
+#define FLOWFILTER_GPU_HISTORY_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/image.h"
+#include "flowfilter/gpu/image.h"
+
+namespace flowfilter {
+namespace gpu {
+
+
+/**
+ * Quantization steps per pixel of int16 flow slots. Quantized flows
+ * have a resolution of 1/256 pixels and saturate at +-128 pixels.
+ */
+const float FLOWHISTORY_INT16_SCALE = 256.0f;
+
+
+/**
+ * \brief Ring buffer of the last flow fields recorded.
+ *
+ * Holds depth device slots. Each call to record() writes a flow field
+ * into the oldest slot, in float or, quantized, in int16 with
+ * FLOWHISTORY_INT16_SCALE steps per pixel, which halves the memory of
+ * the history. Slots are addressed by age, 0 being the last recorded
+ * flow, and keep the frame number they were recorded at, starting at 1.
+ *
+ * getFlow() returns the slot itself, which should be treated as read
+ * only and stays valid until depth more flows are recorded. The
+ * history is meant to be read from the thread calling record(); use
+ * FlowSnapshotBuffer to read flows from another thread.
+ *
+ * Copies of this object share the same slots.
+ */
+class FLOWFILTER_API FlowHistory {
+
+public:
+    FlowHistory();
+
+    /**
+     * \brief allocates depth flow slots of the given shape.
+     *
+     * \throws std::invalid_argument if depth is less than 1.
+     */
+    FlowHistory(const int height, const int width, const int depth,
+        const bool quantized = false);
+
+public:
+
+    /**
+     * \brief writes flow into the oldest slot.
+     *
+     * The slot gets the next frame number.
+     */
+    void record(flowfilter::gpu::GPUImage& flow);
+
+    /**
+     * \brief forgets all recorded flows. Frame numbers start again at 1.
+     */
+    void clear();
+
+    /**
+     * \brief returns the slot of the given age, float or int16 with depth 2.
+     *
+     * \throws std::invalid_argument if age is not less than size().
+     */
+    flowfilter::gpu::GPUImage getFlow(const int age);
+
+    /**
+     * \brief returns the frame number of the slot of the given age.
+     *
+     * \throws std::invalid_argument if age is not less than size().
+     */
+    std::uint64_t getFrame(const int age) const;
+
+    /**
+     * \brief downloads the slot of the given age.
+     *
+     * flow can be float, quantized slots are then converted
+     * to pixels, or have the item size of the slots.
+     *
+     * \throws std::invalid_argument if age is not less than size().
+     */
+    void downloadFlow(const int age, flowfilter::image_t& flow);
+
+    /** number of slots */
+    int depth() const;
+
+    /** number of slots holding a recorded flow */
+    int size() const;
+
+    /** number of flows recorded so far, the frame number of the last one */
+    std::uint64_t getRecorded() const;
+
+    bool isQuantized() const;
+
+    bool isAllocated() const;
+
+private:
+
+    /** returns the slot index of an age, throws if not recorded */
+    int slotIndex(const std::string& method, const int age) const;
+
+private:
+    struct state_t;
+
+    std::shared_ptr<state_t> __state;
+};
+
+}; // namespace gpu
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_GPU_HISTORY_H_
@@ -42,6 +42,14 @@ struct gpuimage_t {
 };
 
 
+/**
+ * \brief Function releasing a device buffer wrapped by a GPUImage.
+ *
+ * \param context pointer given to the GPUImage constructor.
+ */
+typedef void (*gpuImageRelease_t)(void* context);
+
+
 /*! \brief GPU Image container.
  */
 class FLOWFILTER_API GPUImage {
@@ -51,6 +59,21 @@ public:
     GPUImage(const int height, const int width,
              const int depth = 1, const int itemSize = sizeof(char));
 
+    /**
+     * \brief wraps a pitched device buffer allocated outside the library.
+     *
+     * The buffer is not copied. If release is not null, it is called
+     * with context when the last copy of this image is destroyed.
+     *
+     * \param data device buffer.
+     * \param pitch row pitch in bytes.
+     * \param device CUDA device owning the buffer.
+     */
+    GPUImage(const int height, const int width,
+             const int depth, const int itemSize,
+             void* data, const std::size_t pitch, const int device,
+             gpuImageRelease_t release = nullptr, void* context = nullptr);
+
     ~GPUImage();
 
 public:
@@ -60,6 +83,11 @@ public:
     int pitch() const;
     int itemSize() const;
 
+    /**
+     * \brief returns the CUDA device where the buffer is allocated.
+     */
+    int device() const;
+
     void* data();
 
     template<typename T>
@@ -116,6 +144,7 @@ private:
     std::size_t __depth;        // number of channels
     std::size_t __pitch;        // row pitch in bytes
     std::size_t __itemSize;     // item size in bytes
+    int __device;               // CUDA device of the buffer
     std::shared_ptr<void> __ptr_dev;
 
 private:
@@ -18,6 +18,21 @@
 namespace flowfilter {
 namespace gpu {
 
+/** Maximum window support of the image model */
+const int IMAGE_MODEL_MAX_SUPPORT = 15;
+
+/**
+ * \brief Separable masks of the image model for a given support.
+ *
+ * smooth is the normalized binomial mask of width 2*radius + 1
+ * and diff the derivative mask k*smooth[k], with k in [-radius, radius].
+ */
+typedef struct {
+    int radius;
+    float smooth[IMAGE_MODEL_MAX_SUPPORT];
+    float diff[IMAGE_MODEL_MAX_SUPPORT];
+} imageModelMask_t;
+
 
 class FLOWFILTER_API ImageModel : public Stage {
 
@@ -51,6 +66,26 @@ public:
      */
     void compute();
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
+    /**
+     * \brief sets the window support of the image model.
+     *
+     * The support must be odd, in [3, IMAGE_MODEL_MAX_SUPPORT].
+     * Supports other than 5 run generic kernels reading the
+     * masks as kernel parameters. Defaults to 5.
+     */
+    void setSupport(const int support);
+    int getSupport() const;
+
     //#########################
     // Stage inputs
     //#########################
@@ -70,6 +105,9 @@ private:
     /** tells if an input image has been set */
     bool __inputImageSet;
 
+    int __support;
+    imageModelMask_t __mask;
+
     // inputs
     flowfilter::gpu::GPUImage __inputImage;
     flowfilter::gpu::GPUTexture __inputImageTexture;
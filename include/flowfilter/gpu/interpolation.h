@@ -0,0 +1,174 @@
+/**
+ * \file interpolation.h
+ * \brief Motion compensated frame interpolation.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_GPU_INTERPOLATION_H_
+#define FLOWFILTER_GPU_INTERPOLATION_H_
+
+#include <vector>
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/image.h"
+
+#include "flowfilter/gpu/pipeline.h"
+#include "flowfilter/gpu/image.h"
+
+
+namespace flowfilter {
+namespace gpu {
+
+/**
+ * \brief Warps images by a fraction of an optical flow field.
+ *
+ * The flow field maps the previous frame to the current one. The
+ * output is the frame at time t in [0, 1] between them, t = 0 being
+ * the previous frame and t = 1 the current one. Each output pixel x
+ * is a backward warp of the current image, sampled at x + (1 - t)*flow(x).
+ * With blending enabled, the previous image sampled at x - t*flow(x)
+ * is mixed in with weight (1 - t).
+ *
+ * Images are sampled with bilinear texture filtering and clamped
+ * coordinates, so every output frame costs one pass reading the flow
+ * and one or two texture fetches per pixel.
+ *
+ * The inputs can be the live buffers of a filter, for instance
+ * FlowFilter::getFlow() and FlowFilter::getImageConstant(): the
+ * stage reads them in place and several values of t can be computed
+ * after each filter compute() without any copy.
+ *
+ * Input images are float or uint8 with depth 1. uint8 images are read
+ * normalized, the output image is float in range [0, 1] for them.
+ */
+class FLOWFILTER_API FrameInterpolator : public Stage {
+
+public:
+    FrameInterpolator();
+
+    FrameInterpolator(flowfilter::gpu::GPUImage inputFlow,
+        flowfilter::gpu::GPUImage inputImage);
+
+    FrameInterpolator(flowfilter::gpu::GPUImage inputFlow,
+        flowfilter::gpu::GPUImage inputImage,
+        flowfilter::gpu::GPUImage inputImageOld);
+
+    ~FrameInterpolator();
+
+public:
+
+    /**
+     * \brief configures the stage.
+     *
+     * After configuration, calls to compute()
+     * are valid.
+     * Input buffers should not change after
+     * this method has been called.
+     */
+    void configure();
+
+    /**
+     * \brief computes the interpolated frame at the current time.
+     */
+    void compute();
+
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
+
+    //#########################
+    // Host load-download
+    //#########################
+
+    /**
+     * \brief download the interpolated frame
+     */
+    void downloadInterpolatedImage(flowfilter::image_t& image);
+
+
+    //#########################
+    // Stage inputs
+    //#########################
+    void setInputFlow(flowfilter::gpu::GPUImage inputFlow);
+    void setInputImage(flowfilter::gpu::GPUImage inputImage);
+
+    /**
+     * \brief sets the previous image, required for blending.
+     */
+    void setInputImageOld(flowfilter::gpu::GPUImage inputImageOld);
+
+
+    //#########################
+    // Stage outputs
+    //#########################
+    flowfilter::gpu::GPUImage getInterpolatedImage();
+
+
+    //#########################
+    // Parameters
+    //#########################
+    float getTime() const;
+
+    /**
+     * \brief sets the time of the interpolated frame.
+     *
+     * \throws std::invalid_argument if t is not in [0, 1].
+     */
+    void setTime(const float t);
+
+    bool getBlend() const;
+
+    /**
+     * \brief enables blending with the previous image.
+     *
+     * \throws std::logic_error if enabled without a previous image.
+     */
+    void setBlend(const bool blend);
+
+private:
+
+    /** returns the bilinear texture to sample an input image */
+    static GPUTexture linearTexture(flowfilter::gpu::GPUImage& image);
+
+    /** checks the size and type of an input image */
+    void checkInputImage(const char* method, flowfilter::gpu::GPUImage& image) const;
+
+private:
+    bool __configured;
+    bool __inputFlowSet;
+    bool __inputImageSet;
+    bool __inputImageOldSet;
+
+    float __time;
+    bool __blend;
+
+    // inputs
+    flowfilter::gpu::GPUImage __inputFlow;
+    flowfilter::gpu::GPUImage __inputImage;
+    flowfilter::gpu::GPUImage __inputImageOld;
+
+    flowfilter::gpu::GPUTexture __inputImageTexture;
+    flowfilter::gpu::GPUTexture __inputImageOldTexture;
+
+    // outputs
+    flowfilter::gpu::GPUImage __interpolatedImage;
+
+    dim3 __block;
+    dim3 __grid;
+};
+
+}; // namespace gpu
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_GPU_INTERPOLATION_H_
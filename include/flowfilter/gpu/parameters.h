@@ -0,0 +1,143 @@
+/**
+ * \file parameters.h
+ * \brief Filter parameter blocks updated from a control thread.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_GPU_PARAMETERS_H_
+#define FLOWFILTER_GPU_PARAMETERS_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "flowfilter/osconfig.h"
+
+namespace flowfilter {
+namespace gpu {
+
+/** Maximum number of pyramid levels of a parameter block */
+const int PARAMETERS_MAX_LEVELS = 16;
+
+
+/**
+ * \brief Filter parameters submitted from a control thread.
+ *
+ * Only the fields whose bit is set in the change masks
+ * are applied to the filter.
+ */
+typedef struct {
+
+    /** bit h set if gamma[h] has been submitted */
+    std::uint32_t gammaMask;
+
+    /** bit h set if smoothIterations[h] has been submitted */
+    std::uint32_t smoothIterationsMask;
+
+    /** true if maxflow has been submitted */
+    bool maxflowSet;
+
+    float gamma[PARAMETERS_MAX_LEVELS];
+    int smoothIterations[PARAMETERS_MAX_LEVELS];
+    float maxflow;
+} filterParameters_t;
+
+
+/**
+ * \brief Lock-free parameter block shared between a control
+ *      thread and the thread running the filter.
+ *
+ * The control thread edits its own copy of the parameters and
+ * publishes it with submit(), an atomic exchange. The filter picks
+ * up the latest published block at the start of compute(), so a
+ * frame never sees a partially updated set of parameters and
+ * neither thread waits for the other. There is a single control thread.
+ * Values are validated when submitted, applying them in compute()
+ * does not throw.
+ *
+ * Changes accumulate: a published block carries every value
+ * submitted so far, so blocks replaced before the filter picked
+ * them up are not lost.
+ *
+ * Copies of this object share the same block.
+ */
+class FLOWFILTER_API ParameterBuffer {
+
+public:
+    ParameterBuffer();
+
+    /**
+     * \brief creates a parameter block for a filter with the given levels.
+     */
+    ParameterBuffer(const int levels);
+
+public:
+
+    //#########################
+    // Control thread
+    //#########################
+
+    /**
+     * \brief sets the gamma of a level in the next submitted block.
+     *
+     * \throws std::invalid_argument if the level is out of
+     *      range or gamma is not greater than zero.
+     */
+    void setGamma(const int level, const float gamma);
+
+    /**
+     * \brief sets the smoothing iterations of a level in the next submitted block.
+     *
+     * \throws std::invalid_argument if the level is out of
+     *      range or N is not greater than zero.
+     */
+    void setSmoothIterations(const int level, const int N);
+
+    /**
+     * \brief sets the maximum flow in the next submitted block.
+     *
+     * The maximum flow also sets the propagation iterations of each level.
+     *
+     * \throws std::invalid_argument if maxflow is not greater than zero.
+     */
+    void setMaxFlow(const float maxflow);
+
+    /**
+     * \brief publishes the parameters set so far.
+     *
+     * The filter applies all of them at the start of the same compute().
+     */
+    void submit();
+
+    /**
+     * \brief returns the parameters set so far.
+     */
+    filterParameters_t getSubmitted() const;
+
+    int levels() const;
+
+
+    //#########################
+    // Filter thread
+    //#########################
+
+    /**
+     * \brief takes the latest published block.
+     *
+     * \return true if a block was published since the last call,
+     *      in which case params holds it.
+     */
+    bool consume(filterParameters_t& params);
+
+private:
+    struct state_t;
+
+    void checkLevel(const char* method, const int level) const;
+
+    std::shared_ptr<state_t> __state;
+};
+
+}; // namespace gpu
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_GPU_PARAMETERS_H_
@@ -9,6 +9,8 @@
 #define FLOWFILTER_GPU_PIPELINE_H_
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <cuda.h>
 #include <cuda_runtime.h>
@@ -18,6 +20,95 @@
 namespace flowfilter {
 namespace gpu {
 
+/**
+ * \brief Theoretical memory traffic of a pipeline stage.
+ *
+ * Byte counts correspond to the compulsory traffic of one
+ * call to compute(), that is, each buffer element read or
+ * written by a kernel is counted once per kernel call.
+ */
+typedef struct {
+
+    /** bytes read from device memory */
+    std::size_t bytesRead;
+
+    /** bytes written to device memory */
+    std::size_t bytesWritten;
+} memoryTraffic_t;
+
+
+/**
+ * \brief accumulates memory traffic b into a.
+ */
+inline memoryTraffic_t& operator+=(memoryTraffic_t& a, const memoryTraffic_t& b) {
+    a.bytesRead += b.bytesRead;
+    a.bytesWritten += b.bytesWritten;
+    return a;
+}
+
+
+/**
+ * \brief Runtime and memory traffic record of a stage.
+ *
+ * Composite stages, such as filters, report one record
+ * for each of their inner stages.
+ */
+typedef struct {
+
+    /** stage name */
+    std::string name;
+
+    /** pyramid level the stage belongs to */
+    int level;
+
+    /** elapsed time in milliseconds of last compute() call */
+    float elapsedTime;
+
+    /** theoretical memory traffic of one compute() call */
+    memoryTraffic_t traffic;
+} stageProfile_t;
+
+
+/**
+ * \brief Description of a device buffer owned by a stage.
+ *
+ * Persistent buffers hold state carried from one call
+ * to compute() to the next, for instance the old image or
+ * the flow fed back to the propagator. Transient buffers
+ * are rewritten in every call and could be reused by other
+ * stages. Non resident buffers are only allocated during
+ * configure() and released afterwards.
+ */
+typedef struct {
+
+    /** name of the stage owning the buffer */
+    std::string stage;
+
+    /** pyramid level the stage belongs to */
+    int level;
+
+    /** buffer name within the stage */
+    std::string name;
+
+    int height;
+    int width;
+    int depth;
+    int itemSize;
+
+    /** row pitch in bytes */
+    int pitch;
+
+    /** allocated bytes, pitch * height */
+    std::size_t bytes;
+
+    bool persistent;
+    bool resident;
+
+    /** device pointer, used to identify buffers shared among stages */
+    const void* data;
+} bufferInfo_t;
+
+
 /**
  * \brief Abstract class
  *
@@ -64,6 +155,34 @@ public:
      */
     float elapsedTime() const;
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     *
+     * The default implementation returns zero traffic. Stages
+     * override this method according to the shape of their
+     * buffers and their iteration counts.
+     */
+    virtual memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief returns the achieved bandwidth in GB/s of last compute() call
+     *
+     * The bandwidth is computed as memoryTraffic() divided
+     * by elapsedTime().
+     */
+    float achievedBandwidth() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     *
+     * The default implementation appends nothing. Input buffers
+     * are owned by the stage producing them and are not reported.
+     *
+     * \param buffers output vector.
+     * \param level pyramid level reported in the records.
+     */
+    virtual void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
 
 protected:
     /** CUDA stream to which this stage belongs */
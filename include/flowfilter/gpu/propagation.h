@@ -46,10 +46,31 @@ public:
      */
     void compute();
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
     void setIterations(const int N);
     int getIterations() const;
     float getDt() const;
 
+    /**
+     * \brief sets the number of frame intervals the flow is propagated.
+     *
+     * The iterations split the time step, dt = timeStep / N. For a
+     * stable propagation N should be at least maxflow * timeStep.
+     *
+     * \throws std::invalid_argument if timeStep is not greater than zero.
+     */
+    void setTimeStep(const float timeStep);
+    float getTimeStep() const;
+
     void setBorder(const int border);
     int getBorder() const;
 
@@ -71,6 +92,7 @@ private:
 
     int __iterations;
     float __dt;
+    float __timeStep;
     int __border;
 
     /** tell if the stage has been configured */
@@ -136,10 +158,31 @@ public:
      */
     void compute();
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
     void setIterations(const int N);
     int getIterations() const;
     float getDt() const;
 
+    /**
+     * \brief sets the number of frame intervals the flow is propagated.
+     *
+     * The iterations split the time step, dt = timeStep / N. For a
+     * stable propagation N should be at least maxflow * timeStep.
+     *
+     * \throws std::invalid_argument if timeStep is not greater than zero.
+     */
+    void setTimeStep(const float timeStep);
+    float getTimeStep() const;
+
     void setBorder(const int border);
     int getBorder() const;
 
@@ -162,6 +205,7 @@ private:
 
     int __iterations;
     float __dt;
+    float __timeStep;
     int __border;
 
     /** tell if the stage has been configured */
@@ -239,6 +283,16 @@ public:
      */
     void compute();
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
     //#########################
     // Parameters
     //#########################
@@ -47,6 +47,16 @@ public:
      */
     void compute();
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
 
 
     //#########################
@@ -88,6 +98,93 @@ private:
 };
 
 
+/**
+ * \brief Adds the rotational optical flow of a camera to a flow field.
+ *
+ * Used to restore the total flow from the residual flow estimated
+ * on derotated images. The rotational flow is computed in the same
+ * pass, so the stage reads the input flow and writes the output once.
+ */
+class FLOWFILTER_API RotationalFlowAdder : public Stage {
+
+public:
+    RotationalFlowAdder();
+    RotationalFlowAdder(perspectiveCamera cam,
+        flowfilter::gpu::GPUImage inputFlow);
+    ~RotationalFlowAdder();
+
+public:
+    /**
+     * \brief configures the stage.
+     *
+     * After configuration, calls to compute()
+     * are valid.
+     * Input buffers should not change after
+     * this method has been called.
+     */
+    void configure();
+
+    /**
+     * \brief perform computation
+     */
+    void compute();
+
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
+
+    //#########################
+    // Stage inputs
+    //#########################
+    void setInputFlow(flowfilter::gpu::GPUImage inputFlow);
+
+
+    //#########################
+    // Stage outputs
+    //#########################
+    flowfilter::gpu::GPUImage getFlow();
+
+
+    //#########################
+    // Parameters
+    //#########################
+    void setCamera(perspectiveCamera cam);
+    void setAngularVelocity(const float wx, const float wy, const float wz);
+
+
+private:
+    bool __configured;
+    bool __inputFlowSet;
+
+    perspectiveCamera __camera;
+    float3 __angularVelocity;
+
+    flowfilter::gpu::GPUImage __inputFlow;
+    flowfilter::gpu::GPUImage __flow;
+
+    dim3 __grid;
+    dim3 __block;
+};
+
+
+/**
+ * \brief returns the largest rotational flow magnitude over an image.
+ *
+ * The flow is evaluated at the corners, the side midpoints and the
+ * center of the image, where its magnitude peaks for the rotation
+ * rates seen between consecutive frames.
+ */
+FLOWFILTER_API float maxRotationalFlow(const perspectiveCamera& cam,
+    const float3& w, const int height, const int width);
+
+
 } // namespace gpu
 } // namespace flowfilter
 
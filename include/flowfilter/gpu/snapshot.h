@@ -0,0 +1,99 @@
+/**
+ * \file snapshot.h
+ * \brief Triple buffer of flow snapshots shared with reader threads.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_GPU_SNAPSHOT_H_
+#define FLOWFILTER_GPU_SNAPSHOT_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/image.h"
+#include "flowfilter/gpu/image.h"
+
+namespace flowfilter {
+namespace gpu {
+
+
+/**
+ * \brief Lock-free triple buffer of optical flow snapshots.
+ *
+ * One writer thread, the one running compute(), publishes completed
+ * flow fields and one reader thread acquires the most recent of them.
+ * The writer owns a back slot, the reader a front slot, and the third
+ * slot holds the latest published snapshot. Publishing and acquiring
+ * swap slots with an atomic exchange, so neither side ever waits for
+ * the other and the front slot is never written while the reader
+ * holds it.
+ *
+ * Copies of this object share the same slots.
+ */
+class FLOWFILTER_API FlowSnapshotBuffer {
+
+public:
+    FlowSnapshotBuffer();
+
+    /**
+     * \brief allocates three float flow slots of the given shape.
+     */
+    FlowSnapshotBuffer(const int height, const int width);
+
+public:
+
+    /**
+     * \brief copies flow into the back slot and publishes it.
+     *
+     * Called from the writer thread. The snapshot receives the
+     * next sequence number, starting at 1.
+     */
+    void publish(flowfilter::gpu::GPUImage& flow);
+
+    /**
+     * \brief makes the latest published snapshot the front slot.
+     *
+     * Called from the reader thread.
+     *
+     * \return true if a snapshot newer than the previous
+     *      front slot was acquired.
+     */
+    bool acquire();
+
+    /**
+     * \brief returns the front slot.
+     *
+     * Valid until the next call to acquire() from the reader thread.
+     */
+    flowfilter::gpu::GPUImage getFlow();
+
+    /**
+     * \brief downloads the front slot.
+     */
+    void downloadFlow(flowfilter::image_t& flow);
+
+    /**
+     * \brief returns the sequence number of the front slot,
+     *      0 if no snapshot has been acquired.
+     */
+    std::uint64_t getSequence() const;
+
+    /**
+     * \brief returns the sequence number of the last published snapshot.
+     */
+    std::uint64_t getPublished() const;
+
+    bool isAllocated() const;
+
+private:
+    struct state_t;
+
+    std::shared_ptr<state_t> __state;
+};
+
+}; // namespace gpu
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_GPU_SNAPSHOT_H_
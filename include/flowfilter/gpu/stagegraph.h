@@ -0,0 +1,261 @@
+/**
+ * \file stagegraph.h
+ * \brief Declarative assembly of pipeline stages.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_GPU_STAGEGRAPH_H_
+#define FLOWFILTER_GPU_STAGEGRAPH_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/gpu/image.h"
+#include "flowfilter/gpu/pipeline.h"
+
+namespace flowfilter {
+namespace gpu {
+
+
+/**
+ * \brief Type of the buffers accepted or produced by a port.
+ */
+typedef struct {
+    int height;
+    int width;
+    int depth;
+    int itemSize;
+} portType_t;
+
+
+/**
+ * \brief Buffer allocated to configure a node before the
+ *      producer of one of its inputs is configured.
+ */
+typedef struct {
+
+    /** consumer input, "Node.port" */
+    std::string input;
+
+    portType_t type;
+} placeholder_t;
+
+
+/**
+ * \brief Execution plan of a StageGraph.
+ *
+ * Nodes are referred to by the index returned by
+ * StageGraph::addNode().
+ */
+typedef struct {
+
+    /** node names */
+    std::vector<std::string> names;
+
+    /** true for the nodes some required output depends on */
+    std::vector<bool> live;
+
+    /** live nodes in execution order */
+    std::vector<int> order;
+
+    /**
+     * live nodes grouped by dependency depth. Nodes of
+     * a wave only depend on nodes of previous waves and
+     * can run concurrently.
+     */
+    std::vector<std::vector<int>> waves;
+
+    /** live nodes in configuration order */
+    std::vector<int> configureOrder;
+
+    /** buffers allocated only during StageGraph::configure() */
+    std::vector<placeholder_t> placeholders;
+} stagePlan_t;
+
+
+/**
+ * \brief Graph of stages connected through typed ports.
+ *
+ * Each node wraps a Stage. Input ports set a stage input,
+ * output ports read a buffer of a configured stage. Ports
+ * are addressed as "Node.port".
+ *
+ * Edges are either regular, the consumer reads the value
+ * produced in the same call to compute(), or loop carried,
+ * the consumer reads the value produced in the previous
+ * call. Regular edges define the execution order and
+ * must not form cycles.
+ *
+ * Only the nodes some required output depends on are
+ * configured and scheduled.
+ *
+ * Stages usually allocate their outputs in configure(), so
+ * a cycle closed by a loop carried edge cannot be configured
+ * in dependency order. It is broken at a rebindable input,
+ * that is, an input the stage reads directly from the buffer
+ * in compute() and can be set after configure(). The consumer
+ * is configured on a placeholder buffer of the port type,
+ * and the input is set to the producer output once all nodes
+ * are configured.
+ *
+ * The graph holds raw pointers to the stages and is meant
+ * to be used while configuring their owner. The returned
+ * stagePlan_t refers to nodes by index and can be stored.
+ */
+class FLOWFILTER_API StageGraph {
+
+public:
+    typedef std::function<void(flowfilter::gpu::GPUImage)> inputBinder_t;
+    typedef std::function<flowfilter::gpu::GPUImage()> outputGetter_t;
+
+public:
+    StageGraph();
+    ~StageGraph();
+
+public:
+
+    /**
+     * \brief adds a node and returns its index.
+     *
+     * \param configured true if the stage is already configured.
+     *      Such nodes only produce outputs, they have no inputs
+     *      and configure() leaves them untouched.
+     *
+     * \throws std::invalid_argument if the name is already used
+     *      or contains a dot.
+     */
+    int addNode(const std::string& name, flowfilter::gpu::Stage* stage,
+        const bool configured = false);
+
+    /**
+     * \brief declares an input port of a node.
+     *
+     * \param bind sets the stage input.
+     * \param rebindable true if the input can be set after
+     *      configuring the stage.
+     *
+     * \throws std::invalid_argument if the node is already configured.
+     */
+    void addInput(const std::string& node, const std::string& port,
+        const portType_t& type, inputBinder_t bind, const bool rebindable = false);
+
+    /**
+     * \brief declares an output port of a node.
+     *
+     * \param get returns the output buffer of the configured stage.
+     */
+    void addOutput(const std::string& node, const std::string& port,
+        const portType_t& type, outputGetter_t get);
+
+    /**
+     * \brief connects an output to an input within the same call to compute().
+     */
+    void connect(const std::string& output, const std::string& input);
+
+    /**
+     * \brief connects an output to an input of the next call to compute().
+     */
+    void connectLoop(const std::string& output, const std::string& input);
+
+    /**
+     * \brief connects a buffer owned outside the graph to an input.
+     */
+    void feed(flowfilter::gpu::GPUImage image, const std::string& input);
+
+    /**
+     * \brief marks an output as consumed outside the graph.
+     */
+    void require(const std::string& output);
+
+    /**
+     * \brief returns the execution plan of the graph.
+     *
+     * \throws std::logic_error if no output is required, an input
+     *      of a live node is not connected or the regular edges
+     *      form a cycle.
+     */
+    stagePlan_t plan() const;
+
+    /**
+     * \brief wires and configures the live nodes not configured
+     *      when added.
+     *
+     * \return the execution plan.
+     * \throws std::logic_error if a cycle cannot be broken at a
+     *      rebindable input or an output does not match its type.
+     */
+    stagePlan_t configure();
+
+private:
+
+    struct port_t {
+        std::string name;
+        portType_t type;
+        inputBinder_t bind;
+        outputGetter_t get;
+        bool rebindable;
+
+        /** edge connected to an input port, -1 if none */
+        int edge;
+    };
+
+    struct edge_t {
+
+        /** producer node and output port, -1 for fed buffers */
+        int fromNode;
+        int fromPort;
+
+        int toNode;
+        int toPort;
+
+        bool loop;
+
+        /** buffer fed from outside the graph */
+        flowfilter::gpu::GPUImage image;
+    };
+
+    struct node_t {
+        std::string name;
+        flowfilter::gpu::Stage* stage;
+        bool configured;
+        std::vector<port_t> inputs;
+        std::vector<port_t> outputs;
+    };
+
+private:
+
+    int findNode(const std::string& name) const;
+    void findPort(const std::string& address, const bool input,
+        int& node, int& port) const;
+    void addEdge(const std::string& output, const std::string& input, const bool loop);
+    void connectInput(const int node, const int port, const int edge);
+
+    /** returns the edges deferred to break cycles, fills plan.configureOrder */
+    std::vector<int> planConfiguration(stagePlan_t& plan) const;
+
+    /** returns the output of an edge after checking it against the port type */
+    flowfilter::gpu::GPUImage edgeOutput(const int edge);
+
+private:
+    std::vector<node_t> __nodes;
+    std::vector<edge_t> __edges;
+
+    /** required outputs, node and port indices */
+    std::vector<std::pair<int, int>> __required;
+};
+
+
+/**
+ * \brief appends the description of the placeholders of a plan.
+ */
+FLOWFILTER_API void appendPlaceholders(std::vector<bufferInfo_t>& buffers,
+    const stagePlan_t& plan, const std::string& stage, const int level);
+
+
+}; // namespace gpu
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_GPU_STAGEGRAPH_H_
@@ -18,6 +18,25 @@
 namespace flowfilter {
 namespace gpu {
 
+/**
+ * \brief Summary of the brightness constancy residual over a frame.
+ *
+ * The residual at each pixel is |It + grad(I) . flow|, with It
+ * the temporal derivative of the image. Percentiles are resolved
+ * from a histogram with bins spanning [0, residualRange], residuals
+ * beyond the range are counted in the last bin.
+ */
+typedef struct {
+    float mean;
+    float p50;
+    float p90;
+    float p99;
+
+    /** fraction of pixels with residual at or beyond residualRange */
+    float saturated;
+} residualStats_t;
+
+
 class FLOWFILTER_API FlowUpdate : public Stage {
 
 
@@ -47,12 +66,56 @@ public:
      */
     void compute();
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
     float getGamma() const;
     void setGamma(const float gamma);
 
     float getMaxFlow() const;
     void setMaxFlow(const float maxflow);
 
+    /**
+     * \brief sets the number of frame intervals between the old and new images.
+     *
+     * The temporal derivative is divided by the time step, so the
+     * flow stays in pixels per frame interval when frames are dropped.
+     *
+     * \throws std::invalid_argument if timeStep is not greater than zero.
+     */
+    void setTimeStep(const float timeStep);
+    float getTimeStep() const;
+
+    //#########################
+    // Brightness constancy residual
+    //#########################
+
+    /**
+     * \brief enables the residual histogram in the update kernel.
+     */
+    void setComputeResidual(const bool computeResidual);
+    bool getComputeResidual() const;
+
+    /**
+     * \brief sets the upper limit of the residual histogram, in image intensity units.
+     */
+    void setResidualRange(const float residualRange);
+    float getResidualRange() const;
+
+    /**
+     * \brief returns the residual statistics of last call to compute().
+     *
+     * This method synchronizes with the device.
+     */
+    residualStats_t getResidualStats();
+
     //#########################
     // Stage inputs
     //#########################
@@ -70,6 +133,7 @@ public:
 private:
     float __gamma;
     float __maxflow;
+    float __timeStep;
 
     bool __configured;
     bool __inputFlowSet;
@@ -83,6 +147,11 @@ private:
     flowfilter::gpu::GPUImage __flowUpdated;
     flowfilter::gpu::GPUImage __imageUpdated;
 
+    bool __computeResidual;
+    float __residualRange;
+    flowfilter::gpu::GPUImage __residualHistogram;
+    flowfilter::gpu::GPUImage __residualSum;
+
 
     dim3 __block;
     dim3 __grid;
@@ -120,12 +189,56 @@ public:
      */
     void compute();
 
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
     float getGamma() const;
     void setGamma(const float gamma);
 
     float getMaxFlow() const;
     void setMaxFlow(const float maxflow);
 
+    /**
+     * \brief sets the number of frame intervals between the old and new images.
+     *
+     * The temporal derivative is divided by the time step, so the
+     * flow stays in pixels per frame interval when frames are dropped.
+     *
+     * \throws std::invalid_argument if timeStep is not greater than zero.
+     */
+    void setTimeStep(const float timeStep);
+    float getTimeStep() const;
+
+    //#########################
+    // Brightness constancy residual
+    //#########################
+
+    /**
+     * \brief enables the residual histogram in the update kernel.
+     */
+    void setComputeResidual(const bool computeResidual);
+    bool getComputeResidual() const;
+
+    /**
+     * \brief sets the upper limit of the residual histogram, in image intensity units.
+     */
+    void setResidualRange(const float residualRange);
+    float getResidualRange() const;
+
+    /**
+     * \brief returns the residual statistics of last call to compute().
+     *
+     * This method synchronizes with the device.
+     */
+    residualStats_t getResidualStats();
+
     //#########################
     // Stage inputs
     //#########################
@@ -146,6 +259,7 @@ public:
 private:
     float __gamma;
     float __maxflow;
+    float __timeStep;
 
     bool __configured;
     bool __inputDeltaFlowSet;
@@ -166,6 +280,11 @@ private:
     flowfilter::gpu::GPUImage __deltaFlowUpdated;
     flowfilter::gpu::GPUImage __imageUpdated;
 
+    bool __computeResidual;
+    float __residualRange;
+    flowfilter::gpu::GPUImage __residualHistogram;
+    flowfilter::gpu::GPUImage __residualSum;
+
 
     dim3 __block;
     dim3 __grid;
@@ -0,0 +1,145 @@
+/**
+ * \file upsampling.h
+ * \brief Guided upsampling of optical flow fields.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_GPU_UPSAMPLING_H_
+#define FLOWFILTER_GPU_UPSAMPLING_H_
+
+#include <vector>
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/image.h"
+
+#include "flowfilter/gpu/pipeline.h"
+#include "flowfilter/gpu/image.h"
+
+
+namespace flowfilter {
+namespace gpu {
+
+/**
+ * \brief Upsamples a flow field with joint bilateral filtering.
+ *
+ * The input flow is estimated at a coarse resolution. Each pixel of
+ * the output, at the resolution of the guide image, averages the 3x3
+ * nearest input flow pixels. Weights combine a Gaussian of the
+ * spatial distance, in input flow pixels, and a Gaussian of the
+ * difference between the guide at the output pixel and the coarse
+ * guide at the input pixel, so that motion boundaries follow the
+ * image edges. The flow is scaled to output pixels in the same pass.
+ *
+ * Guides are uint8 images with depth 1, read in range [0, 1]. The
+ * coarse guide has the size of the input flow, typically the image
+ * pyramid level at which the flow is estimated.
+ */
+class FLOWFILTER_API JointBilateralUpsampler : public Stage {
+
+public:
+    JointBilateralUpsampler();
+
+    JointBilateralUpsampler(flowfilter::gpu::GPUImage inputFlow,
+        flowfilter::gpu::GPUImage guideCoarse,
+        flowfilter::gpu::GPUImage guide);
+
+    ~JointBilateralUpsampler();
+
+public:
+
+    /**
+     * \brief configures the stage.
+     *
+     * After configuration, calls to compute()
+     * are valid.
+     * Input buffers should not change after
+     * this method has been called.
+     */
+    void configure();
+
+    /**
+     * \brief computes the upsampled flow.
+     */
+    void compute();
+
+    /**
+     * \brief returns the theoretical memory traffic of one call to compute()
+     */
+    memoryTraffic_t memoryTraffic() const;
+
+    /**
+     * \brief appends the description of the device buffers owned by this stage
+     */
+    void appendBuffers(std::vector<bufferInfo_t>& buffers, const int level);
+
+
+    //#########################
+    // Stage inputs
+    //#########################
+    void setInputFlow(flowfilter::gpu::GPUImage inputFlow);
+    void setGuideCoarse(flowfilter::gpu::GPUImage guideCoarse);
+    void setGuide(flowfilter::gpu::GPUImage guide);
+
+
+    //#########################
+    // Stage outputs
+    //#########################
+    flowfilter::gpu::GPUImage getUpsampledFlow();
+
+
+    //#########################
+    // Parameters
+    //#########################
+
+    /**
+     * \brief sets the spatial standard deviation, in input
+     *      flow pixels. Defaults to 1.
+     *
+     * \throws std::invalid_argument if sigma is not greater than zero.
+     */
+    float getSigmaSpace() const;
+    void setSigmaSpace(const float sigma);
+
+    /**
+     * \brief sets the range standard deviation, in guide
+     *      units. Defaults to 0.1.
+     *
+     * \throws std::invalid_argument if sigma is not greater than zero.
+     */
+    float getSigmaRange() const;
+    void setSigmaRange(const float sigma);
+
+private:
+
+    /** checks the type of a guide image */
+    void checkGuide(const char* method, flowfilter::gpu::GPUImage& guide) const;
+
+private:
+    bool __configured;
+    bool __inputFlowSet;
+    bool __guideCoarseSet;
+    bool __guideSet;
+
+    float __sigmaSpace;
+    float __sigmaRange;
+
+    // inputs
+    flowfilter::gpu::GPUImage __inputFlow;
+    flowfilter::gpu::GPUImage __guideCoarse;
+    flowfilter::gpu::GPUImage __guide;
+
+    // outputs
+    flowfilter::gpu::GPUImage __upsampledFlow;
+
+    dim3 __block;
+    dim3 __grid;
+};
+
+}; // namespace gpu
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_GPU_UPSAMPLING_H_
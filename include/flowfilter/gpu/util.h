@@ -23,6 +23,23 @@ FLOWFILTER_API void configureKernelGrid(const int height, const int width,
     const dim3 block, dim3& grid);
 
 
+/**
+ * \brief Measures the device memory copy bandwidth in GB/s.
+ *
+ * The measurement follows the STREAM copy benchmark: a float image
+ * of shape [height, width] is copied device to device repetitions
+ * times and the bandwidth is computed from the bytes read and
+ * written by the copies. The returned value is a practical peak
+ * against which the achieved bandwidth of the stages can be compared.
+ *
+ * \param height image height in pixels.
+ * \param width image width in pixels.
+ * \param repetitions number of timed copies.
+ */
+FLOWFILTER_API float measurePeakBandwidth(const int height = 2048,
+    const int width = 2048, const int repetitions = 20);
+
+
 }; // namespace gpu
 }; // namespace flowfilter
 
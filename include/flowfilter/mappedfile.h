@@ -0,0 +1,62 @@
+/**
+ * \file mappedfile.h
+ * \brief Read only memory mapped files.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_MAPPEDFILE_H_
+#define FLOWFILTER_MAPPEDFILE_H_
+
+#include <cstddef>
+#include <string>
+
+#include "flowfilter/osconfig.h"
+
+namespace flowfilter {
+
+
+/**
+ * \brief Maps a whole file in read only mode.
+ *
+ * The mapping is released when the object is destroyed.
+ */
+class FLOWFILTER_API MappedFile {
+
+public:
+
+    /**
+     * \brief maps the file at path.
+     *
+     * \throws std::runtime_error if the file cannot be opened or mapped.
+     */
+    MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+
+    /**
+     * \brief returns a pointer to the first byte of the file.
+     */
+    const void* data() const;
+
+    /**
+     * \brief returns the file size in bytes.
+     */
+    std::size_t size() const;
+
+    std::string path() const;
+
+private:
+    std::string __path;
+    int __fd;
+    const void* __data;
+    std::size_t __size;
+};
+
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_MAPPEDFILE_H_
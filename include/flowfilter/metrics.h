@@ -0,0 +1,264 @@
+/**
+ * \file metrics.h
+ * \brief Live metrics export through a shared memory page.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_METRICS_H_
+#define FLOWFILTER_METRICS_H_
+
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/image.h"
+
+namespace flowfilter {
+
+/** Magic number at the start of a metrics page, "FFMT" */
+const std::uint32_t METRICS_MAGIC = 0x544D4646;
+
+/** Layout version of the metrics page */
+const std::uint32_t METRICS_VERSION = 1;
+
+const int METRICS_MAX_STAGES = 32;
+const int METRICS_MAX_QUEUES = 8;
+const int METRICS_NAME_LENGTH = 32;
+
+
+/**
+ * \brief Latency percentiles of a stage, in milliseconds.
+ */
+typedef struct {
+
+    char name[METRICS_NAME_LENGTH];
+    std::int32_t level;
+
+    /** number of samples the percentiles are computed from */
+    std::uint32_t samples;
+
+    float mean;
+    float p50;
+    float p90;
+    float p99;
+    float max;
+} stageMetrics_t;
+
+
+/**
+ * \brief Depth and drop count of a queue.
+ */
+typedef struct {
+
+    char name[METRICS_NAME_LENGTH];
+    std::uint32_t depth;
+    std::uint32_t capacity;
+    std::uint64_t drops;
+} queueMetrics_t;
+
+
+/**
+ * \brief Summary statistics of an optical flow field, in pixels.
+ */
+typedef struct {
+    float meanX;
+    float meanY;
+    float meanMagnitude;
+    float maxMagnitude;
+} flowStatistics_t;
+
+
+/**
+ * \brief Content of a metrics page.
+ *
+ * The structure is plain old data, readers
+ * copy it out of the shared page as a whole.
+ */
+typedef struct {
+
+    /** number of times the page has been published */
+    std::uint64_t publishCount;
+
+    /** publish time, nanoseconds since epoch */
+    std::uint64_t timestamp;
+
+    /** frames recorded since the publisher was created */
+    std::uint64_t frameCount;
+
+    /** frame rate over the last publish interval */
+    float frameRate;
+
+    std::uint32_t stageCount;
+    stageMetrics_t stages[METRICS_MAX_STAGES];
+
+    std::uint32_t queueCount;
+    queueMetrics_t queues[METRICS_MAX_QUEUES];
+
+    flowStatistics_t flow;
+} metrics_t;
+
+
+/**
+ * \brief Publishes metrics into a POSIX shared memory page.
+ *
+ * Recording methods are cheap and meant to be called from the
+ * processing loop; they only store samples in host memory.
+ * publish() writes the page at most publishRate times per
+ * second. The page is protected by a sequence lock, so readers
+ * in other processes never block the publisher.
+ *
+ * Objects of this class are not thread safe, all methods
+ * should be called from the same thread.
+ */
+class FLOWFILTER_API MetricsPublisher {
+
+public:
+
+    /**
+     * \brief creates the shared memory page.
+     *
+     * \param name shared memory object name, starting with '/'.
+     * \param publishRate maximum publish rate in Hz.
+     * \param latencySamples number of latency samples kept per stage.
+     */
+    MetricsPublisher(const std::string& name = "/flowfilter_metrics",
+        const float publishRate = 10.0f,
+        const int latencySamples = 256);
+
+    /**
+     * \brief unmaps and unlinks the shared memory page.
+     */
+    ~MetricsPublisher();
+
+    MetricsPublisher(const MetricsPublisher&) = delete;
+    MetricsPublisher& operator=(const MetricsPublisher&) = delete;
+
+
+public:
+
+    /**
+     * \brief records the completion of a frame.
+     */
+    void recordFrame();
+
+    /**
+     * \brief records a latency sample of a stage, in milliseconds.
+     */
+    void recordStageLatency(const std::string& stage, const int level,
+        const float latency);
+
+    /**
+     * \brief sets the current state of a queue.
+     */
+    void setQueue(const std::string& name, const int depth,
+        const int capacity, const std::uint64_t drops);
+
+    /**
+     * \brief sets the flow statistics of the last frame.
+     */
+    void setFlowStatistics(const flowStatistics_t& stats);
+
+    /**
+     * \brief returns true if the publish interval has elapsed.
+     *
+     * Callers can use this method to compute expensive
+     * metrics, such as flow statistics, only when needed.
+     */
+    bool publishDue() const;
+
+    /**
+     * \brief writes the page if the publish interval has elapsed.
+     *
+     * \return true if the page was written.
+     */
+    bool publish();
+
+    /**
+     * \brief writes the page regardless of the publish rate.
+     */
+    void publishNow();
+
+    std::string getName() const;
+
+    float getPublishRate() const;
+    void setPublishRate(const float publishRate);
+
+
+private:
+
+    typedef struct {
+        std::string name;
+        int level;
+        std::vector<float> samples;
+        std::size_t next;
+        std::size_t count;
+    } latencyRing_t;
+
+    std::string __name;
+    int __fd;
+    void* __page;
+
+    float __publishRate;
+    int __latencySamples;
+
+    std::chrono::steady_clock::time_point __lastPublish;
+    std::uint64_t __frameCount;
+    std::uint64_t __lastFrameCount;
+
+    std::vector<latencyRing_t> __stages;
+    std::vector<queueMetrics_t> __queues;
+    flowStatistics_t __flowStats;
+
+    metrics_t __metrics;
+
+    /** scratch buffer for percentile computation */
+    std::vector<float> __sortBuffer;
+};
+
+
+/**
+ * \brief Reads a metrics page published by another process.
+ */
+class FLOWFILTER_API MetricsReader {
+
+public:
+
+    /**
+     * \brief maps an existing shared memory page in read only mode.
+     */
+    MetricsReader(const std::string& name = "/flowfilter_metrics");
+    ~MetricsReader();
+
+    MetricsReader(const MetricsReader&) = delete;
+    MetricsReader& operator=(const MetricsReader&) = delete;
+
+    /**
+     * \brief copies a consistent snapshot of the page into metrics.
+     *
+     * \param retries number of attempts if a write is in progress.
+     * \return true if a consistent snapshot was read.
+     */
+    bool read(metrics_t& metrics, const int retries = 1000) const;
+
+private:
+    std::string __name;
+    int __fd;
+    const void* __page;
+};
+
+
+/**
+ * \brief computes summary statistics of a host flow field.
+ *
+ * \param flow float image with depth 2.
+ * \param stride pixel stride in rows and columns.
+ */
+FLOWFILTER_API flowStatistics_t computeFlowStatistics(const flowfilter::image_t& flow,
+    const int stride = 4);
+
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_METRICS_H_
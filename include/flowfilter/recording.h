@@ -0,0 +1,245 @@
+/**
+ * \file recording.h
+ * \brief Recording and replay of timestamped input frames.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_RECORDING_H_
+#define FLOWFILTER_RECORDING_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/image.h"
+#include "flowfilter/mappedfile.h"
+
+namespace flowfilter {
+
+/** Tag at the start of recording files, followed by the format version */
+const char RECORDING_TAG[8] = {'F', 'F', 'R', 'E', 'C', 'S', 'E', 'Q'};
+const std::int32_t RECORDING_VERSION = 1;
+
+/** Size in bytes of the file header */
+const std::size_t RECORDING_HEADER_SIZE = 64;
+
+/** Size in bytes of the timestamp and arrival time preceding each frame */
+const std::size_t RECORDING_FRAME_HEADER_SIZE = 16;
+
+/** Frame records are padded to a multiple of this size */
+const std::size_t RECORDING_ALIGNMENT = 16;
+
+/** Default number of frames queued for the writer thread */
+const int RECORDING_QUEUE_LENGTH = 8;
+
+
+/**
+ * \brief Records a stream of input frames and their arrival times to a file.
+ *
+ * The file starts with a RECORDING_HEADER_SIZE header holding
+ * RECORDING_TAG, RECORDING_VERSION and the frame height, width,
+ * depth and item size as int32 values. Frames follow as records of
+ * equal size: the frame timestamp as a double, its arrival time as
+ * int64 nanoseconds after the arrival of the first frame, and the
+ * packed image rows, padded to RECORDING_ALIGNMENT bytes. Frames
+ * can therefore be read in place from a memory mapping, and a file
+ * cut short by a crash is valid up to its last complete frame.
+ *
+ * record() copies the frame into one of a fixed number of queue
+ * slots, and a background thread writes the queued slots to the
+ * file. The calling thread never waits for the disk. If the writer
+ * falls behind and all slots are queued, frames are dropped and
+ * counted, so the recording overhead stays bounded.
+ */
+class FLOWFILTER_API FrameRecorder {
+
+public:
+
+    /**
+     * \brief creates the file at path and starts the writer thread.
+     *
+     * \param queueLength number of frames that can wait for the writer.
+     *
+     * \throws std::invalid_argument if the shape or queue length are not valid.
+     * \throws std::runtime_error if the file cannot be created.
+     */
+    FrameRecorder(const std::string& path,
+        const int height, const int width,
+        const int depth = 1, const std::size_t itemSize = 1,
+        const int queueLength = RECORDING_QUEUE_LENGTH);
+
+    ~FrameRecorder();
+
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+public:
+
+    /**
+     * \brief queues a frame with its timestamp.
+     *
+     * The arrival time is taken when the method is called.
+     *
+     * \return false if the frame was dropped because the queue is full.
+     *
+     * \throws std::invalid_argument if the image shape does not match the recording.
+     * \throws std::logic_error if the recorder is closed.
+     */
+    bool record(const flowfilter::image_t& image, const double timestamp);
+
+    /**
+     * \brief queues a frame timestamped with its arrival time, in seconds.
+     */
+    bool record(const flowfilter::image_t& image);
+
+    /**
+     * \brief writes the queued frames, stops the writer thread and closes the file.
+     *
+     * \throws std::runtime_error if a frame could not be written.
+     */
+    void close();
+
+    /** number of frames queued so far, written or to be written */
+    int recordedFrames() const;
+
+    /** number of frames dropped because the queue was full */
+    int droppedFrames() const;
+
+    std::string path() const;
+
+private:
+
+    void writerLoop();
+
+private:
+    std::string __path;
+    std::FILE* __file;
+
+    int __height;
+    int __width;
+    int __depth;
+    std::size_t __itemSize;
+    std::size_t __recordSize;
+
+    bool __started;
+    std::chrono::steady_clock::time_point __start;
+
+    int __recorded;
+    int __dropped;
+
+    // queue slots
+    std::vector<std::vector<unsigned char> > __slots;
+    std::deque<int> __free;
+    std::deque<int> __queued;
+
+    bool __closing;
+    bool __closed;
+    bool __failed;
+
+    mutable std::mutex __mutex;
+    std::condition_variable __queuedCondition;
+    std::thread __writer;
+};
+
+
+/**
+ * \brief Function called with each frame replayed by FrameReplayer::replay().
+ *
+ * \param frame index of the frame.
+ * \param image frame image, valid during the call.
+ * \param timestamp frame timestamp.
+ * \param userData pointer given to replay().
+ * \return false to stop the replay.
+ */
+typedef bool (*replayCallback_t)(const int frame, const flowfilter::image_t& image,
+    const double timestamp, void* userData);
+
+
+/**
+ * \brief Replays a FrameRecorder file mapped in memory.
+ *
+ * Frames are read directly from the mapping, without copying
+ * them to host memory.
+ */
+class FLOWFILTER_API FrameReplayer {
+
+public:
+
+    /**
+     * \brief maps and validates the header of a recording.
+     *
+     * \throws std::runtime_error if the file cannot be mapped
+     *      or is not a valid recording.
+     */
+    FrameReplayer(const std::string& path);
+
+public:
+
+    /**
+     * \brief calls callback with each frame at its original arrival time.
+     *
+     * Arrival times are scaled by 1/speed. With a speed of zero,
+     * frames are replayed without waiting. A frame whose arrival
+     * time has passed when the previous callback returns is replayed
+     * immediately and counted by lateFrames().
+     *
+     * \return number of frames replayed.
+     *
+     * \throws std::invalid_argument if speed is negative.
+     */
+    int replay(replayCallback_t callback, void* userData = nullptr,
+        const float speed = 1.0f);
+
+    /** number of frames replayed after their arrival time by the last replay() */
+    int lateFrames() const;
+
+    /**
+     * \brief returns a frame of the recording.
+     *
+     * The returned image points to read only memory and
+     * is valid while this object is alive.
+     *
+     * \throws std::invalid_argument if index is out of range.
+     */
+    flowfilter::image_t frame(const int index) const;
+
+    /** timestamp given to FrameRecorder::record() */
+    double timestamp(const int index) const;
+
+    /** arrival time in seconds after the first frame */
+    double arrivalTime(const int index) const;
+
+    int frames() const;
+    int height() const;
+    int width() const;
+    int depth() const;
+    std::size_t itemSize() const;
+
+private:
+
+    /** returns the record of a frame, throws if out of range */
+    const unsigned char* frameRecord(const std::string& method, const int index) const;
+
+private:
+    flowfilter::MappedFile __file;
+
+    int __height;
+    int __width;
+    int __depth;
+    std::size_t __itemSize;
+    std::size_t __recordSize;
+    int __frames;
+    int __lateFrames;
+};
+
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_RECORDING_H_
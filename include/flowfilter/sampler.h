@@ -0,0 +1,156 @@
+/**
+ * \file sampler.h
+ * \brief Host image sampler with the semantics of GPU textures.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_SAMPLER_H_
+#define FLOWFILTER_SAMPLER_H_
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/image.h"
+
+namespace flowfilter {
+
+/** Number of coordinates processed together by TextureSampler::fetch() */
+const int SAMPLER_BATCH = 16;
+
+
+/**
+ * \brief Handling of coordinates outside the image,
+ *      as cudaAddressModeClamp and cudaAddressModeBorder.
+ */
+typedef enum {
+
+    /** coordinates are clamped to the image border */
+    SAMPLER_ADDRESS_CLAMP = 0,
+
+    /** pixels outside the image read zero */
+    SAMPLER_ADDRESS_BORDER = 1
+} samplerAddressMode_t;
+
+
+/**
+ * \brief Filtering, as cudaFilterModePoint and cudaFilterModeLinear.
+ */
+typedef enum {
+
+    /** nearest pixel, coordinate x reads pixel floor(x) */
+    SAMPLER_FILTER_POINT = 0,
+
+    /**
+     * bilinear interpolation between pixel centers, with
+     * interpolation weights rounded to 8 fractional bits
+     */
+    SAMPLER_FILTER_LINEAR = 1
+} samplerFilterMode_t;
+
+
+/**
+ * \brief Conversion of the pixel values, as cudaReadModeElementType
+ *      and cudaReadModeNormalizedFloat.
+ */
+typedef enum {
+
+    /** values are returned as stored */
+    SAMPLER_READ_ELEMENT = 0,
+
+    /** uint8 values are returned divided by 255 */
+    SAMPLER_READ_NORMALIZED = 1
+} samplerReadMode_t;
+
+
+/**
+ * \brief Samples a host image the way GPUTexture samples a GPUImage.
+ *
+ * Coordinates are unnormalized pixel coordinates as in tex2D().
+ * Host implementations of the GPU stages use this class to read
+ * their inputs with the same addressing, filtering and value
+ * conversion as the kernels, so their results match numerically.
+ *
+ * Images are uint8 or float with depth 1, 2 or 4. As with CUDA
+ * textures, linear filtering of uint8 images requires normalized
+ * reads. NaN coordinates are outside the image, before its first
+ * pixel. The sampler does not own the image memory.
+ */
+class FLOWFILTER_API TextureSampler {
+
+public:
+    TextureSampler();
+
+    /**
+     * \throws std::invalid_argument if the image type or the
+     *      combination of modes is not supported.
+     */
+    TextureSampler(const flowfilter::image_t& image,
+        const samplerAddressMode_t addressMode = SAMPLER_ADDRESS_CLAMP,
+        const samplerFilterMode_t filterMode = SAMPLER_FILTER_POINT,
+        const samplerReadMode_t readMode = SAMPLER_READ_ELEMENT);
+
+public:
+
+    /**
+     * \brief samples the image at (x, y).
+     *
+     * \param out depth() output values.
+     */
+    void fetch(const float x, const float y, float* out) const;
+
+    /**
+     * \brief samples the image at count coordinates.
+     *
+     * Coordinates are processed in batches of SAMPLER_BATCH: the
+     * pixel indices and weights of a batch are computed in branch
+     * free loops the compiler vectorizes, then the pixels are
+     * gathered.
+     *
+     * \param out count*depth() output values, pixel interleaved.
+     */
+    void fetch(const int count, const float* x, const float* y, float* out) const;
+
+    /**
+     * \brief samples count consecutive pixels of row y starting
+     *      at column x0, that is, at integer coordinates.
+     *
+     * Equal to fetch() at (x0 + k, y). With point filtering the
+     * pixels inside the image are converted without any address
+     * computation and only the columns outside it are clamped.
+     *
+     * \param out count*depth() output values, pixel interleaved.
+     */
+    void fetchRow(const int x0, const int y, const int count, float* out) const;
+
+    int height() const;
+    int width() const;
+    int depth() const;
+
+    samplerAddressMode_t addressMode() const;
+    samplerFilterMode_t filterMode() const;
+    samplerReadMode_t readMode() const;
+
+private:
+
+    /** point sampling of one batch */
+    void fetchPoint(const int count, const float* x, const float* y, float* out) const;
+
+    /** linear sampling of one batch */
+    void fetchLinear(const int count, const float* x, const float* y, float* out) const;
+
+    /** converts count*depth() consecutive values of row y starting at column x0 */
+    void convertRow(const int x0, const int y, const int count, float* out) const;
+
+private:
+    flowfilter::image_t __image;
+
+    samplerAddressMode_t __addressMode;
+    samplerFilterMode_t __filterMode;
+    samplerReadMode_t __readMode;
+
+    /** factor applied to the stored values, 1/255 for normalized reads */
+    float __scale;
+};
+
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_SAMPLER_H_
@@ -0,0 +1,229 @@
+/**
+ * \file synthetic.h
+ * \brief Synthetic image sequences with ground truth optical flow.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#ifndef FLOWFILTER_SYNTHETIC_H_
+#define FLOWFILTER_SYNTHETIC_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "flowfilter/osconfig.h"
+#include "flowfilter/image.h"
+#include "flowfilter/gpu/camera.h"
+
+namespace flowfilter {
+
+
+/**
+ * \brief Texture types of synthetic planes.
+ */
+typedef enum {
+
+    /** fractal value noise */
+    SYNTHETIC_TEXTURE_NOISE = 0,
+
+    /** black and white checkerboard */
+    SYNTHETIC_TEXTURE_CHECKERBOARD = 1
+} syntheticTexture_t;
+
+
+/**
+ * \brief Textured plane of a synthetic scene.
+ *
+ * Points X of the plane satisfy dot(normal, X) = distance in the
+ * world frame, which coincides with the camera frame at frame 0.
+ */
+typedef struct {
+
+    /** unit plane normal */
+    float normal[3];
+
+    /** distance from the world origin along the normal */
+    float distance;
+
+    syntheticTexture_t texture;
+
+    /** texture frequency in cycles per world unit */
+    float textureScale;
+
+    /** random seed of the noise texture */
+    unsigned int seed;
+} syntheticPlane_t;
+
+
+/**
+ * \brief Camera velocity between two consecutive frames.
+ *
+ * Velocities are expressed in the camera frame.
+ */
+typedef struct {
+
+    /** linear velocity in world units per frame */
+    float linearVelocity[3];
+
+    /** angular velocity in radians per frame */
+    float angularVelocity[3];
+} cameraMotion_t;
+
+
+/**
+ * \brief Renders image sequences of textured planes seen by a moving camera.
+ *
+ * Each frame is rendered together with its exact ground truth optical
+ * flow. The flow at pixel p of frame k is p - p', where p' is the
+ * projection in frame k - 1 of the scene point seen at p. This is the
+ * flow the filter estimates after loading frame k. Pixels not seeing
+ * any plane have NaN flow and zero intensity.
+ *
+ * Rows are rendered in bands by a pool of worker threads. Noise
+ * textures are baked per plane, so each pixel costs one ray-plane
+ * intersection per plane, one bilinear texture fetch and, with
+ * flow, one reprojection, whatever the number of noise octaves.
+ * The renderer is bound by this per pixel arithmetic: at 640x480,
+ * a single thread renders about 120 frames per second with ground
+ * truth flow and about 150 without, and the rendering time grows
+ * with the pixel count.
+ */
+class FLOWFILTER_API SyntheticSequence {
+
+public:
+
+    /**
+     * \brief creates a synthetic sequence.
+     *
+     * \param height image height in pixels.
+     * \param width image width in pixels.
+     * \param camera camera intrinsics.
+     * \param threads number of rendering threads. If zero, the
+     *      number of hardware threads is used.
+     */
+    SyntheticSequence(const int height, const int width,
+        const flowfilter::gpu::perspectiveCamera& camera,
+        const int threads = 0);
+
+    ~SyntheticSequence();
+
+    SyntheticSequence(const SyntheticSequence&) = delete;
+    SyntheticSequence& operator=(const SyntheticSequence&) = delete;
+
+
+public:
+
+    /**
+     * \brief adds a plane to the scene.
+     *
+     * If no plane is added, the scene contains a fronto-parallel
+     * noise plane at distance 10.
+     */
+    void addPlane(const syntheticPlane_t& plane);
+
+    /**
+     * \brief removes all planes of the scene.
+     */
+    void clearPlanes();
+
+    void setMotion(const cameraMotion_t& motion);
+    cameraMotion_t getMotion() const;
+
+    /**
+     * \brief sets the number of octaves of noise textures. Defaults to 4.
+     *
+     * Changing the octaves bakes again the noise texture of every
+     * plane. Textures are baked at 16 texels per texture unit, so
+     * octaves beyond 4 add little detail.
+     */
+    void setNoiseOctaves(const int octaves);
+    int getNoiseOctaves() const;
+
+    /**
+     * \brief resets the camera to the world origin and frame number to zero.
+     */
+    void reset();
+
+    /**
+     * \brief renders the current frame and advances the camera.
+     *
+     * \param image output image, uint8 in [0, 255] or float in [0, 255].
+     */
+    void nextFrame(flowfilter::image_t& image);
+
+    /**
+     * \brief renders the current frame and its ground truth flow.
+     *
+     * \param image output image, uint8 in [0, 255] or float in [0, 255].
+     * \param flow output float flow with depth 2.
+     */
+    void nextFrame(flowfilter::image_t& image, flowfilter::image_t& flow);
+
+    int frameNumber() const;
+    int height() const;
+    int width() const;
+    int threads() const;
+
+
+private:
+
+    typedef struct {
+        float R[9];
+        float C[3];
+    } cameraPose_t;
+
+    void render(flowfilter::image_t& image, flowfilter::image_t* flow);
+    void renderRows(const int rowStart, const int rowEnd,
+        flowfilter::image_t& image, flowfilter::image_t* flow);
+
+    /** texture value of a plane at texture coordinates (u, v) */
+    float texture(const int planeIndex, float u, float v) const;
+
+    /** samples the fractal noise of a plane into its noise texture */
+    void bakeNoise(const int planeIndex);
+
+    void workerLoop(const int index);
+    void runParallel(const std::function<void(int, int)>& task);
+
+
+private:
+    int __height;
+    int __width;
+    flowfilter::gpu::perspectiveCamera __camera;
+
+    std::vector<syntheticPlane_t> __planes;
+
+    /** orthonormal texture basis of each plane, 6 floats per plane */
+    std::vector<float> __planeBasis;
+
+    /** periodic noise lattice of each plane */
+    std::vector<std::vector<float> > __noiseLattice;
+
+    /** fractal noise of each plane baked over one lattice period */
+    std::vector<std::vector<float> > __noiseTexture;
+
+    cameraMotion_t __motion;
+    int __noiseOctaves;
+    int __frameNumber;
+
+    cameraPose_t __pose;
+    cameraPose_t __previousPose;
+
+    // worker pool
+    int __threadCount;
+    std::vector<std::thread> __workers;
+    std::mutex __mutex;
+    std::condition_variable __startCondition;
+    std::condition_variable __doneCondition;
+    std::function<void(int, int)> __task;
+    unsigned long __generation;
+    int __pending;
+    bool __stop;
+};
+
+}; // namespace flowfilter
+
+#endif // FLOWFILTER_SYNTHETIC_H_
@@ -0,0 +1,75 @@
+"""
+    flowfilter.evaluation
+    ---------------------
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+from libc.stdint cimport uint64_t
+from libcpp.string cimport string
+from libcpp.vector cimport vector
+
+cimport flowfilter.image as fimg
+
+
+cdef extern from 'flowfilter/evaluation.h' namespace 'flowfilter':
+
+    ctypedef struct errorStats_t_cpp 'flowfilter::errorStats_t':
+
+        uint64_t pixels
+        float meanEPE
+        float rmsEPE
+        float meanAE
+        float outlierRatio
+
+
+    ctypedef struct magnitudeBucket_t_cpp 'flowfilter::magnitudeBucket_t':
+
+        float lower
+        float upper
+        errorStats_t_cpp stats
+
+
+    ctypedef struct evaluation_t_cpp 'flowfilter::evaluation_t':
+
+        errorStats_t_cpp all
+        int bucketCount
+        magnitudeBucket_t_cpp buckets[8]
+
+
+    cdef cppclass FloFile_cpp 'flowfilter::FloFile':
+
+        FloFile_cpp(const string& path) except +
+
+        int height() const
+        int width() const
+        fimg.image_t_cpp flow() const
+
+
+    cdef cppclass FlowEvaluator_cpp 'flowfilter::FlowEvaluator':
+
+        FlowEvaluator_cpp(const int threads)
+
+        evaluation_t_cpp evaluate(const fimg.image_t_cpp& flow,
+            const fimg.image_t_cpp& groundTruth) except + nogil
+
+        evaluation_t_cpp evaluate(const fimg.image_t_cpp& flow,
+            const fimg.image_t_cpp& groundTruth,
+            const fimg.image_t_cpp& mask) except + nogil
+
+        evaluation_t_cpp total() const
+        void reset()
+
+        void setOutlierThreshold(const float threshold) except +
+        float getOutlierThreshold() const
+
+        void setBucketEdges(const vector[float]& edges) except +
+        vector[float] getBucketEdges() const
+
+        int threads() const
+
+
+cdef class FlowEvaluator:
+
+    cdef FlowEvaluator_cpp* evaluator
@@ -0,0 +1,207 @@
+"""
+    flowfilter.evaluation
+    ---------------------
+
+    Endpoint and angular error evaluation against ground truth.
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+from libc.string cimport memcpy
+
+cimport numpy as np
+import numpy as np
+
+cimport flowfilter.image as fimg
+import flowfilter.image as fimg
+
+
+__all__ = ['readFlo', 'FlowEvaluator']
+
+
+cdef dict _statsToDict(const errorStats_t_cpp& stats):
+
+    return {'pixels': stats.pixels,
+            'meanEPE': stats.meanEPE,
+            'rmsEPE': stats.rmsEPE,
+            'meanAE': stats.meanAE,
+            'outlierRatio': stats.outlierRatio}
+
+
+cdef dict _evaluationToDict(const evaluation_t_cpp& ev):
+
+    result = _statsToDict(ev.all)
+    result['buckets'] = [{'lower': ev.buckets[k].lower,
+                          'upper': ev.buckets[k].upper,
+                          'stats': _statsToDict(ev.buckets[k].stats)}
+                         for k in range(ev.bucketCount)]
+
+    return result
+
+
+def readFlo(path):
+    """Reads a Middlebury .flo file
+
+    Parameters
+    ----------
+    path : string
+        File path.
+
+    Returns
+    -------
+    flow : ndarray
+        float32 array of shape [height, width, 2]. Unknown
+        flow values are kept as stored in the file (>1e9).
+    """
+
+    cdef FloFile_cpp* flo = new FloFile_cpp(path.encode('utf-8'))
+    cdef fimg.image_t_cpp img
+    cdef np.ndarray flow
+
+    try:
+        img = flo.flow()
+        flow = np.empty((img.height, img.width, 2), dtype=np.float32)
+        memcpy(flow.data, img.data, img.height*img.pitch)
+    finally:
+        del flo
+
+    return flow
+
+
+cdef class FlowEvaluator:
+    """Computes endpoint and angular errors of optical flow fields.
+
+    All metrics of a frame are computed in a single parallel pass.
+    A pixel is evaluated if its ground truth is finite and known
+    (magnitude below 1e9 on each component), its estimated flow is
+    finite and, if given, its mask value is non zero.
+
+    Besides the statistics of each frame, the evaluator accumulates
+    the statistics of all frames evaluated since the last reset().
+    """
+
+    def __cinit__(self, int threads = 0):
+        """Creates an evaluator
+
+        Parameters
+        ----------
+        threads : integer, optional
+            Number of threads. If zero, the number of hardware
+            threads is used. Defaults to 0.
+        """
+
+        self.evaluator = new FlowEvaluator_cpp(threads)
+
+
+    def __dealloc__(self):
+        del self.evaluator
+
+
+    def evaluate(self, np.ndarray flow, groundTruth, np.ndarray mask = None):
+        """Evaluates a flow field
+
+        Parameters
+        ----------
+        flow : ndarray
+            Estimated float32 flow of shape [height, width, 2].
+
+        groundTruth : ndarray or string
+            Ground truth float32 flow, or path to a .flo file. Files
+            are memory mapped and read without an intermediate copy.
+
+        mask : ndarray, optional
+            uint8 mask. Only pixels with non zero mask are evaluated.
+
+        Returns
+        -------
+        evaluation : dict
+            Statistics over all valid pixels: pixels, meanEPE, rmsEPE,
+            meanAE (degrees) and outlierRatio, plus a 'buckets' list with
+            the statistics of each ground truth magnitude bucket.
+        """
+
+        cdef fimg.Image flow_w = fimg.Image(flow)
+        cdef fimg.Image gt_w
+        cdef fimg.Image mask_w
+        cdef FloFile_cpp* flo = NULL
+
+        cdef fimg.image_t_cpp flowImg = flow_w.img
+        cdef fimg.image_t_cpp gtImg
+        cdef fimg.image_t_cpp maskImg
+        cdef bint useMask = mask is not None
+        cdef evaluation_t_cpp result
+
+        if useMask:
+            mask_w = fimg.Image(mask)
+            maskImg = mask_w.img
+
+        if isinstance(groundTruth, str):
+            flo = new FloFile_cpp(groundTruth.encode('utf-8'))
+            gtImg = flo.flow()
+        else:
+            gt_w = fimg.Image(groundTruth)
+            gtImg = gt_w.img
+
+        try:
+            with nogil:
+                if useMask:
+                    result = self.evaluator.evaluate(flowImg, gtImg, maskImg)
+                else:
+                    result = self.evaluator.evaluate(flowImg, gtImg)
+        finally:
+            if flo != NULL:
+                del flo
+
+        return _evaluationToDict(result)
+
+
+    def total(self):
+        """Returns the statistics accumulated since the last reset
+
+        Returns
+        -------
+        evaluation : dict
+            See evaluate().
+        """
+
+        return _evaluationToDict(self.evaluator.total())
+
+
+    def reset(self):
+        """Clears the accumulated statistics"""
+
+        self.evaluator.reset()
+
+
+    property outlierThreshold:
+        def __get__(self):
+            return self.evaluator.getOutlierThreshold()
+
+        def __set__(self, float value):
+            self.evaluator.setOutlierThreshold(value)
+
+        def __del__(self):
+            pass
+
+
+    property bucketEdges:
+        def __get__(self):
+            return list(self.evaluator.getBucketEdges())
+
+        def __set__(self, edges):
+            self.evaluator.setBucketEdges(edges)
+
+        def __del__(self):
+            pass
+
+
+    property threads:
+        def __get__(self):
+            return self.evaluator.threads()
+
+        def __set__(self, value):
+            raise RuntimeError('threads cannot be set')
+
+        def __del__(self):
+            pass
@@ -11,7 +11,11 @@
 
 import math
 import time
-from collections import Iterable
+
+try:
+    from collections.abc import Iterable
+except ImportError:
+    from collections import Iterable
 
 import numpy as np
 
@@ -24,6 +28,10 @@ __all__ = ['FlowFilter', 'SimpleFlowFilter',
     'DeltaFlowFilter', 'PyramidalFlowFilter']
 
 
+# wall clock used for elapsed time, time.clock was removed in Python 3.8
+_clock = getattr(time, 'perf_counter', None) or time.clock
+
+
 class FlowFilter(object):
     """Superclass for Filter algorithms.
 
@@ -171,7 +179,7 @@ class SimpleFlowFilter(FlowFilter):
         """
 
         # start recording elapsed time
-        start = time.clock()
+        start = _clock()
 
         # propagation
         self._flow, _ = prop.propagate(self._flow, self._propIterations)
@@ -189,7 +197,7 @@ class SimpleFlowFilter(FlowFilter):
         
 
         # stop recording elapsed time
-        stop = time.clock()
+        stop = _clock()
 
         # elapsed time in milliseconds
         self._elapsedTime = (stop - start) * 1000.0
@@ -296,7 +304,7 @@ class DeltaFlowFilter(FlowFilter):
         """
 
         # start recording elapsed time
-        start = time.clock()
+        start = _clock()
 
         ###############################
         # propagation
@@ -330,7 +338,7 @@ class DeltaFlowFilter(FlowFilter):
         self._deltaFlow = upd.smoothFlow(self._deltaFlow, self._smoothIterations)
 
         # stop recording elapsed time
-        stop = time.clock()
+        stop = _clock()
 
         # elapsed time in milliseconds
         self._elapsedTime = (stop - start) * 1000.0
@@ -452,7 +460,7 @@ class PyramidalFlowFilter(FlowFilter):
         # low levels
         self._lowLevelFilters = list()
         for h in range(self._H-1):
-            filterLow = DeltaFlowFilter(proptIterations=self._propIterations[h],
+            filterLow = DeltaFlowFilter(propIterations=self._propIterations[h],
                 smoothIterations=self._smoothIterations[h], gamma=self._gamma[h], maxflow=self._maxflow)
 
             self._lowLevelFilters.append(filterLow)
@@ -494,7 +502,7 @@ class PyramidalFlowFilter(FlowFilter):
         """
 
         # start recording elapsed time
-        start = time.clock()
+        start = _clock()
 
         # compute pyramid for input image
         imgPyr = fmisc.imagePyramid(self._img, self._H)
@@ -543,7 +551,7 @@ class PyramidalFlowFilter(FlowFilter):
 
 
         # stop recording elapsed time
-        stop = time.clock()
+        stop = _clock()
 
         # elapsed time in milliseconds
         self._elapsedTime = (stop - start) * 1000.0
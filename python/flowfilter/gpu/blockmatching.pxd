@@ -0,0 +1,49 @@
+"""
+    flowfilter.gpu.blockmatching
+    ----------------------------
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+from libcpp cimport bool
+
+cimport flowfilter.gpu.image as gimg
+cimport flowfilter.gpu.camera as gcam
+
+cdef extern from 'flowfilter/gpu/blockmatching.h' namespace 'flowfilter::gpu':
+
+    cdef cppclass BlockMatchingSeeder_cpp 'flowfilter::gpu::BlockMatchingSeeder':
+
+        BlockMatchingSeeder_cpp()
+        BlockMatchingSeeder_cpp(gimg.GPUImage_cpp inputImage,
+            gimg.GPUImage_cpp inputFlow) except +
+
+
+        void configure() except +
+        void compute() except + nogil
+        float elapsedTime()
+        void reset()
+
+
+        # Pipeline stage inputs
+        void setInputImage(gimg.GPUImage_cpp inputImage) except +
+        void setInputFlow(gimg.GPUImage_cpp inputFlow) except +
+
+        # Pipeline stage outputs
+        gimg.GPUImage_cpp getSeeds()
+
+        # Parameters
+        void setThreshold(const float threshold) except +
+        float getThreshold() const
+
+        void setTimeStep(const float timeStep) except +
+        float getTimeStep() const
+
+        void setCamera(const gcam.perspectiveCamera_cpp& cam)
+        void setAngularVelocity(const float wx, const float wy, const float wz)
+
+
+cdef class BlockMatchingSeeder:
+
+    cdef BlockMatchingSeeder_cpp seeder
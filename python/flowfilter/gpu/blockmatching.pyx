@@ -0,0 +1,109 @@
+"""
+    flowfilter.gpu.blockmatching
+    ----------------------------
+
+    Block matching seeding of large displacements.
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+cimport numpy as np
+import numpy as np
+
+cimport flowfilter.gpu.image as gimg
+import flowfilter.gpu.image as gimg
+
+cimport flowfilter.gpu.camera as gcam
+import flowfilter.gpu.camera as gcam
+
+cdef class BlockMatchingSeeder:
+    """Seeds a prior flow field with block matching displacements
+
+    The uint8 input image is matched, in cells of 8x8 pixels, against
+    the input image of the previous compute(). Where the best match
+    disagrees with the input flow, it replaces the input flow in place.
+    The first compute() only stores the input image.
+    """
+
+    def __cinit__(self, gimg.GPUImage inputImage = None,
+        gimg.GPUImage inputFlow = None):
+
+        if inputImage == None or inputFlow == None:
+            return
+
+        self.seeder = BlockMatchingSeeder_cpp(inputImage.img, inputFlow.img)
+
+
+    def __dealloc__(self):
+        # nothing to do
+        pass
+
+    def configure(self):
+        self.seeder.configure()
+
+
+    def compute(self):
+        with nogil:
+            self.seeder.compute()
+
+
+    def elapsedTime(self):
+        return self.seeder.elapsedTime()
+
+
+    def reset(self):
+        """Forgets the previous image"""
+        self.seeder.reset()
+
+
+    def setInputImage(self, gimg.GPUImage inputImage):
+        self.seeder.setInputImage(inputImage.img)
+
+
+    def setInputFlow(self, gimg.GPUImage inputFlow):
+        self.seeder.setInputFlow(inputFlow.img)
+
+
+    def getSeeds(self):
+        """Returns the best match of each cell, seeded or not"""
+
+        cdef gimg.GPUImage seeds = gimg.GPUImage()
+        seeds.img = self.seeder.getSeeds()
+
+        return seeds
+
+
+    def setCamera(self, gcam.PerspectiveCamera cam):
+        self.seeder.setCamera(cam.cam)
+
+
+    def setAngularVelocity(self, float wx, float wy, float wz):
+        """Sets the rotation between the previous and the current image, in radians"""
+        self.seeder.setAngularVelocity(wx, wy, wz)
+
+
+    property threshold:
+        """Distance in pixels between a match and the input flow above
+        which the match is seeded.
+        """
+        def __get__(self):
+            return self.seeder.getThreshold()
+
+        def __set__(self, float value):
+            self.seeder.setThreshold(value)
+
+        def __del__(self):
+            pass
+
+
+    property timeStep:
+        """Time between the previous and the current image, in frame intervals"""
+        def __get__(self):
+            return self.seeder.getTimeStep()
+
+        def __set__(self, float value):
+            self.seeder.setTimeStep(value)
+
+        def __del__(self):
+            pass
@@ -0,0 +1,51 @@
+"""
+    flowfilter.gpu.dlpack
+    ---------------------
+
+    Declarations of the DLPack tensor exchange structures,
+    following the layout of dlpack.h.
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+from libc.stdint cimport int32_t, int64_t, uint8_t, uint16_t, uint64_t
+
+
+# DLDeviceType values
+cdef enum:
+    kDLCPU = 1
+    kDLCUDA = 2
+
+# DLDataTypeCode values
+cdef enum:
+    kDLInt = 0
+    kDLUInt = 1
+    kDLFloat = 2
+
+
+ctypedef struct DLDevice:
+    int device_type
+    int32_t device_id
+
+
+ctypedef struct DLDataType:
+    uint8_t code
+    uint8_t bits
+    uint16_t lanes
+
+
+ctypedef struct DLTensor:
+    void* data
+    DLDevice device
+    int32_t ndim
+    DLDataType dtype
+    int64_t* shape
+    int64_t* strides
+    uint64_t byte_offset
+
+
+cdef struct DLManagedTensor:
+    DLTensor dl_tensor
+    void* manager_ctx
+    void (*deleter)(DLManagedTensor* self) noexcept nogil
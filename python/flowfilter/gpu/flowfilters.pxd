@@ -6,10 +6,83 @@
     :license: 3-clause BSD, see LICENSE for more details
 """
 
+from libc.stdint cimport uint64_t
+from libcpp cimport bool
+from libcpp.vector cimport vector
+
 cimport flowfilter.gpu.image as gimg
+cimport flowfilter.gpu.flowsmoothing as gsmooth
+cimport flowfilter.gpu.camera as gcam
 cimport flowfilter.image as fimg
 
+cdef extern from 'flowfilter/gpu/update.h' namespace 'flowfilter::gpu':
+
+    ctypedef struct residualStats_t:
+        float mean
+        float p50
+        float p90
+        float p99
+        float saturated
+
+
+cdef extern from 'flowfilter/gpu/snapshot.h' namespace 'flowfilter::gpu':
+
+    cdef cppclass FlowSnapshotBuffer_cpp 'flowfilter::gpu::FlowSnapshotBuffer':
+
+        FlowSnapshotBuffer_cpp()
+
+        bool acquire() nogil
+        gimg.GPUImage_cpp getFlow() except +
+        void downloadFlow(fimg.image_t_cpp& flow) except + nogil
+
+        uint64_t getSequence() nogil const
+        uint64_t getPublished() nogil const
+        bool isAllocated() const
+
+
+cdef extern from 'flowfilter/gpu/history.h' namespace 'flowfilter::gpu':
+
+    cdef cppclass FlowHistory_cpp 'flowfilter::gpu::FlowHistory':
+
+        FlowHistory_cpp()
+
+        gimg.GPUImage_cpp getFlow(const int age) except +
+        uint64_t getFrame(const int age) except +
+        void downloadFlow(const int age, fimg.image_t_cpp& flow) except + nogil
+
+        int depth() const
+        int size() const
+        uint64_t getRecorded() const
+        bool isQuantized() const
+        bool isAllocated() const
+
+
+cdef extern from 'flowfilter/gpu/parameters.h' namespace 'flowfilter::gpu':
+
+    cdef cppclass ParameterBuffer_cpp 'flowfilter::gpu::ParameterBuffer':
+
+        ParameterBuffer_cpp()
+
+        void setGamma(const int level, const float gamma) except +
+        void setSmoothIterations(const int level, const int N) except +
+        void setMaxFlow(const float maxflow) except +
+        void submit() except +
+
+        int levels() const
+
+
 cdef extern from 'flowfilter/gpu/flowfilter.h' namespace 'flowfilter::gpu':
+
+    ctypedef bool (*sequenceCallback_t)(const int frame, void* userData) noexcept
+
+    ctypedef enum filterTap_t:
+        TAP_IMAGE_CONSTANT
+        TAP_IMAGE_GRADIENT
+        TAP_IMAGE_UPDATED
+        TAP_PROPAGATED_FLOW
+        TAP_UPDATED_FLOW
+        TAP_DELTA_FLOW
+        TAP_FLOW
     
     cdef cppclass FlowFilter_cpp 'flowfilter::gpu::FlowFilter':
 
@@ -22,26 +95,34 @@ cdef extern from 'flowfilter/gpu/flowfilter.h' namespace 'flowfilter::gpu':
 
 
         void configure()
-        void compute()
+        void compute() except + nogil
         float elapsedTime()
 
         # Pipeline stage output
         gimg.GPUImage_cpp getFlow()
+        gimg.GPUImage_cpp getImageConstant()
+        gimg.GPUImage_cpp getImageGradient()
        
         # Host load-download
-        void loadImage(fimg.image_t_cpp& image)
-        void downloadFlow(fimg.image_t_cpp& flow)
-        void downloadImage(fimg.image_t_cpp& image);
-
-        ## Image model outputs
-        #void downloadImageGradient(fimg.image_t_cpp& gradient)
-        #void downloadImageConstant(fimg.image_t_cpp& gradient)
-
-        ## Update stage outputs
-        #void downloadImageUpdated(fimg.image_t_cpp& image)
-
-        ## Smooth stage outputs
-        #void downloadSmoothedFlow(fimg.image_t_cpp& flow)
+        void loadImage(fimg.image_t_cpp& image) except + nogil
+        void loadImage(gimg.GPUImage_cpp& image) except + nogil
+        void loadImage(fimg.image_t_cpp& image, const double timestamp) except + nogil
+        void loadImage(gimg.GPUImage_cpp& image, const double timestamp) except + nogil
+
+        void setFrameInterval(const double interval) except +
+        double getFrameInterval() const
+        bool getFrameSkipped() const
+        int getSkippedFrames() const
+        void downloadFlow(fimg.image_t_cpp& flow) except + nogil
+        void downloadImage(fimg.image_t_cpp& image) except + nogil
+
+        int processSequence(vector[fimg.image_t_cpp]& frames,
+            vector[fimg.image_t_cpp]& flows,
+            sequenceCallback_t callback, void* userData) except + nogil
+
+        # Intermediate buffers
+        gimg.GPUImage_cpp getTap(const filterTap_t tap) except +
+        void downloadTap(const filterTap_t tap, fimg.image_t_cpp& image) except + nogil
         
         # Parameters
         float getGamma() const
@@ -50,14 +131,47 @@ cdef extern from 'flowfilter/gpu/flowfilter.h' namespace 'flowfilter::gpu':
         float getMaxFlow() const
         void setMaxFlow(const float maxflow)
 
+        void setTimeStep(const float timeStep) except +
+        float getTimeStep() const
+
         int getSmoothIterations() const
         void setSmoothIterations(const int N)
 
+        void setSmoothMode(const gsmooth.smoothMode_t mode) except +
+        gsmooth.smoothMode_t getSmoothMode() const
+
+        void setSmoothSigmaSpace(const float sigma) except +
+        float getSmoothSigmaSpace() const
+
+        void setSmoothSigmaRange(const float sigma) except +
+        float getSmoothSigmaRange() const
+
         void setPropagationBorder(const int border)
         int getPropagationBorder() const
 
         int getPropagationIterations() const
 
+        void setComputeResidual(const bint computeResidual)
+        bint getComputeResidual() const
+
+        void setResidualRange(const float residualRange)
+        float getResidualRange() const
+
+        residualStats_t getResidualStats()
+
+        # Flow snapshots
+        void setPublishFlow(const bool publish)
+        bool getPublishFlow() const
+        FlowSnapshotBuffer_cpp getSnapshotBuffer()
+
+        # Flow history
+        void setHistoryDepth(const int depth, const bool quantized) except +
+        int getHistoryDepth() const
+        FlowHistory_cpp getHistory()
+
+        # Runtime parameters
+        ParameterBuffer_cpp getParameterBuffer()
+
         int height() const
         int width() const
 
@@ -71,18 +185,35 @@ cdef extern from 'flowfilter/gpu/flowfilter.h' namespace 'flowfilter::gpu':
         
 
         void configure()
-        void compute()
+        void compute() except + nogil
         float elapsedTime()
 
 
         # Pipeline stage outputs
         gimg.GPUImage_cpp getFlow()
+        gimg.GPUImage_cpp getFlow(const int level) except +
+        gimg.GPUImage_cpp getDeltaFlow(const int level) except +
+        gimg.GPUImage_cpp getImageConstant(const int level) except +
+        gimg.GPUImage_cpp getImageGradient(const int level) except +
+        gimg.GPUImage_cpp getTap(const filterTap_t tap, const int level) except +
 
 
         # Host load-download
-        void loadImage(fimg.image_t_cpp& image)
-        void downloadFlow(fimg.image_t_cpp& flow)
-        void downloadImage(fimg.image_t_cpp& image)
+        void loadImage(fimg.image_t_cpp& image) except + nogil
+        void loadImage(gimg.GPUImage_cpp& image) except + nogil
+        void loadImage(fimg.image_t_cpp& image, const double timestamp) except + nogil
+        void loadImage(gimg.GPUImage_cpp& image, const double timestamp) except + nogil
+
+        void setFrameInterval(const double interval) except +
+        double getFrameInterval() const
+        bool getFrameSkipped() const
+        int getSkippedFrames() const
+        void downloadFlow(fimg.image_t_cpp& flow) except + nogil
+        void downloadImage(fimg.image_t_cpp& image) except + nogil
+
+        int processSequence(vector[fimg.image_t_cpp]& frames,
+            vector[fimg.image_t_cpp]& flows,
+            sequenceCallback_t callback, void* userData) except + nogil
 
         # Paramters
         float getGamma(const int level) const
@@ -91,12 +222,65 @@ cdef extern from 'flowfilter/gpu/flowfilter.h' namespace 'flowfilter::gpu':
         float getMaxFlow() const
         void setMaxFlow(const float maxflow)
 
+        void setTimeStep(const float timeStep) except +
+        float getTimeStep() const
+
+        # Derotation
+        void setCamera(const gcam.perspectiveCamera_cpp& cam) except +
+        void setDerotate(const bool derotate) except +
+        bool getDerotate() const
+        void setAngularVelocity(const float wx, const float wy, const float wz)
+
+        # Seeding
+        void setSeeding(const bool seeding)
+        bool getSeeding() const
+        void setSeedThreshold(const float threshold) except +
+        float getSeedThreshold() const
+
+        # Output level
+        void setOutputLevel(const int level) except +
+        int getOutputLevel() const
+        void setUpsamplingSigmaSpace(const float sigma) except +
+        float getUpsamplingSigmaSpace() const
+        void setUpsamplingSigmaRange(const float sigma) except +
+        float getUpsamplingSigmaRange() const
+
         int getSmoothIterations(const int level) const
         void setSmoothIterations(const int level, const int smoothIterations)
 
+        void setSmoothMode(const gsmooth.smoothMode_t mode) except +
+        gsmooth.smoothMode_t getSmoothMode() const
+
+        void setSmoothSigmaSpace(const float sigma) except +
+        float getSmoothSigmaSpace() const
+
+        void setSmoothSigmaRange(const float sigma) except +
+        float getSmoothSigmaRange() const
+
         void setPropagationBorder(const int border)
         int getPropagationBorder() const
 
+        void setComputeResidual(const bint computeResidual)
+        bint getComputeResidual() const
+
+        void setResidualRange(const float residualRange)
+        float getResidualRange() const
+
+        residualStats_t getResidualStats(const int level)
+
+        # Flow snapshots
+        void setPublishFlow(const bool publish)
+        bool getPublishFlow() const
+        FlowSnapshotBuffer_cpp getSnapshotBuffer()
+
+        # Flow history
+        void setHistoryDepth(const int depth, const bool quantized) except +
+        int getHistoryDepth() const
+        FlowHistory_cpp getHistory()
+
+        # Runtime parameters
+        ParameterBuffer_cpp getParameterBuffer()
+
         int height() const
         int width() const
         int levels() const
@@ -106,7 +290,15 @@ cdef class FlowFilter:
     
     cdef FlowFilter_cpp ffilter
 
+    # host buffers returned when no output array is given
+    cdef object flowBuffer
+    cdef object imageBuffer
+
 
 cdef class PyramidalFlowFilter:
     
-    cdef PyramidalFlowFilter_cpp ffilter
\ No newline at end of file
+    cdef PyramidalFlowFilter_cpp ffilter
+
+    # host buffers returned when no output array is given
+    cdef object flowBuffer
+    cdef object imageBuffer
\ No newline at end of file
@@ -6,12 +6,124 @@
     :license: 3-clause BSD, see LICENSE for more details
 """
 
+from libc.stdint cimport uint64_t
+
 cimport numpy as np
 import numpy as np
 
 cimport flowfilter.image as fimg
 import flowfilter.image as fimg
 
+cimport flowfilter.gpu.image as gimg
+import flowfilter.gpu.image as gimg
+
+cimport flowfilter.gpu.flowsmoothing as gsmooth
+cimport flowfilter.gpu.camera as gcam
+import flowfilter.gpu.flowsmoothing as gsmooth
+
+
+def _isDeviceImage(img):
+    """Tells if img is a GPUImage or a DLPack tensor in CUDA memory"""
+
+    if isinstance(img, gimg.GPUImage):
+        return True
+
+    return (hasattr(img, '__dlpack_device__')
+        and img.__dlpack_device__()[0] == gimg.DLPACK_CUDA)
+
+
+# names of the intermediate buffers returned by getTap()
+TAPS = {'imageConstant': TAP_IMAGE_CONSTANT,
+        'imageGradient': TAP_IMAGE_GRADIENT,
+        'imageUpdated': TAP_IMAGE_UPDATED,
+        'propagatedFlow': TAP_PROPAGATED_FLOW,
+        'updatedFlow': TAP_UPDATED_FLOW,
+        'deltaFlow': TAP_DELTA_FLOW,
+        'flow': TAP_FLOW}
+
+
+cdef filterTap_t _tap(name) except *:
+
+    if name not in TAPS:
+        raise ValueError('unknown tap {0}, expected one of {1}'.format(name, sorted(TAPS.keys())))
+
+    return TAPS[name]
+
+
+cdef class _SequenceState:
+    """Python state reached by the processSequence() callback"""
+
+    cdef object callback
+    cdef object out
+    cdef object error
+
+
+cdef bool _sequenceCallback(const int frame, void* userData) noexcept with gil:
+
+    cdef _SequenceState state = <_SequenceState>userData
+
+    try:
+        return state.callback(frame, state.out[frame]) is not False
+    except BaseException as e:
+        state.error = e
+        return False
+
+
+cdef _checkFrames(frames, int height, int width):
+    """Raises ValueError if frames is not an array of shape [T, height, width]"""
+
+    if frames.ndim != 3 or frames.shape[1] != height or frames.shape[2] != width:
+        raise ValueError('frames should have shape [T, {0}, {1}], got: {2}'.format(
+            height, width, frames.shape))
+
+
+cdef tuple _wrapSequence(frames, out, int height, int width,
+    vector[fimg.image_t_cpp]& framesVec, vector[fimg.image_t_cpp]& flowsVec):
+    """Fills framesVec and flowsVec with the images of each frame.
+
+    Returns the Image wrappers of frames and out, which must
+    be kept alive while the vectors are in use.
+    """
+
+    _checkFrames(frames, height, width)
+
+    cdef int T = frames.shape[0]
+
+    if out.shape != (T, height, width, 2) or out.dtype != np.float32:
+        raise ValueError('out should be a float32 array of shape {0}, got: {1} {2}'.format(
+            (T, height, width, 2), out.dtype, out.shape))
+
+    # frames are stacked as rows of a single image. Inputs that cannot
+    # be reshaped without a copy are copied, outputs must be contiguous
+    framesFlat = np.reshape(frames, (T*height, width))
+    outFlat = out.view()
+    try:
+        outFlat.shape = (T*height, width, 2)
+    except AttributeError:
+        raise ValueError('out should be C contiguous')
+
+    cdef fimg.Image frames_w = fimg.Image(framesFlat)
+    cdef fimg.Image out_w = fimg.Image(outFlat, writable=True)
+
+    cdef fimg.image_t_cpp frame = frames_w.img
+    cdef fimg.image_t_cpp flow = out_w.img
+    frame.height = height
+    flow.height = height
+
+    cdef char* framesData = <char*>frames_w.img.data
+    cdef char* flowsData = <char*>out_w.img.data
+    cdef int t
+
+    for t in range(T):
+        frame.data = framesData + t*height*frames_w.img.pitch
+        flow.data = flowsData + t*height*out_w.img.pitch
+
+        framesVec.push_back(frame)
+        flowsVec.push_back(flow)
+
+    return frames_w, out_w
+
+
 cdef class FlowFilter:
 
     
@@ -24,301 +136,1190 @@ cdef class FlowFilter:
             maxflow, gamma)
 
 
-    def loadImage(self, np.ndarray img):
+    def loadImage(self, img, timestamp=None):
+        """Loads a new image into the filter
+
+        Parameters
+        ----------
+        img : buffer, GPUImage or DLPack tensor
+            uint8 or float32 image. Any object exporting the buffer
+            protocol is read without copy. GPUImage objects and CUDA
+            tensors exporting DLPack, for instance from an ML framework,
+            are copied device to device. The GIL is released during
+            the transfer.
+
+        timestamp : float, optional
+            capture time of the image, in units of frameInterval.
+            Repeated frames are detected and skipped by the next call
+            to compute(), see frameSkipped, and the flow is propagated
+            over the time elapsed since the last accepted frame. If
+            None, the image is one frame interval after the previous.
+        """
+
+        cdef gimg.GPUImage img_d
+        cdef fimg.Image img_w
+        cdef fimg.image_t_cpp img_c
+        cdef double ts = 0.0 if timestamp is None else timestamp
+        cdef bint timed = timestamp is not None
+
+        if _isDeviceImage(img):
+            img_d = img if isinstance(img, gimg.GPUImage) else gimg.fromDLPack(img)
+
+            with nogil:
+                if timed:
+                    self.ffilter.loadImage(img_d.img, ts)
+                else:
+                    self.ffilter.loadImage(img_d.img)
+
+            return
+
+        # wrap numpy array in a Image object
+        img_w = fimg.Image(img)
+        img_c = img_w.img
+
+        # transfer image to device memory space
+        with nogil:
+            if timed:
+                self.ffilter.loadImage(img_c, ts)
+            else:
+                self.ffilter.loadImage(img_c)
+
+
+    def getFlow(self, flow = None):
+        """Downloads the optical flow
+
+        Parameters
+        ----------
+        flow : buffer, optional
+            float32 output of shape [height, width, 2]. If None, the
+            flow is downloaded into a host buffer owned by the filter,
+            which is overwritten by subsequent calls.
+
+        Returns
+        -------
+        flow : ndarray or buffer
+        """
+
+        if flow is None:
+            if self.flowBuffer is None:
+                self.flowBuffer = np.empty((self.height, self.width, 2), dtype=np.float32)
+
+            flow = self.flowBuffer
+
+        # wrap numpy array in a Image object
+        cdef fimg.Image flow_w = fimg.Image(flow, writable=True)
+        cdef fimg.image_t_cpp flow_c = flow_w.img
+
+        # transfer flow to host memory space
+        with nogil:
+            self.ffilter.downloadFlow(flow_c)
+
+        return flow
+
+
+    def getFlowDevice(self):
+        """Returns GPU buffer with the optical flow.
+
+        Use toDLPack() on the returned image to hand it over
+        to other libraries without copy.
+        """
+
+        cdef gimg.GPUImage flow = gimg.GPUImage()
+        flow.img = self.ffilter.getFlow()
+
+        return flow
+
+
+    def getImageConstantDevice(self):
+        """Returns GPU buffer with the image model constant term.
+        """
+
+        cdef gimg.GPUImage img = gimg.GPUImage()
+        img.img = self.ffilter.getImageConstant()
+
+        return img
+
+
+    def getImageGradientDevice(self):
+        """Returns GPU buffer with the image model gradient.
+        """
+
+        cdef gimg.GPUImage img = gimg.GPUImage()
+        img.img = self.ffilter.getImageGradient()
+
+        return img
+
+
+    def getImage(self, image = None):
+        """Downloads the image loaded into the filter
+
+        Parameters
+        ----------
+        image : buffer, optional
+            float32 output of shape [height, width]. If None, the
+            image is downloaded into a host buffer owned by the filter,
+            which is overwritten by subsequent calls.
+
+        Returns
+        -------
+        image : ndarray or buffer
+        """
+
+        if image is None:
+            if self.imageBuffer is None:
+                self.imageBuffer = np.empty((self.height, self.width), dtype=np.float32)
+
+            image = self.imageBuffer
+
+        # wrap numpy array in a Image object
+        cdef fimg.Image image_w = fimg.Image(image, writable=True)
+        cdef fimg.image_t_cpp image_c = image_w.img
+
+        # transfer image to host memory space
+        with nogil:
+            self.ffilter.downloadImage(image_c)
+
+        return image
+
+
+    def getTapDevice(self, name):
+        """Returns an intermediate buffer of the last call to compute()
+
+        The returned GPUImage shares the filter buffer. It should be
+        treated as read only and its content is valid until the next
+        call to compute().
+
+        Parameters
+        ----------
+        name : string
+            One of 'imageConstant', 'imageGradient', 'imageUpdated',
+            'propagatedFlow', 'updatedFlow' (before smoothing) or 'flow'.
+
+        Returns
+        -------
+        img : GPUImage
+
+        Raises
+        ------
+        ValueError : if the filter does not have the tap.
+        """
+
+        cdef gimg.GPUImage img = gimg.GPUImage()
+        img.img = self.ffilter.getTap(_tap(name))
+
+        return img
+
+
+    def getTap(self, name, out = None):
+        """Downloads an intermediate buffer, see getTapDevice()
+
+        Parameters
+        ----------
+        name : string
+            Tap name.
+
+        out : buffer, optional
+            float32 output with the shape of the tap. If None,
+            a new array is allocated.
+
+        Returns
+        -------
+        out : ndarray or buffer
+        """
+
+        img = self.getTapDevice(name)
+        if out is None:
+            out = np.empty(img.shape, dtype=np.float32)
+
+        return img.download(np.float32, out)
+
+
+    def getImageGradient(self, gradient = None):
+        return self.getTap('imageGradient', gradient)
+
+
+    def getImageConstant(self, image = None):
+        return self.getTap('imageConstant', image)
+
+
+    def getImageUpdated(self, image = None):
+        return self.getTap('imageUpdated', image)
+
+
+    def getSmoothedFlow(self, flow = None):
+        return self.getTap('flow', flow)
+
+
+    def processSequence(self, frames, out = None, callback = None):
+        """Runs the filter over a whole image sequence
+
+        The sequence is processed inside the C++ library with the
+        GIL released, except while calling the callback.
+
+        Parameters
+        ----------
+        frames : ndarray
+            uint8 or float32 images of shape [T, height, width].
+
+        out : ndarray, optional
+            C contiguous float32 output of shape [T, height, width, 2],
+            for instance a numpy.memmap. If None, a new array is allocated.
+
+        callback : callable, optional
+            Called as callback(t, flow) after each frame, with flow a
+            view of out[t]. Processing stops if it returns False.
+
+        Returns
+        -------
+        flow : ndarray
+            The frames of out processed before stopping.
+
+        Raises
+        ------
+        ValueError : if frames or out do not have the expected
+            shape, or out is not a writable float32 C contiguous array.
+        """
+
+        frames = np.asarray(frames)
+        _checkFrames(frames, self.height, self.width)
+
+        if out is None:
+            out = np.empty((frames.shape[0], self.height, self.width, 2), dtype=np.float32)
+
+        if frames.shape[0] == 0:
+            return out
+
+        cdef vector[fimg.image_t_cpp] framesVec
+        cdef vector[fimg.image_t_cpp] flowsVec
+        wrappers = _wrapSequence(frames, out, self.height, self.width, framesVec, flowsVec)
+
+        cdef _SequenceState state = _SequenceState()
+        state.callback = callback
+        state.out = out
+
+        cdef sequenceCallback_t callback_c = NULL
+        if callback is not None:
+            callback_c = _sequenceCallback
+
+        cdef void* state_c = <void*>state
+        cdef int processed
+
+        with nogil:
+            processed = self.ffilter.processSequence(framesVec, flowsVec, callback_c, state_c)
+
+        if state.error is not None:
+            raise state.error
+
+        return out[0:processed]
+
+
+    def getSnapshot(self, flow = None):
+        """Returns the latest flow published by compute()
+
+        Can be called from another thread while compute() runs,
+        it never waits for the frame being computed. The flow is
+        only published if publishFlow is True.
+
+        Parameters
+        ----------
+        flow : buffer, optional
+            float32 output of shape [height, width, 2]. If None,
+            a new array is allocated.
+
+        Returns
+        -------
+        flow : ndarray or buffer
+            Latest published flow, zero if none was published yet.
+
+        sequence : integer
+            Number of the compute() call that produced the flow,
+            starting at 1. Zero if none was published yet.
+
+        Raises
+        ------
+        RuntimeError : if publishFlow is False.
+        """
+
+        cdef FlowSnapshotBuffer_cpp snapshots = self.ffilter.getSnapshotBuffer()
+
+        if not snapshots.isAllocated():
+            raise RuntimeError('flow publishing is not enabled, set publishFlow to True')
+
+        if flow is None:
+            flow = np.zeros((self.height, self.width, 2), dtype=np.float32)
+
+        cdef fimg.Image flow_w = fimg.Image(flow, writable=True)
+        cdef fimg.image_t_cpp flow_c = flow_w.img
+        cdef uint64_t sequence
+
+        with nogil:
+            snapshots.acquire()
+            snapshots.downloadFlow(flow_c)
+            sequence = snapshots.getSequence()
+
+        return flow, sequence
+
+
+    def setHistoryDepth(self, int depth, bint quantized = False):
+        """Keeps the last depth output flows, see getHistory()
+
+        Parameters
+        ----------
+        depth : integer
+            Number of flows kept. Zero disables the history.
+
+        quantized : bool, optional
+            If True, flows are stored as int16 with a resolution of
+            1/256 pixels, saturating at 128 pixels.
+        """
+
+        self.ffilter.setHistoryDepth(depth, quantized)
+
+
+    def getHistory(self, int age = 0, flow = None):
+        """Returns a flow kept in the history
+
+        Parameters
+        ----------
+        age : integer, optional
+            Number of frames before the last computed one, 0 for the
+            last output flow. It must be less than historySize.
+
+        flow : buffer, optional
+            float32 output of shape [height, width, 2]. If None,
+            a new array is allocated.
+
+        Returns
+        -------
+        flow : ndarray or buffer
+            Flow, in pixels also for quantized histories.
+
+        frame : integer
+            Number of the compute() call that produced the flow since
+            the history was set, starting at 1.
+
+        Raises
+        ------
+        ValueError : if age is out of range.
+        """
+
+        cdef FlowHistory_cpp history = self.ffilter.getHistory()
+
+        if flow is None:
+            flow = np.zeros((self.height, self.width, 2), dtype=np.float32)
+
+        cdef fimg.Image flow_w = fimg.Image(flow, writable=True)
+        cdef fimg.image_t_cpp flow_c = flow_w.img
+        cdef uint64_t frame = history.getFrame(age)
+
+        with nogil:
+            history.downloadFlow(age, flow_c)
+
+        return flow, frame
+
+
+    property historyDepth:
+        def __get__(self):
+            return self.ffilter.getHistoryDepth()
+
+        def __set__(self, int value):
+            self.ffilter.setHistoryDepth(value, False)
+
+        def __del__(self):
+            pass
+
+
+    property historySize:
+        """Number of flows available in the history"""
+        def __get__(self):
+            return self.ffilter.getHistory().size()
+
+        def __set__(self, value):
+            raise RuntimeError('historySize cannot be set')
+
+        def __del__(self):
+            pass
+
+
+    def submitParameters(self, gamma = None, maxflow = None, smoothIterations = None):
+        """Submits parameters from a control thread
+
+        Unlike the gamma, maxflow and smoothIterations properties,
+        this method can be called while another thread runs compute().
+        The parameters are applied at the start of the next compute(),
+        all of them in the same frame. Arguments left to None are
+        not changed.
+
+        Parameters
+        ----------
+        gamma : float, optional.
+
+        maxflow : float, optional.
+            Also sets the propagation iterations.
+
+        smoothIterations : integer, optional.
+
+        Raises
+        ------
+        ValueError : if a parameter is out of range.
+        """
+
+        cdef ParameterBuffer_cpp params = self.ffilter.getParameterBuffer()
+
+        if gamma is not None:
+            params.setGamma(0, gamma)
+
+        if smoothIterations is not None:
+            params.setSmoothIterations(0, smoothIterations)
+
+        if maxflow is not None:
+            params.setMaxFlow(maxflow)
+
+        params.submit()
+
+
+    def configure(self):
+        self.ffilter.configure()
+
+
+    def compute(self):
+        """Runs the filter on the last loaded image
+
+        The GIL is released during computation, so several Python
+        threads can drive different filters in parallel. A filter
+        should not be used by more than one thread at a time.
+        """
+
+        with nogil:
+            self.ffilter.compute()
+
+
+    def elapsedTime(self):
+        return self.ffilter.elapsedTime()
+
+
+    def getResidualStats(self):
+        """
+        Returns the brightness constancy residual statistics of last compute() call.
+
+        Returns
+        -------
+        stats : dict
+            mean, p50, p90, p99 and saturated fraction of the residual.
+        """
+
+        if not self.ffilter.getComputeResidual():
+            raise RuntimeError('residual computation not enabled, set computeResidual to True')
+
+        return self.ffilter.getResidualStats()
+
+
+    #############################################
+    # PROPERTIES
+    #############################################
+
+    property height:
+        def __get__(self):
+            return self.ffilter.height()
+
+        def __set__(self, value):
+            raise RuntimeError('Filter height cannot be set after instantiation')
+
+        def __del__(self):
+            pass
+
+
+    property width:
+        def __get__(self):
+            return self.ffilter.width()
+
+        def __set__(self, value):
+            raise RuntimeError('Filter width cannot be set after instantiation')
+
+        def __del__(self):
+            pass
+
+
+    property gamma:
+        def __get__(self):
+            return self.ffilter.getGamma()
+
+        def __set__(self, float value):
+            self.ffilter.setGamma(value)
+
+        def __del__(self):
+            pass
+
+
+    property maxflow:
+        def __get__(self):
+            return self.ffilter.getMaxFlow()
+
+        def __set__(self, float value):
+            self.ffilter.setMaxFlow(value)
+
+        def __del__(self):
+            pass
+
+
+    property timeStep:
+        """Frame intervals between the previous and the next image
+
+        Set by loadImage() from the image timestamps.
+        """
+        def __get__(self):
+            return self.ffilter.getTimeStep()
+
+        def __set__(self, float value):
+            self.ffilter.setTimeStep(value)
+
+        def __del__(self):
+            pass
+
+
+    property frameInterval:
+        """Nominal frame interval, in timestamp units"""
+        def __get__(self):
+            return self.ffilter.getFrameInterval()
+
+        def __set__(self, double value):
+            self.ffilter.setFrameInterval(value)
+
+        def __del__(self):
+            pass
+
+
+    property frameSkipped:
+        """True if the last loaded image is a duplicate and compute() does nothing"""
+        def __get__(self):
+            return self.ffilter.getFrameSkipped()
+
+        def __set__(self, value):
+            raise RuntimeError('frameSkipped cannot be set')
+
+        def __del__(self):
+            pass
+
+
+    property skippedFrames:
+        """Number of duplicate images loaded so far"""
+        def __get__(self):
+            return self.ffilter.getSkippedFrames()
+
+        def __set__(self, value):
+            raise RuntimeError('skippedFrames cannot be set')
+
+        def __del__(self):
+            pass
+
+
+    property smoothIterations:
+        def __get__(self):
+            return self.ffilter.getSmoothIterations()
+
+        def __set__(self, int value):
+            self.ffilter.setSmoothIterations(value)
+
+        def __del__(self):
+            pass
+
+
+    property propagationIterations:
+        def __get__(self):
+            return self.ffilter.getPropagationIterations()
+
+        def __set__(self, value):
+            raise RuntimeError('propagation iterations cannot be set, use maxflow instead')
+
+        def __del__(self):
+            pass
+
+
+    property smoothMode:
+        """Smoothing filter, 'box', 'domainTransform', 'median3' or 'median5'.
+
+        'domainTransform' is an edge-aware filter guided by the
+        image constant, see smoothSigmaSpace and smoothSigmaRange.
+        The median modes run smoothIterations 3x3 or 5x5 median
+        passes on each flow component, removing isolated outliers.
+        """
+
+        def __get__(self):
+            return gsmooth.smoothModeName(self.ffilter.getSmoothMode())
+
+        def __set__(self, mode):
+            self.ffilter.setSmoothMode(gsmooth.smoothModeValue(mode))
+
+        def __del__(self):
+            pass
+
+
+    property smoothSigmaSpace:
+        """Spatial standard deviation of the domain transform, in pixels"""
+
+        def __get__(self):
+            return self.ffilter.getSmoothSigmaSpace()
+
+        def __set__(self, float sigma):
+            self.ffilter.setSmoothSigmaSpace(sigma)
+
+        def __del__(self):
+            pass
+
+
+    property smoothSigmaRange:
+        """Range standard deviation of the domain transform, for images in [0, 1]"""
+
+        def __get__(self):
+            return self.ffilter.getSmoothSigmaRange()
+
+        def __set__(self, float sigma):
+            self.ffilter.setSmoothSigmaRange(sigma)
+
+        def __del__(self):
+            pass
+
+
+    property propagationBorder:
+        def __get__(self):
+            return self.ffilter.getPropagationBorder();
+
+        def __set__(self, value):
+            self.ffilter.setPropagationBorder(value)
+
+        def __del__(self):
+            pass
+
+
+    property computeResidual:
+        def __get__(self):
+            return self.ffilter.getComputeResidual()
+
+        def __set__(self, bint value):
+            self.ffilter.setComputeResidual(value)
+
+        def __del__(self):
+            pass
+
+
+    property publishFlow:
+        def __get__(self):
+            return self.ffilter.getPublishFlow()
+
+        def __set__(self, bint value):
+            self.ffilter.setPublishFlow(value)
+
+        def __del__(self):
+            pass
+
+
+    property residualRange:
+        def __get__(self):
+            return self.ffilter.getResidualRange()
+
+        def __set__(self, float value):
+            self.ffilter.setResidualRange(value)
+
+        def __del__(self):
+            pass
+
+
+cdef class PyramidalFlowFilter:
+    
+
+    def __cinit__(self, int height, int width, int levels):
+
+        self.ffilter = PyramidalFlowFilter_cpp(height, width, levels)
+
+
+    def loadImage(self, img, timestamp=None):
+        """Loads a new image into the filter
+
+        Parameters
+        ----------
+        img : buffer, GPUImage or DLPack tensor
+            uint8 or float32 image. Any object exporting the buffer
+            protocol is read without copy. GPUImage objects and CUDA
+            tensors exporting DLPack, for instance from an ML framework,
+            are copied device to device. The GIL is released during
+            the transfer.
+
+        timestamp : float, optional
+            capture time of the image, in units of frameInterval.
+            Repeated frames are detected and skipped by the next call
+            to compute(), see frameSkipped, and the flow is propagated
+            over the time elapsed since the last accepted frame. If
+            None, the image is one frame interval after the previous.
+        """
+
+        cdef gimg.GPUImage img_d
+        cdef fimg.Image img_w
+        cdef fimg.image_t_cpp img_c
+        cdef double ts = 0.0 if timestamp is None else timestamp
+        cdef bint timed = timestamp is not None
+
+        if _isDeviceImage(img):
+            img_d = img if isinstance(img, gimg.GPUImage) else gimg.fromDLPack(img)
+
+            with nogil:
+                if timed:
+                    self.ffilter.loadImage(img_d.img, ts)
+                else:
+                    self.ffilter.loadImage(img_d.img)
+
+            return
 
         # wrap numpy array in a Image object
-        cdef fimg.Image img_w = fimg.Image(img)
+        img_w = fimg.Image(img)
+        img_c = img_w.img
 
         # transfer image to device memory space
-        self.ffilter.loadImage(img_w.img)
+        with nogil:
+            if timed:
+                self.ffilter.loadImage(img_c, ts)
+            else:
+                self.ffilter.loadImage(img_c)
+
+
+    def getFlow(self, flow = None):
+        """Downloads the optical flow
+
+        Parameters
+        ----------
+        flow : buffer, optional
+            float32 output of shape [height, width, 2]. If None, the
+            flow is downloaded into a host buffer owned by the filter,
+            which is overwritten by subsequent calls.
+
+        Returns
+        -------
+        flow : ndarray or buffer
+        """
+
+        if flow is None:
+            if self.flowBuffer is None:
+                self.flowBuffer = np.empty((self.height, self.width, 2), dtype=np.float32)
+
+            flow = self.flowBuffer
+
+        # wrap numpy array in a Image object
+        cdef fimg.Image flow_w = fimg.Image(flow, writable=True)
+        cdef fimg.image_t_cpp flow_c = flow_w.img
+
+        # transfer flow to host memory space
+        with nogil:
+            self.ffilter.downloadFlow(flow_c)
+
+        return flow
+
+
+    def getFlowDevice(self, level = None):
+        """Returns GPU buffer with the optical flow.
+
+        Use toDLPack() on the returned image to hand it over
+        to other libraries without copy.
+
+        Parameters
+        ----------
+        level : integer, optional
+            Pyramid level. If None, returns the output flow of
+            the filter. Defaults to None.
+        """
+
+        cdef gimg.GPUImage flow = gimg.GPUImage()
+
+        if level is None:
+            flow.img = self.ffilter.getFlow()
+        else:
+            flow.img = self.ffilter.getFlow(<int>level)
 
+        return flow
 
-    def getFlow(self, np.ndarray flow = None):
 
-        if flow == None:
-            flow = np.zeros((self.height, self.width, 2), dtype=np.float32)
+    def getDeltaFlowDevice(self, int level):
+        """Returns GPU buffer with the delta flow of a pyramid level.
 
-        # wrap numpy array in a Image object
-        cdef fimg.Image flow_w = fimg.Image(flow)
+        Raises
+        ------
+        ValueError : if level is out of range or is the top level.
+        """
 
-        # transfer image to device memory space
-        self.ffilter.downloadFlow(flow_w.img)
+        cdef gimg.GPUImage flow = gimg.GPUImage()
+        flow.img = self.ffilter.getDeltaFlow(level)
 
         return flow
 
 
-    def getImage(self, np.ndarray image = None):
+    def getImageConstantDevice(self, int level = 0):
+        """Returns GPU buffer with the image model constant term of a pyramid level.
+        """
 
-        if image == None:
-            image = np.zeros((self.height, self.width), dtype=np.float32)
+        cdef gimg.GPUImage img = gimg.GPUImage()
+        img.img = self.ffilter.getImageConstant(level)
 
-        # wrap numpy array in a Image object
-        cdef fimg.Image image_w = fimg.Image(image)
+        return img
 
-        # transfer image to device memory space
-        self.ffilter.downloadImage(image_w.img)
 
-        return image
+    def getImageGradientDevice(self, int level = 0):
+        """Returns GPU buffer with the image model gradient of a pyramid level.
+        """
 
+        cdef gimg.GPUImage img = gimg.GPUImage()
+        img.img = self.ffilter.getImageGradient(level)
 
-    #def getImageGradient(self, np.ndarray gradient = None):
+        return img
 
-    #    if gradient == None:
-    #        gradient = np.zeros((self.height, self.width, 2), dtype=np.float32)
 
-    #    # wrap numpy array in a Image object
-    #    cdef fimg.Image gradient_w = fimg.Image(gradient)
+    def getImage(self, image = None):
+        """Downloads the image loaded into the filter
 
-    #    # transfer image to device memory space
-    #    self.ffilter.downloadImageGradient(gradient_w.img)
+        Parameters
+        ----------
+        image : buffer, optional
+            float32 output of shape [height, width]. If None, the
+            image is downloaded into a host buffer owned by the filter,
+            which is overwritten by subsequent calls.
 
-    #    return gradient
+        Returns
+        -------
+        image : ndarray or buffer
+        """
 
+        if image is None:
+            if self.imageBuffer is None:
+                self.imageBuffer = np.empty((self.height, self.width), dtype=np.float32)
 
-    #def getImageConstant(self, np.ndarray image = None):
+            image = self.imageBuffer
 
-    #    if image == None:
-    #        image = np.zeros((self.height, self.width), dtype=np.float32)
+        # wrap numpy array in a Image object
+        cdef fimg.Image image_w = fimg.Image(image, writable=True)
+        cdef fimg.image_t_cpp image_c = image_w.img
 
-    #    # wrap numpy array in a Image object
-    #    cdef fimg.Image image_w = fimg.Image(image)
+        # transfer image to host memory space
+        with nogil:
+            self.ffilter.downloadImage(image_c)
 
-    #    # transfer image to device memory space
-    #    self.ffilter.downloadImageConstant(image_w.img)
+        return image
 
-    #    return image
 
+    def getTapDevice(self, name, int level = 0):
+        """Returns an intermediate buffer of a pyramid level
 
-    #def getImageUpdated(self, np.ndarray image = None):
+        The returned GPUImage shares the filter buffer. It should be
+        treated as read only and its content is valid until the next
+        call to compute().
 
-    #    if image == None:
-    #        image = np.zeros((self.height, self.width), dtype=np.float32)
+        Parameters
+        ----------
+        name : string
+            One of 'imageConstant', 'imageGradient', 'imageUpdated',
+            'propagatedFlow', 'updatedFlow' (before smoothing),
+            'deltaFlow' (not defined at the top level) or 'flow'.
 
-    #    # wrap numpy array in a Image object
-    #    cdef fimg.Image image_w = fimg.Image(image)
+        level : integer, optional
+            Pyramid level, 0 has the input image resolution.
+            Defaults to 0.
 
-    #    # transfer image to device memory space
-    #    self.ffilter.downloadImageUpdated(image_w.img)
+        Returns
+        -------
+        img : GPUImage
 
-    #    return image
+        Raises
+        ------
+        ValueError : if the level is out of range or does not have the tap.
+        """
 
+        cdef gimg.GPUImage img = gimg.GPUImage()
+        img.img = self.ffilter.getTap(_tap(name), level)
 
-    #def getSmoothedFlow(self, np.ndarray flow = None):
+        return img
 
-    #    if flow == None:
-    #        flow = np.zeros((self.height, self.width, 2), dtype=np.float32)
 
-    #    # wrap numpy array in a Image object
-    #    cdef fimg.Image flow_w = fimg.Image(flow)
+    def getTap(self, name, int level = 0, out = None):
+        """Downloads an intermediate buffer, see getTapDevice()
 
-    #    # transfer image to device memory space
-    #    self.ffilter.downloadSmoothedFlow(flow_w.img)
+        Parameters
+        ----------
+        name : string
+            Tap name.
 
-    #    return flow
+        level : integer, optional
+            Pyramid level. Defaults to 0.
 
+        out : buffer, optional
+            float32 output with the shape of the tap. If None,
+            a new array is allocated.
 
-    def configure(self):
-        self.ffilter.configure()
+        Returns
+        -------
+        out : ndarray or buffer
+        """
 
+        img = self.getTapDevice(name, level)
+        if out is None:
+            out = np.empty(img.shape, dtype=np.float32)
 
-    def compute(self):
-        self.ffilter.compute()
+        return img.download(np.float32, out)
 
 
-    def elapsedTime(self):
-        return self.ffilter.elapsedTime()
+    def getImageGradient(self, int level = 0, gradient = None):
+        return self.getTap('imageGradient', level, gradient)
 
 
-    #############################################
-    # PROPERTIES
-    #############################################
+    def getImageConstant(self, int level = 0, image = None):
+        return self.getTap('imageConstant', level, image)
 
-    property height:
-        def __get__(self):
-            return self.ffilter.height()
 
-        def __set__(self, value):
-            raise RuntimeError('Filter height cannot be set after instantiation')
+    def getImageUpdated(self, int level = 0, image = None):
+        return self.getTap('imageUpdated', level, image)
 
-        def __del__(self):
-            pass
 
+    def getSmoothedFlow(self, int level = 0, flow = None):
+        return self.getTap('flow', level, flow)
 
-    property width:
-        def __get__(self):
-            return self.ffilter.width()
 
-        def __set__(self, value):
-            raise RuntimeError('Filter width cannot be set after instantiation')
+    def processSequence(self, frames, out = None, callback = None):
+        """Runs the filter over a whole image sequence
 
-        def __del__(self):
-            pass
+        The sequence is processed inside the C++ library with the
+        GIL released, except while calling the callback.
 
+        Parameters
+        ----------
+        frames : ndarray
+            uint8 or float32 images of shape [T, height, width].
 
-    property gamma:
-        def __get__(self):
-            return self.ffilter.getGamma()
+        out : ndarray, optional
+            C contiguous float32 output of shape [T, height, width, 2],
+            for instance a numpy.memmap. If None, a new array is allocated.
 
-        def __set__(self, float value):
-            self.ffilter.setGamma(value)
+        callback : callable, optional
+            Called as callback(t, flow) after each frame, with flow a
+            view of out[t]. Processing stops if it returns False.
 
-        def __del__(self):
-            pass
+        Returns
+        -------
+        flow : ndarray
+            The frames of out processed before stopping.
 
+        Raises
+        ------
+        ValueError : if frames or out do not have the expected
+            shape, or out is not a writable float32 C contiguous array.
+        """
 
-    property maxflow:
-        def __get__(self):
-            return self.ffilter.getMaxFlow()
+        frames = np.asarray(frames)
+        _checkFrames(frames, self.height, self.width)
 
-        def __set__(self, float value):
-            self.ffilter.setMaxFlow(value)
+        if out is None:
+            out = np.empty((frames.shape[0], self.height, self.width, 2), dtype=np.float32)
 
-        def __del__(self):
-            pass
+        if frames.shape[0] == 0:
+            return out
 
+        cdef vector[fimg.image_t_cpp] framesVec
+        cdef vector[fimg.image_t_cpp] flowsVec
+        wrappers = _wrapSequence(frames, out, self.height, self.width, framesVec, flowsVec)
 
-    property smoothIterations:
-        def __get__(self):
-            return self.ffilter.getSmoothIterations()
+        cdef _SequenceState state = _SequenceState()
+        state.callback = callback
+        state.out = out
 
-        def __set__(self, int value):
-            self.ffilter.setSmoothIterations(value)
+        cdef sequenceCallback_t callback_c = NULL
+        if callback is not None:
+            callback_c = _sequenceCallback
 
-        def __del__(self):
-            pass
+        cdef void* state_c = <void*>state
+        cdef int processed
 
+        with nogil:
+            processed = self.ffilter.processSequence(framesVec, flowsVec, callback_c, state_c)
 
-    property propagationIterations:
-        def __get__(self):
-            return self.ffilter.getPropagationIterations()
+        if state.error is not None:
+            raise state.error
 
-        def __set__(self, value):
-            raise RuntimeError('propagation iterations cannot be set, use maxflow instead')
+        return out[0:processed]
 
-        def __del__(self):
-            pass
 
+    def getSnapshot(self, flow = None):
+        """Returns the latest flow published by compute()
 
-    property propagationBorder:
-        def __get__(self):
-            return self.ffilter.getPropagationBorder();
+        Can be called from another thread while compute() runs,
+        it never waits for the frame being computed. The flow is
+        only published if publishFlow is True.
 
-        def __set__(self, value):
-            self.ffilter.setPropagationBorder(value)
+        Parameters
+        ----------
+        flow : buffer, optional
+            float32 output of shape [height, width, 2]. If None,
+            a new array is allocated.
 
-        def __del__(self):
-            pass
+        Returns
+        -------
+        flow : ndarray or buffer
+            Latest published flow, zero if none was published yet.
 
+        sequence : integer
+            Number of the compute() call that produced the flow,
+            starting at 1. Zero if none was published yet.
 
-cdef class PyramidalFlowFilter:
-    
+        Raises
+        ------
+        RuntimeError : if publishFlow is False.
+        """
 
-    def __cinit__(self, int height, int width, int levels):
+        cdef FlowSnapshotBuffer_cpp snapshots = self.ffilter.getSnapshotBuffer()
 
-        self.ffilter = PyramidalFlowFilter_cpp(height, width, levels)
+        if not snapshots.isAllocated():
+            raise RuntimeError('flow publishing is not enabled, set publishFlow to True')
 
+        if flow is None:
+            flow = np.zeros((self.height, self.width, 2), dtype=np.float32)
 
-    def loadImage(self, np.ndarray img):
+        cdef fimg.Image flow_w = fimg.Image(flow, writable=True)
+        cdef fimg.image_t_cpp flow_c = flow_w.img
+        cdef uint64_t sequence
 
-        # wrap numpy array in a Image object
-        cdef fimg.Image img_w = fimg.Image(img)
+        with nogil:
+            snapshots.acquire()
+            snapshots.downloadFlow(flow_c)
+            sequence = snapshots.getSequence()
 
-        # transfer image to device memory space
-        self.ffilter.loadImage(img_w.img)
+        return flow, sequence
 
 
-    def getFlow(self, np.ndarray flow = None):
+    def setHistoryDepth(self, int depth, bint quantized = False):
+        """Keeps the last depth output flows, see getHistory()
 
-        if flow == None:
-            flow = np.zeros((self.height, self.width, 2), dtype=np.float32)
+        Parameters
+        ----------
+        depth : integer
+            Number of flows kept. Zero disables the history.
 
-        # wrap numpy array in a Image object
-        cdef fimg.Image flow_w = fimg.Image(flow)
+        quantized : bool, optional
+            If True, flows are stored as int16 with a resolution of
+            1/256 pixels, saturating at 128 pixels.
+        """
 
-        # transfer image to device memory space
-        self.ffilter.downloadFlow(flow_w.img)
+        self.ffilter.setHistoryDepth(depth, quantized)
 
-        return flow
 
+    def getHistory(self, int age = 0, flow = None):
+        """Returns a flow kept in the history
 
-    def getFlowDevice(self):
-        """Returns GPU buffer with the optical flow.
-        """
+        Parameters
+        ----------
+        age : integer, optional
+            Number of frames before the last computed one, 0 for the
+            last output flow. It must be less than historySize.
 
-        cdef gimg.GPUImage flow = gimg.GPUImage()
-        flow.img = self.ffilter.getFlow()
+        flow : buffer, optional
+            float32 output of shape [height, width, 2]. If None,
+            a new array is allocated.
 
-        return flow
+        Returns
+        -------
+        flow : ndarray or buffer
+            Flow, in pixels also for quantized histories.
 
+        frame : integer
+            Number of the compute() call that produced the flow since
+            the history was set, starting at 1.
 
-    def getImage(self, np.ndarray image = None):
+        Raises
+        ------
+        ValueError : if age is out of range.
+        """
 
-        if image == None:
-            image = np.zeros((self.height, self.width), dtype=np.float32)
+        cdef FlowHistory_cpp history = self.ffilter.getHistory()
 
-        # wrap numpy array in a Image object
-        cdef fimg.Image image_w = fimg.Image(image)
+        if flow is None:
+            flow = np.zeros((self.height, self.width, 2), dtype=np.float32)
 
-        # transfer image to device memory space
-        self.ffilter.downloadImage(image_w.img)
+        cdef fimg.Image flow_w = fimg.Image(flow, writable=True)
+        cdef fimg.image_t_cpp flow_c = flow_w.img
+        cdef uint64_t frame = history.getFrame(age)
 
-        return image
+        with nogil:
+            history.downloadFlow(age, flow_c)
 
+        return flow, frame
 
-    #def getImageGradient(self, np.ndarray gradient = None):
 
-    #    if gradient == None:
-    #        gradient = np.zeros((self.height, self.width, 2), dtype=np.float32)
+    property historyDepth:
+        def __get__(self):
+            return self.ffilter.getHistoryDepth()
 
-    #    # wrap numpy array in a Image object
-    #    cdef fimg.Image gradient_w = fimg.Image(gradient)
+        def __set__(self, int value):
+            self.ffilter.setHistoryDepth(value, False)
 
-    #    # transfer image to device memory space
-    #    self.ffilter.downloadImageGradient(gradient_w.img)
+        def __del__(self):
+            pass
 
-    #    return gradient
 
+    property historySize:
+        """Number of flows available in the history"""
+        def __get__(self):
+            return self.ffilter.getHistory().size()
 
-    #def getImageConstant(self, np.ndarray image = None):
+        def __set__(self, value):
+            raise RuntimeError('historySize cannot be set')
 
-    #    if image == None:
-    #        image = np.zeros((self.height, self.width), dtype=np.float32)
+        def __del__(self):
+            pass
 
-    #    # wrap numpy array in a Image object
-    #    cdef fimg.Image image_w = fimg.Image(image)
 
-    #    # transfer image to device memory space
-    #    self.ffilter.downloadImageConstant(image_w.img)
+    def submitParameters(self, gamma = None, maxflow = None, smoothIterations = None):
+        """Submits parameters from a control thread
 
-    #    return image
+        Unlike the gamma, maxflow and smoothIterations properties,
+        this method can be called while another thread runs compute().
+        The parameters are applied at the start of the next compute(),
+        all of them in the same frame. Arguments left to None are
+        not changed.
 
+        Parameters
+        ----------
+        gamma : float or list of floats, optional.
+            Gamma of each level, or a float if levels is 1.
 
-    #def getImageUpdated(self, np.ndarray image = None):
+        maxflow : float, optional.
+            Maximum flow at level 0, also sets the propagation
+            iterations of each level.
 
-    #    if image == None:
-    #        image = np.zeros((self.height, self.width), dtype=np.float32)
+        smoothIterations : integer or list of integers, optional.
+            Smoothing iterations of each level, or an integer if
+            levels is 1.
 
-    #    # wrap numpy array in a Image object
-    #    cdef fimg.Image image_w = fimg.Image(image)
+        Raises
+        ------
+        ValueError : if a parameter is out of range.
+        """
 
-    #    # transfer image to device memory space
-    #    self.ffilter.downloadImageUpdated(image_w.img)
+        cdef ParameterBuffer_cpp params = self.ffilter.getParameterBuffer()
 
-    #    return image
+        if self.levels == 1:
+            if gamma is not None: gamma = [gamma]
+            if smoothIterations is not None: smoothIterations = [smoothIterations]
 
+        if gamma is not None:
+            if len(gamma) != self.levels:
+                raise ValueError('gamma should have {0} values'.format(self.levels))
 
-    #def getSmoothedFlow(self, np.ndarray flow = None):
+            for h in range(self.levels):
+                params.setGamma(h, gamma[h])
 
-    #    if flow == None:
-    #        flow = np.zeros((self.height, self.width, 2), dtype=np.float32)
+        if smoothIterations is not None:
+            if len(smoothIterations) != self.levels:
+                raise ValueError('smoothIterations should have {0} values'.format(self.levels))
 
-    #    # wrap numpy array in a Image object
-    #    cdef fimg.Image flow_w = fimg.Image(flow)
+            for h in range(self.levels):
+                params.setSmoothIterations(h, smoothIterations[h])
 
-    #    # transfer image to device memory space
-    #    self.ffilter.downloadSmoothedFlow(flow_w.img)
+        if maxflow is not None:
+            params.setMaxFlow(maxflow)
 
-    #    return flow
+        params.submit()
 
 
     def configure(self):
@@ -326,13 +1327,45 @@ cdef class PyramidalFlowFilter:
 
 
     def compute(self):
-        self.ffilter.compute()
+        """Runs the filter on the last loaded image
+
+        The GIL is released during computation, so several Python
+        threads can drive different filters in parallel. A filter
+        should not be used by more than one thread at a time.
+        """
+
+        with nogil:
+            self.ffilter.compute()
 
 
     def elapsedTime(self):
         return self.ffilter.elapsedTime()
 
 
+    def getResidualStats(self, int level = 0):
+        """
+        Returns the brightness constancy residual statistics of last compute() call.
+
+        Parameters
+        ----------
+        level : int, optional
+            pyramid level. Defaults to 0.
+
+        Returns
+        -------
+        stats : dict
+            mean, p50, p90, p99 and saturated fraction of the residual.
+        """
+
+        if not self.ffilter.getComputeResidual():
+            raise RuntimeError('residual computation not enabled, set computeResidual to True')
+
+        if level < 0 or level >= self.levels:
+            raise ValueError('level index out of bounds: {0}'.format(level))
+
+        return self.ffilter.getResidualStats(level)
+
+
     #############################################
     # PROPERTIES
     #############################################
@@ -407,6 +1440,151 @@ cdef class PyramidalFlowFilter:
             pass
 
 
+    def setCamera(self, gcam.PerspectiveCamera cam):
+        """Sets the camera used for derotation, at the input image resolution"""
+
+        self.ffilter.setCamera(cam.cam)
+
+
+    def setAngularVelocity(self, float wx, float wy, float wz):
+        """Sets the angular velocity for the next compute(), in radians per frame interval"""
+
+        self.ffilter.setAngularVelocity(wx, wy, wz)
+
+
+    property derotate:
+        """Removes the rotational flow of the angular velocity before
+        propagation and adds it back to the output flow. Requires
+        setCamera().
+        """
+        def __get__(self):
+            return self.ffilter.getDerotate()
+
+        def __set__(self, bint value):
+            self.ffilter.setDerotate(value)
+
+        def __del__(self):
+            pass
+
+
+    property seeding:
+        """Replaces the top level propagated flow by block matching
+        displacements where they disagree with it.
+        """
+        def __get__(self):
+            return self.ffilter.getSeeding()
+
+        def __set__(self, bint value):
+            self.ffilter.setSeeding(value)
+
+        def __del__(self):
+            pass
+
+
+    property seedThreshold:
+        """Distance between a block match and the propagated flow
+        above which the match is seeded, in input image pixels.
+        """
+        def __get__(self):
+            return self.ffilter.getSeedThreshold()
+
+        def __set__(self, float value):
+            self.ffilter.setSeedThreshold(value)
+
+        def __del__(self):
+            pass
+
+
+    property outputLevel:
+        """Finest pyramid level computed. Above zero, the flow of
+        that level is upsampled to the input resolution guided by
+        the input image, skipping the cost of the lower levels.
+        """
+        def __get__(self):
+            return self.ffilter.getOutputLevel()
+
+        def __set__(self, int value):
+            self.ffilter.setOutputLevel(value)
+
+        def __del__(self):
+            pass
+
+
+    property upsamplingSigmaSpace:
+        """Spatial standard deviation of the upsampling, in output level pixels"""
+        def __get__(self):
+            return self.ffilter.getUpsamplingSigmaSpace()
+
+        def __set__(self, float value):
+            self.ffilter.setUpsamplingSigmaSpace(value)
+
+        def __del__(self):
+            pass
+
+
+    property upsamplingSigmaRange:
+        """Range standard deviation of the upsampling, for images in [0, 1]"""
+        def __get__(self):
+            return self.ffilter.getUpsamplingSigmaRange()
+
+        def __set__(self, float value):
+            self.ffilter.setUpsamplingSigmaRange(value)
+
+        def __del__(self):
+            pass
+
+
+    property timeStep:
+        """Frame intervals between the previous and the next image
+
+        Set by loadImage() from the image timestamps.
+        """
+        def __get__(self):
+            return self.ffilter.getTimeStep()
+
+        def __set__(self, float value):
+            self.ffilter.setTimeStep(value)
+
+        def __del__(self):
+            pass
+
+
+    property frameInterval:
+        """Nominal frame interval, in timestamp units"""
+        def __get__(self):
+            return self.ffilter.getFrameInterval()
+
+        def __set__(self, double value):
+            self.ffilter.setFrameInterval(value)
+
+        def __del__(self):
+            pass
+
+
+    property frameSkipped:
+        """True if the last loaded image is a duplicate and compute() does nothing"""
+        def __get__(self):
+            return self.ffilter.getFrameSkipped()
+
+        def __set__(self, value):
+            raise RuntimeError('frameSkipped cannot be set')
+
+        def __del__(self):
+            pass
+
+
+    property skippedFrames:
+        """Number of duplicate images loaded so far"""
+        def __get__(self):
+            return self.ffilter.getSkippedFrames()
+
+        def __set__(self, value):
+            raise RuntimeError('skippedFrames cannot be set')
+
+        def __del__(self):
+            pass
+
+
     property smoothIterations:
         def __get__(self):
 
@@ -433,6 +1611,51 @@ cdef class PyramidalFlowFilter:
             pass
 
 
+    property smoothMode:
+        """Smoothing filter, 'box', 'domainTransform', 'median3' or 'median5'.
+
+        'domainTransform' is an edge-aware filter guided by the
+        image constant, see smoothSigmaSpace and smoothSigmaRange.
+        The median modes run smoothIterations 3x3 or 5x5 median
+        passes on each flow component, removing isolated outliers.
+        """
+
+        def __get__(self):
+            return gsmooth.smoothModeName(self.ffilter.getSmoothMode())
+
+        def __set__(self, mode):
+            self.ffilter.setSmoothMode(gsmooth.smoothModeValue(mode))
+
+        def __del__(self):
+            pass
+
+
+    property smoothSigmaSpace:
+        """Spatial standard deviation of the domain transform, in pixels"""
+
+        def __get__(self):
+            return self.ffilter.getSmoothSigmaSpace()
+
+        def __set__(self, float sigma):
+            self.ffilter.setSmoothSigmaSpace(sigma)
+
+        def __del__(self):
+            pass
+
+
+    property smoothSigmaRange:
+        """Range standard deviation of the domain transform, for images in [0, 1]"""
+
+        def __get__(self):
+            return self.ffilter.getSmoothSigmaRange()
+
+        def __set__(self, float sigma):
+            self.ffilter.setSmoothSigmaRange(sigma)
+
+        def __del__(self):
+            pass
+
+
     property propagationBorder:
         def __get__(self):
             return self.ffilter.getPropagationBorder();
@@ -443,6 +1666,39 @@ cdef class PyramidalFlowFilter:
         def __del__(self):
             pass
 
+
+    property computeResidual:
+        def __get__(self):
+            return self.ffilter.getComputeResidual()
+
+        def __set__(self, bint value):
+            self.ffilter.setComputeResidual(value)
+
+        def __del__(self):
+            pass
+
+
+    property publishFlow:
+        def __get__(self):
+            return self.ffilter.getPublishFlow()
+
+        def __set__(self, bint value):
+            self.ffilter.setPublishFlow(value)
+
+        def __del__(self):
+            pass
+
+
+    property residualRange:
+        def __get__(self):
+            return self.ffilter.getResidualRange()
+
+        def __set__(self, float value):
+            self.ffilter.setResidualRange(value)
+
+        def __del__(self):
+            pass
+
     
     #property propagationIterations:
     #    def __get__(self):
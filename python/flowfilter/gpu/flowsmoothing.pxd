@@ -0,0 +1,55 @@
+"""
+    flowfilter.gpu.flowsmoothing
+    ----------------------------
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+cimport flowfilter.gpu.image as gimg
+
+cdef extern from 'flowfilter/gpu/flowsmoothing.h' namespace 'flowfilter::gpu':
+
+    ctypedef enum smoothMode_t:
+        SMOOTH_BOX
+        SMOOTH_DOMAIN_TRANSFORM
+        SMOOTH_MEDIAN3
+        SMOOTH_MEDIAN5
+    
+    cdef cppclass FlowSmoother_cpp 'flowfilter::gpu::FlowSmoother':
+
+        FlowSmoother_cpp()
+        FlowSmoother_cpp(gimg.GPUImage_cpp inputFlow,
+            const int iterations)
+
+
+        void configure()
+        void compute()
+        float elapsedTime()
+
+        int getIterations() const
+        void setIterations(const int N)
+
+        int getSupport() const
+        void setSupport(const int support) except +
+
+        smoothMode_t getMode() const
+        void setMode(const smoothMode_t mode) except +
+
+        float getSigmaSpace() const
+        void setSigmaSpace(const float sigma) except +
+
+        float getSigmaRange() const
+        void setSigmaRange(const float sigma) except +
+
+        # Pipeline stage inputs
+        void setInputFlow(gimg.GPUImage_cpp inputFlow)
+        void setGuideImage(gimg.GPUImage_cpp guideImage) except +
+
+        # Pipeline stage outputs
+        gimg.GPUImage_cpp getSmoothedFlow()
+
+
+cdef class FlowSmoother:
+    
+    cdef FlowSmoother_cpp smoother
@@ -0,0 +1,140 @@
+"""
+    flowfilter.gpu.flowsmoothing
+    ----------------------------
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+cimport flowfilter.gpu.image as gimg
+import flowfilter.gpu.image as gimg
+
+
+# smoothing modes, by name
+SMOOTH_MODES = {'box': SMOOTH_BOX,
+                'domainTransform': SMOOTH_DOMAIN_TRANSFORM,
+                'median3': SMOOTH_MEDIAN3,
+                'median5': SMOOTH_MEDIAN5}
+
+
+def smoothModeValue(name):
+    """Returns the smoothMode_t value of a mode name"""
+
+    if name not in SMOOTH_MODES:
+        raise ValueError('unknown smoothing mode {0}, expected one of {1}'.format(
+            name, sorted(SMOOTH_MODES.keys())))
+
+    return SMOOTH_MODES[name]
+
+
+def smoothModeName(int mode):
+    """Returns the name of a smoothMode_t value"""
+
+    for name, value in SMOOTH_MODES.items():
+        if value == mode:
+            return name
+
+    raise ValueError('unknown smoothing mode value {0}'.format(mode))
+
+
+cdef class FlowSmoother:
+
+    def __cinit__(self, gimg.GPUImage inputFlow = None,
+        int iterations = 1):
+        
+        if inputFlow == None:
+            self.smoother.setIterations(iterations)
+            return
+        
+        self.smoother = FlowSmoother_cpp(inputFlow.img, iterations)
+
+
+    def __dealloc__(self):
+        # nothing to do
+        pass
+
+
+    def configure(self):
+        self.smoother.configure()
+
+
+    def compute(self):
+        self.smoother.compute()
+
+
+    def elapsedTime(self):
+        return self.smoother.elapsedTime()
+
+
+    def setInputFlow(self, gimg.GPUImage inputFlow):
+        self.smoother.setInputFlow(inputFlow.img)
+
+
+    def setGuideImage(self, gimg.GPUImage guideImage):
+        """Sets the float guide image of the 'domainTransform' mode"""
+        self.smoother.setGuideImage(guideImage.img)
+
+
+    def getSmoothedFlow(self):
+
+        cdef gimg.GPUImage smoothFlow = gimg.GPUImage()
+        smoothFlow.img = self.smoother.getSmoothedFlow()
+
+        return smoothFlow
+
+
+    property iterations:
+        def __get__(self):
+            return self.smoother.getIterations()
+
+        def __set__(self, int N):
+            self.smoother.setIterations(N)
+
+        def __del__(self):
+            pass
+
+
+    property support:
+        def __get__(self):
+            return self.smoother.getSupport()
+
+        def __set__(self, int support):
+            self.smoother.setSupport(support)
+
+        def __del__(self):
+            pass
+
+
+    property mode:
+        """Smoothing filter, 'box', 'domainTransform', 'median3' or 'median5'"""
+
+        def __get__(self):
+            return smoothModeName(self.smoother.getMode())
+
+        def __set__(self, mode):
+            self.smoother.setMode(smoothModeValue(mode))
+
+        def __del__(self):
+            pass
+
+
+    property sigmaSpace:
+        def __get__(self):
+            return self.smoother.getSigmaSpace()
+
+        def __set__(self, float sigma):
+            self.smoother.setSigmaSpace(sigma)
+
+        def __del__(self):
+            pass
+
+
+    property sigmaRange:
+        def __get__(self):
+            return self.smoother.getSigmaRange()
+
+        def __set__(self, float sigma):
+            self.smoother.setSigmaRange(sigma)
+
+        def __del__(self):
+            pass
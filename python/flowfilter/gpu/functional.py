@@ -0,0 +1,342 @@
+"""
+    flowfilter.gpu.functional
+    -------------------------
+
+    Drop-in GPU versions of the functions of the NumPy reference
+    implementation. Each function has the same signature and returns
+    the same structure as its counterpart in flowfilter.update,
+    flowfilter.propagation, flowfilter.misc or flowfilter.plot, so
+    prototypes can switch engine by changing an import::
+
+        import flowfilter.gpu.functional as upd
+
+        A0, Ax, Ay = upd.imageModel(img, support=7)
+        flow, payload = upd.propagate(flow, 4, payload=[A0, Ax])
+
+    Stages and device buffers are allocated on the first call for a
+    given shape and reused by later calls with the same shape.
+
+    Results are float32. The GPU samples textures with clamped
+    coordinates while the reference convolves with reflected borders,
+    so values differ within a few pixels of the image sides. Arguments
+    the GPU stages do not cover (image model support above 15,
+    propagation with dx != 1, pyramids of non float images or of sizes
+    not divisible by 2^(levels-1)) are forwarded to the reference.
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+import numpy as np
+
+import flowfilter.gpu.image as gimg
+import flowfilter.gpu.imagemodel as gimodel
+import flowfilter.gpu.update as gupd
+import flowfilter.gpu.flowsmoothing as gsmooth
+import flowfilter.gpu.propagation as gprop
+import flowfilter.gpu.pyramid as gpyr
+import flowfilter.gpu.display as gdisplay
+
+
+__all__ = ['imageModel', 'update', 'smoothFlow', 'propagate',
+    'imagePyramid', 'flowToColor', 'clearCache']
+
+
+# maximum image model support computed on the GPU
+MAX_SUPPORT = 15
+
+
+# stages and buffers of each function, by function name and input shape
+_cache = dict()
+
+
+def clearCache():
+    """Releases the stages and device buffers kept between calls"""
+
+    _cache.clear()
+
+
+def _cached(key, factory):
+    """Returns the cached entry for key, creating it with factory if needed"""
+
+    entry = _cache.get(key)
+    if entry is None:
+        entry = factory()
+        _cache[key] = entry
+
+    return entry
+
+
+def _float32(array):
+    return np.ascontiguousarray(array, dtype=np.float32)
+
+
+def _checkSupport(support):
+    if support < 3 or support % 2 != 1:
+        raise ValueError('support should be an odd number greater or equal 3')
+
+
+def _imageModelStage(shape, support):
+    """Returns the image buffer and image model stage for an image shape"""
+
+    def factory():
+        image = gimg.GPUImage(shape, itemSize=4)
+        return image, gimodel.ImageModel(image)
+
+    image, imodel = _cached(('imageModel', shape), factory)
+    imodel.support = support
+
+    return image, imodel
+
+
+def imageModel(img, support=5):
+    """Computes brightness model parameters.
+
+    See flowfilter.update.imageModel.
+    """
+
+    _checkSupport(support)
+
+    if support > MAX_SUPPORT:
+        from flowfilter import update as upd
+        return upd.imageModel(img, support)
+
+    img = _float32(img)
+
+    image, imodel = _imageModelStage(img.shape, support)
+    image.upload(img)
+    imodel.compute()
+
+    A0 = imodel.getImageConstant().download(np.float32)
+    gradient = imodel.getImageGradient().download(np.float32)
+
+    return A0, gradient[..., 0], gradient[..., 1]
+
+
+def update(img, imgOld, flowPredicted, support=5, gamma=1.0):
+    """Update the optical flow field provided new image data.
+
+    See flowfilter.update.update. The update is computed by a
+    DeltaFlowUpdate stage taking flowPredicted as the delta flow,
+    with its maxflow clamp disabled.
+    """
+
+    if gamma <= 0.0: raise ValueError('gamma should be greater than zero')
+
+    _checkSupport(support)
+
+    if support > MAX_SUPPORT:
+        from flowfilter import update as upd
+        return upd.update(img, imgOld, flowPredicted, support, gamma)
+
+    img = _float32(img)
+    imgOld = _float32(imgOld)
+    flowPredicted = _float32(flowPredicted)
+
+    image, imodel = _imageModelStage(img.shape, support)
+
+    def factory():
+        height, width = img.shape
+        imageOld = gimg.GPUImage(img.shape, itemSize=4)
+        deltaFlow = gimg.GPUImage((height, width, 2), itemSize=4)
+
+        # the total flow output is not used, a small zero flow
+        # is enough to feed the stage
+        flow = gimg.GPUImage((1, 1, 2), itemSize=4)
+        flow.upload(np.zeros((1, 1, 2), dtype=np.float32))
+
+        deltaUpdate = gupd.DeltaFlowUpdate(flow, deltaFlow, imageOld,
+            imodel.getImageConstant(), imodel.getImageGradient(),
+            gamma, 1e9)
+
+        return imageOld, deltaFlow, deltaUpdate
+
+    imageOld, deltaFlow, deltaUpdate = _cached(('update', img.shape), factory)
+    deltaUpdate.gamma = gamma
+
+    image.upload(img)
+    imageOld.upload(imgOld)
+    deltaFlow.upload(flowPredicted)
+
+    imodel.compute()
+    deltaUpdate.compute()
+
+    flowUpdated = deltaUpdate.getUpdatedDeltaFlow().download(np.float32)
+    A0 = imodel.getImageConstant().download(np.float32)
+
+    return flowUpdated, A0
+
+
+def smoothFlow(flow, iterations=1, support=5):
+    """Apply a smoothing filter to optical flow
+
+    See flowfilter.update.smoothFlow.
+    """
+
+    if iterations <= 0: raise ValueError('iterations should be greater than 1')
+    _checkSupport(support)
+
+    flow = _float32(flow)
+
+    def factory():
+        inputFlow = gimg.GPUImage(flow.shape, itemSize=4)
+        return inputFlow, gsmooth.FlowSmoother(inputFlow, iterations)
+
+    inputFlow, smoother = _cached(('smoothFlow', flow.shape), factory)
+    smoother.iterations = iterations
+    smoother.support = support
+
+    inputFlow.upload(flow)
+    smoother.compute()
+
+    return smoother.getSmoothedFlow().download(np.float32)
+
+
+def propagate(flow, iterations=1, dx=1.0, payload=None, border=3):
+    """Propagate an optical flow field and attached payloads
+
+    See flowfilter.propagation.propagate. Payloads are propagated
+    three at a time, as the scalar and 2-channel vector payloads
+    of a FlowPropagatorPayload stage.
+    """
+
+    if iterations <= 0: raise ValueError('iterations must be greater than zero')
+
+    if dx != 1.0:
+        from flowfilter import propagation as prop
+        return prop.propagate(flow, iterations, dx, payload, border)
+
+    flow = _float32(flow)
+
+    if not payload:
+
+        def factory():
+            inputFlow = gimg.GPUImage(flow.shape, itemSize=4)
+            return inputFlow, gprop.FlowPropagator(inputFlow, iterations)
+
+        inputFlow, propagator = _cached(('propagate', flow.shape), factory)
+        propagator.iterations = iterations
+        propagator.border = border
+
+        inputFlow.upload(flow)
+        propagator.compute()
+
+        return propagator.getPropagatedFlow().download(np.float32), payload
+
+    shape = flow.shape[0:2]
+
+    def factory():
+        inputFlow = gimg.GPUImage(flow.shape, itemSize=4)
+        scalar = gimg.GPUImage(shape, itemSize=4)
+        vector = gimg.GPUImage(flow.shape, itemSize=4)
+
+        return inputFlow, scalar, vector, gprop.FlowPropagatorPayload(
+            inputFlow, scalar, vector, iterations)
+
+    inputFlow, scalar, vector, propagator = _cached(('propagatePayload', shape), factory)
+    propagator.iterations = iterations
+    propagator.border = border
+
+    inputFlow.upload(flow)
+
+    vectorPayload = np.zeros(flow.shape, dtype=np.float32)
+    payloadPropagated = list()
+
+    for n in range(0, len(payload), 3):
+
+        group = payload[n:n+3]
+
+        scalar.upload(_float32(group[0]))
+
+        vectorPayload[...] = 0.0
+        for k, field in enumerate(group[1:]):
+            vectorPayload[..., k] = field
+
+        vector.upload(vectorPayload)
+
+        # the flow is propagated again with each group, with identical result
+        propagator.compute()
+
+        payloadPropagated.append(propagator.getPropagatedScalar().download(np.float32))
+
+        vectorPropagated = propagator.getPropagatedVector().download(np.float32)
+        for k in range(len(group) - 1):
+            payloadPropagated.append(np.copy(vectorPropagated[..., k]))
+
+    flowPropagated = propagator.getPropagatedFlow().download(np.float32)
+
+    return flowPropagated, payloadPropagated
+
+
+def imagePyramid(img, levels):
+    """Creates an image pyramid
+
+    See flowfilter.misc.imagePyramid. Each channel of 3D images
+    is processed independently.
+    """
+
+    if levels < 1: raise ValueError('levels should be greater or equal 1')
+
+    factor = 2**(levels - 1)
+
+    if (img.dtype.kind != 'f' or img.shape[0] % factor != 0
+        or img.shape[1] % factor != 0):
+
+        from flowfilter import misc
+        return misc.imagePyramid(img, levels)
+
+    if levels == 1:
+        return [np.copy(img)]
+
+    shape = img.shape[0:2]
+
+    def factory():
+        image = gimg.GPUImage(shape, itemSize=4)
+        return image, gpyr.ImagePyramid(image, levels)
+
+    image, pyramid = _cached(('imagePyramid', shape, levels), factory)
+
+    channels = [img] if img.ndim == 2 else [img[..., c] for c in range(img.shape[2])]
+
+    levelChannels = [list() for _ in range(levels)]
+
+    for channel in channels:
+        image.upload(_float32(channel))
+        pyramid.compute()
+
+        for h in range(1, levels):
+            levelChannels[h].append(pyramid.getImage(h).download(np.float32))
+
+    pyr = [np.copy(img)]
+    for h in range(1, levels):
+        if img.ndim == 2:
+            level = levelChannels[h][0]
+        else:
+            level = np.concatenate([p[..., np.newaxis] for p in levelChannels[h]], axis=2)
+
+        pyr.append(level.astype(img.dtype, copy=False))
+
+    return pyr
+
+
+def flowToColor(flow, maxflow=1.0):
+    """Returns the color wheel encoded version of the flow field.
+
+    See flowfilter.plot.flowToColor.
+    """
+
+    if maxflow <= 0.0: raise ValueError('maxflow should be greater than zero')
+
+    flow = _float32(flow)
+
+    def factory():
+        inputFlow = gimg.GPUImage(flow.shape, itemSize=4)
+        return inputFlow, gdisplay.FlowToColor(inputFlow, maxflow)
+
+    inputFlow, flowColor = _cached(('flowToColor', flow.shape), factory)
+    flowColor.maxflow = maxflow
+
+    inputFlow.upload(flow)
+    flowColor.compute()
+
+    return np.ascontiguousarray(flowColor.download()[..., 0:3])
@@ -9,25 +9,38 @@
 cimport flowfilter.image as fimg
 
 cdef extern from 'flowfilter/gpu/image.h' namespace 'flowfilter::gpu':
+
+    ctypedef void (*gpuImageRelease_t)(void* context) noexcept nogil
     
     cdef cppclass GPUImage_cpp 'flowfilter::gpu::GPUImage':
 
         GPUImage_cpp();
+        GPUImage_cpp(const GPUImage_cpp& other)
         GPUImage_cpp(const int height, const int width,
             const int depth, const int itemSize);
+        GPUImage_cpp(const int height, const int width,
+            const int depth, const int itemSize,
+            void* data, const size_t pitch, const int device,
+            gpuImageRelease_t release, void* context) except +
 
         int height() const;
         int width() const;
         int depth() const;
         int pitch() const;
         int itemSize() const;
+        int device() const;
 
-        void upload(fimg.image_t_cpp& img);
-        void download(fimg.image_t_cpp& img) const;
+        void* data()
+
+        void upload(fimg.image_t_cpp& img) except + nogil
+        void download(fimg.image_t_cpp& img) except + nogil
 
 
 cdef class GPUImage:
         
     cdef GPUImage_cpp img
 
+    # host buffer returned by download() when no output is given
+    cdef object hostBuffer
+
 
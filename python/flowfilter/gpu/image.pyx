@@ -6,12 +6,61 @@
     :license: 3-clause BSD, see LICENSE for more details
 """
 
+from cpython.pycapsule cimport PyCapsule_New, PyCapsule_IsValid
+from cpython.pycapsule cimport PyCapsule_GetPointer, PyCapsule_SetName
+from libc.stdint cimport int64_t
+from libc.stdlib cimport malloc, free
+
 cimport numpy as np
 import numpy as np
 
 cimport flowfilter.image as fimg
 import flowfilter.image as fimg
 
+from flowfilter.gpu.dlpack cimport *
+
+
+__all__ = ['GPUImage', 'fromDLPack', 'DLPACK_CUDA', 'DLPACK_LAYOUTS']
+
+
+# DLPack device type of CUDA memory
+DLPACK_CUDA = kDLCUDA
+
+# DLPack layouts accepted by GPUImage.toDLPack()
+DLPACK_LAYOUTS = ('hwc', 'chw', 'nhwc', 'nchw')
+
+
+ctypedef struct _DLPackExport:
+    DLManagedTensor tensor
+    int64_t shape[4]
+    int64_t strides[4]
+
+    # copy of the exported image, keeps its buffer alive
+    GPUImage_cpp* image
+
+
+cdef void _deleteDLPackExport(DLManagedTensor* tensor) noexcept nogil:
+
+    cdef _DLPackExport* export = <_DLPackExport*>tensor.manager_ctx
+    del export.image
+    free(export)
+
+
+cdef void _destroyDLPackCapsule(object capsule) noexcept:
+
+    # capsules renamed to used_dltensor are owned by their consumer
+    cdef DLManagedTensor* tensor
+    if PyCapsule_IsValid(capsule, 'dltensor'):
+        tensor = <DLManagedTensor*>PyCapsule_GetPointer(capsule, 'dltensor')
+        tensor.deleter(tensor)
+
+
+cdef void _releaseDLPackImport(void* context) noexcept nogil:
+
+    cdef DLManagedTensor* tensor = <DLManagedTensor*>context
+    if tensor.deleter != NULL:
+        tensor.deleter(tensor)
+
 
 cdef class GPUImage:
     
@@ -33,16 +82,27 @@ cdef class GPUImage:
         # nothing to do
         pass
 
-    def upload(self, np.ndarray img):
+    def upload(self, img):
+        """Upload image to device memory
+
+        Parameters
+        ----------
+        img : buffer
+            Host image. Any object exporting the buffer protocol
+            is read without copy. The GIL is released during the
+            transfer.
+        """
         
         # wrap numpy array in a Image object
         cdef fimg.Image img_w = fimg.Image(img)
+        cdef fimg.image_t_cpp img_c = img_w.img
 
         # transfer image to device memory space
-        self.img.upload(img_w.img)
+        with nogil:
+            self.img.upload(img_c)
 
 
-    def download(self, dtype, np.ndarray output=None):
+    def download(self, dtype, output=None):
         """Download image to numpy array
 
         Parameters
@@ -50,21 +110,125 @@ cdef class GPUImage:
         dtype : numpy dtype
             Numpy dtype of the downloaded image
 
-        output : ndarray, optional
-            Output numpy ndarray
+        output : buffer, optional
+            Output array. If None, the image is downloaded into a
+            host buffer owned by this object, which is reused by
+            subsequent calls.
+
+        Returns
+        -------
+        output : ndarray or buffer
+            The output array, or the internal host buffer.
         """
 
-        if output == None:
-            output = np.zeros(self.shape, dtype=dtype)
+        if output is None:
+            if (self.hostBuffer is None or self.hostBuffer.shape != self.shape
+                or self.hostBuffer.dtype != np.dtype(dtype)):
 
-        oshape = (output.shape[0], output.shape[1], output.shape[2])
+                self.hostBuffer = np.empty(self.shape, dtype=dtype)
 
-        cdef fimg.Image output_w = fimg.Image(output)
-        self.img.download(output_w.img)
+            output = self.hostBuffer
+
+        cdef fimg.Image output_w = fimg.Image(output, writable=True)
+        cdef fimg.image_t_cpp output_c = output_w.img
+
+        with nogil:
+            self.img.download(output_c)
         
         return output
 
 
+    def toDLPack(self, layout = 'hwc'):
+        """Exports the image as a DLPack capsule, without copy
+
+        The capsule references the device buffer of this image, which
+        stays allocated until the consumer releases the tensor. The
+        content is overwritten by the next compute() of the stage that
+        produced it. compute() synchronizes with the device before
+        returning, so the content is ready for any consumer stream.
+
+        Parameters
+        ----------
+        layout : string, optional
+            Dimension order of the tensor. 'hwc' is the layout in
+            memory, 'chw', 'nhwc' and 'nchw' are views of the same
+            buffer with permuted strides and a batch of 1 for 'n'
+            layouts. Channels are omitted from 'hwc' for images of
+            depth 1. Defaults to 'hwc'.
+
+        Returns
+        -------
+        capsule : PyCapsule
+            DLPack capsule named 'dltensor'.
+
+        Raises
+        ------
+        ValueError : if layout is unknown or the image has an item
+            size other than 1 (uint8) or 4 (float32).
+        """
+
+        if layout not in DLPACK_LAYOUTS:
+            raise ValueError('layout should be one of {0}, got: {1}'.format(DLPACK_LAYOUTS, layout))
+
+        cdef int itemSize = self.img.itemSize()
+        if itemSize != 1 and itemSize != 4:
+            raise ValueError('item size should be 1 or 4, got: {0}'.format(itemSize))
+
+        cdef int64_t H = self.img.height()
+        cdef int64_t W = self.img.width()
+        cdef int64_t C = self.img.depth()
+        cdef int64_t rowStride = self.img.pitch() // itemSize
+
+        # dimension sizes and strides, in elements, of the memory layout
+        sizes = {'n': 1, 'h': H, 'w': W, 'c': C}
+        strides = {'n': H*rowStride, 'h': rowStride, 'w': C, 'c': 1}
+
+        if layout == 'hwc' and C == 1:
+            layout = 'hw'
+
+        cdef _DLPackExport* export = <_DLPackExport*>malloc(sizeof(_DLPackExport))
+        if export == NULL:
+            raise MemoryError()
+
+        export.image = new GPUImage_cpp(self.img)
+
+        cdef int n
+        for n in range(len(layout)):
+            export.shape[n] = sizes[layout[n]]
+            export.strides[n] = strides[layout[n]]
+
+        cdef DLTensor* tensor = &export.tensor.dl_tensor
+        tensor.data = export.image.data()
+        tensor.device.device_type = kDLCUDA
+        tensor.device.device_id = self.img.device()
+        tensor.ndim = len(layout)
+        tensor.dtype.code = kDLUInt if itemSize == 1 else kDLFloat
+        tensor.dtype.bits = 8*itemSize
+        tensor.dtype.lanes = 1
+        tensor.shape = export.shape
+        tensor.strides = export.strides
+        tensor.byte_offset = 0
+
+        export.tensor.manager_ctx = export
+        export.tensor.deleter = _deleteDLPackExport
+
+        return PyCapsule_New(&export.tensor, 'dltensor', _destroyDLPackCapsule)
+
+
+    def __dlpack__(self, stream = None, **kwargs):
+        """DLPack protocol, exports the image in 'hwc' layout
+
+        The content is ready when compute() returns, stream
+        is therefore ignored.
+        """
+
+        return self.toDLPack()
+
+
+    def __dlpack_device__(self):
+        return (kDLCUDA, self.img.device())
+
+
     property shape:
 
         def __get__(self):
@@ -134,3 +298,81 @@ cdef class GPUImage:
 
         def __del__(self):
             pass # nothing to do
+
+
+    property device:
+        def __get__(self):
+            return self.img.device()
+
+        def __set__(self, value):
+            raise RuntimeError('device cannot be set')
+
+        def __del__(self):
+            pass
+
+
+def fromDLPack(tensor):
+    """Wraps a DLPack tensor in device memory as a GPUImage, without copy
+
+    The tensor is released when the returned image, and all stages
+    using it, are deleted.
+
+    Parameters
+    ----------
+    tensor : object or PyCapsule
+        Object implementing __dlpack__(), or a DLPack capsule. It must
+        be a CUDA uint8 or float32 tensor of shape [height, width] or
+        [height, width, depth], with contiguous columns and channels.
+
+    Returns
+    -------
+    image : GPUImage
+
+    Raises
+    ------
+    ValueError : if the tensor does not satisfy the conditions above.
+    """
+
+    capsule = tensor.__dlpack__() if hasattr(tensor, '__dlpack__') else tensor
+
+    if not PyCapsule_IsValid(capsule, 'dltensor'):
+        raise ValueError('expected a DLPack capsule not yet consumed')
+
+    cdef DLManagedTensor* managed = <DLManagedTensor*>PyCapsule_GetPointer(capsule, 'dltensor')
+    cdef DLTensor* t = &managed.dl_tensor
+
+    if t.device.device_type != kDLCUDA:
+        raise ValueError('tensor should be in CUDA device memory, got device type: {0}'.format(
+            t.device.device_type))
+
+    cdef int itemSize
+    if t.dtype.code == kDLUInt and t.dtype.bits == 8 and t.dtype.lanes == 1:
+        itemSize = 1
+    elif t.dtype.code == kDLFloat and t.dtype.bits == 32 and t.dtype.lanes == 1:
+        itemSize = 4
+    else:
+        raise ValueError('tensor dtype should be uint8 or float32')
+
+    if t.ndim != 2 and t.ndim != 3:
+        raise ValueError('tensor should have 2 or 3 dimensions, got: {0}'.format(t.ndim))
+
+    cdef int height = t.shape[0]
+    cdef int width = t.shape[1]
+    cdef int depth = 1 if t.ndim == 2 else t.shape[2]
+    cdef int64_t rowStride = width*depth
+
+    if t.strides != NULL:
+        if (t.ndim == 3 and t.strides[2] != 1) or t.strides[1] != depth:
+            raise ValueError('tensor columns and channels should be contiguous')
+
+        rowStride = t.strides[0]
+
+    cdef GPUImage image = GPUImage()
+    image.img = GPUImage_cpp(height, width, depth, itemSize,
+        <char*>t.data + t.byte_offset, rowStride*itemSize, t.device.device_id,
+        _releaseDLPackImport, managed)
+
+    # the image owns the tensor from now on
+    PyCapsule_SetName(capsule, 'used_dltensor')
+
+    return image
@@ -20,6 +20,9 @@ cdef extern from 'flowfilter/gpu/imagemodel.h' namespace 'flowfilter::gpu':
         void compute()
         float elapsedTime()
 
+        void setSupport(const int support) except +
+        int getSupport() const
+
         # Pipeline stage inputs
         void setInputImage(gimg.GPUImage_cpp img)
 
@@ -61,4 +61,15 @@ cdef class ImageModel:
         cdef gimg.GPUImage imgGrad = gimg.GPUImage()
         imgGrad.img = self.imodel.getImageGradient()
 
-        return imgGrad
\ No newline at end of file
+        return imgGrad
+
+
+    property support:
+        def __get__(self):
+            return self.imodel.getSupport()
+
+        def __set__(self, int support):
+            self.imodel.setSupport(support)
+
+        def __del__(self):
+            pass
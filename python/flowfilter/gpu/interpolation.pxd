@@ -0,0 +1,48 @@
+"""
+    flowfilter.gpu.interpolation
+    ----------------------------
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+from libcpp cimport bool
+
+cimport flowfilter.gpu.image as gimg
+
+cdef extern from 'flowfilter/gpu/interpolation.h' namespace 'flowfilter::gpu':
+
+    cdef cppclass FrameInterpolator_cpp 'flowfilter::gpu::FrameInterpolator':
+
+        FrameInterpolator_cpp()
+        FrameInterpolator_cpp(gimg.GPUImage_cpp inputFlow,
+            gimg.GPUImage_cpp inputImage) except +
+        FrameInterpolator_cpp(gimg.GPUImage_cpp inputFlow,
+            gimg.GPUImage_cpp inputImage,
+            gimg.GPUImage_cpp inputImageOld) except +
+
+
+        void configure() except +
+        void compute() except + nogil
+        float elapsedTime()
+
+
+        # Pipeline stage inputs
+        void setInputFlow(gimg.GPUImage_cpp inputFlow) except +
+        void setInputImage(gimg.GPUImage_cpp inputImage)
+        void setInputImageOld(gimg.GPUImage_cpp inputImageOld)
+
+        # Pipeline stage outputs
+        gimg.GPUImage_cpp getInterpolatedImage()
+
+        # Parameters
+        float getTime() const
+        void setTime(const float t) except +
+
+        bool getBlend() const
+        void setBlend(const bool blend) except +
+
+
+cdef class FrameInterpolator:
+
+    cdef FrameInterpolator_cpp interpolator
@@ -0,0 +1,112 @@
+"""
+    flowfilter.gpu.interpolation
+    ----------------------------
+
+    Motion compensated frame interpolation.
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+cimport numpy as np
+import numpy as np
+
+cimport flowfilter.gpu.image as gimg
+import flowfilter.gpu.image as gimg
+
+cdef class FrameInterpolator:
+    """Warps images by a fraction of an optical flow field
+
+    The output is the frame at time t in [0, 1] between the previous
+    image (t = 0) and the current one (t = 1), the flow mapping the
+    previous image to the current. Inputs can be the live buffers of
+    a filter, for instance::
+
+        interp = FrameInterpolator(ffilter.getFlow(), ffilter.getImageConstant())
+
+        ffilter.compute()
+        for t in [0.25, 0.5, 0.75]:
+            interp.time = t
+            interp.compute()
+            frame = interp.download()
+
+    uint8 images are read normalized, the output is float32.
+    """
+
+    def __cinit__(self, gimg.GPUImage inputFlow = None,
+        gimg.GPUImage inputImage = None,
+        gimg.GPUImage inputImageOld = None):
+
+        if inputFlow == None or inputImage == None:
+            return
+
+        if inputImageOld == None:
+            self.interpolator = FrameInterpolator_cpp(inputFlow.img, inputImage.img)
+        else:
+            self.interpolator = FrameInterpolator_cpp(inputFlow.img,
+                inputImage.img, inputImageOld.img)
+
+
+    def __dealloc__(self):
+        # nothing to do
+        pass
+
+    def configure(self):
+        self.interpolator.configure()
+
+
+    def compute(self):
+        with nogil:
+            self.interpolator.compute()
+
+
+    def elapsedTime(self):
+        return self.interpolator.elapsedTime()
+
+
+    def setInputFlow(self, gimg.GPUImage inputFlow):
+        self.interpolator.setInputFlow(inputFlow.img)
+
+
+    def setInputImage(self, gimg.GPUImage inputImage):
+        self.interpolator.setInputImage(inputImage.img)
+
+
+    def setInputImageOld(self, gimg.GPUImage inputImageOld):
+        """Sets the previous image, required for blending"""
+        self.interpolator.setInputImageOld(inputImageOld.img)
+
+
+    def getInterpolatedImage(self):
+
+        cdef gimg.GPUImage interpolatedImage = gimg.GPUImage()
+        interpolatedImage.img = self.interpolator.getInterpolatedImage()
+
+        return interpolatedImage
+
+
+    def download(self):
+
+        return self.getInterpolatedImage().download(np.float32)
+
+
+    property time:
+        def __get__(self):
+            return self.interpolator.getTime()
+
+        def __set__(self, float value):
+            self.interpolator.setTime(value)
+
+        def __del__(self):
+            pass
+
+
+    property blend:
+        def __get__(self):
+            return self.interpolator.getBlend()
+
+        def __set__(self, bint value):
+            self.interpolator.setBlend(value)
+
+        def __del__(self):
+            pass
@@ -40,6 +40,32 @@ cdef extern from 'flowfilter/gpu/rotation.h' namespace 'flowfilter::gpu':
 
 
 
+    cdef cppclass RotationalFlowAdder_cpp 'flowfilter::gpu::RotationalFlowAdder':
+
+        RotationalFlowAdder_cpp()
+        RotationalFlowAdder_cpp(gcam.perspectiveCamera_cpp cam,
+            gimg.GPUImage_cpp inputFlow) except +
+
+        void configure() except +
+        void compute()
+        float elapsedTime()
+
+        # Stage inputs
+        void setInputFlow(gimg.GPUImage_cpp inputFlow) except +
+
+        # Stage outputs
+        gimg.GPUImage_cpp getFlow()
+
+        # Parameters
+        void setCamera(gcam.perspectiveCamera_cpp cam)
+        void setAngularVelocity(const float wx, const float wy, const float wz)
+
+
 cdef class RotationalFlowImagePredictor:
     
     cdef RotationalFlowImagePredictor_cpp predictor
+
+
+cdef class RotationalFlowAdder:
+
+    cdef RotationalFlowAdder_cpp adder
@@ -95,3 +95,55 @@ cdef class RotationalFlowImagePredictor:
         def __del__(self):
             pass
 
+
+cdef class RotationalFlowAdder:
+
+    def __cinit__(self, gcam.PerspectiveCamera cam = None,
+        gimg.GPUImage inputFlow = None):
+        """Adds the rotational flow of a camera to a flow field
+
+        Parameters
+        ----------
+        cam : PerspectiveCamera, optional.
+            Camera intrinsic parameters.
+
+        inputFlow : GPUImage, optional.
+            float32 flow field of depth 2.
+        """
+
+        if cam is None or inputFlow is None:
+            return
+
+        self.adder = RotationalFlowAdder_cpp(cam.cam, inputFlow.img)
+
+
+    def configure(self):
+        self.adder.configure()
+
+
+    def compute(self):
+        self.adder.compute()
+
+
+    def elapsedTime(self):
+        return self.adder.elapsedTime()
+
+
+    def setInputFlow(self, gimg.GPUImage inputFlow):
+        self.adder.setInputFlow(inputFlow.img)
+
+
+    def getFlow(self):
+
+        cdef gimg.GPUImage flow = gimg.GPUImage()
+        flow.img = self.adder.getFlow()
+
+        return flow
+
+
+    def setCamera(self, gcam.PerspectiveCamera cam):
+        self.adder.setCamera(cam.cam)
+
+
+    def setAngularVelocity(self, float wx, float wy, float wz):
+        self.adder.setAngularVelocity(wx, wy, wz)
@@ -0,0 +1,44 @@
+"""
+    flowfilter.gpu.upsampling
+    -------------------------
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+cimport flowfilter.gpu.image as gimg
+
+cdef extern from 'flowfilter/gpu/upsampling.h' namespace 'flowfilter::gpu':
+
+    cdef cppclass JointBilateralUpsampler_cpp 'flowfilter::gpu::JointBilateralUpsampler':
+
+        JointBilateralUpsampler_cpp()
+        JointBilateralUpsampler_cpp(gimg.GPUImage_cpp inputFlow,
+            gimg.GPUImage_cpp guideCoarse,
+            gimg.GPUImage_cpp guide) except +
+
+
+        void configure() except +
+        void compute() except + nogil
+        float elapsedTime()
+
+
+        # Pipeline stage inputs
+        void setInputFlow(gimg.GPUImage_cpp inputFlow) except +
+        void setGuideCoarse(gimg.GPUImage_cpp guideCoarse) except +
+        void setGuide(gimg.GPUImage_cpp guide) except +
+
+        # Pipeline stage outputs
+        gimg.GPUImage_cpp getUpsampledFlow()
+
+        # Parameters
+        float getSigmaSpace() const
+        void setSigmaSpace(const float sigma) except +
+
+        float getSigmaRange() const
+        void setSigmaRange(const float sigma) except +
+
+
+cdef class JointBilateralUpsampler:
+
+    cdef JointBilateralUpsampler_cpp upsampler
@@ -0,0 +1,98 @@
+"""
+    flowfilter.gpu.upsampling
+    -------------------------
+
+    Guided upsampling of optical flow fields.
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+cimport numpy as np
+import numpy as np
+
+cimport flowfilter.gpu.image as gimg
+import flowfilter.gpu.image as gimg
+
+cdef class JointBilateralUpsampler:
+    """Upsamples a flow field with joint bilateral filtering
+
+    Each output pixel averages the 3x3 nearest input flow pixels,
+    weighted by spatial distance and by the difference between the
+    uint8 guide at the output pixel and the coarse guide at the
+    input pixel. The flow is scaled to output pixels.
+    """
+
+    def __cinit__(self, gimg.GPUImage inputFlow = None,
+        gimg.GPUImage guideCoarse = None,
+        gimg.GPUImage guide = None):
+
+        if inputFlow == None or guideCoarse == None or guide == None:
+            return
+
+        self.upsampler = JointBilateralUpsampler_cpp(inputFlow.img,
+            guideCoarse.img, guide.img)
+
+
+    def __dealloc__(self):
+        # nothing to do
+        pass
+
+    def configure(self):
+        self.upsampler.configure()
+
+
+    def compute(self):
+        with nogil:
+            self.upsampler.compute()
+
+
+    def elapsedTime(self):
+        return self.upsampler.elapsedTime()
+
+
+    def setInputFlow(self, gimg.GPUImage inputFlow):
+        self.upsampler.setInputFlow(inputFlow.img)
+
+
+    def setGuideCoarse(self, gimg.GPUImage guideCoarse):
+        self.upsampler.setGuideCoarse(guideCoarse.img)
+
+
+    def setGuide(self, gimg.GPUImage guide):
+        self.upsampler.setGuide(guide.img)
+
+
+    def getUpsampledFlow(self):
+
+        cdef gimg.GPUImage upsampledFlow = gimg.GPUImage()
+        upsampledFlow.img = self.upsampler.getUpsampledFlow()
+
+        return upsampledFlow
+
+
+    def download(self):
+
+        return self.getUpsampledFlow().download(np.float32)
+
+
+    property sigmaSpace:
+        def __get__(self):
+            return self.upsampler.getSigmaSpace()
+
+        def __set__(self, float value):
+            self.upsampler.setSigmaSpace(value)
+
+        def __del__(self):
+            pass
+
+
+    property sigmaRange:
+        def __get__(self):
+            return self.upsampler.getSigmaRange()
+
+        def __set__(self, float value):
+            self.upsampler.setSigmaRange(value)
+
+        def __del__(self):
+            pass
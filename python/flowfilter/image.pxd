@@ -23,3 +23,9 @@ cdef class Image:
     
     cdef object numpyArray
     cdef image_t_cpp img
+
+    # buffer of numpyArray, released on deallocation
+    cdef Py_buffer buffer
+    cdef bint hasBuffer
+
+    cdef bint _packedRows(self)
@@ -6,6 +6,9 @@
     :license: 3-clause BSD, see LICENSE for more details
 """
 
+from cpython.buffer cimport PyObject_GetBuffer, PyBuffer_Release
+from cpython.buffer cimport PyBUF_STRIDES, PyBUF_FORMAT, PyBUF_WRITABLE
+
 cimport numpy as np
 import numpy as np
 
@@ -13,39 +16,94 @@ from image cimport image_t_cpp
 
 
 cdef class Image:
-    """Image wrapper class"""
+    """Image wrapper class
+
+    Wraps any object exporting the buffer protocol, such as NumPy
+    arrays or memoryviews, without copying its data. Rows can be
+    strided, but pixels and channels within a row must be packed.
+    """
+
+    def __cinit__(self, arr = None, bint writable = False):
+        """Wraps arr
+
+        Parameters
+        ----------
+        arr : buffer, optional
+            2D or 3D array. If its rows are not packed, arr is
+            copied to a C contiguous array, unless writable is True.
+
+        writable : bool, optional
+            Request a writable buffer, used for outputs. Defaults to False.
 
-    def __cinit__(self, np.ndarray arr = None):
+        Raises
+        ------
+        ValueError : if arr has not 2 or 3 dimensions, or if writable
+            is True and the rows of arr are not packed.
+        BufferError : if arr does not export a buffer, or it is read
+            only and writable is True. NumPy raises ValueError instead.
+        """
 
         if arr is None:
             self.numpyArray = None
             return
 
-        if not arr.flags['C_CONTIGUOUS']:
-            raise ValueError('arr must be C_CONTIGUOUS')
+        cdef int flags = PyBUF_STRIDES | PyBUF_FORMAT
+        if writable:
+            flags |= PyBUF_WRITABLE
 
-        # hold a reference to this numpy array inside this object
-        self.numpyArray = arr
+        PyObject_GetBuffer(arr, &self.buffer, flags)
+        self.hasBuffer = True
 
         # validate shape
-        shape = arr.shape
-        ndim = arr.ndim
+        ndim = self.buffer.ndim
         if ndim != 2 and ndim != 3:
             raise ValueError('Incorrect number of image dimensions. Expecting 2 or 3: {0}'.format(ndim))
 
+        if not self._packedRows():
+
+            if writable:
+                raise ValueError('arr rows must be packed to be written')
+
+            # read only inputs are copied into packed rows
+            PyBuffer_Release(&self.buffer)
+            self.hasBuffer = False
+
+            arr = np.ascontiguousarray(arr)
+            PyObject_GetBuffer(arr, &self.buffer, flags)
+            self.hasBuffer = True
+
+        # hold a reference to the wrapped object inside this object
+        self.numpyArray = arr
+
         # populate image_t properties
-        self.img.height = shape[0]
-        self.img.width = shape[1]
-        self.img.depth = shape[2] if ndim == 3 else 1
-        self.img.pitch = arr.strides[0]              # first stride corresponds to row pitch
-        self.img.itemSize = arr.strides[ndim -1]     # last stride corresponds to item size
-        self.img.data = <void*>arr.data
+        self.img.height = self.buffer.shape[0]
+        self.img.width = self.buffer.shape[1]
+        self.img.depth = self.buffer.shape[2] if ndim == 3 else 1
+        self.img.pitch = self.buffer.strides[0]     # first stride corresponds to row pitch
+        self.img.itemSize = self.buffer.itemsize
+        self.img.data = self.buffer.buf
 
 
     def __dealloc__(self):
 
-        # nothing to do, memory is relased by self.numpyArray
-        pass
+        # memory is released by the wrapped object
+        if self.hasBuffer:
+            PyBuffer_Release(&self.buffer)
+
+
+    cdef bint _packedRows(self):
+        """Tells if pixels and channels are packed within each row"""
+
+        cdef Py_ssize_t itemSize = self.buffer.itemsize
+        cdef Py_ssize_t depth = self.buffer.shape[2] if self.buffer.ndim == 3 else 1
+
+        if self.buffer.strides[self.buffer.ndim - 1] != itemSize:
+            return False
+
+        if self.buffer.ndim == 3 and self.buffer.strides[1] != depth*itemSize:
+            return False
+
+        return self.buffer.strides[0] >= self.buffer.shape[1]*depth*itemSize
 
 
     property width:
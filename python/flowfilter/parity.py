@@ -0,0 +1,602 @@
+"""
+    flowfilter.parity
+    -----------------
+
+    Parity and speed harness between the GPU engine and the
+    NumPy reference implementation of the filter.
+
+    Each stage of the filter (image model, propagation, update and
+    smoothing) is run on the same input by both implementations, as
+    well as the complete pyramidal filter over an image sequence.
+    For every comparison the harness reports the maximum and mean
+    absolute deviation, the runtime of each implementation and the
+    speedup of the engine over the reference.
+
+    The reference convolves with reflected borders while the GPU
+    samples textures with clamped coordinates, therefore deviations
+    are measured in the image interior, excluding a margin of pixels
+    at each side.
+
+    Usage from the command line::
+
+        python -m flowfilter.parity [--frames N] [--levels H] [--recorded seq.npy]
+
+    The process exits with status 1 if any comparison drifts beyond
+    its tolerance.
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+import argparse
+import math
+import sys
+import time
+
+import numpy as np
+
+from . import update as upd
+from . import propagation as prop
+from . import flowfilter as ff
+
+
+__all__ = ['deviation', 'compareImageModel', 'comparePropagation',
+    'compareUpdate', 'compareSmoothing', 'compareFilter',
+    'syntheticSequence', 'recordedSequence', 'runParity',
+    'formatReport', 'main']
+
+
+# wall clock used to time the reference implementation
+_clock = getattr(time, 'perf_counter', None) or time.clock
+
+
+# default tolerance on the maximum absolute deviation of each stage
+STAGE_TOLERANCE = 1e-3
+
+# default tolerance on the mean endpoint deviation of the complete filter
+FILTER_TOLERANCE = 0.25
+
+
+def deviation(reference, engine, margin=0):
+    """Returns the maximum and mean absolute deviation between two fields.
+
+    Pixels where either field is not finite are ignored.
+
+    Parameters
+    ----------
+    reference : ndarray
+        Field computed by the reference implementation.
+
+    engine : ndarray
+        Field computed by the engine. Must have the same shape
+        as reference.
+
+    margin : integer, optional
+        Number of pixels excluded at each image side. Defaults to 0.
+
+    Returns
+    -------
+    maxError : float
+        Maximum absolute deviation.
+
+    meanError : float
+        Mean absolute deviation.
+
+    Raises
+    ------
+    ValueError : if the shapes of reference and engine differ.
+    """
+
+    if reference.shape != engine.shape:
+        raise ValueError('shape mismatch: {0} != {1}'.format(reference.shape, engine.shape))
+
+    if margin > 0:
+        reference = reference[margin:-margin, margin:-margin, ...]
+        engine = engine[margin:-margin, margin:-margin, ...]
+
+    diff = np.abs(reference.astype(np.float64) - engine.astype(np.float64))
+    diff = diff[np.isfinite(diff)]
+
+    if diff.size == 0:
+        return 0.0, 0.0
+
+    return float(np.max(diff)), float(np.mean(diff))
+
+
+def _record(name, reference, engine, referenceTime, engineTime,
+    margin, tolerance, meanTolerance=None):
+    """Creates a comparison record.
+
+    If meanTolerance is given, the comparison passes if the mean
+    deviation is within meanTolerance, otherwise the maximum
+    deviation is compared against tolerance.
+    """
+
+    maxError, meanError = deviation(reference, engine, margin)
+
+    if meanTolerance is None:
+        passed = maxError <= tolerance
+    else:
+        passed = meanError <= meanTolerance
+
+    return {'name': name,
+            'maxError': maxError,
+            'meanError': meanError,
+            'referenceTime': referenceTime,
+            'engineTime': engineTime,
+            'speedup': referenceTime / engineTime if engineTime > 0.0 else float('inf'),
+            'tolerance': tolerance if meanTolerance is None else meanTolerance,
+            'passed': passed}
+
+
+def _timed(func, *args, **kwargs):
+    """Calls func and returns its result and runtime in milliseconds"""
+
+    start = _clock()
+    result = func(*args, **kwargs)
+    stop = _clock()
+
+    return result, (stop - start) * 1000.0
+
+
+def _upload(array):
+    """Uploads a float32 array into a new GPUImage"""
+
+    import flowfilter.gpu.image as gimg
+
+    array = np.ascontiguousarray(array, dtype=np.float32)
+    img = gimg.GPUImage(array.shape, itemSize=4)
+    img.upload(array)
+
+    return img
+
+
+def compareImageModel(img, margin=8, tolerance=STAGE_TOLERANCE):
+    """Compares the image model stage.
+
+    Parameters
+    ----------
+    img : ndarray
+        float32 image.
+
+    margin : integer, optional
+        Number of pixels excluded at each image side. Defaults to 8.
+
+    tolerance : float, optional
+        Maximum absolute deviation allowed.
+
+    Returns
+    -------
+    records : list[dict]
+        Comparison records for the constant and gradient terms.
+    """
+
+    import flowfilter.gpu.imagemodel as gimodel
+
+    img = img.astype(np.float32)
+
+    (A0, Ax, Ay), refTime = _timed(upd.imageModel, img, support=5)
+
+    imodel = gimodel.ImageModel(_upload(img))
+    imodel.compute()
+    engineTime = imodel.elapsedTime()
+
+    constant = imodel.getImageConstant().download(np.float32)
+    gradient = imodel.getImageGradient().download(np.float32)
+
+    refGradient = np.concatenate([Ax[..., np.newaxis], Ay[..., np.newaxis]], axis=2)
+
+    return [_record('ImageModel.constant', A0, constant, refTime, engineTime, margin, tolerance),
+            _record('ImageModel.gradient', refGradient, gradient, refTime, engineTime, margin, tolerance)]
+
+
+def comparePropagation(flow, iterations=1, border=3, margin=8, tolerance=STAGE_TOLERANCE):
+    """Compares the propagation stage.
+
+    Parameters
+    ----------
+    flow : ndarray
+        float32 optical flow field.
+
+    iterations : integer, optional
+        Propagation iterations. Defaults to 1.
+
+    border : integer, optional
+        Propagation border. Defaults to 3.
+
+    margin : integer, optional
+        Number of pixels excluded at each image side. Defaults to 8.
+
+    tolerance : float, optional
+        Maximum absolute deviation allowed.
+
+    Returns
+    -------
+    records : list[dict]
+    """
+
+    import flowfilter.gpu.propagation as gprop
+
+    flow = flow.astype(np.float32)
+
+    (flowProp, _), refTime = _timed(prop.propagate, flow, iterations, border=border)
+
+    propagator = gprop.FlowPropagator(_upload(flow), iterations)
+    propagator.border = border
+    propagator.compute()
+    engineTime = propagator.elapsedTime()
+
+    engineFlow = propagator.getPropagatedFlow().download(np.float32)
+
+    return [_record('FlowPropagator', flowProp, engineFlow, refTime, engineTime, margin, tolerance)]
+
+
+def compareUpdate(imgOld, img, flowPredicted, gamma=1.0, margin=8, tolerance=STAGE_TOLERANCE):
+    """Compares the update stage.
+
+    The engine update clamps the updated flow to maxflow, this
+    clamp is disabled for the comparison.
+
+    Parameters
+    ----------
+    imgOld : ndarray
+        float32 image of the previous frame.
+
+    img : ndarray
+        float32 image of the current frame.
+
+    flowPredicted : ndarray
+        float32 predicted optical flow.
+
+    gamma : float, optional
+        Temporal regularization gain. Defaults to 1.0.
+
+    margin : integer, optional
+        Number of pixels excluded at each image side. Defaults to 8.
+
+    tolerance : float, optional
+        Maximum absolute deviation allowed.
+
+    Returns
+    -------
+    records : list[dict]
+    """
+
+    import flowfilter.gpu.imagemodel as gimodel
+    import flowfilter.gpu.update as gupd
+
+    imgOld = imgOld.astype(np.float32)
+    img = img.astype(np.float32)
+    flowPredicted = flowPredicted.astype(np.float32)
+
+    A0old = upd.imageModel(imgOld, support=5)[0]
+    (flowUpd, A0), refTime = _timed(upd.update, img, A0old, flowPredicted, gamma=gamma)
+
+    gpuImage = _upload(imgOld)
+    gpuFlow = _upload(flowPredicted)
+
+    imodel = gimodel.ImageModel(gpuImage)
+
+    update = gupd.FlowUpdate(gpuFlow, imodel.getImageConstant(),
+        imodel.getImageGradient(), gamma, 1e6)
+
+    # first pass stores the constant term of the old image
+    imodel.compute()
+    update.compute()
+
+    gpuImage.upload(img)
+    imodel.compute()
+    update.compute()
+    engineTime = update.elapsedTime()
+
+    engineFlow = update.getUpdatedFlow().download(np.float32)
+    engineImage = update.getUpdatedImage().download(np.float32)
+
+    return [_record('FlowUpdate.flow', flowUpd, engineFlow, refTime, engineTime, margin, tolerance),
+            _record('FlowUpdate.image', A0, engineImage, refTime, engineTime, margin, tolerance)]
+
+
+def compareSmoothing(flow, iterations=1, margin=8, tolerance=STAGE_TOLERANCE):
+    """Compares the smoothing stage.
+
+    Parameters
+    ----------
+    flow : ndarray
+        float32 optical flow field.
+
+    iterations : integer, optional
+        Smoothing iterations. Defaults to 1.
+
+    margin : integer, optional
+        Number of pixels excluded at each image side. Defaults to 8.
+
+    tolerance : float, optional
+        Maximum absolute deviation allowed.
+
+    Returns
+    -------
+    records : list[dict]
+    """
+
+    import flowfilter.gpu.flowsmoothing as gsmooth
+
+    flow = flow.astype(np.float32)
+
+    flowSmooth, refTime = _timed(upd.smoothFlow, flow, iterations, support=5)
+
+    smoother = gsmooth.FlowSmoother(_upload(flow), iterations)
+    smoother.compute()
+    engineTime = smoother.elapsedTime()
+
+    engineFlow = smoother.getSmoothedFlow().download(np.float32)
+
+    return [_record('FlowSmoother', flowSmooth, engineFlow, refTime, engineTime, margin, tolerance)]
+
+
+def compareFilter(frames, groundTruth=None, levels=2, gamma=1.0,
+    maxflow=4.0, smoothIterations=1, margin=8, tolerance=FILTER_TOLERANCE):
+    """Compares the complete pyramidal filter over an image sequence.
+
+    Both filters are configured with the same parameters. The
+    reference applies the same maxflow to the delta flow of every
+    low level, while the engine halves it at each level, so the
+    comparison is made on the mean endpoint deviation.
+
+    Parameters
+    ----------
+    frames : iterable of ndarray
+        uint8 images. The engine reads them normalized to [0, 1],
+        the reference is fed the same normalized values.
+
+    groundTruth : iterable of ndarray, optional
+        Ground truth flow of each frame. If given, the endpoint
+        error of each implementation is included in the records.
+
+    levels : integer, optional
+        Pyramid levels. Defaults to 2.
+
+    gamma : float, optional
+        Temporal regularization gain of all levels. Defaults to 1.0.
+
+    maxflow : float, optional
+        Maximum flow magnitude at the base level. Defaults to 4.0.
+
+    smoothIterations : integer, optional
+        Smoothing iterations of all levels. Defaults to 1.
+
+    margin : integer, optional
+        Number of pixels excluded at each image side of the base level.
+        Defaults to 8.
+
+    tolerance : float, optional
+        Mean absolute deviation allowed on the final flow.
+
+    Returns
+    -------
+    records : list[dict]
+    """
+
+    import flowfilter.gpu.flowfilters as gff
+
+    frames = list(frames)
+    groundTruth = list(groundTruth) if groundTruth is not None else None
+    height, width = frames[0].shape[0:2]
+
+    engine = gff.PyramidalFlowFilter(height, width, levels)
+    engine.gamma = [gamma] * levels
+    engine.maxflow = maxflow
+    engine.smoothIterations = [smoothIterations] * levels
+
+    # propagation iterations of the reference, ceil(N / 2^h) at level h,
+    # match the ones derived from maxflow by the engine
+    reference = ff.PyramidalFlowFilter(levels=levels,
+        propIterations=int(math.ceil(maxflow)),
+        smoothIterations=smoothIterations,
+        gamma=gamma,
+        maxflow=engine.maxflow)
+
+    refTime = 0.0
+    engineTime = 0.0
+    refEPE = list()
+    engineEPE = list()
+
+    for k, frame in enumerate(frames):
+
+        reference.loadImage(frame.astype(np.float32) / 255.0)
+        reference.compute()
+        refTime += reference.elapsedTime()
+        refFlow = reference.getFlow()
+
+        engine.loadImage(np.ascontiguousarray(frame, dtype=np.uint8))
+        engine.compute()
+        engineTime += engine.elapsedTime()
+        engineFlow = engine.getFlow()
+
+        if groundTruth is not None:
+            refEPE.append(_endpointError(refFlow, groundTruth[k], margin))
+            engineEPE.append(_endpointError(engineFlow, groundTruth[k], margin))
+
+    record = _record('PyramidalFlowFilter', refFlow, engineFlow,
+        refTime, engineTime, margin, tolerance, meanTolerance=tolerance)
+
+    if groundTruth is not None:
+        record['referenceEPE'] = float(np.mean(refEPE))
+        record['engineEPE'] = float(np.mean(engineEPE))
+
+    return [record]
+
+
+def _endpointError(flow, groundTruth, margin):
+    """Mean endpoint error over the pixels with valid ground truth"""
+
+    if margin > 0:
+        flow = flow[margin:-margin, margin:-margin]
+        groundTruth = groundTruth[margin:-margin, margin:-margin]
+
+    err = np.sqrt(np.sum((flow - groundTruth)**2, axis=2))
+    err = err[np.isfinite(err)]
+
+    return float(np.mean(err)) if err.size > 0 else 0.0
+
+
+def syntheticSequence(height=240, width=320, frames=10,
+    linearVelocity=(0.05, 0.02, 0.0), angularVelocity=(0.0, 0.0, 0.002)):
+    """Renders a synthetic sequence with ground truth flow.
+
+    Parameters
+    ----------
+    height : integer, optional
+    width : integer, optional
+    frames : integer, optional
+        Number of frames.
+
+    linearVelocity : sequence of 3 floats, optional
+        Camera linear velocity in world units per frame.
+
+    angularVelocity : sequence of 3 floats, optional
+        Camera angular velocity in radians per frame.
+
+    Returns
+    -------
+    images : list[ndarray]
+        uint8 images.
+
+    flows : list[ndarray]
+        float32 ground truth flow of each image.
+    """
+
+    import flowfilter.synthetic as fsyn
+
+    seq = fsyn.SyntheticSequence(height, width)
+    seq.setMotion(linearVelocity, angularVelocity)
+
+    images = list()
+    flows = list()
+    for _ in range(frames):
+        img, flow = seq.nextFrame()
+        images.append(img)
+        flows.append(flow)
+
+    return images, flows
+
+
+def recordedSequence(path):
+    """Loads a recorded sequence.
+
+    Parameters
+    ----------
+    path : string
+        Path to a .npy file with a uint8 array of shape [frames, height, width].
+
+    Returns
+    -------
+    images : list[ndarray]
+    """
+
+    seq = np.load(path)
+    if seq.ndim != 3:
+        raise ValueError('recorded sequence must have shape [frames, height, width], got: {0}'.format(seq.shape))
+
+    return [np.ascontiguousarray(seq[k], dtype=np.uint8) for k in range(seq.shape[0])]
+
+
+def runParity(images, groundTruth=None, levels=2, gamma=1.0, maxflow=4.0,
+    smoothIterations=1, margin=8, stageTolerance=STAGE_TOLERANCE,
+    filterTolerance=FILTER_TOLERANCE):
+    """Runs all stage comparisons and the complete filter comparison.
+
+    Stages are compared on the first two frames of the sequence.
+    If ground truth is available, it is used as the predicted flow,
+    otherwise the flow estimated by the reference update is used.
+
+    Parameters
+    ----------
+    images : list[ndarray]
+        uint8 images, at least two.
+
+    groundTruth : list[ndarray], optional
+        Ground truth flow of each image.
+
+    Returns
+    -------
+    records : list[dict]
+    """
+
+    if len(images) < 2:
+        raise ValueError('at least two images are needed, got: {0}'.format(len(images)))
+
+    img0 = images[0].astype(np.float32) / 255.0
+    img1 = images[1].astype(np.float32) / 255.0
+
+    if groundTruth is not None:
+        flow = np.nan_to_num(groundTruth[1]).astype(np.float32)
+    else:
+        flow = upd.update(img1, upd.imageModel(img0)[0],
+            np.zeros(img0.shape + (2,), dtype=np.float32), gamma=gamma)[0]
+
+    flow = np.clip(flow, -maxflow, maxflow).astype(np.float32)
+
+    records = list()
+    records += compareImageModel(img1, margin, stageTolerance)
+    records += comparePropagation(flow, int(math.ceil(maxflow)), margin=margin,
+        tolerance=stageTolerance)
+    records += compareUpdate(img0, img1, flow, gamma, margin, stageTolerance)
+    records += compareSmoothing(flow, smoothIterations, margin, stageTolerance)
+    records += compareFilter(images, groundTruth, levels, gamma, maxflow,
+        smoothIterations, margin, filterTolerance)
+
+    return records
+
+
+def formatReport(records):
+    """Formats comparison records as a text table"""
+
+    lines = ['{0:24s} {1:>10s} {2:>10s} {3:>10s} {4:>12s} {5:>12s} {6:>9s}  {7}'.format(
+        'stage', 'max dev', 'mean dev', 'tolerance', 'ref (ms)', 'engine (ms)', 'speedup', 'status')]
+
+    for r in records:
+        lines.append('{0:24s} {1:10.3e} {2:10.3e} {3:10.3e} {4:12.3f} {5:12.3f} {6:9.1f}  {7}'.format(
+            r['name'], r['maxError'], r['meanError'], r['tolerance'],
+            r['referenceTime'], r['engineTime'], r['speedup'],
+            'ok' if r['passed'] else 'DRIFT'))
+
+        if 'engineEPE' in r:
+            lines.append('{0:24s} EPE reference: {1:.4f} engine: {2:.4f}'.format(
+                '', r['referenceEPE'], r['engineEPE']))
+
+    return '\n'.join(lines)
+
+
+def main(argv=None):
+
+    parser = argparse.ArgumentParser(description='GPU engine versus NumPy reference parity harness')
+    parser.add_argument('--recorded', default=None, help='.npy file with a uint8 [frames, height, width] sequence')
+    parser.add_argument('--frames', type=int, default=10, help='synthetic sequence length')
+    parser.add_argument('--height', type=int, default=240)
+    parser.add_argument('--width', type=int, default=320)
+    parser.add_argument('--levels', type=int, default=2)
+    parser.add_argument('--gamma', type=float, default=1.0)
+    parser.add_argument('--maxflow', type=float, default=4.0)
+    parser.add_argument('--smooth-iterations', type=int, default=1)
+    parser.add_argument('--margin', type=int, default=8)
+    parser.add_argument('--stage-tolerance', type=float, default=STAGE_TOLERANCE)
+    parser.add_argument('--filter-tolerance', type=float, default=FILTER_TOLERANCE)
+    args = parser.parse_args(argv)
+
+    if args.recorded is not None:
+        images = recordedSequence(args.recorded)
+        groundTruth = None
+    else:
+        images, groundTruth = syntheticSequence(args.height, args.width, args.frames)
+
+    records = runParity(images, groundTruth, args.levels, args.gamma,
+        args.maxflow, args.smooth_iterations, args.margin,
+        args.stage_tolerance, args.filter_tolerance)
+
+    print(formatReport(records))
+
+    return 0 if all(r['passed'] for r in records) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,59 @@
+"""
+    flowfilter.recording
+    --------------------
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+from libcpp cimport bool
+from libcpp.string cimport string
+
+cimport flowfilter.image as fimg
+
+
+cdef extern from 'flowfilter/recording.h' namespace 'flowfilter':
+
+    ctypedef bool (*replayCallback_t)(const int frame, const fimg.image_t_cpp& image,
+        const double timestamp, void* userData)
+
+
+    cdef cppclass FrameRecorder_cpp 'flowfilter::FrameRecorder':
+
+        FrameRecorder_cpp(const string& path, const int height, const int width,
+            const int depth, const size_t itemSize, const int queueLength) except +
+
+        bool record(const fimg.image_t_cpp& image, const double timestamp) except + nogil
+        bool record(const fimg.image_t_cpp& image) except + nogil
+        void close() except + nogil
+
+        int recordedFrames() const
+        int droppedFrames() const
+
+
+    cdef cppclass FrameReplayer_cpp 'flowfilter::FrameReplayer':
+
+        FrameReplayer_cpp(const string& path) except +
+
+        int replay(replayCallback_t callback, void* userData, const float speed) except + nogil
+        int lateFrames() const
+
+        fimg.image_t_cpp frame(const int index) except +
+        double timestamp(const int index) except +
+        double arrivalTime(const int index) except +
+
+        int frames() const
+        int height() const
+        int width() const
+        int depth() const
+        size_t itemSize() const
+
+
+cdef class FrameRecorder:
+
+    cdef FrameRecorder_cpp* recorder
+
+
+cdef class FrameReplayer:
+
+    cdef FrameReplayer_cpp* replayer
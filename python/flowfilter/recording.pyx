@@ -0,0 +1,303 @@
+"""
+    flowfilter.recording
+    --------------------
+
+    Recording and replay of timestamped input frames.
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+from libc.string cimport memcpy
+
+cimport numpy as np
+import numpy as np
+
+cimport flowfilter.image as fimg
+import flowfilter.image as fimg
+
+
+__all__ = ['FrameRecorder', 'FrameReplayer']
+
+
+# dtypes of the recorded frames, by item size
+_DTYPES = {1 : np.uint8, 4 : np.float32}
+
+
+cdef np.ndarray _copyImage(const fimg.image_t_cpp& img):
+    """Copies a packed uint8 or float32 image to a new array"""
+
+    dtype = _DTYPES[img.itemSize]
+
+    cdef np.ndarray arr
+    if img.depth == 1:
+        arr = np.empty((img.height, img.width), dtype=dtype)
+    else:
+        arr = np.empty((img.height, img.width, img.depth), dtype=dtype)
+
+    memcpy(arr.data, img.data, img.height*img.pitch)
+    return arr
+
+
+cdef class FrameRecorder:
+    """Records input frames and their arrival times to a file
+
+    Frames are copied to a bounded queue and written by a
+    background thread. When the queue is full, frames are
+    dropped instead of blocking the caller.
+    """
+
+    def __cinit__(self, path, int height, int width, int depth = 1,
+        dtype = np.uint8, int queueLength = 8):
+        """Creates the recording file
+
+        Parameters
+        ----------
+        path : string
+            File path.
+
+        height, width, depth : integer
+            Frame shape.
+
+        dtype : numpy dtype, optional
+            uint8 or float32. Defaults to uint8.
+
+        queueLength : integer, optional
+            Number of frames that can wait for the writer thread.
+
+        Raises
+        ------
+        ValueError : if dtype is not uint8 or float32.
+        """
+
+        dtype = np.dtype(dtype)
+        if dtype != np.uint8 and dtype != np.float32:
+            raise ValueError('dtype should be uint8 or float32, got: {0}'.format(dtype))
+
+        cdef size_t itemSize = dtype.itemsize
+        self.recorder = new FrameRecorder_cpp(path.encode('utf-8'),
+            height, width, depth, itemSize, queueLength)
+
+
+    def __dealloc__(self):
+        del self.recorder
+
+
+    def record(self, image, timestamp = None):
+        """Queues a frame
+
+        Parameters
+        ----------
+        image : buffer
+            Frame of the recording shape and dtype.
+
+        timestamp : float, optional
+            Frame timestamp. If None, the arrival time in seconds is used.
+
+        Returns
+        -------
+        queued : bool
+            False if the frame was dropped because the queue is full.
+        """
+
+        cdef fimg.Image img_w = fimg.Image(image)
+        cdef fimg.image_t_cpp img_c = img_w.img
+        cdef double ts
+        cdef bint queued
+
+        if timestamp is None:
+            with nogil:
+                queued = self.recorder.record(img_c)
+        else:
+            ts = timestamp
+            with nogil:
+                queued = self.recorder.record(img_c, ts)
+
+        return queued
+
+
+    def close(self):
+        """Writes the queued frames and closes the file"""
+
+        with nogil:
+            self.recorder.close()
+
+
+    property recordedFrames:
+        def __get__(self):
+            return self.recorder.recordedFrames()
+
+        def __set__(self, value):
+            raise RuntimeError('recordedFrames cannot be set')
+
+        def __del__(self):
+            pass
+
+
+    property droppedFrames:
+        def __get__(self):
+            return self.recorder.droppedFrames()
+
+        def __set__(self, value):
+            raise RuntimeError('droppedFrames cannot be set')
+
+        def __del__(self):
+            pass
+
+
+cdef class _ReplayState:
+    """Python state reached by the replay() callback"""
+
+    cdef object callback
+    cdef object error
+
+
+cdef bool _replayCallback(const int frame, const fimg.image_t_cpp& image,
+    const double timestamp, void* userData) noexcept with gil:
+
+    cdef _ReplayState state = <_ReplayState>userData
+
+    try:
+        return state.callback(frame, _copyImage(image), timestamp) is not False
+    except BaseException as e:
+        state.error = e
+        return False
+
+
+cdef class FrameReplayer:
+    """Replays a FrameRecorder file with its original timing
+
+    The file is memory mapped, frames are read without
+    loading the whole recording.
+    """
+
+    def __cinit__(self, path):
+        """Opens a recording
+
+        Raises
+        ------
+        ValueError : if the frames are not uint8 or float32.
+        """
+
+        cdef FrameReplayer_cpp* replayer = new FrameReplayer_cpp(path.encode('utf-8'))
+        cdef size_t itemSize = replayer.itemSize()
+
+        if itemSize not in _DTYPES:
+            del replayer
+            raise ValueError('recorded frames should be uint8 or float32, got item size: {0}'.format(itemSize))
+
+        self.replayer = replayer
+
+
+    def __dealloc__(self):
+        del self.replayer
+
+
+    def __len__(self):
+        return self.replayer.frames()
+
+
+    def replay(self, callback, float speed = 1.0):
+        """Calls callback(frame, image, timestamp) at the arrival time of each frame
+
+        Parameters
+        ----------
+        callback : callable
+            Called with the frame index, a copy of the frame and its
+            timestamp. The replay stops when it returns False.
+
+        speed : float, optional
+            Arrival times are divided by speed. Zero replays
+            without waiting. Defaults to 1.
+
+        Returns
+        -------
+        replayed : integer
+            Number of frames replayed. Frames replayed after their
+            arrival time are counted in lateFrames.
+        """
+
+        cdef _ReplayState state = _ReplayState()
+        state.callback = callback
+
+        cdef void* state_c = <void*>state
+        cdef int replayed
+
+        with nogil:
+            replayed = self.replayer.replay(_replayCallback, state_c, speed)
+
+        if state.error is not None:
+            raise state.error
+
+        return replayed
+
+
+    def frame(self, int index):
+        """Returns a copy of a frame"""
+
+        return _copyImage(self.replayer.frame(index))
+
+
+    def timestamp(self, int index):
+        return self.replayer.timestamp(index)
+
+
+    def arrivalTime(self, int index):
+        """Arrival time in seconds after the first frame"""
+
+        return self.replayer.arrivalTime(index)
+
+
+    property lateFrames:
+        def __get__(self):
+            return self.replayer.lateFrames()
+
+        def __set__(self, value):
+            raise RuntimeError('lateFrames cannot be set')
+
+        def __del__(self):
+            pass
+
+
+    property height:
+        def __get__(self):
+            return self.replayer.height()
+
+        def __set__(self, value):
+            raise RuntimeError('height cannot be set')
+
+        def __del__(self):
+            pass
+
+
+    property width:
+        def __get__(self):
+            return self.replayer.width()
+
+        def __set__(self, value):
+            raise RuntimeError('width cannot be set')
+
+        def __del__(self):
+            pass
+
+
+    property depth:
+        def __get__(self):
+            return self.replayer.depth()
+
+        def __set__(self, value):
+            raise RuntimeError('depth cannot be set')
+
+        def __del__(self):
+            pass
+
+
+    property dtype:
+        def __get__(self):
+            return np.dtype(_DTYPES[self.replayer.itemSize()])
+
+        def __set__(self, value):
+            raise RuntimeError('dtype cannot be set')
+
+        def __del__(self):
+            pass
@@ -0,0 +1,63 @@
+"""
+    flowfilter.synthetic
+    --------------------
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+cimport flowfilter.image as fimg
+cimport flowfilter.gpu.camera as gcam
+
+
+cdef extern from 'flowfilter/synthetic.h' namespace 'flowfilter':
+
+    ctypedef enum syntheticTexture_t_cpp 'flowfilter::syntheticTexture_t':
+        SYNTHETIC_TEXTURE_NOISE 'flowfilter::SYNTHETIC_TEXTURE_NOISE'
+        SYNTHETIC_TEXTURE_CHECKERBOARD 'flowfilter::SYNTHETIC_TEXTURE_CHECKERBOARD'
+
+
+    ctypedef struct syntheticPlane_t_cpp 'flowfilter::syntheticPlane_t':
+
+        float normal[3]
+        float distance
+        syntheticTexture_t_cpp texture
+        float textureScale
+        unsigned int seed
+
+
+    ctypedef struct cameraMotion_t_cpp 'flowfilter::cameraMotion_t':
+
+        float linearVelocity[3]
+        float angularVelocity[3]
+
+
+    cdef cppclass SyntheticSequence_cpp 'flowfilter::SyntheticSequence':
+
+        SyntheticSequence_cpp(const int height, const int width,
+            const gcam.perspectiveCamera_cpp& camera,
+            const int threads) except +
+
+        void addPlane(const syntheticPlane_t_cpp& plane) except +
+        void clearPlanes()
+
+        void setMotion(const cameraMotion_t_cpp& motion)
+        cameraMotion_t_cpp getMotion() const
+
+        void setNoiseOctaves(const int octaves) except +
+        int getNoiseOctaves() const
+
+        void reset()
+
+        void nextFrame(fimg.image_t_cpp& image) except + nogil
+        void nextFrame(fimg.image_t_cpp& image, fimg.image_t_cpp& flow) except + nogil
+
+        int frameNumber() const
+        int height() const
+        int width() const
+        int threads() const
+
+
+cdef class SyntheticSequence:
+
+    cdef SyntheticSequence_cpp* seq
@@ -0,0 +1,241 @@
+"""
+    flowfilter.synthetic
+    --------------------
+
+    Synthetic image sequences with ground truth optical flow.
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+cimport numpy as np
+import numpy as np
+
+cimport flowfilter.image as fimg
+import flowfilter.image as fimg
+
+cimport flowfilter.gpu.camera as gcam
+import flowfilter.gpu.camera as gcam
+
+
+cdef class SyntheticSequence:
+    """Renders textured planes seen by a moving camera.
+
+    Each frame is rendered together with its exact ground truth
+    optical flow. Pixels not seeing any plane have NaN flow.
+    """
+
+    def __cinit__(self, int height, int width,
+        gcam.PerspectiveCamera camera = None, int threads = 0):
+        """Creates a synthetic sequence
+
+        Parameters
+        ----------
+        height : integer
+            Image height.
+
+        width : integer
+            Image width.
+
+        camera : PerspectiveCamera, optional
+            Camera intrinsics. Defaults to a camera with focal
+            length equal to the image width in pixels.
+
+        threads : integer, optional
+            Number of rendering threads. If zero, the number
+            of hardware threads is used. Defaults to 0.
+        """
+
+        if camera is None:
+            camera = gcam.createPerspectiveCamera(width, height, width, height, width)
+
+        self.seq = new SyntheticSequence_cpp(height, width, camera.cam, threads)
+
+
+    def __dealloc__(self):
+        del self.seq
+
+
+    def addPlane(self, normal, float distance, texture='noise',
+        float textureScale = 1.0, unsigned int seed = 0):
+        """Adds a plane to the scene.
+
+        Points X of the plane satisfy dot(normal, X) = distance
+        in the camera frame of the first frame.
+
+        Parameters
+        ----------
+        normal : sequence of 3 floats
+            Plane normal.
+
+        distance : float
+            Distance from the camera center along the normal.
+
+        texture : string, optional
+            'noise' or 'checkerboard'. Defaults to 'noise'.
+
+        textureScale : float, optional
+            Texture frequency in cycles per world unit. Defaults to 1.0.
+
+        seed : integer, optional
+            Seed of the noise texture. Defaults to 0.
+        """
+
+        cdef syntheticPlane_t_cpp plane
+
+        for i in range(3):
+            plane.normal[i] = normal[i]
+
+        plane.distance = distance
+        plane.textureScale = textureScale
+        plane.seed = seed
+
+        if texture == 'noise':
+            plane.texture = SYNTHETIC_TEXTURE_NOISE
+        elif texture == 'checkerboard':
+            plane.texture = SYNTHETIC_TEXTURE_CHECKERBOARD
+        else:
+            raise ValueError('unknown texture: {0}'.format(texture))
+
+        self.seq.addPlane(plane)
+
+
+    def clearPlanes(self):
+        self.seq.clearPlanes()
+
+
+    def setMotion(self, linearVelocity, angularVelocity):
+        """Sets the camera velocity and resets the sequence.
+
+        Parameters
+        ----------
+        linearVelocity : sequence of 3 floats
+            Linear velocity in world units per frame, camera frame.
+
+        angularVelocity : sequence of 3 floats
+            Angular velocity in radians per frame, camera frame.
+        """
+
+        cdef cameraMotion_t_cpp motion
+
+        for i in range(3):
+            motion.linearVelocity[i] = linearVelocity[i]
+            motion.angularVelocity[i] = angularVelocity[i]
+
+        self.seq.setMotion(motion)
+
+
+    def getMotion(self):
+        """Returns the camera velocity
+
+        Returns
+        -------
+        linearVelocity : ndarray
+
+        angularVelocity : ndarray
+        """
+
+        cdef cameraMotion_t_cpp motion = self.seq.getMotion()
+
+        v = np.array([motion.linearVelocity[i] for i in range(3)], dtype=np.float32)
+        w = np.array([motion.angularVelocity[i] for i in range(3)], dtype=np.float32)
+
+        return v, w
+
+
+    def reset(self):
+        self.seq.reset()
+
+
+    def nextFrame(self, image = None, flow = None):
+        """Renders the current frame and its ground truth flow
+
+        The GIL is released while rendering.
+
+        Parameters
+        ----------
+        image : ndarray, optional
+            Output uint8 or float32 image. If None, a new uint8
+            array is allocated.
+
+        flow : ndarray, optional
+            Output float32 flow of shape [height, width, 2]. If None,
+            a new array is allocated.
+
+        Returns
+        -------
+        image : ndarray
+
+        flow : ndarray
+        """
+
+        if image is None:
+            image = np.zeros((self.height, self.width), dtype=np.uint8)
+
+        if flow is None:
+            flow = np.zeros((self.height, self.width, 2), dtype=np.float32)
+
+        cdef fimg.Image image_w = fimg.Image(image, writable=True)
+        cdef fimg.Image flow_w = fimg.Image(flow, writable=True)
+        cdef fimg.image_t_cpp image_c = image_w.img
+        cdef fimg.image_t_cpp flow_c = flow_w.img
+
+        with nogil:
+            self.seq.nextFrame(image_c, flow_c)
+
+        return image, flow
+
+
+    property noiseOctaves:
+        def __get__(self):
+            return self.seq.getNoiseOctaves()
+
+        def __set__(self, int octaves):
+            self.seq.setNoiseOctaves(octaves)
+
+        def __del__(self):
+            pass
+
+
+    property frameNumber:
+        def __get__(self):
+            return self.seq.frameNumber()
+
+        def __set__(self, value):
+            raise RuntimeError('frameNumber cannot be set')
+
+        def __del__(self):
+            pass
+
+
+    property height:
+        def __get__(self):
+            return self.seq.height()
+
+        def __set__(self, value):
+            raise RuntimeError('height cannot be set')
+
+        def __del__(self):
+            pass
+
+
+    property width:
+        def __get__(self):
+            return self.seq.width()
+
+        def __set__(self, value):
+            raise RuntimeError('width cannot be set')
+
+        def __del__(self):
+            pass
+
+
+    property threads:
+        def __get__(self):
+            return self.seq.threads()
+
+        def __set__(self, value):
+            raise RuntimeError('threads cannot be set')
+
+        def __del__(self):
+            pass
@@ -63,14 +63,21 @@ package_data = {'flowfilter' : ['*.pxd'],
 # CYTHON EXTENSIONS
 #################################################
 GPUmodulesTable = [ ('flowfilter.image', ['flowfilter/image.pyx']),
+                    ('flowfilter.synthetic', ['flowfilter/synthetic.pyx']),
+                    ('flowfilter.evaluation', ['flowfilter/evaluation.pyx']),
+                    ('flowfilter.recording', ['flowfilter/recording.pyx']),
                     ('flowfilter.gpu.image', ['flowfilter/gpu/image.pyx']),
                     ('flowfilter.gpu.imagemodel', ['flowfilter/gpu/imagemodel.pyx']),
                     ('flowfilter.gpu.pyramid', ['flowfilter/gpu/pyramid.pyx']),
                     ('flowfilter.gpu.propagation', ['flowfilter/gpu/propagation.pyx']),
                     ('flowfilter.gpu.update', ['flowfilter/gpu/update.pyx']),
+                    ('flowfilter.gpu.flowsmoothing', ['flowfilter/gpu/flowsmoothing.pyx']),
                     ('flowfilter.gpu.display', ['flowfilter/gpu/display.pyx']),
                     ('flowfilter.gpu.camera', ['flowfilter/gpu/camera.pyx']),
                     ('flowfilter.gpu.rotation', ['flowfilter/gpu/rotation.pyx']),
+                    ('flowfilter.gpu.interpolation', ['flowfilter/gpu/interpolation.pyx']),
+                    ('flowfilter.gpu.blockmatching', ['flowfilter/gpu/blockmatching.pyx']),
+                    ('flowfilter.gpu.upsampling', ['flowfilter/gpu/upsampling.pyx']),
 
                     # this module cannot be called flowfilter.gpu.flowfilter
                     ('flowfilter.gpu.flowfilters', ['flowfilter/gpu/flowfilters.pyx'])
@@ -0,0 +1,36 @@
+"""
+    test_exceptions
+    ---------------
+
+    Tests that C++ exceptions thrown while the GIL is released
+    reach Python. Requires a CUDA device.
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+import unittest
+
+from flowfilter.gpu.blockmatching import BlockMatchingSeeder
+from flowfilter.gpu.interpolation import FrameInterpolator
+from flowfilter.gpu.upsampling import JointBilateralUpsampler
+
+
+class TestComputeExceptions(unittest.TestCase):
+    """compute() of an unconfigured stage throws std::logic_error"""
+
+    def test_blockMatchingSeeder(self):
+        with self.assertRaises(RuntimeError):
+            BlockMatchingSeeder().compute()
+
+    def test_frameInterpolator(self):
+        with self.assertRaises(RuntimeError):
+            FrameInterpolator().compute()
+
+    def test_jointBilateralUpsampler(self):
+        with self.assertRaises(RuntimeError):
+            JointBilateralUpsampler().compute()
+
+
+if __name__ == '__main__':
+    unittest.main()
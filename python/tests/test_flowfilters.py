@@ -0,0 +1,79 @@
+"""
+    test_flowfilters
+    ----------------
+
+    Tests of flowfilter.gpu.flowfilters. Requires a CUDA device.
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+import unittest
+
+import numpy as np
+
+from flowfilter.gpu.flowfilters import FlowFilter, PyramidalFlowFilter
+
+
+class ProcessSequenceTests(object):
+    """processSequence() tests, run for each filter class"""
+
+    height = 32
+    width = 48
+
+    def createFilter(self):
+        raise NotImplementedError()
+
+    def test_scalarFrames(self):
+        with self.assertRaises(ValueError):
+            self.createFilter().processSequence(np.uint8(0))
+
+    def test_wrongRank(self):
+        frames = np.zeros((self.height, self.width), dtype=np.uint8)
+        with self.assertRaises(ValueError):
+            self.createFilter().processSequence(frames)
+
+    def test_wrongFrameShape(self):
+        frames = np.zeros((2, self.height, self.width + 1), dtype=np.uint8)
+        with self.assertRaises(ValueError):
+            self.createFilter().processSequence(frames)
+
+    def test_emptySequence(self):
+        frames = np.zeros((0, self.height, self.width), dtype=np.uint8)
+        flow = self.createFilter().processSequence(frames)
+        self.assertEqual(flow.shape, (0, self.height, self.width, 2))
+
+    def test_sequence(self):
+        rng = np.random.RandomState(0)
+        frames = rng.randint(0, 256, (3, self.height, self.width)).astype(np.uint8)
+
+        flow = self.createFilter().processSequence(frames)
+
+        self.assertEqual(flow.shape, (3, self.height, self.width, 2))
+        self.assertEqual(flow.dtype, np.float32)
+        self.assertTrue(np.all(np.isfinite(flow)))
+
+    def test_callbackError(self):
+        frames = np.zeros((3, self.height, self.width), dtype=np.uint8)
+
+        def callback(t, flow):
+            raise KeyError(t)
+
+        with self.assertRaises(KeyError):
+            self.createFilter().processSequence(frames, callback=callback)
+
+
+class TestFlowFilterSequence(ProcessSequenceTests, unittest.TestCase):
+
+    def createFilter(self):
+        return FlowFilter(self.height, self.width)
+
+
+class TestPyramidalFlowFilterSequence(ProcessSequenceTests, unittest.TestCase):
+
+    def createFilter(self):
+        return PyramidalFlowFilter(self.height, self.width, 2)
+
+
+if __name__ == '__main__':
+    unittest.main()
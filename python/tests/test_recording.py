@@ -0,0 +1,105 @@
+"""
+    test_recording
+    --------------
+
+    Tests of flowfilter.recording.
+
+    :copyright: 2015, Juan David Adarve, ANU. See AUTHORS for more details
+    :license: 3-clause BSD, see LICENSE for more details
+"""
+
+import os
+import shutil
+import struct
+import tempfile
+import unittest
+
+import numpy as np
+
+from flowfilter.recording import FrameRecorder, FrameReplayer
+
+
+class TestRecording(unittest.TestCase):
+
+    def setUp(self):
+        self.folder = tempfile.mkdtemp()
+        self.path = os.path.join(self.folder, 'frames.ffr')
+
+    def tearDown(self):
+        shutil.rmtree(self.folder)
+
+    def roundTrip(self, frames):
+        """Records and replays frames, returns the replayer"""
+
+        height, width = frames[0].shape[:2]
+        depth = frames[0].shape[2] if frames[0].ndim == 3 else 1
+
+        recorder = FrameRecorder(self.path, height, width, depth,
+            dtype=frames[0].dtype, queueLength=len(frames))
+
+        for n, frame in enumerate(frames):
+            self.assertTrue(recorder.record(frame, timestamp=0.5*n))
+
+        recorder.close()
+        self.assertEqual(recorder.recordedFrames, len(frames))
+
+        return FrameReplayer(self.path)
+
+    def checkRoundTrip(self, frames):
+
+        replayer = self.roundTrip(frames)
+        self.assertEqual(len(replayer), len(frames))
+        self.assertEqual(replayer.dtype, frames[0].dtype)
+
+        for n, frame in enumerate(frames):
+            replayed = replayer.frame(n)
+            self.assertEqual(replayed.dtype, frame.dtype)
+            self.assertEqual(replayed.shape, frame.shape)
+            np.testing.assert_array_equal(replayed, frame)
+            self.assertEqual(replayer.timestamp(n), 0.5*n)
+
+    def test_uint8(self):
+        rng = np.random.RandomState(0)
+        frames = [rng.randint(0, 256, (5, 7)).astype(np.uint8) for _ in range(3)]
+        self.checkRoundTrip(frames)
+
+    def test_float32(self):
+        rng = np.random.RandomState(1)
+        frames = [rng.rand(5, 7, 2).astype(np.float32) for _ in range(3)]
+        self.checkRoundTrip(frames)
+
+    def test_replayCallback(self):
+        frames = [np.full((4, 6), n, dtype=np.uint8) for n in range(3)]
+        replayer = self.roundTrip(frames)
+
+        replayed = []
+        count = replayer.replay(lambda n, image, ts: replayed.append(image), speed=0)
+
+        self.assertEqual(count, len(frames))
+        for frame, image in zip(frames, replayed):
+            np.testing.assert_array_equal(image, frame)
+
+    def test_unsupportedDtype(self):
+        for dtype in [np.float64, np.int16, np.int32]:
+            with self.assertRaises(ValueError):
+                FrameRecorder(self.path, 4, 6, 1, dtype=dtype)
+
+    def test_mismatchedFrame(self):
+        recorder = FrameRecorder(self.path, 4, 6, 1, dtype=np.float32)
+        with self.assertRaises(ValueError):
+            recorder.record(np.zeros((4, 6), dtype=np.float64))
+        recorder.close()
+
+    def test_unsupportedItemSize(self):
+
+        # header of a recording of float64 frames, without frames
+        header = b'FFRECSEQ' + struct.pack('<5i', 1, 4, 6, 1, 8)
+        with open(self.path, 'wb') as f:
+            f.write(header.ljust(64, b'\0'))
+
+        with self.assertRaises(ValueError):
+            FrameReplayer(self.path)
+
+
+if __name__ == '__main__':
+    unittest.main()
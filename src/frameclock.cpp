@@ -0,0 +1,145 @@
+/**
+ * \file frameclock.cpp
+ * \brief Frame timing of timestamped image streams.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "flowfilter/frameclock.h"
+
+namespace flowfilter {
+
+/** FNV-1a 64 bits offset basis and prime */
+static const std::uint64_t HASH_OFFSET = 14695981039346656037ull;
+static const std::uint64_t HASH_PRIME = 1099511628211ull;
+
+
+/**
+ * \brief FNV-1a hash of FRAMECLOCK_HASH_ROWS evenly spaced image rows.
+ */
+static std::uint64_t hashRows(const image_t& image) {
+
+    std::uint64_t hash = HASH_OFFSET;
+
+    const int rows = std::min(FRAMECLOCK_HASH_ROWS, image.height);
+    const std::size_t rowBytes = std::size_t(image.width) * image.depth * image.itemSize;
+
+    for(int r = 0; r < rows; r ++) {
+
+        // rows at the center of each of the bands the image is divided in
+        const int y = int((2*std::int64_t(r) + 1) * image.height / (2*rows));
+        const unsigned char* row = static_cast<const unsigned char*>(image.data) + y*image.pitch;
+
+        for(std::size_t i = 0; i < rowBytes; i ++) {
+            hash = (hash ^ row[i]) * HASH_PRIME;
+        }
+    }
+
+    return hash;
+}
+
+
+FrameClock::FrameClock() {
+
+    __frameInterval = 1.0;
+    __duplicateCount = 0;
+    reset();
+}
+
+
+bool FrameClock::tick(const double timestamp, const image_t& image) {
+
+    return accept(timestamp, true, hashRows(image));
+}
+
+
+bool FrameClock::tick(const double timestamp) {
+
+    return accept(timestamp, false, 0);
+}
+
+
+void FrameClock::tick() {
+
+    // the next timestamped frame starts a new stream
+    reset();
+}
+
+
+void FrameClock::reset() {
+
+    __started = false;
+    __timestamp = 0.0;
+    __hashed = false;
+    __hash = 0;
+    __timeStep = 1.0f;
+    __duplicate = false;
+}
+
+
+bool FrameClock::accept(const double timestamp, const bool hashed, const std::uint64_t hash) {
+
+    if(__started) {
+
+        __duplicate = timestamp <= __timestamp || (hashed && __hashed && hash == __hash);
+
+        if(__duplicate) {
+            __duplicateCount ++;
+            return false;
+        }
+
+        const double step = (timestamp - __timestamp) / __frameInterval;
+        __timeStep = float(std::min(std::max(step, 1.0 / FRAMECLOCK_MAX_TIME_STEP),
+            double(FRAMECLOCK_MAX_TIME_STEP)));
+
+    } else {
+        __timeStep = 1.0f;
+        __duplicate = false;
+    }
+
+    __started = true;
+    __timestamp = timestamp;
+    __hashed = hashed;
+    __hash = hash;
+
+    return true;
+}
+
+
+void FrameClock::setFrameInterval(const double interval) {
+
+    if(!(interval > 0.0)) {
+        std::cerr << "ERROR: FrameClock::setFrameInterval(): interval should be greater than zero: " << interval << std::endl;
+        throw std::invalid_argument("FrameClock::setFrameInterval(): interval should be greater than zero, got: "
+            + std::to_string(interval));
+    }
+
+    __frameInterval = interval;
+}
+
+
+double FrameClock::getFrameInterval() const {
+    return __frameInterval;
+}
+
+
+float FrameClock::timeStep() const {
+    return __timeStep;
+}
+
+
+bool FrameClock::duplicate() const {
+    return __duplicate;
+}
+
+
+int FrameClock::duplicateCount() const {
+    return __duplicateCount;
+}
+
+}; // namespace flowfilter
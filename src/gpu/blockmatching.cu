@@ -0,0 +1,250 @@
+/**
+ * \file blockmatching.cu
+ * \brief Block matching seeding of large displacements.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "flowfilter/gpu/util.h"
+#include "flowfilter/gpu/blockmatching.h"
+#include "flowfilter/gpu/device/blockmatching_k.h"
+#include "flowfilter/gpu/footprint.h"
+
+
+namespace flowfilter {
+namespace gpu {
+
+
+BlockMatchingSeeder::BlockMatchingSeeder() :
+    Stage() {
+
+    __configured = false;
+    __inputImageSet = false;
+    __inputFlowSet = false;
+    __imageOldSet = false;
+    __threshold = 2.0f;
+    __timeStep = 1.0f;
+
+    __camera.alphaX = 1.0f;
+    __camera.alphaY = 1.0f;
+    __camera.centerX = 0.0f;
+    __camera.centerY = 0.0f;
+    __angularVelocity = make_float3(0.0f, 0.0f, 0.0f);
+}
+
+
+BlockMatchingSeeder::BlockMatchingSeeder(GPUImage inputImage,
+    GPUImage inputFlow) :
+    BlockMatchingSeeder() {
+
+    setInputImage(inputImage);
+    setInputFlow(inputFlow);
+    configure();
+}
+
+
+BlockMatchingSeeder::~BlockMatchingSeeder() {
+    // nothing to do
+}
+
+
+void BlockMatchingSeeder::configure() {
+
+    if(!__inputImageSet) {
+        std::cerr << "ERROR: BlockMatchingSeeder::configure(): input image not set" << std::endl;
+        throw std::logic_error("BlockMatchingSeeder::configure(): input image not set");
+    }
+
+    if(!__inputFlowSet) {
+        std::cerr << "ERROR: BlockMatchingSeeder::configure(): input flow not set" << std::endl;
+        throw std::logic_error("BlockMatchingSeeder::configure(): input flow not set");
+    }
+
+    const int height = __inputImage.height();
+    const int width = __inputImage.width();
+
+    if(__inputFlow.height() != height || __inputFlow.width() != width) {
+        std::cerr << "ERROR: BlockMatchingSeeder::configure(): input image and flow shapes do not match" << std::endl;
+        throw std::invalid_argument("BlockMatchingSeeder::configure(): input image and flow shapes do not match");
+    }
+
+    __inputImageOld = GPUImage(height, width, 1, sizeof(unsigned char));
+    __imageOldSet = false;
+
+    // one thread block per cell, one thread per candidate displacement
+    const int cellsY = (height + BLOCKMATCHING_PATCH - 1) / BLOCKMATCHING_PATCH;
+    const int cellsX = (width + BLOCKMATCHING_PATCH - 1) / BLOCKMATCHING_PATCH;
+
+    __seeds = GPUImage(cellsY, cellsX, 2, sizeof(float));
+    __seeds.clear();
+
+    __block = dim3(2*BLOCKMATCHING_RADIUS + 1, 2*BLOCKMATCHING_RADIUS + 1, 1);
+    __grid = dim3(cellsX, cellsY, 1);
+
+    __configured = true;
+}
+
+
+void BlockMatchingSeeder::compute() {
+
+    startTiming();
+
+    if(!__configured) {
+        std::cerr << "ERROR: BlockMatchingSeeder::compute(): Stage not configured" << std::endl;
+        throw std::logic_error("BlockMatchingSeeder::compute(): stage not configured");
+    }
+
+    if(__imageOldSet) {
+        blockMatchingSeed_k<<<__grid, __block, 0, __stream>>>(
+            __inputImage.wrap<unsigned char>(),
+            __inputImageOld.wrap<unsigned char>(),
+            __camera, __angularVelocity, __timeStep, __threshold,
+            __inputFlow.wrap<float2>(),
+            __seeds.wrap<float2>());
+    }
+
+    __inputImageOld.copyFrom(__inputImage);
+    __imageOldSet = true;
+
+    stopTiming();
+}
+
+
+memoryTraffic_t BlockMatchingSeeder::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__inputImage.height()) * __inputImage.width();
+    std::size_t cells = std::size_t(__seeds.height()) * __seeds.width();
+
+    // each cell reads its patch, the search window of the
+    // previous image and the flow at the cell center, and writes
+    // its seed and, at most, the flow over the cell. The input
+    // image is then copied for the next call.
+    const std::size_t side = BLOCKMATCHING_PATCH + 2*BLOCKMATCHING_RADIUS;
+
+    memoryTraffic_t traffic;
+    traffic.bytesRead = cells * (side*side + 2*sizeof(float))
+        + 2*pixels*sizeof(unsigned char);
+
+    traffic.bytesWritten = cells * 2*sizeof(float)
+        + pixels * (2*sizeof(float) + sizeof(unsigned char));
+
+    return traffic;
+}
+
+
+void BlockMatchingSeeder::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("BlockMatchingSeeder", level, "inputImageOld", __inputImageOld));
+    buffers.push_back(describeBuffer("BlockMatchingSeeder", level, "seeds", __seeds));
+}
+
+
+void BlockMatchingSeeder::reset() {
+    __imageOldSet = false;
+}
+
+
+void BlockMatchingSeeder::setInputImage(GPUImage inputImage) {
+
+    if(inputImage.depth() != 1) {
+        std::cerr << "ERROR: BlockMatchingSeeder::setInputImage(): input image should have depth 1: "
+            << inputImage.depth() << std::endl;
+        throw std::invalid_argument("BlockMatchingSeeder::setInputImage(): input image should have depth 1, got: "
+            + std::to_string(inputImage.depth()));
+    }
+
+    if(inputImage.itemSize() != sizeof(unsigned char)) {
+        std::cerr << "ERROR: BlockMatchingSeeder::setInputImage(): input image should have item size 1: "
+            << inputImage.itemSize() << std::endl;
+        throw std::invalid_argument("BlockMatchingSeeder::setInputImage(): input image should have item size 1, got: "
+            + std::to_string(inputImage.itemSize()));
+    }
+
+    __inputImage = inputImage;
+    __inputImageSet = true;
+}
+
+
+void BlockMatchingSeeder::setInputFlow(GPUImage inputFlow) {
+
+    if(inputFlow.depth() != 2) {
+        std::cerr << "ERROR: BlockMatchingSeeder::setInputFlow(): input flow should have depth 2: "
+            << inputFlow.depth() << std::endl;
+        throw std::invalid_argument("BlockMatchingSeeder::setInputFlow(): input flow should have depth 2, got: "
+            + std::to_string(inputFlow.depth()));
+    }
+
+    if(inputFlow.itemSize() != 4) {
+        std::cerr << "ERROR: BlockMatchingSeeder::setInputFlow(): input flow should have item size 4: "
+            << inputFlow.itemSize() << std::endl;
+        throw std::invalid_argument("BlockMatchingSeeder::setInputFlow(): input flow should have item size 4, got: "
+            + std::to_string(inputFlow.itemSize()));
+    }
+
+    __inputFlow = inputFlow;
+    __inputFlowSet = true;
+}
+
+
+GPUImage BlockMatchingSeeder::getSeeds() {
+    return __seeds;
+}
+
+
+void BlockMatchingSeeder::setThreshold(const float threshold) {
+
+    if(!(threshold >= 0.0f)) {
+        std::cerr << "ERROR: BlockMatchingSeeder::setThreshold(): threshold should be greater or equal zero: "
+            << threshold << std::endl;
+        throw std::invalid_argument("BlockMatchingSeeder::setThreshold(): threshold should be greater or equal zero, got: "
+            + std::to_string(threshold));
+    }
+
+    __threshold = threshold;
+}
+
+
+float BlockMatchingSeeder::getThreshold() const {
+    return __threshold;
+}
+
+
+void BlockMatchingSeeder::setTimeStep(const float timeStep) {
+
+    if(!(timeStep > 0.0f)) {
+        std::cerr << "ERROR: BlockMatchingSeeder::setTimeStep(): time step should be greater than zero: "
+            << timeStep << std::endl;
+        throw std::invalid_argument("BlockMatchingSeeder::setTimeStep(): time step should be greater than zero, got: "
+            + std::to_string(timeStep));
+    }
+
+    __timeStep = timeStep;
+}
+
+
+float BlockMatchingSeeder::getTimeStep() const {
+    return __timeStep;
+}
+
+
+void BlockMatchingSeeder::setCamera(const perspectiveCamera& cam) {
+    __camera = cam;
+}
+
+
+void BlockMatchingSeeder::setAngularVelocity(const float wx, const float wy, const float wz) {
+
+    __angularVelocity.x = wx;
+    __angularVelocity.y = wy;
+    __angularVelocity.z = wz;
+}
+
+
+}; // namespace gpu
+}; // namespace flowfilter
@@ -28,5 +28,21 @@ perspectiveCamera createPerspectiveCamera(
     return cam;
 }
 
+
+perspectiveCamera pyramidLevelCamera(
+    const perspectiveCamera& cam, const int level) {
+
+    const float scale = 1.0f / float(1 << level);
+
+    // pixel centers of level h are at (x + 0.5)/2^h - 0.5
+    perspectiveCamera levelCam;
+    levelCam.alphaX = scale * cam.alphaX;
+    levelCam.alphaY = scale * cam.alphaY;
+    levelCam.centerX = scale * (cam.centerX + 0.5f) - 0.5f;
+    levelCam.centerY = scale * (cam.centerY + 0.5f) - 0.5f;
+
+    return levelCam;
+}
+
 }// namespace gpu
 }// namespace flowfilter
\ No newline at end of file
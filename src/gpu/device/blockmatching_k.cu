@@ -0,0 +1,174 @@
+/**
+ * \file blockmatching_k.cu
+ * \brief Kernel declarations for block matching flow seeding.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include "flowfilter/gpu/device/camera_k.h"
+#include "flowfilter/gpu/device/image_k.h"
+#include "flowfilter/gpu/device/math_k.h"
+#include "flowfilter/gpu/device/blockmatching_k.h"
+
+namespace flowfilter {
+namespace gpu {
+
+
+/**
+ * \brief rotational optical flow of angular velocity w at pixel pix.
+ */
+inline __device__ float2 rotationalFlow(const perspectiveCamera& cam,
+    const float3& w, const int2& pix) {
+
+    const float3 p = pixelToCameraCoordinates(cam, pix);
+    const float3 wp_cross = cross(w, p);
+
+    return make_float2(cam.alphaX*wp_cross.x + (cam.centerX - pix.x)*wp_cross.z,
+        cam.alphaY*wp_cross.y + (cam.centerY - pix.y)*wp_cross.z);
+}
+
+
+__global__ void blockMatchingSeed_k(gpuimage_t<unsigned char> image,
+                                    gpuimage_t<unsigned char> imageOld,
+                                    perspectiveCamera cam,
+                                    const float3 w,
+                                    const float timeStep,
+                                    const float threshold,
+                                    gpuimage_t<float2> inputFlow,
+                                    gpuimage_t<float2> seeds) {
+
+    const int P = BLOCKMATCHING_PATCH;
+    const int R = BLOCKMATCHING_RADIUS;
+
+    // search window rows, padded with one word for unaligned reads
+    const int windowSide = P + 2*R;
+    const int windowWords = windowSide/4 + 1;
+
+    __shared__ unsigned int window_s[windowSide*windowWords];
+    __shared__ unsigned int patch_s[P*P/4];
+    __shared__ unsigned int best_s;
+    __shared__ unsigned int worst_s;
+    __shared__ unsigned int prior_s;
+
+    const int height = image.height;
+    const int width = image.width;
+
+    // top left corner of the cell patch
+    const int x0 = blockIdx.x*P;
+    const int y0 = blockIdx.y*P;
+
+    const int tid = threadIdx.y*blockDim.x + threadIdx.x;
+    const int threads = blockDim.x*blockDim.y;
+
+    unsigned char* window_b = reinterpret_cast<unsigned char*>(window_s);
+    unsigned char* patch_b = reinterpret_cast<unsigned char*>(patch_s);
+
+    // previous image around the patch, clamped at the borders
+    for(int i = tid; i < windowSide*windowWords*4; i += threads) {
+
+        const int r = i / (windowWords*4);
+        const int c = i - r*windowWords*4;
+        const int2 pix = make_int2(min(max(x0 - R + c, 0), width - 1),
+            min(max(y0 - R + r, 0), height - 1));
+
+        window_b[i] = *coordPitch(imageOld, pix);
+    }
+
+    for(int i = tid; i < P*P; i += threads) {
+
+        const int r = i / P;
+        const int c = i - r*P;
+        const int2 pix = make_int2(min(x0 + c, width - 1), min(y0 + r, height - 1));
+
+        patch_b[i] = *coordPitch(image, pix);
+    }
+
+    if(tid == 0) {
+        best_s = 0xFFFFFFFF;
+        worst_s = 0;
+        prior_s = 0xFFFFFFFF;
+    }
+
+    __syncthreads();
+
+    // displacement predicted by the prior flow at the cell
+    // center over the time step, including rotation
+    const int2 center = make_int2(min(x0 + P/2, width - 1), min(y0 + P/2, height - 1));
+    const float2 rotation = rotationalFlow(cam, w, center);
+
+    const float2 flow = *coordPitch(inputFlow, center);
+    const float2 prior = make_float2(timeStep*flow.x + rotation.x,
+        timeStep*flow.y + rotation.y);
+
+    // candidate displacement of this thread, the patch
+    // at pixel x in image comes from x - d in imageOld
+    const int dx = int(threadIdx.x) - R;
+    const int dy = int(threadIdx.y) - R;
+
+    unsigned int sad = 0;
+
+    #pragma unroll
+    for(int r = 0; r < P; r ++) {
+
+        const int offset = (R - dy + r)*windowWords*4 + (R - dx);
+        const int k = offset >> 2;
+        const unsigned int selector = 0x3210 + (offset & 3)*0x1111;
+
+        #pragma unroll
+        for(int c = 0; c < P/4; c ++) {
+
+            // 4 consecutive window bytes starting at an unaligned offset
+            const unsigned int word = __byte_perm(window_s[k + c], window_s[k + c + 1], selector);
+            sad += __vsadu4(word, patch_s[r*P/4 + c]);
+        }
+    }
+
+    // ties are resolved towards the shortest displacement
+    const unsigned int length = abs(dx) + abs(dy);
+    atomicMin(&best_s, (sad << 16) | (length << 10) | tid);
+    atomicMax(&worst_s, sad);
+
+    if(dx == __float2int_rn(prior.x) && dy == __float2int_rn(prior.y)) {
+        prior_s = sad;
+    }
+
+    __syncthreads();
+
+    const unsigned int best = best_s;
+    const unsigned int bestSad = best >> 16;
+    const int bestIndex = best & 0x3FF;
+
+    const float2 match = make_float2(float(int(bestIndex % blockDim.x) - R),
+        float(int(bestIndex / blockDim.x) - R));
+
+    // flows are stored per frame interval and without rotation
+    const float2 seed = make_float2((match.x - rotation.x) / timeStep,
+        (match.y - rotation.y) / timeStep);
+
+    if(tid == 0) {
+        *coordPitch(seeds, make_int2(blockIdx.x, blockIdx.y)) = seed;
+    }
+
+    // flat or repetitive patches do not have a distinct match
+    const float distance = sqrtf((match.x - prior.x)*(match.x - prior.x)
+        + (match.y - prior.y)*(match.y - prior.y));
+
+    const float limit = BLOCKMATCHING_SAD_RATIO*float(min(prior_s, worst_s));
+
+    if(distance <= threshold || !(float(bestSad) < limit)) {
+        return;
+    }
+
+    for(int i = tid; i < P*P; i += threads) {
+
+        const int2 pix = make_int2(x0 + (i % P), y0 + i / P);
+
+        if(pix.x < width && pix.y < height) {
+            *coordPitch(inputFlow, pix) = seed;
+        }
+    }
+}
+
+
+}; // namespace gpu
+}; // namespace flowfilter
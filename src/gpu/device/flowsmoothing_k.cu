@@ -86,5 +86,353 @@ __global__ void flowSmoothY_k(cudaTextureObject_t inputFlow,
     *coordPitch(flowSmooth, pix) = smooth_y;
 }
 
+
+//######################
+// arbitrary support
+//######################
+__global__ void flowSmoothSupportX_k(cudaTextureObject_t inputFlow,
+        const int radius,
+        gpuimage_t<float2> flowSmooth) {
+
+    const int height = flowSmooth.height;
+    const int width = flowSmooth.width;
+
+    // pixel coordinate
+    const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
+    blockIdx.y*blockDim.y + threadIdx.y);
+
+    if(pix.x >= width || pix.y >= height) {
+        return;
+    }
+
+    float2 smooth_x = make_float2(0.0f, 0.0f);
+
+    for(int c = -radius; c <= radius; c ++) {
+        float2 flow = tex2D<float2>(inputFlow, pix.x + c, pix.y);
+        smooth_x.x += flow.x;
+        smooth_x.y += flow.y;
+    }
+
+    const float coeff = 1.0f / (2*radius + 1);
+    *coordPitch(flowSmooth, pix) = make_float2(coeff*smooth_x.x, coeff*smooth_x.y);
+}
+
+__global__ void flowSmoothSupportY_k(cudaTextureObject_t inputFlow,
+        const int radius,
+        gpuimage_t<float2> flowSmooth) {
+
+    const int height = flowSmooth.height;
+    const int width = flowSmooth.width;
+
+    // pixel coordinate
+    const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
+    blockIdx.y*blockDim.y + threadIdx.y);
+
+    if(pix.x >= width || pix.y >= height) {
+        return;
+    }
+
+    float2 smooth_y = make_float2(0.0f, 0.0f);
+
+    for(int r = -radius; r <= radius; r ++) {
+        float2 flow = tex2D<float2>(inputFlow, pix.x, pix.y + r);
+        smooth_y.x += flow.x;
+        smooth_y.y += flow.y;
+    }
+
+    const float coeff = 1.0f / (2*radius + 1);
+    *coordPitch(flowSmooth, pix) = make_float2(coeff*smooth_y.x, coeff*smooth_y.y);
+}
+
+
+
+//######################
+// domain transform
+//######################
+__global__ void flowDomainTransformX_k(cudaTextureObject_t inputFlow,
+        gpuimage_t<float> guide,
+        const float log2Feedback,
+        const float ratio,
+        gpuimage_t<float2> flowSmooth) {
+
+    const int height = flowSmooth.height;
+    const int width = flowSmooth.width;
+
+    // one thread per row
+    const int y = blockIdx.x*blockDim.x + threadIdx.x;
+
+    if(y >= height) {
+        return;
+    }
+
+    //#################################
+    // CAUSAL SWEEP
+    //#################################
+    float guidePrev = *coordPitch(guide, make_int2(0, y));
+    float2 smooth = tex2D<float2>(inputFlow, 0, y);
+    *coordPitch(flowSmooth, make_int2(0, y)) = smooth;
+
+    for(int x = 1; x < width; x ++) {
+
+        const int2 pix = make_int2(x, y);
+        const float g = *coordPitch(guide, pix);
+        const float w = exp2f(log2Feedback * (1.0f + ratio*fabsf(g - guidePrev)));
+        const float2 flow = tex2D<float2>(inputFlow, x, y);
+
+        smooth.x = flow.x + w*(smooth.x - flow.x);
+        smooth.y = flow.y + w*(smooth.y - flow.y);
+
+        *coordPitch(flowSmooth, pix) = smooth;
+        guidePrev = g;
+    }
+
+    //#################################
+    // ANTICAUSAL SWEEP
+    //#################################
+    float guideNext = guidePrev;
+
+    for(int x = width - 2; x >= 0; x --) {
+
+        const int2 pix = make_int2(x, y);
+        const float g = *coordPitch(guide, pix);
+        const float w = exp2f(log2Feedback * (1.0f + ratio*fabsf(guideNext - g)));
+        const float2 flow = *coordPitch(flowSmooth, pix);
+
+        smooth.x = flow.x + w*(smooth.x - flow.x);
+        smooth.y = flow.y + w*(smooth.y - flow.y);
+
+        *coordPitch(flowSmooth, pix) = smooth;
+        guideNext = g;
+    }
+}
+
+__global__ void flowDomainTransformY_k(gpuimage_t<float2> inputFlow,
+        gpuimage_t<float> guide,
+        const float log2Feedback,
+        const float ratio,
+        gpuimage_t<float2> flowSmooth) {
+
+    const int height = flowSmooth.height;
+    const int width = flowSmooth.width;
+
+    // one thread per column, consecutive threads access consecutive pixels
+    const int x = blockIdx.x*blockDim.x + threadIdx.x;
+
+    if(x >= width) {
+        return;
+    }
+
+    //#################################
+    // CAUSAL SWEEP
+    //#################################
+    float guidePrev = *coordPitch(guide, make_int2(x, 0));
+    float2 smooth = *coordPitch(inputFlow, make_int2(x, 0));
+    *coordPitch(flowSmooth, make_int2(x, 0)) = smooth;
+
+    for(int y = 1; y < height; y ++) {
+
+        const int2 pix = make_int2(x, y);
+        const float g = *coordPitch(guide, pix);
+        const float w = exp2f(log2Feedback * (1.0f + ratio*fabsf(g - guidePrev)));
+        const float2 flow = *coordPitch(inputFlow, pix);
+
+        smooth.x = flow.x + w*(smooth.x - flow.x);
+        smooth.y = flow.y + w*(smooth.y - flow.y);
+
+        *coordPitch(flowSmooth, pix) = smooth;
+        guidePrev = g;
+    }
+
+    //#################################
+    // ANTICAUSAL SWEEP
+    //#################################
+    float guideNext = guidePrev;
+
+    for(int y = height - 2; y >= 0; y --) {
+
+        const int2 pix = make_int2(x, y);
+        const float g = *coordPitch(guide, pix);
+        const float w = exp2f(log2Feedback * (1.0f + ratio*fabsf(guideNext - g)));
+        const float2 flow = *coordPitch(flowSmooth, pix);
+
+        smooth.x = flow.x + w*(smooth.x - flow.x);
+        smooth.y = flow.y + w*(smooth.y - flow.y);
+
+        *coordPitch(flowSmooth, pix) = smooth;
+        guideNext = g;
+    }
+}
+
+
+
+//######################
+// median
+//######################
+
+/**
+ * \brief branch-free compare and exchange of each component,
+ *      a receives the minimum and b the maximum.
+ */
+__device__ __forceinline__ void sortPair(float2& a, float2& b) {
+
+    const float2 lo = make_float2(fminf(a.x, b.x), fminf(a.y, b.y));
+    b = make_float2(fmaxf(a.x, b.x), fmaxf(a.y, b.y));
+    a = lo;
+}
+
+__device__ __forceinline__ float2 median3(float2 a, float2 b, float2 c) {
+
+    sortPair(a, b);
+    sortPair(b, c);
+    sortPair(a, b);
+    return b;
+}
+
+
+/**
+ * \brief loads the block tile with a border of radius pixels.
+ */
+template<int radius>
+__device__ __forceinline__ void loadMedianTile(cudaTextureObject_t inputFlow,
+    float2 tile[FLOW_MEDIAN_BLOCK_Y + 2*radius][FLOW_MEDIAN_BLOCK_X + 2*radius]) {
+
+    const int tileHeight = FLOW_MEDIAN_BLOCK_Y + 2*radius;
+    const int tileWidth = FLOW_MEDIAN_BLOCK_X + 2*radius;
+
+    const int x0 = blockIdx.x*FLOW_MEDIAN_BLOCK_X - radius;
+    const int y0 = blockIdx.y*FLOW_MEDIAN_BLOCK_Y - radius;
+
+    for(int r = threadIdx.y; r < tileHeight; r += FLOW_MEDIAN_BLOCK_Y) {
+        for(int c = threadIdx.x; c < tileWidth; c += FLOW_MEDIAN_BLOCK_X) {
+            // texture address mode clamps coordinates at the borders
+            tile[r][c] = tex2D<float2>(inputFlow, x0 + c, y0 + r);
+        }
+    }
+
+    __syncthreads();
+}
+
+
+__global__ void flowMedian3_k(cudaTextureObject_t inputFlow,
+        gpuimage_t<float2> flowSmooth) {
+
+    const int tileWidth = FLOW_MEDIAN_BLOCK_X + 2;
+
+    __shared__ float2 tile[FLOW_MEDIAN_BLOCK_Y + 2][FLOW_MEDIAN_BLOCK_X + 2];
+
+    // sorted columns of 3 pixels centered at each row of the block
+    __shared__ float2 colMin[FLOW_MEDIAN_BLOCK_Y][FLOW_MEDIAN_BLOCK_X + 2];
+    __shared__ float2 colMed[FLOW_MEDIAN_BLOCK_Y][FLOW_MEDIAN_BLOCK_X + 2];
+    __shared__ float2 colMax[FLOW_MEDIAN_BLOCK_Y][FLOW_MEDIAN_BLOCK_X + 2];
+
+    loadMedianTile<1>(inputFlow, tile);
+
+    //#################################
+    // COLUMN SORTS
+    //#################################
+    for(int c = threadIdx.x; c < tileWidth; c += FLOW_MEDIAN_BLOCK_X) {
+
+        const int r = threadIdx.y;
+        float2 a = tile[r][c];
+        float2 b = tile[r + 1][c];
+        float2 d = tile[r + 2][c];
+
+        sortPair(a, b);
+        sortPair(b, d);
+        sortPair(a, b);
+
+        colMin[r][c] = a;
+        colMed[r][c] = b;
+        colMax[r][c] = d;
+    }
+
+    __syncthreads();
+
+    const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
+        blockIdx.y*blockDim.y + threadIdx.y);
+
+    if(pix.x >= flowSmooth.width || pix.y >= flowSmooth.height) {
+        return;
+    }
+
+    //#################################
+    // MERGE THE THREE COLUMNS
+    //#################################
+    const int r = threadIdx.y;
+    const int c = threadIdx.x;
+
+    // the median is the median of the largest minimum,
+    // the median of the medians and the smallest maximum
+    float2 lo = colMin[r][c];
+    float2 hi = colMax[r][c];
+
+    #pragma unroll
+    for(int k = 1; k < 3; k ++) {
+        const float2 m = colMin[r][c + k];
+        const float2 M = colMax[r][c + k];
+        lo = make_float2(fmaxf(lo.x, m.x), fmaxf(lo.y, m.y));
+        hi = make_float2(fminf(hi.x, M.x), fminf(hi.y, M.y));
+    }
+
+    const float2 md = median3(colMed[r][c], colMed[r][c + 1], colMed[r][c + 2]);
+
+    *coordPitch(flowSmooth, pix) = median3(lo, md, hi);
+}
+
+
+__global__ void flowMedian5_k(cudaTextureObject_t inputFlow,
+        gpuimage_t<float2> flowSmooth) {
+
+    __shared__ float2 tile[FLOW_MEDIAN_BLOCK_Y + 4][FLOW_MEDIAN_BLOCK_X + 4];
+
+    loadMedianTile<2>(inputFlow, tile);
+
+    const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
+        blockIdx.y*blockDim.y + threadIdx.y);
+
+    if(pix.x >= flowSmooth.width || pix.y >= flowSmooth.height) {
+        return;
+    }
+
+    const int r = threadIdx.y;
+    const int c = threadIdx.x;
+
+    //#################################
+    // FORGETFUL SELECTION
+    //#################################
+    // the median of 25 values is never the minimum or maximum of
+    // any 14 of them. Starting with 14 window values, the minimum
+    // and maximum are discarded and the next value is inserted
+    // until the 25 values are consumed and 3 remain.
+    float2 v[14];
+
+    #pragma unroll
+    for(int k = 0; k < 14; k ++) {
+        v[k] = tile[r + k / 5][c + k % 5];
+    }
+
+    #pragma unroll
+    for(int k = 14; k < 25; k ++) {
+
+        const int n = 28 - k;
+
+        // move the minimum to v[0] and the maximum to v[n - 1]
+        #pragma unroll
+        for(int i = 1; i < n; i ++) {
+            sortPair(v[0], v[i]);
+        }
+
+        #pragma unroll
+        for(int i = 1; i < n - 1; i ++) {
+            sortPair(v[i], v[n - 1]);
+        }
+
+        // replace the minimum, forget the maximum
+        v[0] = tile[r + k / 5][c + k % 5];
+    }
+
+    *coordPitch(flowSmooth, pix) = median3(v[0], v[1], v[2]);
+}
+
 }; // namespace gpu
 }; // namespace flowfilter
\ No newline at end of file
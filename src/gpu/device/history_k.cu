@@ -0,0 +1,40 @@
+/**
+ * \file history_k.cu
+ * \brief Kernel declarations for the flow history.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include "flowfilter/gpu/device/image_k.h"
+#include "flowfilter/gpu/device/history_k.h"
+
+namespace flowfilter {
+namespace gpu {
+
+
+__global__ void quantizeFlow_k(gpuimage_t<float2> inputFlow,
+                               const float scale,
+                               gpuimage_t<short2> quantizedFlow) {
+
+    const int height = inputFlow.height;
+    const int width = inputFlow.width;
+
+    // pixel coordinate
+    const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
+        blockIdx.y*blockDim.y + threadIdx.y);
+
+    if(pix.x >= width || pix.y >= height) {
+        return;
+    }
+
+    const float2 flow = *coordPitch(inputFlow, pix);
+
+    const int qx = min(max(__float2int_rn(scale*flow.x), -32767), 32767);
+    const int qy = min(max(__float2int_rn(scale*flow.y), -32767), 32767);
+
+    *coordPitch(quantizedFlow, pix) = make_short2(qx, qy);
+}
+
+
+}; // namespace gpu
+}; // namespace flowfilter
@@ -132,5 +132,78 @@ __global__ void imageModel_k(cudaTextureObject_t imgPrefiltered,
     *coordPitch(imgConstant, pix) = smooth;
 }
 
+
+//######################
+// arbitrary support
+//######################
+
+__global__ void imagePrefilterSupport_k(cudaTextureObject_t inputImage,
+        const imageModelMask_t mask,
+        gpuimage_t<float2> imgPrefiltered) {
+
+    const int height = imgPrefiltered.height;
+    const int width = imgPrefiltered.width;
+
+    // pixel coordinate
+    const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
+    blockIdx.y*blockDim.y + threadIdx.y);
+
+    if(pix.x >= width || pix.y >= height) {
+        return;
+    }
+
+    const int R = mask.radius;
+
+    float smooth_x = 0.0f;
+    float smooth_y = 0.0f;
+
+    for(int k = -R; k <= R; k ++) {
+        smooth_x += mask.smooth[k + R] * tex2D<float>(inputImage, pix.x + k, pix.y);
+        smooth_y += mask.smooth[k + R] * tex2D<float>(inputImage, pix.x, pix.y + k);
+    }
+
+    // {smooth_y, smooth_x}
+    *coordPitch(imgPrefiltered, pix) = make_float2(smooth_y, smooth_x);
+}
+
+
+__global__ void imageModelSupport_k(cudaTextureObject_t imgPrefiltered,
+        const imageModelMask_t mask,
+        gpuimage_t<float> imgConstant,
+        gpuimage_t<float2> imgGradient) {
+
+    const int height = imgConstant.height;
+    const int width = imgConstant.width;
+
+    // pixel coordinate
+    const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
+    blockIdx.y*blockDim.y + threadIdx.y);
+
+    if(pix.x >= width || pix.y >= height) {
+        return;
+    }
+
+    const int R = mask.radius;
+
+    float diff_x = 0.0;
+    float diff_y = 0.0;
+    float smooth = 0.0;
+
+    for(int k = -R; k <= R; k ++) {
+
+        // smoothed in Y, differenced and smoothed in X
+        float2 imElement = tex2D<float2>(imgPrefiltered, pix.x + k, pix.y);
+        diff_x += mask.diff[k + R]*imElement.x;
+        smooth += mask.smooth[k + R]*imElement.x;
+
+        // smoothed in X, differenced in Y
+        imElement = tex2D<float2>(imgPrefiltered, pix.x, pix.y + k);
+        diff_y += mask.diff[k + R]*imElement.y;
+    }
+
+    *coordPitch(imgGradient, pix) = make_float2(diff_x, diff_y);
+    *coordPitch(imgConstant, pix) = smooth;
+}
+
 }; // namespace gpu
 }; // namespace flowfilter
\ No newline at end of file
@@ -0,0 +1,74 @@
+/**
+ * \file interpolation_k.cu
+ * \brief Kernel declarations for motion compensated frame interpolation.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include "flowfilter/gpu/device/image_k.h"
+#include "flowfilter/gpu/device/interpolation_k.h"
+
+namespace flowfilter {
+namespace gpu {
+
+
+__global__ void warpImage_k(gpuimage_t<float2> inputFlow,
+                            cudaTextureObject_t inputImage,
+                            const float t,
+                            gpuimage_t<float> interpolatedImage) {
+
+    const int height = inputFlow.height;
+    const int width = inputFlow.width;
+
+    // pixel coordinate
+    const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
+        blockIdx.y*blockDim.y + threadIdx.y);
+
+    if(pix.x >= width || pix.y >= height) {
+        return;
+    }
+
+    const float2 flow = *coordPitch(inputFlow, pix);
+
+    // texel centers are at half pixel coordinates
+    const float s = 1.0f - t;
+    const float value = tex2D<float>(inputImage,
+        pix.x + 0.5f + s*flow.x, pix.y + 0.5f + s*flow.y);
+
+    *coordPitch(interpolatedImage, pix) = value;
+}
+
+
+__global__ void warpBlendImage_k(gpuimage_t<float2> inputFlow,
+                                 cudaTextureObject_t inputImage,
+                                 cudaTextureObject_t inputImageOld,
+                                 const float t,
+                                 gpuimage_t<float> interpolatedImage) {
+
+    const int height = inputFlow.height;
+    const int width = inputFlow.width;
+
+    // pixel coordinate
+    const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
+        blockIdx.y*blockDim.y + threadIdx.y);
+
+    if(pix.x >= width || pix.y >= height) {
+        return;
+    }
+
+    const float2 flow = *coordPitch(inputFlow, pix);
+
+    const float x = pix.x + 0.5f;
+    const float y = pix.y + 0.5f;
+    const float s = 1.0f - t;
+
+    // forward to the current frame, backward to the previous one
+    const float value = tex2D<float>(inputImage, x + s*flow.x, y + s*flow.y);
+    const float valueOld = tex2D<float>(inputImageOld, x - t*flow.x, y - t*flow.y);
+
+    *coordPitch(interpolatedImage, pix) = s*valueOld + t*value;
+}
+
+
+}; // namespace gpu
+}; // namespace flowfilter
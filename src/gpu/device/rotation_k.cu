@@ -42,5 +42,31 @@ __global__ void rotationalOpticalFlow_k(perspectiveCamera cam,
     *coordPitch(flowField, pix) = flow;
 }
 
+
+__global__ void addRotationalFlow_k(perspectiveCamera cam,
+    float3 w, gpuimage_t<float2> inputFlow, gpuimage_t<float2> flowField) {
+
+    const int height = flowField.height;
+    const int width = flowField.width;
+
+    // pixel coordinate
+    const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
+    blockIdx.y*blockDim.y + threadIdx.y);
+
+    if(pix.x >= width || pix.y >= height) {
+        return;
+    }
+
+    float3 p = pixelToCameraCoordinates(cam, pix);
+
+    float3 wp_cross = cross(w, p);
+
+    float2 flow = *coordPitch(inputFlow, pix);
+    flow.x += cam.alphaX*wp_cross.x + (cam.centerX - pix.x)*wp_cross.z;
+    flow.y += cam.alphaY*wp_cross.y + (cam.centerY - pix.y)*wp_cross.z;
+
+    *coordPitch(flowField, pix) = flow;
+}
+
 } // namespace gpu
 } // namespace flowfilter
@@ -12,11 +12,70 @@
 namespace flowfilter {
 namespace gpu {
 
+
+/**
+ * \brief clears the block histogram of the residual.
+ */
+__device__ void residualInit_d(unsigned int* histogram_s, float* sum_s) {
+
+    const int tid = threadIdx.y*blockDim.x + threadIdx.x;
+    for(int b = tid; b < RESIDUAL_HISTOGRAM_BINS; b += blockDim.x*blockDim.y) {
+        histogram_s[b] = 0;
+    }
+
+    if(tid == 0) {
+        *sum_s = 0.0f;
+    }
+
+    __syncthreads();
+}
+
+
+/**
+ * \brief accumulates the absolute residual e in the block histogram.
+ *
+ * Residuals greater than residualRange are counted in the last bin.
+ */
+__device__ void residualAccumulate_d(const float e, const float residualRange,
+    unsigned int* histogram_s, float* sum_s) {
+
+    int bin = (int)(e * (RESIDUAL_HISTOGRAM_BINS / residualRange));
+    bin = min(bin, RESIDUAL_HISTOGRAM_BINS - 1);
+
+    atomicAdd(&histogram_s[bin], 1);
+    atomicAdd(sum_s, e);
+}
+
+
+/**
+ * \brief adds the block histogram and sum to the global ones.
+ */
+__device__ void residualFlush_d(unsigned int* histogram_s, float* sum_s,
+    gpuimage_t<unsigned int> residualHistogram, gpuimage_t<float> residualSum) {
+
+    __syncthreads();
+
+    const int tid = threadIdx.y*blockDim.x + threadIdx.x;
+    for(int b = tid; b < RESIDUAL_HISTOGRAM_BINS; b += blockDim.x*blockDim.y) {
+        if(histogram_s[b] > 0) {
+            atomicAdd(&residualHistogram.data[b], histogram_s[b]);
+        }
+    }
+
+    if(tid == 0) {
+        atomicAdd(residualSum.data, *sum_s);
+    }
+}
+
+
 __global__ void flowUpdate_k(gpuimage_t<float> newImage, 
     gpuimage_t<float2> newImageGradient,
     gpuimage_t<float> oldImage, gpuimage_t<float2> oldFlow,
     gpuimage_t<float> imageUpdated, gpuimage_t<float2> flowUpdated,
-    const float gamma, const float maxflow) {
+    const float gamma, const float maxflow,
+    const float timeStep,
+    const bool computeResidual, const float residualRange,
+    gpuimage_t<unsigned int> residualHistogram, gpuimage_t<float> residualSum) {
 
 
     const int height = flowUpdated.height;
@@ -26,21 +85,35 @@ __global__ void flowUpdate_k(gpuimage_t<float> newImage,
     const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
     blockIdx.y*blockDim.y + threadIdx.y);
 
-    if(pix.x >= width || pix.y >= height) {
+    const bool inside = pix.x < width && pix.y < height;
+
+    if(!inside && !computeResidual) {
         return;
     }
 
+    // block histogram of the brightness constancy residual
+    __shared__ unsigned int histogram_s[RESIDUAL_HISTOGRAM_BINS];
+    __shared__ float sum_s;
+
+    if(computeResidual) {
+        residualInit_d(histogram_s, &sum_s);
+    }
+
+    // out of range threads read the closest pixel and only
+    // take part in the block reduction of the residual
+    const int2 pixc = make_int2(min(pix.x, width - 1), min(pix.y, height - 1));
+
     // read elements from the different arrays
-    float2 a1 = *coordPitch(newImageGradient, pix);
-    float a0 = *coordPitch(newImage, pix);
-    float a0old = *coordPitch(oldImage, pix);
-    float2 ofOld = *coordPitch(oldFlow, pix);
+    float2 a1 = *coordPitch(newImageGradient, pixc);
+    float a0 = *coordPitch(newImage, pixc);
+    float a0old = *coordPitch(oldImage, pixc);
+    float2 ofOld = *coordPitch(oldFlow, pixc);
 
     //#################################
     // FLOW UPDATE
     //#################################
-    // temporal derivative
-    float Yt = a0old - a0;
+    // temporal derivative, per frame interval
+    float Yt = (a0old - a0) / timeStep;
 
     float ax2 = a1.x*a1.x;
     float ay2 = a1.y*a1.y;
@@ -71,6 +144,24 @@ __global__ void flowUpdate_k(gpuimage_t<float> newImage,
     ofNew.y = isinf(ofNew.y) + isnan(ofNew.y) > 0? 0.0f : ofNew.y;
 
 
+    //#################################
+    // BRIGHTNESS CONSTANCY RESIDUAL
+    //#################################
+    if(computeResidual) {
+
+        if(inside) {
+            float e = fabsf(a1.x*ofNew.x + a1.y*ofNew.y - Yt);
+            residualAccumulate_d(e, residualRange, histogram_s, &sum_s);
+        }
+
+        residualFlush_d(histogram_s, &sum_s, residualHistogram, residualSum);
+
+        if(!inside) {
+            return;
+        }
+    }
+
+
     //#################################
     // PACK RESULTS
     //#################################
@@ -87,7 +178,11 @@ __global__ void deltaFlowUpdate_k(gpuimage_t<float> newImage,
                                   gpuimage_t<float> imageUpdated,
                                   gpuimage_t<float2> deltaFlowUpdated,
                                   gpuimage_t<float2> flowUpdated,
-                                  const float gamma, const float maxflow) {
+                                  const float gamma, const float maxflow,
+                                  const float timeStep,
+                                  const bool computeResidual, const float residualRange,
+                                  gpuimage_t<unsigned int> residualHistogram,
+                                  gpuimage_t<float> residualSum) {
 
 
     const int height = flowUpdated.height;
@@ -97,21 +192,35 @@ __global__ void deltaFlowUpdate_k(gpuimage_t<float> newImage,
     const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
     blockIdx.y*blockDim.y + threadIdx.y);
 
-    if(pix.x >= width || pix.y >= height) {
+    const bool inside = pix.x < width && pix.y < height;
+
+    if(!inside && !computeResidual) {
         return;
     }
 
+    // block histogram of the brightness constancy residual
+    __shared__ unsigned int histogram_s[RESIDUAL_HISTOGRAM_BINS];
+    __shared__ float sum_s;
+
+    if(computeResidual) {
+        residualInit_d(histogram_s, &sum_s);
+    }
+
+    // out of range threads read the closest pixel and only
+    // take part in the block reduction of the residual
+    const int2 pixc = make_int2(min(pix.x, width - 1), min(pix.y, height - 1));
+
     // read elements from the different arrays
-    float2 a1 = *coordPitch(newImageGradient, pix);
-    float a0 = *coordPitch(newImage, pix);
-    float a0old = *coordPitch(oldImage, pix);
-    float2 deltaFlowOld = *coordPitch(oldDeltaFlow, pix);
+    float2 a1 = *coordPitch(newImageGradient, pixc);
+    float a0 = *coordPitch(newImage, pixc);
+    float a0old = *coordPitch(oldImage, pixc);
+    float2 deltaFlowOld = *coordPitch(oldDeltaFlow, pixc);
 
     //#################################
     // FLOW UPDATE
     //#################################
-    // temporal derivative
-    float Yt = a0old - a0;
+    // temporal derivative, per frame interval
+    float Yt = (a0old - a0) / timeStep;
 
     float ax2 = a1.x*a1.x;
     float ay2 = a1.y*a1.y;
@@ -142,6 +251,24 @@ __global__ void deltaFlowUpdate_k(gpuimage_t<float> newImage,
     dFlowNew.y = max(-0.5f*maxflow, min(dFlowNew.y, 0.5f*maxflow));
 
 
+    //#################################
+    // BRIGHTNESS CONSTANCY RESIDUAL
+    //#################################
+    if(computeResidual) {
+
+        if(inside) {
+            float e = fabsf(a1.x*dFlowNew.x + a1.y*dFlowNew.y - Yt);
+            residualAccumulate_d(e, residualRange, histogram_s, &sum_s);
+        }
+
+        residualFlush_d(histogram_s, &sum_s, residualHistogram, residualSum);
+
+        if(!inside) {
+            return;
+        }
+    }
+
+
     //#################################
     // OPTICAL FLOW COMPUTATION
     //#################################
@@ -0,0 +1,88 @@
+/**
+ * \file upsampling_k.cu
+ * \brief Kernel declarations for guided flow upsampling.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include "flowfilter/gpu/device/image_k.h"
+#include "flowfilter/gpu/device/upsampling_k.h"
+
+namespace flowfilter {
+namespace gpu {
+
+
+__global__ void jointBilateralUpsample_k(gpuimage_t<float2> inputFlow,
+                                         gpuimage_t<unsigned char> guideCoarse,
+                                         gpuimage_t<unsigned char> guide,
+                                         const float2 scale,
+                                         const float invSigmaSpace2,
+                                         const float invSigmaRange2,
+                                         gpuimage_t<float2> upsampledFlow) {
+
+    const int height = upsampledFlow.height;
+    const int width = upsampledFlow.width;
+
+    // pixel coordinate
+    const int2 pix = make_int2(blockIdx.x*blockDim.x + threadIdx.x,
+        blockIdx.y*blockDim.y + threadIdx.y);
+
+    if(pix.x >= width || pix.y >= height) {
+        return;
+    }
+
+    // pixel center in input flow coordinates
+    const float xc = (pix.x + 0.5f) / scale.x - 0.5f;
+    const float yc = (pix.y + 0.5f) / scale.y - 0.5f;
+
+    const int cx = __float2int_rn(xc);
+    const int cy = __float2int_rn(yc);
+
+    const float g = (1.0f / 255.0f) * (*coordPitch(guide, pix));
+
+    float2 sum = make_float2(0.0f, 0.0f);
+    float2 sumSpace = make_float2(0.0f, 0.0f);
+    float weight = 0.0f;
+    float weightSpace = 0.0f;
+
+    #pragma unroll
+    for(int r = -1; r <= 1; r ++) {
+
+        #pragma unroll
+        for(int c = -1; c <= 1; c ++) {
+
+            const int2 q = make_int2(min(max(cx + c, 0), inputFlow.width - 1),
+                min(max(cy + r, 0), inputFlow.height - 1));
+
+            const float dx = q.x - xc;
+            const float dy = q.y - yc;
+            const float dg = g - (1.0f / 255.0f) * (*coordPitch(guideCoarse, q));
+
+            const float ws = __expf(-0.5f*invSigmaSpace2*(dx*dx + dy*dy));
+            const float w = ws * __expf(-0.5f*invSigmaRange2*dg*dg);
+
+            const float2 flow = *coordPitch(inputFlow, q);
+
+            sum.x += w*flow.x;
+            sum.y += w*flow.y;
+            weight += w;
+
+            sumSpace.x += ws*flow.x;
+            sumSpace.y += ws*flow.y;
+            weightSpace += ws;
+        }
+    }
+
+    // pixels unlike all their neighbors fall back to spatial weights
+    if(weight < 1e-6f) {
+        sum = sumSpace;
+        weight = weightSpace;
+    }
+
+    *coordPitch(upsampledFlow, pix) = make_float2(scale.x*sum.x / weight,
+        scale.y*sum.y / weight);
+}
+
+
+}; // namespace gpu
+}; // namespace flowfilter
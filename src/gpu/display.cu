@@ -13,6 +13,7 @@
 #include "flowfilter/gpu/util.h"
 #include "flowfilter/gpu/display.h"
 #include "flowfilter/gpu/device/display_k.h"
+#include "flowfilter/gpu/footprint.h"
 
 
 namespace flowfilter {
@@ -97,6 +98,31 @@ void FlowToColor::compute() {
 }
 
 
+memoryTraffic_t FlowToColor::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__inputFlow.height()) * __inputFlow.width();
+
+    memoryTraffic_t traffic;
+
+    // reads the flow and writes RGBA color. Color wheel
+    // reads are served by the texture cache and not counted.
+    traffic.bytesRead = pixels * 2*sizeof(float);
+    traffic.bytesWritten = pixels * 4*sizeof(unsigned char);
+
+    return traffic;
+}
+
+
+void FlowToColor::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("FlowToColor", level, "colorWheel", __colorWheel, true));
+    buffers.push_back(describeBuffer("FlowToColor", level, "colorFlow", __colorFlow));
+}
+
+
+
 void FlowToColor::setInputFlow(GPUImage inputFlow) {
 
     if(inputFlow.depth() != 2) {
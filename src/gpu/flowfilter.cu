@@ -10,15 +10,63 @@
 #include <string>
 #include <exception>
 #include <stdexcept>
+#include <algorithm>
 #include <cmath>
 
 #include "flowfilter/gpu/util.h"
 #include "flowfilter/gpu/error.h"
 #include "flowfilter/gpu/flowfilter.h"
+#include "flowfilter/gpu/footprint.h"
 
 namespace flowfilter {
 namespace gpu {
 
+/**
+ * \brief load, compute and download loop shared by the
+ *      processSequence() methods of the filters.
+ */
+template<typename filter_t>
+int runSequence(filter_t& filter, const std::string& name,
+    std::vector<image_t>& frames, std::vector<image_t>& flows,
+    sequenceCallback_t callback, void* userData) {
+
+    if(frames.size() != flows.size()) {
+        std::cerr << "ERROR: " << name << "::processSequence(): frames and flows size do not match: "
+            << frames.size() << " != " << flows.size() << std::endl;
+        throw std::invalid_argument(name + "::processSequence(): frames and flows size do not match: "
+            + std::to_string(frames.size()) + " != " + std::to_string(flows.size()));
+    }
+
+    int processed = 0;
+    for(std::size_t t = 0; t < frames.size(); t ++) {
+
+        filter.loadImage(frames[t]);
+        filter.compute();
+        filter.downloadFlow(flows[t]);
+        processed ++;
+
+        if(callback != nullptr && !callback(int(t), userData)) {
+            break;
+        }
+    }
+
+    return processed;
+}
+
+
+/** node index of the image model in the stage graph of the filters */
+static const int NODE_IMAGEMODEL = 0;
+
+
+/**
+ * \brief throws std::invalid_argument for a tap a filter does not have.
+ */
+static void tapNotAvailable(const std::string& name, const filterTap_t tap) {
+
+    std::cerr << "ERROR: " << name << "::getTap(): tap not available: " << int(tap) << std::endl;
+    throw std::invalid_argument(name + "::getTap(): tap not available: " + std::to_string(int(tap)));
+}
+
 
 FlowFilter::FlowFilter() :
     Stage() {
@@ -27,11 +75,15 @@ FlowFilter::FlowFilter() :
     __width = 0;
     __configured = false;
     __inputImageSet = false;
+    __publishFlow = false;
+    __parameters = ParameterBuffer(1);
 }
 
 FlowFilter::FlowFilter(flowfilter::gpu::GPUImage inputImage) :
     Stage() {
 
+    __publishFlow = false;
+    __parameters = ParameterBuffer(1);
 
     setInputImage(inputImage);
     configure();
@@ -64,6 +116,8 @@ FlowFilter::FlowFilter(const int height, const int width,
     __width = 0;
     __configured = false;
     __inputImageSet = false;
+    __publishFlow = false;
+    __parameters = ParameterBuffer(1);
 
     // creates a GPUImage for storing input image internally
     GPUImage inputImage = GPUImage(height, width, 1, sizeof(unsigned char));
@@ -88,35 +142,82 @@ void FlowFilter::configure() {
         throw std::logic_error("FlowFilter::configure(): input image has not been set");
     }
 
-    // connect the blocks
-    __imageModel = ImageModel(__inputImage);
-
-    // dummy flow field use to instanciate the update block
-    // This is necessary to break the circular dependency
-    // between propagation and update blocks.
-    GPUImage dummyFlow(__height, __width, 2, sizeof(float));
+    const int height = __inputImage.height();
+    const int width = __inputImage.width();
 
-    // FIXME: find good default values
-    __update = FlowUpdate(dummyFlow,
-        __imageModel.getImageConstant(),
-        __imageModel.getImageGradient(),
-        1.0, 1.0);
+    const portType_t imageType = {height, width, 1, int(sizeof(float))};
+    const portType_t flowType = {height, width, 2, int(sizeof(float))};
 
-    __smoother = FlowSmoother(__update.getUpdatedFlow(), 1);
+    // fresh stages, wired and configured by the graph
+    __imageModel = ImageModel();
+    __propagator = FlowPropagator();
+    __update = FlowUpdate();
+    __smoother = FlowSmoother();
 
-    __propagator = FlowPropagator(__smoother.getSmoothedFlow(), 1);
+    // FIXME: find good default values
+    __propagator.setIterations(1);
+    __smoother.setIterations(1);
+
+    StageGraph graph;
+    graph.addNode("ImageModel", &__imageModel);
+    graph.addNode("FlowPropagator", &__propagator);
+    graph.addNode("FlowUpdate", &__update);
+    graph.addNode("FlowSmoother", &__smoother);
+
+    graph.addInput("ImageModel", "inputImage", {height, width, 1, __inputImage.itemSize()},
+        [this](GPUImage img) { __imageModel.setInputImage(img); });
+    graph.addOutput("ImageModel", "imageConstant", imageType,
+        [this]() { return __imageModel.getImageConstant(); });
+    graph.addOutput("ImageModel", "imageGradient", flowType,
+        [this]() { return __imageModel.getImageGradient(); });
+
+    graph.addInput("FlowPropagator", "inputFlow", flowType,
+        [this](GPUImage img) { __propagator.setInputFlow(img); });
+    graph.addOutput("FlowPropagator", "propagatedFlow", flowType,
+        [this]() { return __propagator.getPropagatedFlow(); });
+
+    // the update reads its input flow directly, which breaks the
+    // cycle between propagation and update blocks
+    graph.addInput("FlowUpdate", "inputFlow", flowType,
+        [this](GPUImage img) { __update.setInputFlow(img); }, true);
+    graph.addInput("FlowUpdate", "inputImage", imageType,
+        [this](GPUImage img) { __update.setInputImage(img); });
+    graph.addInput("FlowUpdate", "inputImageGradient", flowType,
+        [this](GPUImage img) { __update.setInputImageGradient(img); });
+    graph.addOutput("FlowUpdate", "updatedFlow", flowType,
+        [this]() { return __update.getUpdatedFlow(); });
+
+    graph.addInput("FlowSmoother", "inputFlow", flowType,
+        [this](GPUImage img) { __smoother.setInputFlow(img); });
+    graph.addInput("FlowSmoother", "guideImage", imageType,
+        [this](GPUImage img) { __smoother.setGuideImage(img); });
+    graph.addOutput("FlowSmoother", "smoothedFlow", flowType,
+        [this]() { return __smoother.getSmoothedFlow(); });
+
+    graph.feed(__inputImage, "ImageModel.inputImage");
+    graph.connect("ImageModel.imageConstant", "FlowUpdate.inputImage");
+    graph.connect("ImageModel.imageGradient", "FlowUpdate.inputImageGradient");
+    graph.connect("ImageModel.imageConstant", "FlowSmoother.guideImage");
+    graph.connect("FlowPropagator.propagatedFlow", "FlowUpdate.inputFlow");
+    graph.connect("FlowUpdate.updatedFlow", "FlowSmoother.inputFlow");
+
+    // smoothed flow is propagated in next call to compute()
+    graph.connectLoop("FlowSmoother.smoothedFlow", "FlowPropagator.inputFlow");
+
+    graph.require("FlowSmoother.smoothedFlow");
+
+    __plan = graph.configure();
 
-    // set the input flow of the update block to the output
-    // of the propagator. This replaces dummyFlow previously
-    // assigned to the update
-    __update.setInputFlow(__propagator.getPropagatedFlow());
-    
     // clear buffers
     __propagator.getPropagatedFlow().clear();
     __update.getUpdatedFlow().clear();
     __update.getUpdatedImage().clear();
     __smoother.getSmoothedFlow().clear();
 
+    if(__publishFlow) {
+        __snapshots = FlowSnapshotBuffer(__inputImage.height(), __inputImage.width());
+    }
+
     __configured = true;
     __firstLoad = true;
 }
@@ -124,34 +225,93 @@ void FlowFilter::configure() {
 
 void FlowFilter::compute() {
 
+    // parameters submitted from a control thread
+    filterParameters_t params;
+    if(__parameters.consume(params)) {
+        applyParameters(params);
+    }
+
+    // duplicate frame, the current flow stays valid
+    if(__clock.duplicate()) {
+        return;
+    }
+
     startTiming();
 
-    // compute image model
-    __imageModel.compute();
+    const std::vector<Stage*> stages = this->stages();
+    for(const int n : __plan.order) {
 
-    if(__firstLoad) {
-        std::cout << "FlowFilter::compute(): fisrt load" << std::endl;
+        stages[n]->compute();
 
-        // set the old image value to current
-        // computed constant brightness parameter
-        GPUImage imConstant = __imageModel.getImageConstant();
-        __update.getUpdatedImage().copyFrom(imConstant);
-        
-        __firstLoad = false;
-    }
+        if(n == NODE_IMAGEMODEL && __firstLoad) {
+            std::cout << "FlowFilter::compute(): fisrt load" << std::endl;
 
-    // propagate old flow
-    __propagator.compute();
+            // set the old image value to current
+            // computed constant brightness parameter
+            GPUImage imConstant = __imageModel.getImageConstant();
+            __update.getUpdatedImage().copyFrom(imConstant);
 
-    // update
-    __update.compute();
-    
-    // smooth updated flow
-    __smoother.compute();
+            __firstLoad = false;
+        }
+    }
 
     stopTiming();
+
+    if(__publishFlow) {
+        GPUImage flow = __smoother.getSmoothedFlow();
+        __snapshots.publish(flow);
+    }
+
+    if(__history.isAllocated()) {
+        GPUImage flow = __smoother.getSmoothedFlow();
+        __history.record(flow);
+    }
+}
+
+memoryTraffic_t FlowFilter::memoryTraffic() const {
+
+    memoryTraffic_t traffic = __imageModel.memoryTraffic();
+    traffic += __propagator.memoryTraffic();
+    traffic += __update.memoryTraffic();
+    traffic += __smoother.memoryTraffic();
+
+    return traffic;
+}
+
+
+void FlowFilter::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("FlowFilter", level, "inputImage", __inputImage));
+
+    __imageModel.appendBuffers(buffers, level);
+    __propagator.appendBuffers(buffers, level);
+    __update.appendBuffers(buffers, level);
+    __smoother.appendBuffers(buffers, level);
+
+    // placeholder input flow of FlowUpdate, released after configure()
+    appendPlaceholders(buffers, __plan, "FlowFilter", level);
+
+    // buffers fed back to next call of compute()
+    markPersistent(buffers, __smoother.getSmoothedFlow());
+    markPersistent(buffers, __update.getUpdatedImage());
+}
+
+
+std::vector<stageProfile_t> FlowFilter::getProfile(const int level) const {
+
+    std::vector<stageProfile_t> profile = {
+        {"ImageModel", level, __imageModel.elapsedTime(), __imageModel.memoryTraffic()},
+        {"FlowPropagator", level, __propagator.elapsedTime(), __propagator.memoryTraffic()},
+        {"FlowUpdate", level, __update.elapsedTime(), __update.memoryTraffic()},
+        {"FlowSmoother", level, __smoother.elapsedTime(), __smoother.memoryTraffic()}
+    };
+
+    return profile;
 }
 
+
 void FlowFilter::computeImageModel() {
 
     startTiming();
@@ -219,6 +379,9 @@ void FlowFilter::loadImage(flowfilter::image_t& image) {
 
     __inputImage.upload(image);
 
+    __clock.tick();
+    setTimeStep(1.0f);
+
     // if(__firstLoad) {
 
     //     std::cout << "FlowFilter::loadImage(): fisrt load" << std::endl;
@@ -235,6 +398,52 @@ void FlowFilter::loadImage(flowfilter::image_t& image) {
     // }
 }
 
+void FlowFilter::loadImage(GPUImage& image) {
+
+    __inputImage.copyFrom(image);
+
+    __clock.tick();
+    setTimeStep(1.0f);
+}
+
+
+void FlowFilter::loadImage(flowfilter::image_t& image, const double timestamp) {
+
+    if(__clock.tick(timestamp, image)) {
+        __inputImage.upload(image);
+        setTimeStep(__clock.timeStep());
+    }
+}
+
+
+void FlowFilter::loadImage(GPUImage& image, const double timestamp) {
+
+    if(__clock.tick(timestamp)) {
+        __inputImage.copyFrom(image);
+        setTimeStep(__clock.timeStep());
+    }
+}
+
+
+void FlowFilter::setFrameInterval(const double interval) {
+    __clock.setFrameInterval(interval);
+}
+
+
+double FlowFilter::getFrameInterval() const {
+    return __clock.getFrameInterval();
+}
+
+
+bool FlowFilter::getFrameSkipped() const {
+    return __clock.duplicate();
+}
+
+
+int FlowFilter::getSkippedFrames() const {
+    return __clock.duplicateCount();
+}
+
 void FlowFilter::downloadFlow(flowfilter::image_t& flow) {
     __smoother.getSmoothedFlow().download(flow);
 }
@@ -243,30 +452,140 @@ void FlowFilter::downloadImage(flowfilter::image_t& image) {
     __update.getUpdatedImage().download(image);
 }
 
-// void FlowFilter::downloadImageGradient(flowfilter::image_t& gradient) {
-//     __imageModel.getImageGradient().download(gradient);
-// }
 
-// void FlowFilter::downloadImageConstant(flowfilter::image_t& image) {
-//     __imageModel.getImageConstant().download(image);
-// }
+void FlowFilter::downloadTap(const filterTap_t tap, flowfilter::image_t& image) {
+    getTap(tap).download(image);
+}
+
+
+void FlowFilter::downloadImageGradient(flowfilter::image_t& gradient) {
+    downloadTap(TAP_IMAGE_GRADIENT, gradient);
+}
+
+
+void FlowFilter::downloadImageConstant(flowfilter::image_t& image) {
+    downloadTap(TAP_IMAGE_CONSTANT, image);
+}
+
 
-// void FlowFilter::downloadImageUpdated(flowfilter::image_t& image) {
-//     __update.getUpdatedImage().download(image);
-// }
+void FlowFilter::downloadFlowUpdated(flowfilter::image_t& flow) {
+    downloadTap(TAP_UPDATED_FLOW, flow);
+}
+
+
+void FlowFilter::downloadImageUpdated(flowfilter::image_t& image) {
+    downloadTap(TAP_IMAGE_UPDATED, image);
+}
 
-// void FlowFilter::downloadFlowUpdated(flowfilter::image_t& flow) {
-//     __update.getUpdatedFlow().download(flow);
-// }
 
-// void FlowFilter::downloadSmoothedFlow(flowfilter::image_t& flow) {
-//     __smoother.getSmoothedFlow().download(flow);
-// }
+void FlowFilter::downloadSmoothedFlow(flowfilter::image_t& flow) {
+    downloadTap(TAP_FLOW, flow);
+}
+
+int FlowFilter::processSequence(std::vector<flowfilter::image_t>& frames,
+    std::vector<flowfilter::image_t>& flows,
+    sequenceCallback_t callback, void* userData) {
+
+    return runSequence(*this, "FlowFilter", frames, flows, callback, userData);
+}
 
 GPUImage FlowFilter::getFlow() {
     return __update.getUpdatedFlow();
 }
 
+GPUImage FlowFilter::getImageConstant() {
+    return __imageModel.getImageConstant();
+}
+
+GPUImage FlowFilter::getImageGradient() {
+    return __imageModel.getImageGradient();
+}
+
+
+GPUImage FlowFilter::getTap(const filterTap_t tap) {
+
+    switch(tap) {
+        case TAP_IMAGE_CONSTANT:    return __imageModel.getImageConstant();
+        case TAP_IMAGE_GRADIENT:    return __imageModel.getImageGradient();
+        case TAP_IMAGE_UPDATED:     return __update.getUpdatedImage();
+        case TAP_PROPAGATED_FLOW:   return __propagator.getPropagatedFlow();
+        case TAP_UPDATED_FLOW:      return __update.getUpdatedFlow();
+        case TAP_FLOW:              return __smoother.getSmoothedFlow();
+        default:
+            tapNotAvailable("FlowFilter", tap);
+            return GPUImage();
+    }
+}
+
+
+void FlowFilter::setPublishFlow(const bool publish) {
+
+    __publishFlow = publish;
+
+    if(__publishFlow && __configured && !__snapshots.isAllocated()) {
+        __snapshots = FlowSnapshotBuffer(__inputImage.height(), __inputImage.width());
+    }
+}
+
+
+bool FlowFilter::getPublishFlow() const {
+    return __publishFlow;
+}
+
+
+FlowSnapshotBuffer FlowFilter::getSnapshotBuffer() {
+    return __snapshots;
+}
+
+
+void FlowFilter::setHistoryDepth(const int depth, const bool quantized) {
+
+    if(depth < 0) {
+        std::cerr << "ERROR: FlowFilter::setHistoryDepth(): depth should be greater or equal zero: " << depth << std::endl;
+        throw std::invalid_argument("FlowFilter::setHistoryDepth(): depth should be greater or equal zero, got: "
+            + std::to_string(depth));
+    }
+
+    if(!__configured) {
+        std::cerr << "ERROR: FlowFilter::setHistoryDepth(): filter not configured" << std::endl;
+        throw std::logic_error("FlowFilter::setHistoryDepth(): filter not configured");
+    }
+
+    __history = depth > 0? FlowHistory(__inputImage.height(), __inputImage.width(), depth, quantized) : FlowHistory();
+}
+
+
+int FlowFilter::getHistoryDepth() const {
+    return __history.depth();
+}
+
+
+FlowHistory FlowFilter::getHistory() {
+    return __history;
+}
+
+
+ParameterBuffer FlowFilter::getParameterBuffer() {
+    return __parameters;
+}
+
+
+void FlowFilter::applyParameters(const filterParameters_t& params) {
+
+    if(params.gammaMask & 1u) {
+        setGamma(params.gamma[0]);
+    }
+
+    if(params.smoothIterationsMask & 1u) {
+        setSmoothIterations(params.smoothIterations[0]);
+    }
+
+    // changes the propagation iterations, applied before propagating
+    if(params.maxflowSet) {
+        setMaxFlow(params.maxflow);
+    }
+}
+
 
 float FlowFilter::getGamma() const {
     return __update.getGamma();
@@ -292,7 +611,21 @@ float FlowFilter::getMaxFlow() const {
 
 void FlowFilter::setMaxFlow(const float maxflow) {
     __update.setMaxFlow(maxflow);
-    __propagator.setIterations(int(ceilf(maxflow)));
+    __propagator.setIterations(int(ceilf(maxflow*__propagator.getTimeStep())));
+}
+
+
+float FlowFilter::getTimeStep() const {
+    return __update.getTimeStep();
+}
+
+
+void FlowFilter::setTimeStep(const float timeStep) {
+    __update.setTimeStep(timeStep);
+    __propagator.setTimeStep(timeStep);
+
+    // keeps the propagation stable over the longer interval
+    __propagator.setIterations(int(ceilf(getMaxFlow()*timeStep)));
 }
 
 
@@ -306,6 +639,47 @@ void FlowFilter::setSmoothIterations(const int N) {
 }
 
 
+void FlowFilter::setSmoothMode(const smoothMode_t mode) {
+    __smoother.setMode(mode);
+}
+
+
+smoothMode_t FlowFilter::getSmoothMode() const {
+    return __smoother.getMode();
+}
+
+
+void FlowFilter::setSmoothSigmaSpace(const float sigma) {
+    __smoother.setSigmaSpace(sigma);
+}
+
+
+float FlowFilter::getSmoothSigmaSpace() const {
+    return __smoother.getSigmaSpace();
+}
+
+
+void FlowFilter::setSmoothSigmaRange(const float sigma) {
+
+    // scale sigma if input image is uint8
+    if(__inputImage.itemSize() == 1) {
+        __smoother.setSigmaRange(sigma * 255.0f);
+    } else {
+        __smoother.setSigmaRange(sigma);
+    }
+}
+
+
+float FlowFilter::getSmoothSigmaRange() const {
+
+    if(__inputImage.itemSize() == 1) {
+        return __smoother.getSigmaRange() / 255.0f;
+    } else {
+        return __smoother.getSigmaRange();
+    }
+}
+
+
 void FlowFilter::setPropagationBorder(const int border) {
     __propagator.setBorder(border);
 }
@@ -320,6 +694,27 @@ int FlowFilter::getPropagationIterations() const {
     return __propagator.getIterations();
 }
 
+
+void FlowFilter::setComputeResidual(const bool computeResidual) {
+    __update.setComputeResidual(computeResidual);
+}
+
+bool FlowFilter::getComputeResidual() const {
+    return __update.getComputeResidual();
+}
+
+void FlowFilter::setResidualRange(const float residualRange) {
+    __update.setResidualRange(residualRange);
+}
+
+float FlowFilter::getResidualRange() const {
+    return __update.getResidualRange();
+}
+
+residualStats_t FlowFilter::getResidualStats() {
+    return __update.getResidualStats();
+}
+
 int FlowFilter::height() const {
     return __height;
     
@@ -330,6 +725,16 @@ int FlowFilter::width() const {
 }
 
 
+const stagePlan_t& FlowFilter::getPlan() const {
+    return __plan;
+}
+
+
+std::vector<Stage*> FlowFilter::stages() {
+    return {&__imageModel, &__propagator, &__update, &__smoother};
+}
+
+
 
 //###############################################
 // DeltaFlowFilter
@@ -380,32 +785,89 @@ void DeltaFlowFilter::configure() {
         throw std::exception();
     }
 
-    int height = __inputImage.height();
-    int width = __inputImage.width();
-
-    __imageModel = ImageModel(__inputImage);
-
-    // dummy inputs to create delta flow update
-    GPUImage dummyDeltaFlow(height, width, 2, sizeof(float));
-    GPUImage dummyImageOld(height, width, 1, sizeof(float));
-
-    // create delta flow update stage
-    __update = DeltaFlowUpdate(__inputFlow, dummyDeltaFlow,
-        dummyImageOld, __imageModel.getImageConstant(),
-        __imageModel.getImageGradient());
-
-    // flow smoother
-    __smoother = FlowSmoother(__update.getUpdatedFlow(), 1);
-
-    // propagator with payload
-    __propagator = FlowPropagatorPayload(__smoother.getSmoothedFlow(),
-        __update.getUpdatedImage(), __update.getUpdatedDeltaFlow());
-
-
-    // replace dummy inputs with propagated outputs
-    __update.setInputDeltaFlow(__propagator.getPropagatedVector());
-    __update.setInputImageOld(__propagator.getPropagatedScalar());
-
+    const int height = __inputImage.height();
+    const int width = __inputImage.width();
+
+    const portType_t imageType = {height, width, 1, int(sizeof(float))};
+    const portType_t flowType = {height, width, 2, int(sizeof(float))};
+
+    // fresh stages, wired and configured by the graph
+    __imageModel = ImageModel();
+    __propagator = FlowPropagatorPayload();
+    __update = DeltaFlowUpdate();
+    __smoother = FlowSmoother();
+
+    __propagator.setIterations(1);
+    __smoother.setIterations(1);
+
+    StageGraph graph;
+    graph.addNode("ImageModel", &__imageModel);
+    graph.addNode("FlowPropagatorPayload", &__propagator);
+    graph.addNode("DeltaFlowUpdate", &__update);
+    graph.addNode("FlowSmoother", &__smoother);
+
+    graph.addInput("ImageModel", "inputImage", {height, width, 1, __inputImage.itemSize()},
+        [this](GPUImage img) { __imageModel.setInputImage(img); });
+    graph.addOutput("ImageModel", "imageConstant", imageType,
+        [this]() { return __imageModel.getImageConstant(); });
+    graph.addOutput("ImageModel", "imageGradient", flowType,
+        [this]() { return __imageModel.getImageGradient(); });
+
+    graph.addInput("FlowPropagatorPayload", "inputFlow", flowType,
+        [this](GPUImage img) { __propagator.setInputFlow(img); });
+    graph.addInput("FlowPropagatorPayload", "scalarPayload", imageType,
+        [this](GPUImage img) { __propagator.setScalarPayload(img); });
+    graph.addInput("FlowPropagatorPayload", "vectorPayload", flowType,
+        [this](GPUImage img) { __propagator.setVectorPayload(img); });
+    graph.addOutput("FlowPropagatorPayload", "propagatedScalar", imageType,
+        [this]() { return __propagator.getPropagatedScalar(); });
+    graph.addOutput("FlowPropagatorPayload", "propagatedVector", flowType,
+        [this]() { return __propagator.getPropagatedVector(); });
+
+    // the update reads the propagated payloads directly, which breaks
+    // the cycle between propagation and update blocks
+    graph.addInput("DeltaFlowUpdate", "inputFlow", flowType,
+        [this](GPUImage img) { __update.setInputFlow(img); });
+    graph.addInput("DeltaFlowUpdate", "inputDeltaFlow", flowType,
+        [this](GPUImage img) { __update.setInputDeltaFlow(img); }, true);
+    graph.addInput("DeltaFlowUpdate", "inputImageOld", imageType,
+        [this](GPUImage img) { __update.setInputImageOld(img); }, true);
+    graph.addInput("DeltaFlowUpdate", "inputImage", imageType,
+        [this](GPUImage img) { __update.setInputImage(img); });
+    graph.addInput("DeltaFlowUpdate", "inputImageGradient", flowType,
+        [this](GPUImage img) { __update.setInputImageGradient(img); });
+    graph.addOutput("DeltaFlowUpdate", "updatedFlow", flowType,
+        [this]() { return __update.getUpdatedFlow(); });
+    graph.addOutput("DeltaFlowUpdate", "updatedDeltaFlow", flowType,
+        [this]() { return __update.getUpdatedDeltaFlow(); });
+    graph.addOutput("DeltaFlowUpdate", "updatedImage", imageType,
+        [this]() { return __update.getUpdatedImage(); });
+
+    graph.addInput("FlowSmoother", "inputFlow", flowType,
+        [this](GPUImage img) { __smoother.setInputFlow(img); });
+    graph.addInput("FlowSmoother", "guideImage", imageType,
+        [this](GPUImage img) { __smoother.setGuideImage(img); });
+    graph.addOutput("FlowSmoother", "smoothedFlow", flowType,
+        [this]() { return __smoother.getSmoothedFlow(); });
+
+    graph.feed(__inputImage, "ImageModel.inputImage");
+    graph.feed(__inputFlow, "DeltaFlowUpdate.inputFlow");
+    graph.connect("ImageModel.imageConstant", "DeltaFlowUpdate.inputImage");
+    graph.connect("ImageModel.imageGradient", "DeltaFlowUpdate.inputImageGradient");
+    graph.connect("ImageModel.imageConstant", "FlowSmoother.guideImage");
+    graph.connect("FlowPropagatorPayload.propagatedVector", "DeltaFlowUpdate.inputDeltaFlow");
+    graph.connect("FlowPropagatorPayload.propagatedScalar", "DeltaFlowUpdate.inputImageOld");
+    graph.connect("DeltaFlowUpdate.updatedFlow", "FlowSmoother.inputFlow");
+
+    // smoothed flow, old image and delta flow are propagated
+    // in next call to compute()
+    graph.connectLoop("FlowSmoother.smoothedFlow", "FlowPropagatorPayload.inputFlow");
+    graph.connectLoop("DeltaFlowUpdate.updatedImage", "FlowPropagatorPayload.scalarPayload");
+    graph.connectLoop("DeltaFlowUpdate.updatedDeltaFlow", "FlowPropagatorPayload.vectorPayload");
+
+    graph.require("FlowSmoother.smoothedFlow");
+
+    __plan = graph.configure();
 
     // clear buffers
     __imageModel.getImageConstant().clear();
@@ -430,33 +892,72 @@ void DeltaFlowFilter::compute() {
 
     startTiming();
 
-    // compute image model
-    __imageModel.compute();
+    const std::vector<Stage*> stages = this->stages();
+    for(const int n : __plan.order) {
 
-    if(__firstLoad) {
-        std::cout << "DeltaFlowFilter::compute(): fisrt load" << std::endl;
+        stages[n]->compute();
 
-        // set the old image value to current
-        // computed constant brightness parameter
-        GPUImage imConstant = __imageModel.getImageConstant();
-        __update.getUpdatedImage().copyFrom(imConstant);
-        
-        __firstLoad = false;
-    }
+        if(n == NODE_IMAGEMODEL && __firstLoad) {
+            std::cout << "DeltaFlowFilter::compute(): fisrt load" << std::endl;
 
-    // propagate old flow
-    __propagator.compute();
+            // set the old image value to current
+            // computed constant brightness parameter
+            GPUImage imConstant = __imageModel.getImageConstant();
+            __update.getUpdatedImage().copyFrom(imConstant);
 
-    // update
-    __update.compute();
-    
-    // smooth updated flow
-    __smoother.compute();
+            __firstLoad = false;
+        }
+    }
 
     stopTiming();
 }
 
 
+memoryTraffic_t DeltaFlowFilter::memoryTraffic() const {
+
+    memoryTraffic_t traffic = __imageModel.memoryTraffic();
+    traffic += __propagator.memoryTraffic();
+    traffic += __update.memoryTraffic();
+    traffic += __smoother.memoryTraffic();
+
+    return traffic;
+}
+
+
+void DeltaFlowFilter::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("DeltaFlowFilter", level, "inputImage", __inputImage));
+
+    __imageModel.appendBuffers(buffers, level);
+    __propagator.appendBuffers(buffers, level);
+    __update.appendBuffers(buffers, level);
+    __smoother.appendBuffers(buffers, level);
+
+    // placeholder inputs of DeltaFlowUpdate, released after configure()
+    appendPlaceholders(buffers, __plan, "DeltaFlowFilter", level);
+
+    // buffers fed back to next call of compute() through the payload propagator
+    markPersistent(buffers, __smoother.getSmoothedFlow());
+    markPersistent(buffers, __update.getUpdatedImage());
+    markPersistent(buffers, __update.getUpdatedDeltaFlow());
+}
+
+
+std::vector<stageProfile_t> DeltaFlowFilter::getProfile(const int level) const {
+
+    std::vector<stageProfile_t> profile = {
+        {"ImageModel", level, __imageModel.elapsedTime(), __imageModel.memoryTraffic()},
+        {"FlowPropagatorPayload", level, __propagator.elapsedTime(), __propagator.memoryTraffic()},
+        {"DeltaFlowUpdate", level, __update.elapsedTime(), __update.memoryTraffic()},
+        {"FlowSmoother", level, __smoother.elapsedTime(), __smoother.memoryTraffic()}
+    };
+
+    return profile;
+}
+
+
 void DeltaFlowFilter::computeImageModel() {
 
     startTiming();
@@ -550,9 +1051,38 @@ GPUImage DeltaFlowFilter::getImage() {
     return __update.getUpdatedImage();
 }
 
+GPUImage DeltaFlowFilter::getDeltaFlow() {
+    return __update.getUpdatedDeltaFlow();
+}
 
-float DeltaFlowFilter::getGamma() const {
-    return __update.getGamma();
+GPUImage DeltaFlowFilter::getImageConstant() {
+    return __imageModel.getImageConstant();
+}
+
+GPUImage DeltaFlowFilter::getImageGradient() {
+    return __imageModel.getImageGradient();
+}
+
+
+GPUImage DeltaFlowFilter::getTap(const filterTap_t tap) {
+
+    switch(tap) {
+        case TAP_IMAGE_CONSTANT:    return __imageModel.getImageConstant();
+        case TAP_IMAGE_GRADIENT:    return __imageModel.getImageGradient();
+        case TAP_IMAGE_UPDATED:     return __update.getUpdatedImage();
+        case TAP_PROPAGATED_FLOW:   return __propagator.getPropagatedFlow();
+        case TAP_UPDATED_FLOW:      return __update.getUpdatedFlow();
+        case TAP_DELTA_FLOW:        return __update.getUpdatedDeltaFlow();
+        case TAP_FLOW:              return __smoother.getSmoothedFlow();
+        default:
+            tapNotAvailable("DeltaFlowFilter", tap);
+            return GPUImage();
+    }
+}
+
+
+float DeltaFlowFilter::getGamma() const {
+    return __update.getGamma();
 }
 
 
@@ -575,7 +1105,21 @@ float DeltaFlowFilter::getMaxFlow() const {
 
 void DeltaFlowFilter::setMaxFlow(const float maxflow) {
     __update.setMaxFlow(maxflow);
-    __propagator.setIterations(int(ceilf(maxflow)));
+    __propagator.setIterations(int(ceilf(maxflow*__propagator.getTimeStep())));
+}
+
+
+float DeltaFlowFilter::getTimeStep() const {
+    return __update.getTimeStep();
+}
+
+
+void DeltaFlowFilter::setTimeStep(const float timeStep) {
+    __update.setTimeStep(timeStep);
+    __propagator.setTimeStep(timeStep);
+
+    // keeps the propagation stable over the longer interval
+    __propagator.setIterations(int(ceilf(getMaxFlow()*timeStep)));
 }
 
 
@@ -589,6 +1133,47 @@ void DeltaFlowFilter::setSmoothIterations(const int N) {
 }
 
 
+void DeltaFlowFilter::setSmoothMode(const smoothMode_t mode) {
+    __smoother.setMode(mode);
+}
+
+
+smoothMode_t DeltaFlowFilter::getSmoothMode() const {
+    return __smoother.getMode();
+}
+
+
+void DeltaFlowFilter::setSmoothSigmaSpace(const float sigma) {
+    __smoother.setSigmaSpace(sigma);
+}
+
+
+float DeltaFlowFilter::getSmoothSigmaSpace() const {
+    return __smoother.getSigmaSpace();
+}
+
+
+void DeltaFlowFilter::setSmoothSigmaRange(const float sigma) {
+
+    // scale sigma if input image is uint8
+    if(__inputImage.itemSize() == 1) {
+        __smoother.setSigmaRange(sigma * 255.0f);
+    } else {
+        __smoother.setSigmaRange(sigma);
+    }
+}
+
+
+float DeltaFlowFilter::getSmoothSigmaRange() const {
+
+    if(__inputImage.itemSize() == 1) {
+        return __smoother.getSigmaRange() / 255.0f;
+    } else {
+        return __smoother.getSigmaRange();
+    }
+}
+
+
 void DeltaFlowFilter::setPropagationBorder(const int border) {
     __propagator.setBorder(border);
 }
@@ -604,6 +1189,27 @@ int DeltaFlowFilter::getPropagationIterations() const {
 }
 
 
+void DeltaFlowFilter::setComputeResidual(const bool computeResidual) {
+    __update.setComputeResidual(computeResidual);
+}
+
+bool DeltaFlowFilter::getComputeResidual() const {
+    return __update.getComputeResidual();
+}
+
+void DeltaFlowFilter::setResidualRange(const float residualRange) {
+    __update.setResidualRange(residualRange);
+}
+
+float DeltaFlowFilter::getResidualRange() const {
+    return __update.getResidualRange();
+}
+
+residualStats_t DeltaFlowFilter::getResidualStats() {
+    return __update.getResidualStats();
+}
+
+
 int DeltaFlowFilter::height() const {
     return __inputImage.height();
     
@@ -615,6 +1221,16 @@ int DeltaFlowFilter::width() const {
 }
 
 
+const stagePlan_t& DeltaFlowFilter::getPlan() const {
+    return __plan;
+}
+
+
+std::vector<Stage*> DeltaFlowFilter::stages() {
+    return {&__imageModel, &__propagator, &__update, &__smoother};
+}
+
+
 //###############################################
 // PyramidalFlowFilter
 //###############################################
@@ -625,6 +1241,12 @@ PyramidalFlowFilter::PyramidalFlowFilter() :
     __width = 0;
     __levels = 0;
     __configured = false;
+    __publishFlow = false;
+    __derotate = false;
+    __cameraSet = false;
+    __angularVelocity = make_float3(0.0f, 0.0f, 0.0f);
+    __seeding = false;
+    __outputLevel = 0;
 }
 
 
@@ -636,6 +1258,13 @@ PyramidalFlowFilter::PyramidalFlowFilter(const int height, const int width, cons
     __width = width;
     __levels = levels;
     __configured = false;
+    __publishFlow = false;
+    __derotate = false;
+    __cameraSet = false;
+    __angularVelocity = make_float3(0.0f, 0.0f, 0.0f);
+    __seeding = false;
+    __outputLevel = 0;
+    __parameters = ParameterBuffer(levels);
 
     configure();
 }
@@ -672,24 +1301,47 @@ void PyramidalFlowFilter::configure() {
         }
     }
 
+    // seeds the top level propagated flow, before its update
+    __seeder = BlockMatchingSeeder(__imagePyramid.getImage(__levels -1),
+        __topLevelFilter.getTap(TAP_PROPAGATED_FLOW));
+
     // clear buffers
     __inputImage.clear();
     for(int h = 0; h < __levels; h ++) {
         __imagePyramid.getImage(h).clear();
     }
 
+    if(__publishFlow) {
+        __snapshots = FlowSnapshotBuffer(__height, __width);
+    }
+
     __configured = true;
 }
 
 
 void PyramidalFlowFilter::compute() {
 
+    // parameters submitted from a control thread
+    filterParameters_t params;
+    if(__parameters.consume(params)) {
+        applyParameters(params);
+    }
+
+    // duplicate frame, the current flow stays valid
+    if(__clock.duplicate()) {
+        return;
+    }
+
     startTiming();
 
     // compute image pyramid
     __imagePyramid.compute();
 
-    if(__levels == 1) {
+    if(__derotate) {
+        derotate();
+    }
+
+    if(__levels == 1 && !__seeding) {
         __topLevelFilter.compute();
 
     } else {
@@ -699,7 +1351,11 @@ void PyramidalFlowFilter::compute() {
         __topLevelFilter.computeImageModel();
         __topLevelFilter.computePropagation();
 
-        for(int h =0; h < __levels - 1; h ++) {
+        if(__seeding) {
+            __seeder.compute();
+        }
+
+        for(int h = __outputLevel; h < __levels - 1; h ++) {
             __lowLevelFilters[h].computeImageModel();
             __lowLevelFilters[h].computePropagation();
         }
@@ -707,20 +1363,466 @@ void PyramidalFlowFilter::compute() {
         // update
         __topLevelFilter.computeUpdate();
 
-        for(int h =0; h < __levels - 1; h ++) {
+        for(int h = __outputLevel; h < __levels - 1; h ++) {
             __lowLevelFilters[h].computeUpdate();
         }
     }
 
+    // output level flow at the input resolution
+    if(__outputLevel > 0) {
+        __upsampler.compute();
+    }
+
+    // restore the rotational component of the output flow
+    if(__derotate) {
+        __rotationAdder.compute();
+    }
+
     stopTiming();
+
+    if(__publishFlow) {
+        GPUImage flow = getFlow();
+        __snapshots.publish(flow);
+    }
+
+    if(__history.isAllocated()) {
+        GPUImage flow = getFlow();
+        __history.record(flow);
+    }
 }
 
+memoryTraffic_t PyramidalFlowFilter::memoryTraffic() const {
+
+    memoryTraffic_t traffic = __imagePyramid.memoryTraffic();
+    traffic += __topLevelFilter.memoryTraffic();
+
+    for(int h = __outputLevel; h < __levels - 1; h ++) {
+        traffic += __lowLevelFilters[h].memoryTraffic();
+    }
+
+    if(__outputLevel > 0) {
+        traffic += __upsampler.memoryTraffic();
+    }
+
+    if(__derotate) {
+
+        for(int h = __outputLevel; h < __levels; h ++) {
+
+            // the predicted image is copied back to the level filter
+            std::size_t pixels = (std::size_t(__height) >> h) * (std::size_t(__width) >> h);
+
+            traffic += __derotators[h].memoryTraffic();
+            traffic.bytesRead += pixels * sizeof(float);
+            traffic.bytesWritten += pixels * sizeof(float);
+        }
+
+        traffic += __rotationAdder.memoryTraffic();
+    }
+
+    if(__seeding) {
+        traffic += __seeder.memoryTraffic();
+    }
+
+    return traffic;
+}
+
+
+void PyramidalFlowFilter::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("PyramidalFlowFilter", level, "inputImage", __inputImage));
+
+    __imagePyramid.appendBuffers(buffers, level);
+    __topLevelFilter.appendBuffers(buffers, level + __levels - 1);
+
+    for(int h = __levels - 2; h >= 0; h --) {
+        __lowLevelFilters[h].appendBuffers(buffers, level + h);
+    }
+
+    if(__cameraSet) {
+        for(int h = 0; h < __levels; h ++) {
+            __derotators[h].appendBuffers(buffers, level + h);
+        }
+
+        __rotationAdder.appendBuffers(buffers, level);
+    }
+
+    __seeder.appendBuffers(buffers, level + __levels - 1);
+    __upsampler.appendBuffers(buffers, level);
+}
+
+
+std::vector<stageProfile_t> PyramidalFlowFilter::getProfile() const {
+
+    std::vector<stageProfile_t> profile = {
+        {"ImagePyramid", 0, __imagePyramid.elapsedTime(), __imagePyramid.memoryTraffic()}
+    };
+
+    std::vector<stageProfile_t> levelProfile = __topLevelFilter.getProfile(__levels - 1);
+    profile.insert(profile.end(), levelProfile.begin(), levelProfile.end());
+
+    for(int h = __levels - 2; h >= __outputLevel; h --) {
+        levelProfile = __lowLevelFilters[h].getProfile(h);
+        profile.insert(profile.end(), levelProfile.begin(), levelProfile.end());
+    }
+
+    if(__outputLevel > 0) {
+        profile.push_back({"JointBilateralUpsampler", 0,
+            __upsampler.elapsedTime(), __upsampler.memoryTraffic()});
+    }
+
+    if(__derotate) {
+        for(int h = __outputLevel; h < __levels; h ++) {
+            profile.push_back({"RotationalFlowImagePredictor", h,
+                __derotators[h].elapsedTime(), __derotators[h].memoryTraffic()});
+        }
+
+        profile.push_back({"RotationalFlowAdder", 0,
+            __rotationAdder.elapsedTime(), __rotationAdder.memoryTraffic()});
+    }
+
+    if(__seeding) {
+        profile.push_back({"BlockMatchingSeeder", __levels - 1,
+            __seeder.elapsedTime(), __seeder.memoryTraffic()});
+    }
+
+    return profile;
+}
+
+
 GPUImage PyramidalFlowFilter::getFlow() {
 
-    if(__levels == 1) {
+    if(__derotate) {
+        return __rotationAdder.getFlow();
+    }
+
+    return baseFlow();
+}
+
+
+GPUImage PyramidalFlowFilter::getFlow(const int level) {
+
+    checkLevel("getFlow", level);
+
+    if(level == __levels - 1) {
         return __topLevelFilter.getFlow();
     } else {
-        return __lowLevelFilters[0].getFlow();
+        return __lowLevelFilters[level].getFlow();
+    }
+}
+
+
+GPUImage PyramidalFlowFilter::getDeltaFlow(const int level) {
+
+    checkLevel("getDeltaFlow", level);
+
+    if(level == __levels - 1) {
+        std::cerr << "ERROR: PyramidalFlowFilter::getDeltaFlow(): the top level has no delta flow: " << level << std::endl;
+        throw std::invalid_argument("PyramidalFlowFilter::getDeltaFlow(): the top level has no delta flow: " + std::to_string(level));
+    }
+
+    return __lowLevelFilters[level].getDeltaFlow();
+}
+
+
+GPUImage PyramidalFlowFilter::getImageConstant(const int level) {
+
+    checkLevel("getImageConstant", level);
+
+    if(level == __levels - 1) {
+        return __topLevelFilter.getImageConstant();
+    } else {
+        return __lowLevelFilters[level].getImageConstant();
+    }
+}
+
+
+GPUImage PyramidalFlowFilter::getImageGradient(const int level) {
+
+    checkLevel("getImageGradient", level);
+
+    if(level == __levels - 1) {
+        return __topLevelFilter.getImageGradient();
+    } else {
+        return __lowLevelFilters[level].getImageGradient();
+    }
+}
+
+
+GPUImage PyramidalFlowFilter::getTap(const filterTap_t tap, const int level) {
+
+    checkLevel("getTap", level);
+
+    if(level == __levels - 1) {
+        return __topLevelFilter.getTap(tap);
+    } else {
+        return __lowLevelFilters[level].getTap(tap);
+    }
+}
+
+
+void PyramidalFlowFilter::downloadTap(const filterTap_t tap, const int level, image_t& image) {
+    getTap(tap, level).download(image);
+}
+
+
+void PyramidalFlowFilter::checkLevel(const std::string& method, const int level) const {
+
+    if(level < 0 || level >= __levels) {
+        std::cerr << "ERROR: PyramidalFlowFilter::" << method << "(): level index out of bounds: " << level << std::endl;
+        throw std::invalid_argument("PyramidalFlowFilter::" + method + "(): level index out of bounds: " + std::to_string(level));
+    }
+}
+
+
+void PyramidalFlowFilter::setPublishFlow(const bool publish) {
+
+    __publishFlow = publish;
+
+    if(__publishFlow && __configured && !__snapshots.isAllocated()) {
+        __snapshots = FlowSnapshotBuffer(__height, __width);
+    }
+}
+
+
+bool PyramidalFlowFilter::getPublishFlow() const {
+    return __publishFlow;
+}
+
+
+FlowSnapshotBuffer PyramidalFlowFilter::getSnapshotBuffer() {
+    return __snapshots;
+}
+
+
+void PyramidalFlowFilter::setHistoryDepth(const int depth, const bool quantized) {
+
+    if(depth < 0) {
+        std::cerr << "ERROR: PyramidalFlowFilter::setHistoryDepth(): depth should be greater or equal zero: " << depth << std::endl;
+        throw std::invalid_argument("PyramidalFlowFilter::setHistoryDepth(): depth should be greater or equal zero, got: "
+            + std::to_string(depth));
+    }
+
+    if(!__configured) {
+        std::cerr << "ERROR: PyramidalFlowFilter::setHistoryDepth(): filter not configured" << std::endl;
+        throw std::logic_error("PyramidalFlowFilter::setHistoryDepth(): filter not configured");
+    }
+
+    __history = depth > 0? FlowHistory(__height, __width, depth, quantized) : FlowHistory();
+}
+
+
+int PyramidalFlowFilter::getHistoryDepth() const {
+    return __history.depth();
+}
+
+
+FlowHistory PyramidalFlowFilter::getHistory() {
+    return __history;
+}
+
+
+void PyramidalFlowFilter::setCamera(const perspectiveCamera& cam) {
+
+    if(!__configured) {
+        std::cerr << "ERROR: PyramidalFlowFilter::setCamera(): filter not configured" << std::endl;
+        throw std::logic_error("PyramidalFlowFilter::setCamera(): filter not configured");
+    }
+
+    __camera = cam;
+
+    // predictors warp the image each level keeps for the next frame in place
+    __derotators.resize(__levels);
+    for(int h = 0; h < __levels; h ++) {
+        __derotators[h] = RotationalFlowImagePredictor(pyramidLevelCamera(cam, h),
+            getTap(TAP_IMAGE_UPDATED, h));
+    }
+
+    __rotationAdder = RotationalFlowAdder(cam, baseFlow());
+    __rotationAdder.getFlow().clear();
+
+    __seeder.setCamera(pyramidLevelCamera(cam, __levels - 1));
+
+    __cameraSet = true;
+}
+
+
+void PyramidalFlowFilter::setDerotate(const bool derotate) {
+
+    if(derotate && !__cameraSet) {
+        std::cerr << "ERROR: PyramidalFlowFilter::setDerotate(): camera not set" << std::endl;
+        throw std::logic_error("PyramidalFlowFilter::setDerotate(): camera not set");
+    }
+
+    __derotate = derotate;
+
+    // seeds are compared with the residual flow only while derotating
+    if(!__derotate) {
+        __seeder.setAngularVelocity(0.0f, 0.0f, 0.0f);
+    }
+}
+
+
+bool PyramidalFlowFilter::getDerotate() const {
+    return __derotate;
+}
+
+
+void PyramidalFlowFilter::setAngularVelocity(const float wx, const float wy, const float wz) {
+
+    __angularVelocity.x = wx;
+    __angularVelocity.y = wy;
+    __angularVelocity.z = wz;
+}
+
+
+void PyramidalFlowFilter::derotate() {
+
+    // rotation over the interval since the previous frame
+    const float timeStep = getTimeStep();
+    const float3 w = make_float3(timeStep*__angularVelocity.x,
+        timeStep*__angularVelocity.y, timeStep*__angularVelocity.z);
+
+    for(int h = __outputLevel; h < __levels; h ++) {
+
+        GPUImage image = getTap(TAP_IMAGE_UPDATED, h);
+        perspectiveCamera cam = pyramidLevelCamera(__camera, h);
+
+        // enough iterations for a stable propagation
+        const float maxflow = maxRotationalFlow(cam, w, image.height(), image.width());
+
+        __derotators[h].setAngularVelocity(w.x, w.y, w.z);
+        __derotators[h].setIterations(std::max(1, int(ceilf(maxflow))));
+        __derotators[h].compute();
+
+        GPUImage predicted = __derotators[h].getPredictedImage();
+        image.copyFrom(predicted);
+    }
+
+    // level flows are per frame interval
+    __rotationAdder.setAngularVelocity(__angularVelocity.x,
+        __angularVelocity.y, __angularVelocity.z);
+    __seeder.setAngularVelocity(w.x, w.y, w.z);
+}
+
+
+void PyramidalFlowFilter::setSeeding(const bool seeding) {
+
+    // the previous top level image may be stale
+    if(seeding && !__seeding) {
+        __seeder.reset();
+    }
+
+    __seeding = seeding;
+}
+
+
+bool PyramidalFlowFilter::getSeeding() const {
+    return __seeding;
+}
+
+
+void PyramidalFlowFilter::setSeedThreshold(const float threshold) {
+    __seeder.setThreshold(std::ldexp(threshold, -(__levels - 1)));
+}
+
+
+float PyramidalFlowFilter::getSeedThreshold() const {
+    return std::ldexp(__seeder.getThreshold(), __levels - 1);
+}
+
+
+void PyramidalFlowFilter::setOutputLevel(const int level) {
+
+    checkLevel("setOutputLevel", level);
+
+    if(level > 0) {
+
+        // keep the upsampling parameters set so far
+        JointBilateralUpsampler upsampler(getFlow(level),
+            __imagePyramid.getImage(level), __imagePyramid.getImage(0));
+
+        upsampler.setSigmaSpace(__upsampler.getSigmaSpace());
+        upsampler.setSigmaRange(__upsampler.getSigmaRange());
+        upsampler.getUpsampledFlow().clear();
+
+        __upsampler = upsampler;
+    }
+
+    __outputLevel = level;
+
+    // the rotational flow is added to the new output flow
+    if(__cameraSet) {
+        __rotationAdder.setInputFlow(baseFlow());
+        __rotationAdder.configure();
+        __rotationAdder.getFlow().clear();
+    }
+}
+
+
+int PyramidalFlowFilter::getOutputLevel() const {
+    return __outputLevel;
+}
+
+
+void PyramidalFlowFilter::setUpsamplingSigmaSpace(const float sigma) {
+    __upsampler.setSigmaSpace(sigma);
+}
+
+
+float PyramidalFlowFilter::getUpsamplingSigmaSpace() const {
+    return __upsampler.getSigmaSpace();
+}
+
+
+void PyramidalFlowFilter::setUpsamplingSigmaRange(const float sigma) {
+    __upsampler.setSigmaRange(sigma);
+}
+
+
+float PyramidalFlowFilter::getUpsamplingSigmaRange() const {
+    return __upsampler.getSigmaRange();
+}
+
+
+GPUImage PyramidalFlowFilter::baseFlow() {
+
+    if(__outputLevel > 0) {
+        return __upsampler.getUpsampledFlow();
+    }
+
+    // the top level updated flow feeds the level below, when
+    // it is the only level, the output is its smoothed flow
+    if(__levels == 1) {
+        return __topLevelFilter.getTap(TAP_FLOW);
+    }
+
+    return getFlow(0);
+}
+
+
+ParameterBuffer PyramidalFlowFilter::getParameterBuffer() {
+    return __parameters;
+}
+
+
+void PyramidalFlowFilter::applyParameters(const filterParameters_t& params) {
+
+    for(int h = 0; h < __levels; h ++) {
+
+        if(params.gammaMask & (1u << h)) {
+            setGamma(h, params.gamma[h]);
+        }
+
+        if(params.smoothIterationsMask & (1u << h)) {
+            setSmoothIterations(h, params.smoothIterations[h]);
+        }
+    }
+
+    // changes the propagation iterations of each level
+    if(params.maxflowSet) {
+        setMaxFlow(params.maxflow);
     }
 }
 
@@ -728,19 +1830,65 @@ GPUImage PyramidalFlowFilter::getFlow() {
 void PyramidalFlowFilter::loadImage(image_t& image) {
 
     __inputImage.upload(image);
+
+    __clock.tick();
+    setTimeStep(1.0f);
 }
 
 
-void PyramidalFlowFilter::downloadFlow(image_t& flow) {
+void PyramidalFlowFilter::loadImage(GPUImage& image) {
 
-    if(__levels == 1) {
-        __topLevelFilter.downloadFlow(flow);
-    } else {
-        __lowLevelFilters[0].getFlow().download(flow);
+    __inputImage.copyFrom(image);
+
+    __clock.tick();
+    setTimeStep(1.0f);
+}
+
+
+void PyramidalFlowFilter::loadImage(image_t& image, const double timestamp) {
+
+    if(__clock.tick(timestamp, image)) {
+        __inputImage.upload(image);
+        setTimeStep(__clock.timeStep());
+    }
+}
+
+
+void PyramidalFlowFilter::loadImage(GPUImage& image, const double timestamp) {
+
+    if(__clock.tick(timestamp)) {
+        __inputImage.copyFrom(image);
+        setTimeStep(__clock.timeStep());
     }
 }
 
 
+void PyramidalFlowFilter::setFrameInterval(const double interval) {
+    __clock.setFrameInterval(interval);
+}
+
+
+double PyramidalFlowFilter::getFrameInterval() const {
+    return __clock.getFrameInterval();
+}
+
+
+bool PyramidalFlowFilter::getFrameSkipped() const {
+    return __clock.duplicate();
+}
+
+
+int PyramidalFlowFilter::getSkippedFrames() const {
+    return __clock.duplicateCount();
+}
+
+
+void PyramidalFlowFilter::downloadFlow(image_t& flow) {
+
+    getFlow().download(flow);
+}
+
+
 void PyramidalFlowFilter::downloadImage(image_t& image) {
 
     if(__levels == 1) {
@@ -751,6 +1899,14 @@ void PyramidalFlowFilter::downloadImage(image_t& image) {
 }
 
 
+int PyramidalFlowFilter::processSequence(std::vector<image_t>& frames,
+    std::vector<image_t>& flows,
+    sequenceCallback_t callback, void* userData) {
+
+    return runSequence(*this, "PyramidalFlowFilter", frames, flows, callback, userData);
+}
+
+
 float PyramidalFlowFilter::getGamma(const int level) const {
     
     if(level < 0 || level >= __levels) {
@@ -836,6 +1992,51 @@ void PyramidalFlowFilter::setSmoothIterations(const std::vector<int>& iterations
 }
 
 
+void PyramidalFlowFilter::setSmoothMode(const smoothMode_t mode) {
+
+    __topLevelFilter.setSmoothMode(mode);
+
+    for(int h = 0; h < __levels - 1; h ++) {
+        __lowLevelFilters[h].setSmoothMode(mode);
+    }
+}
+
+
+smoothMode_t PyramidalFlowFilter::getSmoothMode() const {
+    return __topLevelFilter.getSmoothMode();
+}
+
+
+void PyramidalFlowFilter::setSmoothSigmaSpace(const float sigma) {
+
+    __topLevelFilter.setSmoothSigmaSpace(sigma);
+
+    for(int h = 0; h < __levels - 1; h ++) {
+        __lowLevelFilters[h].setSmoothSigmaSpace(sigma);
+    }
+}
+
+
+float PyramidalFlowFilter::getSmoothSigmaSpace() const {
+    return __topLevelFilter.getSmoothSigmaSpace();
+}
+
+
+void PyramidalFlowFilter::setSmoothSigmaRange(const float sigma) {
+
+    __topLevelFilter.setSmoothSigmaRange(sigma);
+
+    for(int h = 0; h < __levels - 1; h ++) {
+        __lowLevelFilters[h].setSmoothSigmaRange(sigma);
+    }
+}
+
+
+float PyramidalFlowFilter::getSmoothSigmaRange() const {
+    return __topLevelFilter.getSmoothSigmaRange();
+}
+
+
 float PyramidalFlowFilter::getMaxFlow() const {
 
     if(__levels == 1) {
@@ -866,6 +2067,23 @@ void PyramidalFlowFilter::setMaxFlow(const float maxflow) {
 }
 
 
+float PyramidalFlowFilter::getTimeStep() const {
+    return __topLevelFilter.getTimeStep();
+}
+
+
+void PyramidalFlowFilter::setTimeStep(const float timeStep) {
+
+    __topLevelFilter.setTimeStep(timeStep);
+
+    for(int h = 0; h < __levels - 1; h ++) {
+        __lowLevelFilters[h].setTimeStep(timeStep);
+    }
+
+    __seeder.setTimeStep(timeStep);
+}
+
+
 void PyramidalFlowFilter::setPropagationBorder(const int border) {
     __topLevelFilter.setPropagationBorder(border);
 
@@ -881,6 +2099,51 @@ int PyramidalFlowFilter::getPropagationBorder() const {
     return __topLevelFilter.getPropagationBorder();
 }
 
+void PyramidalFlowFilter::setComputeResidual(const bool computeResidual) {
+
+    __topLevelFilter.setComputeResidual(computeResidual);
+
+    for(int h = 0; h < __levels - 1; h ++) {
+        __lowLevelFilters[h].setComputeResidual(computeResidual);
+    }
+}
+
+
+bool PyramidalFlowFilter::getComputeResidual() const {
+    return __topLevelFilter.getComputeResidual();
+}
+
+
+void PyramidalFlowFilter::setResidualRange(const float residualRange) {
+
+    __topLevelFilter.setResidualRange(residualRange);
+
+    for(int h = 0; h < __levels - 1; h ++) {
+        __lowLevelFilters[h].setResidualRange(residualRange);
+    }
+}
+
+
+float PyramidalFlowFilter::getResidualRange() const {
+    return __topLevelFilter.getResidualRange();
+}
+
+
+residualStats_t PyramidalFlowFilter::getResidualStats(const int level) {
+
+    if(level < 0 || level >= __levels) {
+        std::cerr << "ERROR: PyramidalFlowFilter::getResidualStats(): level index out of bounds: " << level << std::endl;
+        throw std::exception();
+    }
+
+    if(level == __levels -1) {
+        return __topLevelFilter.getResidualStats();
+    } else {
+        return __lowLevelFilters[level].getResidualStats();
+    }
+}
+
+
 
 int PyramidalFlowFilter::height() const {
     return __height;
@@ -8,11 +8,15 @@
 
 #include <iostream>
 #include <exception>
+#include <stdexcept>
+#include <string>
+#include <cmath>
 
 #include "flowfilter/gpu/util.h"
 #include "flowfilter/gpu/error.h"
 #include "flowfilter/gpu/flowsmoothing.h"
 #include "flowfilter/gpu/device/flowsmoothing_k.h"
+#include "flowfilter/gpu/footprint.h"
 
 namespace flowfilter {
 namespace gpu {
@@ -22,6 +26,11 @@ FlowSmoother::FlowSmoother() :
     __configured = false;
     __inputFlowSet = false;
     __iterations = 0;
+    __support = 5;
+    __mode = SMOOTH_BOX;
+    __sigmaSpace = 5.0f;
+    __sigmaRange = 0.1f;
+    __guideImageSet = false;
 }
 
 
@@ -31,6 +40,11 @@ FlowSmoother::FlowSmoother(GPUImage inputFlow,
 
     __configured = false;
     __inputFlowSet = false;
+    __support = 5;
+    __mode = SMOOTH_BOX;
+    __sigmaSpace = 5.0f;
+    __sigmaRange = 0.1f;
+    __guideImageSet = false;
 
     setInputFlow(inputFlow);
     setIterations(iterations);
@@ -67,6 +81,13 @@ void FlowSmoother::configure() {
     __block = dim3(32, 32, 1);
     configureKernelGrid(height, width, __block, __grid);
 
+    __blockLine = dim3(64, 1, 1);
+    __gridRows = dim3((height + __blockLine.x - 1) / __blockLine.x, 1, 1);
+    __gridColumns = dim3((width + __blockLine.x - 1) / __blockLine.x, 1, 1);
+
+    __blockMedian = dim3(FLOW_MEDIAN_BLOCK_X, FLOW_MEDIAN_BLOCK_Y, 1);
+    configureKernelGrid(height, width, __blockMedian, __gridMedian);
+
     __configured = true;
 }
 
@@ -80,27 +101,32 @@ void FlowSmoother::compute() {
         exit(-1);
     }
 
-    // First iteration takes as input __inputFlow
-    flowSmoothX_k<<<__grid, __block, 0, __stream>>>(
-        __inputFlowTexture.getTextureObject(),
-        __smoothedFlow_X.wrap<float2>());
+    if(__mode == SMOOTH_DOMAIN_TRANSFORM) {
 
-    flowSmoothY_k<<<__grid, __block, 0, __stream>>>(
-        __smoothedFlowTexture_X.getTextureObject(),
-        __smoothedFlow_Y.wrap<float2>());
+        if(!__guideImageSet) {
+            std::cerr << "ERROR: FlowSmoother::compute(): guide image not set" << std::endl;
+            throw std::logic_error("FlowSmoother::compute(): guide image not set");
+        }
 
+        domainTransformPass(__inputFlowTexture.getTextureObject(), 0);
 
-    // Rest of iterations
-    for(int n = 0; n < __iterations - 1; n ++) {
+        for(int n = 1; n < __iterations; n ++) {
+            domainTransformPass(__smoothedFlowTexture_Y.getTextureObject(), n);
+        }
 
-        // take as input __smoothedFlowY
-        flowSmoothX_k<<<__grid, __block, 0, __stream>>>(
-            __smoothedFlowTexture_Y.getTextureObject(),
-            __smoothedFlow_X.wrap<float2>());
+    } else if(__mode == SMOOTH_MEDIAN3 || __mode == SMOOTH_MEDIAN5) {
 
-        flowSmoothY_k<<<__grid, __block, 0, __stream>>>(
-            __smoothedFlowTexture_X.getTextureObject(),
-            __smoothedFlow_Y.wrap<float2>());
+        medianPasses();
+
+    } else {
+
+        // First iteration takes as input __inputFlow
+        smoothPass(__inputFlowTexture.getTextureObject());
+
+        // Rest of iterations take as input __smoothedFlowY
+        for(int n = 0; n < __iterations - 1; n ++) {
+            smoothPass(__smoothedFlowTexture_Y.getTextureObject());
+        }
     }
 
     stopTiming();
@@ -108,6 +134,49 @@ void FlowSmoother::compute() {
 }
 
 
+memoryTraffic_t FlowSmoother::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__inputFlow.height()) * __inputFlow.width();
+
+    memoryTraffic_t traffic;
+
+    if(__mode == SMOOTH_DOMAIN_TRANSFORM) {
+
+        // each iteration runs one X and one Y pass, each pass with
+        // a causal and an anticausal sweep reading the flow and the
+        // guide and writing the flow
+        traffic.bytesRead = __iterations * 4 * pixels * (2*sizeof(float) + sizeof(float));
+        traffic.bytesWritten = __iterations * 4 * pixels * 2*sizeof(float);
+
+    } else if(__mode == SMOOTH_MEDIAN3 || __mode == SMOOTH_MEDIAN5) {
+
+        // each iteration is a single pass, the window is read
+        // from the block tile in shared memory
+        traffic.bytesRead = __iterations * pixels * 2*sizeof(float);
+        traffic.bytesWritten = __iterations * pixels * 2*sizeof(float);
+
+    } else {
+
+        // each iteration runs one X and one Y pass, each pass
+        // reading and writing a 2-channel flow field
+        traffic.bytesRead = __iterations * 2 * pixels * 2*sizeof(float);
+        traffic.bytesWritten = __iterations * 2 * pixels * 2*sizeof(float);
+    }
+
+    return traffic;
+}
+
+
+void FlowSmoother::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("FlowSmoother", level, "smoothedFlow_X", __smoothedFlow_X));
+    buffers.push_back(describeBuffer("FlowSmoother", level, "smoothedFlow_Y", __smoothedFlow_Y));
+}
+
+
+
 int FlowSmoother::getIterations() const {
 
     return __iterations;
@@ -127,6 +196,146 @@ void FlowSmoother::setIterations(const int N) {
 }
 
 
+int FlowSmoother::getSupport() const {
+
+    return __support;
+}
+
+
+void FlowSmoother::setSupport(const int support) {
+
+    if(support < 3 || support % 2 != 1) {
+        std::cerr << "ERROR: FlowSmoother::setSupport(): support should be an odd number greater or equal 3: "
+            << support << std::endl;
+
+        throw std::exception();
+    }
+
+    __support = support;
+}
+
+
+smoothMode_t FlowSmoother::getMode() const {
+
+    return __mode;
+}
+
+
+void FlowSmoother::setMode(const smoothMode_t mode) {
+
+    if(mode != SMOOTH_BOX && mode != SMOOTH_DOMAIN_TRANSFORM
+        && mode != SMOOTH_MEDIAN3 && mode != SMOOTH_MEDIAN5) {
+        std::cerr << "ERROR: FlowSmoother::setMode(): unknown smoothing mode: " << int(mode) << std::endl;
+        throw std::invalid_argument("FlowSmoother::setMode(): unknown smoothing mode: " + std::to_string(int(mode)));
+    }
+
+    __mode = mode;
+}
+
+
+float FlowSmoother::getSigmaSpace() const {
+
+    return __sigmaSpace;
+}
+
+
+void FlowSmoother::setSigmaSpace(const float sigma) {
+
+    if(!(sigma > 0.0f)) {
+        std::cerr << "ERROR: FlowSmoother::setSigmaSpace(): sigma should be greater than zero: " << sigma << std::endl;
+        throw std::invalid_argument("FlowSmoother::setSigmaSpace(): sigma should be greater than zero, got: " + std::to_string(sigma));
+    }
+
+    __sigmaSpace = sigma;
+}
+
+
+float FlowSmoother::getSigmaRange() const {
+
+    return __sigmaRange;
+}
+
+
+void FlowSmoother::setSigmaRange(const float sigma) {
+
+    if(!(sigma > 0.0f)) {
+        std::cerr << "ERROR: FlowSmoother::setSigmaRange(): sigma should be greater than zero: " << sigma << std::endl;
+        throw std::invalid_argument("FlowSmoother::setSigmaRange(): sigma should be greater than zero, got: " + std::to_string(sigma));
+    }
+
+    __sigmaRange = sigma;
+}
+
+
+void FlowSmoother::smoothPass(cudaTextureObject_t inputFlow) {
+
+    if(__support == 5) {
+
+        flowSmoothX_k<<<__grid, __block, 0, __stream>>>(
+            inputFlow, __smoothedFlow_X.wrap<float2>());
+
+        flowSmoothY_k<<<__grid, __block, 0, __stream>>>(
+            __smoothedFlowTexture_X.getTextureObject(),
+            __smoothedFlow_Y.wrap<float2>());
+
+    } else {
+
+        flowSmoothSupportX_k<<<__grid, __block, 0, __stream>>>(
+            inputFlow, __support / 2, __smoothedFlow_X.wrap<float2>());
+
+        flowSmoothSupportY_k<<<__grid, __block, 0, __stream>>>(
+            __smoothedFlowTexture_X.getTextureObject(), __support / 2,
+            __smoothedFlow_Y.wrap<float2>());
+    }
+}
+
+
+void FlowSmoother::domainTransformPass(cudaTextureObject_t inputFlow, const int n) {
+
+    // standard deviation of pass n such that the N passes
+    // add up to a filter of standard deviation __sigmaSpace
+    const float N = float(__iterations);
+    const float sigma = __sigmaSpace * sqrtf(3.0f) * powf(2.0f, N - (n + 1))
+        / sqrtf(powf(4.0f, N) - 1.0f);
+
+    const float log2Feedback = -sqrtf(2.0f) / sigma * 1.4426950408889634f;
+    const float ratio = __sigmaSpace / __sigmaRange;
+
+    flowDomainTransformX_k<<<__gridRows, __blockLine, 0, __stream>>>(
+        inputFlow, __guideImage.wrap<float>(), log2Feedback, ratio,
+        __smoothedFlow_X.wrap<float2>());
+
+    flowDomainTransformY_k<<<__gridColumns, __blockLine, 0, __stream>>>(
+        __smoothedFlow_X.wrap<float2>(), __guideImage.wrap<float>(),
+        log2Feedback, ratio, __smoothedFlow_Y.wrap<float2>());
+}
+
+
+void FlowSmoother::medianPasses() {
+
+    // pass n writes to Y if an even number of passes follow it,
+    // so that the last pass always writes to Y
+    cudaTextureObject_t input = __inputFlowTexture.getTextureObject();
+
+    for(int n = 0; n < __iterations; n ++) {
+
+        const bool toY = (__iterations - 1 - n) % 2 == 0;
+        GPUImage& output = toY? __smoothedFlow_Y : __smoothedFlow_X;
+
+        if(__mode == SMOOTH_MEDIAN3) {
+            flowMedian3_k<<<__gridMedian, __blockMedian, 0, __stream>>>(
+                input, output.wrap<float2>());
+        } else {
+            flowMedian5_k<<<__gridMedian, __blockMedian, 0, __stream>>>(
+                input, output.wrap<float2>());
+        }
+
+        input = toY? __smoothedFlowTexture_Y.getTextureObject()
+            : __smoothedFlowTexture_X.getTextureObject();
+    }
+}
+
+
 void FlowSmoother::setInputFlow(GPUImage inputFlow) {
 
     if(inputFlow.depth() != 2) {
@@ -146,6 +355,25 @@ void FlowSmoother::setInputFlow(GPUImage inputFlow) {
 }
 
 
+void FlowSmoother::setGuideImage(GPUImage guideImage) {
+
+    if(guideImage.depth() != 1 || guideImage.itemSize() != 4) {
+        std::cerr << "ERROR: FlowSmoother::setGuideImage(): guide image should be float with depth 1" << std::endl;
+        throw std::invalid_argument("FlowSmoother::setGuideImage(): guide image should be float with depth 1");
+    }
+
+    if(__inputFlowSet && (guideImage.height() != __inputFlow.height()
+        || guideImage.width() != __inputFlow.width())) {
+
+        std::cerr << "ERROR: FlowSmoother::setGuideImage(): guide image and input flow shapes do not match" << std::endl;
+        throw std::invalid_argument("FlowSmoother::setGuideImage(): guide image and input flow shapes do not match");
+    }
+
+    __guideImage = guideImage;
+    __guideImageSet = true;
+}
+
+
 GPUImage FlowSmoother::getSmoothedFlow() {
 
     return __smoothedFlow_Y;
@@ -0,0 +1,223 @@
+/**
+ * \file footprint.cu
+ * \brief Device memory footprint introspection of pipeline stages.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <map>
+#include <sstream>
+#include <iomanip>
+
+#include "flowfilter/gpu/footprint.h"
+
+namespace flowfilter {
+namespace gpu {
+
+
+bufferInfo_t describeBuffer(const std::string& stage,
+    const int level, const std::string& name,
+    flowfilter::gpu::GPUImage img, const bool persistent) {
+
+    bufferInfo_t info;
+    info.stage = stage;
+    info.level = level;
+    info.name = name;
+    info.height = img.height();
+    info.width = img.width();
+    info.depth = img.depth();
+    info.itemSize = img.itemSize();
+    info.pitch = img.pitch();
+    info.bytes = std::size_t(img.pitch()) * img.height();
+    info.persistent = persistent;
+    info.resident = true;
+    info.data = img.data();
+
+    return info;
+}
+
+
+bufferInfo_t describeConfigureBuffer(const std::string& stage,
+    const int level, const std::string& name,
+    const int height, const int width, const int depth, const int itemSize) {
+
+    bufferInfo_t info;
+    info.stage = stage;
+    info.level = level;
+    info.name = name;
+    info.height = height;
+    info.width = width;
+    info.depth = depth;
+    info.itemSize = itemSize;
+    info.pitch = width*depth*itemSize;
+    info.bytes = std::size_t(info.pitch) * height;
+    info.persistent = false;
+    info.resident = false;
+    info.data = nullptr;
+
+    return info;
+}
+
+
+void markPersistent(std::vector<bufferInfo_t>& buffers,
+    flowfilter::gpu::GPUImage img) {
+
+    const void* data = img.data();
+    for(bufferInfo_t& info : buffers) {
+        if(info.resident && info.data == data) {
+            info.persistent = true;
+        }
+    }
+}
+
+
+std::vector<bufferInfo_t> getMemoryFootprint(Stage& stage) {
+
+    std::vector<bufferInfo_t> buffers;
+    stage.appendBuffers(buffers, 0);
+
+    // removes duplicated device pointers, keeping the first
+    // record but preserving the persistent flag of all of them
+    std::vector<bufferInfo_t> footprint;
+    std::map<const void*, std::size_t> index;
+
+    for(const bufferInfo_t& info : buffers) {
+
+        if(!info.resident) {
+            footprint.push_back(info);
+            continue;
+        }
+
+        auto it = index.find(info.data);
+        if(it == index.end()) {
+            index[info.data] = footprint.size();
+            footprint.push_back(info);
+        } else {
+            footprint[it->second].persistent |= info.persistent;
+        }
+    }
+
+    return footprint;
+}
+
+
+std::size_t footprintBytes(const std::vector<bufferInfo_t>& buffers,
+    const bool residentOnly) {
+
+    std::size_t bytes = 0;
+    for(const bufferInfo_t& info : buffers) {
+        if(info.resident || !residentOnly) {
+            bytes += info.bytes;
+        }
+    }
+
+    return bytes;
+}
+
+
+/**
+ * \brief escapes quotes and backslashes of a string literal.
+ */
+static std::string escapeString(const std::string& str) {
+
+    std::string out;
+    for(char c : str) {
+        if(c == '"' || c == '\\') {
+            out.push_back('\\');
+        }
+        out.push_back(c);
+    }
+    return out;
+}
+
+
+std::string footprintToJSON(const std::vector<bufferInfo_t>& buffers) {
+
+    std::ostringstream json;
+    json << "{" << std::endl;
+    json << "  \"totalBytes\": " << footprintBytes(buffers, true) << "," << std::endl;
+    json << "  \"configureBytes\": " << footprintBytes(buffers, false) - footprintBytes(buffers, true) << "," << std::endl;
+    json << "  \"buffers\": [";
+
+    for(std::size_t i = 0; i < buffers.size(); i ++) {
+
+        const bufferInfo_t& info = buffers[i];
+
+        json << (i == 0? "" : ",") << std::endl;
+        json << "    {\"stage\": \"" << escapeString(info.stage) << "\", "
+             << "\"level\": " << info.level << ", "
+             << "\"name\": \"" << escapeString(info.name) << "\", "
+             << "\"shape\": [" << info.height << ", " << info.width << ", " << info.depth << "], "
+             << "\"itemSize\": " << info.itemSize << ", "
+             << "\"pitch\": " << info.pitch << ", "
+             << "\"bytes\": " << info.bytes << ", "
+             << "\"persistent\": " << (info.persistent? "true" : "false") << ", "
+             << "\"resident\": " << (info.resident? "true" : "false") << "}";
+    }
+
+    json << std::endl << "  ]" << std::endl;
+    json << "}" << std::endl;
+
+    return json.str();
+}
+
+
+std::string footprintToGraphviz(const std::vector<bufferInfo_t>& buffers) {
+
+    // buffer indices grouped by level and stage
+    std::map<int, std::map<std::string, std::vector<std::size_t> > > groups;
+    for(std::size_t i = 0; i < buffers.size(); i ++) {
+        groups[buffers[i].level][buffers[i].stage].push_back(i);
+    }
+
+    std::ostringstream dot;
+    dot << std::fixed << std::setprecision(2);
+    dot << "digraph footprint {" << std::endl;
+    dot << "  label=\"resident: " << footprintBytes(buffers, true) / 1e6 << " MB\";" << std::endl;
+    dot << "  node [shape=box, fontsize=10];" << std::endl;
+
+    for(const auto& levelGroup : groups) {
+
+        const int level = levelGroup.first;
+        dot << "  subgraph cluster_level" << level << " {" << std::endl;
+        dot << "    label=\"level " << level << "\";" << std::endl;
+
+        int s = 0;
+        for(const auto& stageGroup : levelGroup.second) {
+
+            std::size_t stageBytes = 0;
+            for(std::size_t i : stageGroup.second) {
+                if(buffers[i].resident) stageBytes += buffers[i].bytes;
+            }
+
+            dot << "    subgraph cluster_level" << level << "_" << s++ << " {" << std::endl;
+            dot << "      label=\"" << escapeString(stageGroup.first) << " ("
+                << stageBytes / 1e6 << " MB)\";" << std::endl;
+
+            for(std::size_t i : stageGroup.second) {
+
+                const bufferInfo_t& info = buffers[i];
+                dot << "      b" << i << " [label=\"" << escapeString(info.name)
+                    << "\\n[" << info.height << ", " << info.width << ", " << info.depth << "] x "
+                    << info.itemSize << "B, pitch " << info.pitch
+                    << "\\n" << info.bytes / 1e6 << " MB\"";
+
+                if(info.persistent) dot << ", style=bold";
+                if(!info.resident) dot << ", style=dashed";
+                dot << "];" << std::endl;
+            }
+
+            dot << "    }" << std::endl;
+        }
+
+        dot << "  }" << std::endl;
+    }
+
+    dot << "}" << std::endl;
+
+    return dot.str();
+}
+
+
+}; // namespace gpu
+}; // namespace flowfilter
@@ -0,0 +1,209 @@
+/**
+ * \file history.cu
+ * \brief Ring buffer of the last flow fields computed by a filter.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "flowfilter/gpu/util.h"
+#include "flowfilter/gpu/error.h"
+#include "flowfilter/gpu/history.h"
+#include "flowfilter/gpu/device/history_k.h"
+
+namespace flowfilter {
+namespace gpu {
+
+
+struct FlowHistory::state_t {
+
+    std::vector<flowfilter::gpu::GPUImage> slots;
+    std::vector<std::uint64_t> frames;
+
+    bool quantized;
+
+    /** number of flows recorded, the last one is at slot (recorded - 1) % depth */
+    std::uint64_t recorded;
+
+    dim3 block;
+    dim3 grid;
+};
+
+
+FlowHistory::FlowHistory() {
+    // unallocated history
+}
+
+
+FlowHistory::FlowHistory(const int height, const int width, const int depth,
+    const bool quantized) :
+    __state(std::make_shared<state_t>()) {
+
+    if(depth < 1) {
+        std::cerr << "ERROR: FlowHistory::FlowHistory(): depth should be greater than zero: " << depth << std::endl;
+        throw std::invalid_argument("FlowHistory::FlowHistory(): depth should be greater than zero, got: "
+            + std::to_string(depth));
+    }
+
+    const std::size_t itemSize = quantized? sizeof(short) : sizeof(float);
+
+    __state->slots.resize(depth);
+    __state->frames.resize(depth, 0);
+
+    for(int n = 0; n < depth; n ++) {
+        __state->slots[n] = GPUImage(height, width, 2, itemSize);
+        __state->slots[n].clear();
+    }
+
+    __state->quantized = quantized;
+    __state->recorded = 0;
+
+    __state->block = dim3(32, 32, 1);
+    configureKernelGrid(height, width, __state->block, __state->grid);
+}
+
+
+void FlowHistory::record(GPUImage& flow) {
+
+    if(!__state) {
+        std::cerr << "ERROR: FlowHistory::record(): history not allocated" << std::endl;
+        throw std::logic_error("FlowHistory::record(): history not allocated");
+    }
+
+    state_t& s = *__state;
+
+    const int slot = int(s.recorded % s.slots.size());
+
+    if(s.quantized) {
+
+        if(flow.height() != s.slots[slot].height() || flow.width() != s.slots[slot].width()
+            || flow.depth() != 2 || flow.itemSize() != sizeof(float)) {
+            std::cerr << "ERROR: FlowHistory::record(): flow should be float with the shape of the history" << std::endl;
+            throw std::invalid_argument("FlowHistory::record(): flow should be float with the shape of the history");
+        }
+
+        quantizeFlow_k<<<s.grid, s.block>>>(flow.wrap<float2>(),
+            FLOWHISTORY_INT16_SCALE, s.slots[slot].wrap<short2>());
+        checkError(cudaGetLastError());
+
+    } else {
+        s.slots[slot].copyFrom(flow);
+    }
+
+    s.recorded ++;
+    s.frames[slot] = s.recorded;
+}
+
+
+void FlowHistory::clear() {
+
+    if(__state) {
+        __state->recorded = 0;
+    }
+}
+
+
+GPUImage FlowHistory::getFlow(const int age) {
+
+    return __state->slots[slotIndex("getFlow", age)];
+}
+
+
+std::uint64_t FlowHistory::getFrame(const int age) const {
+
+    return __state->frames[slotIndex("getFrame", age)];
+}
+
+
+void FlowHistory::downloadFlow(const int age, flowfilter::image_t& flow) {
+
+    GPUImage& slot = __state->slots[slotIndex("downloadFlow", age)];
+
+    if(!__state->quantized || flow.itemSize == slot.itemSize()) {
+        slot.download(flow);
+        return;
+    }
+
+    if(flow.height != slot.height() || flow.width != slot.width()
+        || flow.depth != 2 || flow.itemSize != sizeof(float)) {
+        std::cerr << "ERROR: FlowHistory::downloadFlow(): flow should be float with the shape of the history" << std::endl;
+        throw std::invalid_argument("FlowHistory::downloadFlow(): flow should be float with the shape of the history");
+    }
+
+    // download the quantized slot and convert it to pixels
+    std::vector<short> buffer(std::size_t(slot.height()) * slot.width() * 2);
+
+    image_t quantized;
+    quantized.height = slot.height();
+    quantized.width = slot.width();
+    quantized.depth = 2;
+    quantized.itemSize = sizeof(short);
+    quantized.pitch = std::size_t(slot.width()) * 2 * sizeof(short);
+    quantized.data = buffer.data();
+
+    slot.download(quantized);
+
+    for(int r = 0; r < flow.height; r ++) {
+
+        const short* src = &buffer[std::size_t(r) * flow.width * 2];
+        float* dst = reinterpret_cast<float*>(static_cast<unsigned char*>(flow.data) + r*flow.pitch);
+
+        for(int c = 0; c < 2*flow.width; c ++) {
+            dst[c] = src[c] / FLOWHISTORY_INT16_SCALE;
+        }
+    }
+}
+
+
+int FlowHistory::depth() const {
+
+    return __state? int(__state->slots.size()) : 0;
+}
+
+
+int FlowHistory::size() const {
+
+    if(!__state) {
+        return 0;
+    }
+
+    return int(std::min<std::uint64_t>(__state->recorded, __state->slots.size()));
+}
+
+
+std::uint64_t FlowHistory::getRecorded() const {
+
+    return __state? __state->recorded : 0;
+}
+
+
+bool FlowHistory::isQuantized() const {
+
+    return __state? __state->quantized : false;
+}
+
+
+bool FlowHistory::isAllocated() const {
+
+    return bool(__state);
+}
+
+
+int FlowHistory::slotIndex(const std::string& method, const int age) const {
+
+    if(age < 0 || age >= size()) {
+        std::cerr << "ERROR: FlowHistory::" << method << "(): age out of bounds: " << age << std::endl;
+        throw std::invalid_argument("FlowHistory::" + method + "(): age out of bounds, got: "
+            + std::to_string(age) + ", recorded: " + std::to_string(size()));
+    }
+
+    const std::uint64_t depth = __state->slots.size();
+    return int((__state->recorded - 1 - age) % depth);
+}
+
+}; // namespace gpu
+}; // namespace flowfilter
@@ -27,6 +27,7 @@ GPUImage::GPUImage() {
     __depth = 0;
     __pitch = 0;
     __itemSize = 0;
+    __device = 0;
 }
 
 GPUImage::GPUImage(const int height, const int width,
@@ -41,6 +42,31 @@ GPUImage::GPUImage(const int height, const int width,
     allocate();
 }
 
+GPUImage::GPUImage(const int height, const int width,
+    const int depth, const int itemSize,
+    void* data, const std::size_t pitch, const int device,
+    gpuImageRelease_t release, void* context) {
+
+    if(pitch < std::size_t(width)*depth*itemSize) {
+        std::cerr << "ERROR: GPUImage::GPUImage(): pitch smaller than row size: " << pitch << std::endl;
+        throw std::invalid_argument("GPUImage::GPUImage(): pitch smaller than row size: " + std::to_string(pitch));
+    }
+
+    __height = height;
+    __width = width;
+    __depth = depth;
+    __itemSize = itemSize;
+    __pitch = pitch;
+    __device = device;
+
+    // the buffer is released by its owner
+    __ptr_dev = std::shared_ptr<void>(data, [release, context](void*) {
+        if(release != nullptr) {
+            release(context);
+        }
+    });
+}
+
 GPUImage::~GPUImage() {
 
     // nothing to do
@@ -69,6 +95,10 @@ int GPUImage::itemSize() const {
     return __itemSize;
 }
 
+int GPUImage::device() const {
+    return __device;
+}
+
 void* GPUImage::data() {
     return __ptr_dev.get();
 }
@@ -151,7 +181,9 @@ void GPUImage::download(flowfilter::image_t& img) const {
 
 void GPUImage::copyFrom(GPUImage& img) {
 
-    if(compareShapeGPU(img)) {
+    // pitches may differ, for instance with buffers wrapped from other libraries
+    if(__height == img.__height && __width == img.__width &&
+        __depth == img.__depth && __itemSize == img.__itemSize) {
 
         // issue synchronous memory copy
         checkError(cudaMemcpy2D(__ptr_dev.get(), __pitch, 
@@ -180,6 +212,8 @@ void GPUImage::allocate() {
 
     // std::cout << "GPUImage::allocate()" << std::endl;
 
+    checkError(cudaGetDevice(&__device));
+
     void* buffer_dev = nullptr;
     checkError(cudaMallocPitch(&buffer_dev, &__pitch,
         __width*__depth*__itemSize, __height));
@@ -14,6 +14,7 @@
 #include "flowfilter/gpu/util.h"
 #include "flowfilter/gpu/error.h"
 #include "flowfilter/gpu/device/imagemodel_k.h"
+#include "flowfilter/gpu/footprint.h"
 
 namespace flowfilter {
 namespace gpu {
@@ -25,6 +26,7 @@ ImageModel::ImageModel() :
     Stage() {
     __configured = false;
     __inputImageSet = false;
+    setSupport(5);
 }
 
 /**
@@ -38,6 +40,7 @@ ImageModel::ImageModel(flowfilter::gpu::GPUImage inputImage) :
     
     __configured = false;
     __inputImageSet = false;
+    setSupport(5);
     setInputImage(inputImage);
     configure();
 }
@@ -99,20 +102,94 @@ void ImageModel::compute() {
         throw std::logic_error("ImageModel::compute() stage not configured.");
     }
 
-    // prefilter
-    imagePrefilter_k<<<__grid, __block, 0, __stream>>> (
-        __inputImageTexture.getTextureObject(), __imageFiltered.wrap<float2>());
+    if(__support == 5) {
 
-    // compute brightness parameters
-    imageModel_k<<<__grid, __block, 0, __stream>>> (
-        __imageFilteredTexture.getTextureObject(),
-        __imageConstant.wrap<float>(),
-        __imageGradient.wrap<float2>());
+        // prefilter
+        imagePrefilter_k<<<__grid, __block, 0, __stream>>> (
+            __inputImageTexture.getTextureObject(), __imageFiltered.wrap<float2>());
+
+        // compute brightness parameters
+        imageModel_k<<<__grid, __block, 0, __stream>>> (
+            __imageFilteredTexture.getTextureObject(),
+            __imageConstant.wrap<float>(),
+            __imageGradient.wrap<float2>());
+
+    } else {
+
+        imagePrefilterSupport_k<<<__grid, __block, 0, __stream>>> (
+            __inputImageTexture.getTextureObject(), __mask,
+            __imageFiltered.wrap<float2>());
+
+        imageModelSupport_k<<<__grid, __block, 0, __stream>>> (
+            __imageFilteredTexture.getTextureObject(), __mask,
+            __imageConstant.wrap<float>(),
+            __imageGradient.wrap<float2>());
+    }
 
     stopTiming();
 }
 
 
+memoryTraffic_t ImageModel::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__inputImage.height()) * __inputImage.width();
+
+    memoryTraffic_t traffic;
+
+    // imagePrefilter_k reads the input image and writes the 2-channel
+    // filtered image. imageModel_k reads the filtered image and writes
+    // the constant and gradient parameters.
+    traffic.bytesRead = pixels * (__inputImage.itemSize() + 2*sizeof(float));
+    traffic.bytesWritten = pixels * (2*sizeof(float) + sizeof(float) + 2*sizeof(float));
+
+    return traffic;
+}
+
+
+void ImageModel::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("ImageModel", level, "imageFiltered", __imageFiltered));
+    buffers.push_back(describeBuffer("ImageModel", level, "imageConstant", __imageConstant));
+    buffers.push_back(describeBuffer("ImageModel", level, "imageGradient", __imageGradient));
+}
+
+
+void ImageModel::setSupport(const int support) {
+
+    if(support < 3 || support > IMAGE_MODEL_MAX_SUPPORT || support % 2 != 1) {
+        std::cerr << "ERROR: ImageModel::setSupport(): support should be odd and in [3, "
+            << IMAGE_MODEL_MAX_SUPPORT << "]: " << support << std::endl;
+        throw std::invalid_argument("ImageModel::setSupport(): support should be odd and in [3, "
+            + std::to_string(IMAGE_MODEL_MAX_SUPPORT) + "], got: " + std::to_string(support));
+    }
+
+    // binomial smooth mask, as rows of Pascal's triangle
+    float binomial[IMAGE_MODEL_MAX_SUPPORT] = {1.0f};
+    for(int n = 1; n < support; n ++) {
+        for(int k = n; k > 0; k --) {
+            binomial[k] += binomial[k - 1];
+        }
+    }
+
+    float norm = float(1 << (support - 1));
+
+    __mask.radius = support / 2;
+    for(int k = 0; k < support; k ++) {
+        __mask.smooth[k] = binomial[k] / norm;
+        __mask.diff[k] = (k - __mask.radius) * __mask.smooth[k];
+    }
+
+    __support = support;
+}
+
+
+int ImageModel::getSupport() const {
+    return __support;
+}
+
+
 //#########################
 // Pipeline stage inputs
 //#########################
@@ -0,0 +1,262 @@
+/**
+ * \file interpolation.cu
+ * \brief Motion compensated frame interpolation.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "flowfilter/gpu/util.h"
+#include "flowfilter/gpu/interpolation.h"
+#include "flowfilter/gpu/device/interpolation_k.h"
+#include "flowfilter/gpu/footprint.h"
+
+
+namespace flowfilter {
+namespace gpu {
+
+
+FrameInterpolator::FrameInterpolator() :
+    Stage() {
+
+    __configured = false;
+    __inputFlowSet = false;
+    __inputImageSet = false;
+    __inputImageOldSet = false;
+    __time = 0.5f;
+    __blend = false;
+}
+
+
+FrameInterpolator::FrameInterpolator(GPUImage inputFlow,
+    GPUImage inputImage) :
+    FrameInterpolator() {
+
+    setInputFlow(inputFlow);
+    setInputImage(inputImage);
+    configure();
+}
+
+
+FrameInterpolator::FrameInterpolator(GPUImage inputFlow,
+    GPUImage inputImage, GPUImage inputImageOld) :
+    FrameInterpolator() {
+
+    setInputFlow(inputFlow);
+    setInputImage(inputImage);
+    setInputImageOld(inputImageOld);
+    configure();
+
+    __blend = true;
+}
+
+
+FrameInterpolator::~FrameInterpolator() {
+    // nothing to do
+}
+
+
+void FrameInterpolator::configure() {
+
+    if(!__inputFlowSet) {
+        std::cerr << "ERROR: FrameInterpolator::configure(): input flow not set" << std::endl;
+        throw std::logic_error("FrameInterpolator::configure(): input flow not set");
+    }
+
+    if(!__inputImageSet) {
+        std::cerr << "ERROR: FrameInterpolator::configure(): input image not set" << std::endl;
+        throw std::logic_error("FrameInterpolator::configure(): input image not set");
+    }
+
+    checkInputImage("configure", __inputImage);
+    __inputImageTexture = linearTexture(__inputImage);
+
+    if(__inputImageOldSet) {
+        checkInputImage("configure", __inputImageOld);
+        __inputImageOldTexture = linearTexture(__inputImageOld);
+    }
+
+    __interpolatedImage = GPUImage(__inputFlow.height(), __inputFlow.width(), 1, sizeof(float));
+
+    // configure block and grid sizes
+    __block = dim3(32, 32, 1);
+    configureKernelGrid(__inputFlow.height(), __inputFlow.width(),
+        __block, __grid);
+
+    __configured = true;
+}
+
+
+void FrameInterpolator::compute() {
+
+    startTiming();
+
+    if(!__configured) {
+        std::cerr << "ERROR: FrameInterpolator::compute(): Stage not configured" << std::endl;
+        throw std::logic_error("FrameInterpolator::compute(): stage not configured");
+    }
+
+    if(__blend) {
+        warpBlendImage_k<<<__grid, __block, 0, __stream>>>(
+            __inputFlow.wrap<float2>(),
+            __inputImageTexture.getTextureObject(),
+            __inputImageOldTexture.getTextureObject(),
+            __time, __interpolatedImage.wrap<float>());
+    } else {
+        warpImage_k<<<__grid, __block, 0, __stream>>>(
+            __inputFlow.wrap<float2>(),
+            __inputImageTexture.getTextureObject(),
+            __time, __interpolatedImage.wrap<float>());
+    }
+
+    stopTiming();
+}
+
+
+memoryTraffic_t FrameInterpolator::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__inputFlow.height()) * __inputFlow.width();
+
+    memoryTraffic_t traffic;
+
+    // reads the flow and, through the texture cache, about one
+    // pixel of each warped image. Writes the interpolated image.
+    traffic.bytesRead = pixels * (2*sizeof(float) + __inputImage.itemSize());
+    if(__blend) {
+        traffic.bytesRead += pixels * __inputImageOld.itemSize();
+    }
+
+    traffic.bytesWritten = pixels * sizeof(float);
+
+    return traffic;
+}
+
+
+void FrameInterpolator::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("FrameInterpolator", level, "interpolatedImage", __interpolatedImage));
+}
+
+
+void FrameInterpolator::downloadInterpolatedImage(flowfilter::image_t& image) {
+    __interpolatedImage.download(image);
+}
+
+
+void FrameInterpolator::setInputFlow(GPUImage inputFlow) {
+
+    if(inputFlow.depth() != 2) {
+        std::cerr << "ERROR: FrameInterpolator::setInputFlow(): input flow should have depth 2: "
+            << inputFlow.depth() << std::endl;
+        throw std::invalid_argument("FrameInterpolator::setInputFlow(): input flow should have depth 2, got: "
+            + std::to_string(inputFlow.depth()));
+    }
+
+    if(inputFlow.itemSize() != 4) {
+        std::cerr << "ERROR: FrameInterpolator::setInputFlow(): input flow should have item size 4: "
+            << inputFlow.itemSize() << std::endl;
+        throw std::invalid_argument("FrameInterpolator::setInputFlow(): input flow should have item size 4, got: "
+            + std::to_string(inputFlow.itemSize()));
+    }
+
+    __inputFlow = inputFlow;
+    __inputFlowSet = true;
+}
+
+
+void FrameInterpolator::setInputImage(GPUImage inputImage) {
+
+    __inputImage = inputImage;
+    __inputImageSet = true;
+}
+
+
+void FrameInterpolator::setInputImageOld(GPUImage inputImageOld) {
+
+    __inputImageOld = inputImageOld;
+    __inputImageOldSet = true;
+}
+
+
+GPUImage FrameInterpolator::getInterpolatedImage() {
+    return __interpolatedImage;
+}
+
+
+float FrameInterpolator::getTime() const {
+    return __time;
+}
+
+
+void FrameInterpolator::setTime(const float t) {
+
+    if(!(t >= 0.0f && t <= 1.0f)) {
+        std::cerr << "ERROR: FrameInterpolator::setTime(): time should be in [0, 1]: " << t << std::endl;
+        throw std::invalid_argument("FrameInterpolator::setTime(): time should be in [0, 1], got: "
+            + std::to_string(t));
+    }
+
+    __time = t;
+}
+
+
+bool FrameInterpolator::getBlend() const {
+    return __blend;
+}
+
+
+void FrameInterpolator::setBlend(const bool blend) {
+
+    if(blend && !(__configured && __inputImageOldSet)) {
+        std::cerr << "ERROR: FrameInterpolator::setBlend(): blending requires a configured previous image" << std::endl;
+        throw std::logic_error("FrameInterpolator::setBlend(): blending requires a configured previous image");
+    }
+
+    __blend = blend;
+}
+
+
+GPUTexture FrameInterpolator::linearTexture(GPUImage& image) {
+
+    // uint8 images can only be filtered as normalized floats
+    if(image.itemSize() == sizeof(unsigned char)) {
+        return GPUTexture(image, cudaChannelFormatKindUnsigned,
+            cudaAddressModeClamp, cudaFilterModeLinear, cudaReadModeNormalizedFloat, false);
+    }
+
+    return GPUTexture(image, cudaChannelFormatKindFloat,
+        cudaAddressModeClamp, cudaFilterModeLinear, cudaReadModeElementType, false);
+}
+
+
+void FrameInterpolator::checkInputImage(const char* method, GPUImage& image) const {
+
+    if(image.depth() != 1) {
+        std::cerr << "ERROR: FrameInterpolator::" << method << "(): input image should have depth 1: "
+            << image.depth() << std::endl;
+        throw std::invalid_argument(std::string("FrameInterpolator::") + method
+            + "(): input image should have depth 1, got: " + std::to_string(image.depth()));
+    }
+
+    if(image.itemSize() != sizeof(unsigned char) && image.itemSize() != sizeof(float)) {
+        std::cerr << "ERROR: FrameInterpolator::" << method << "(): input image should have item size 1 or 4: "
+            << image.itemSize() << std::endl;
+        throw std::invalid_argument(std::string("FrameInterpolator::") + method
+            + "(): input image should have item size 1 or 4, got: " + std::to_string(image.itemSize()));
+    }
+
+    if(image.height() != __inputFlow.height() || image.width() != __inputFlow.width()) {
+        std::cerr << "ERROR: FrameInterpolator::" << method << "(): input image and flow shapes do not match" << std::endl;
+        throw std::invalid_argument(std::string("FrameInterpolator::") + method
+            + "(): input image and flow shapes do not match");
+    }
+}
+
+
+}; // namespace gpu
+}; // namespace flowfilter
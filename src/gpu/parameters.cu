@@ -0,0 +1,185 @@
+/**
+ * \file parameters.cu
+ * \brief Filter parameter blocks updated from a control thread.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "flowfilter/gpu/parameters.h"
+
+namespace flowfilter {
+namespace gpu {
+
+/** flag of the shared block index telling it has not been consumed yet */
+const int PARAMETERS_FRESH = 4;
+
+/** mask of the block index */
+const int PARAMETERS_INDEX = 3;
+
+
+struct ParameterBuffer::state_t {
+
+    int levels;
+
+    /** parameters submitted so far, owned by the control thread */
+    filterParameters_t submitted;
+
+    filterParameters_t blocks[3];
+
+    /** index of the shared block, plus PARAMETERS_FRESH if not consumed */
+    std::atomic<int> shared;
+
+    /** block owned by the control thread */
+    int back;
+
+    /** block owned by the filter thread */
+    int front;
+};
+
+
+ParameterBuffer::ParameterBuffer() {
+    // unallocated buffer
+}
+
+
+ParameterBuffer::ParameterBuffer(const int levels) :
+    __state(std::make_shared<state_t>()) {
+
+    if(levels <= 0 || levels > PARAMETERS_MAX_LEVELS) {
+        std::cerr << "ERROR: ParameterBuffer::ParameterBuffer(): levels should be in [1, "
+            << PARAMETERS_MAX_LEVELS << "]: " << levels << std::endl;
+        throw std::invalid_argument("ParameterBuffer::ParameterBuffer(): levels should be in [1, "
+            + std::to_string(PARAMETERS_MAX_LEVELS) + "], got: " + std::to_string(levels));
+    }
+
+    __state->levels = levels;
+    std::memset(&__state->submitted, 0, sizeof(filterParameters_t));
+
+    for(int n = 0; n < 3; n ++) {
+        __state->blocks[n] = __state->submitted;
+    }
+
+    __state->back = 0;
+    __state->shared.store(1);
+    __state->front = 2;
+}
+
+
+void ParameterBuffer::setGamma(const int level, const float gamma) {
+
+    checkLevel("setGamma", level);
+
+    if(!(gamma > 0.0f)) {
+        std::cerr << "ERROR: ParameterBuffer::setGamma(): gamma should be greater than zero: " << gamma << std::endl;
+        throw std::invalid_argument("ParameterBuffer::setGamma(): gamma should be greater than zero, got: " + std::to_string(gamma));
+    }
+
+    __state->submitted.gamma[level] = gamma;
+    __state->submitted.gammaMask |= (1u << level);
+}
+
+
+void ParameterBuffer::setSmoothIterations(const int level, const int N) {
+
+    checkLevel("setSmoothIterations", level);
+
+    if(N <= 0) {
+        std::cerr << "ERROR: ParameterBuffer::setSmoothIterations(): iterations should be greater than zero: " << N << std::endl;
+        throw std::invalid_argument("ParameterBuffer::setSmoothIterations(): iterations should be greater than zero, got: " + std::to_string(N));
+    }
+
+    __state->submitted.smoothIterations[level] = N;
+    __state->submitted.smoothIterationsMask |= (1u << level);
+}
+
+
+void ParameterBuffer::setMaxFlow(const float maxflow) {
+
+    if(!__state) {
+        std::cerr << "ERROR: ParameterBuffer::setMaxFlow(): buffer not allocated" << std::endl;
+        throw std::logic_error("ParameterBuffer::setMaxFlow(): buffer not allocated");
+    }
+
+    if(!(maxflow > 0.0f)) {
+        std::cerr << "ERROR: ParameterBuffer::setMaxFlow(): maxflow should be greater than zero: " << maxflow << std::endl;
+        throw std::invalid_argument("ParameterBuffer::setMaxFlow(): maxflow should be greater than zero, got: " + std::to_string(maxflow));
+    }
+
+    __state->submitted.maxflow = maxflow;
+    __state->submitted.maxflowSet = true;
+}
+
+
+filterParameters_t ParameterBuffer::getSubmitted() const {
+
+    if(!__state) {
+        std::cerr << "ERROR: ParameterBuffer::getSubmitted(): buffer not allocated" << std::endl;
+        throw std::logic_error("ParameterBuffer::getSubmitted(): buffer not allocated");
+    }
+
+    return __state->submitted;
+}
+
+
+int ParameterBuffer::levels() const {
+    return __state? __state->levels : 0;
+}
+
+
+bool ParameterBuffer::consume(filterParameters_t& params) {
+
+    if(!__state) {
+        return false;
+    }
+
+    state_t& s = *__state;
+
+    if((s.shared.load(std::memory_order_acquire) & PARAMETERS_FRESH) == 0) {
+        return false;
+    }
+
+    // acquire the shared block, give back the front block
+    s.front = s.shared.exchange(s.front, std::memory_order_acq_rel) & PARAMETERS_INDEX;
+    params = s.blocks[s.front];
+    return true;
+}
+
+
+void ParameterBuffer::checkLevel(const char* method, const int level) const {
+
+    if(!__state) {
+        std::cerr << "ERROR: ParameterBuffer::" << method << "(): buffer not allocated" << std::endl;
+        throw std::logic_error(std::string("ParameterBuffer::") + method + "(): buffer not allocated");
+    }
+
+    if(level < 0 || level >= __state->levels) {
+        std::cerr << "ERROR: ParameterBuffer::" << method << "(): level index out of bounds: " << level << std::endl;
+        throw std::invalid_argument(std::string("ParameterBuffer::") + method
+            + "(): level index out of bounds, got: " + std::to_string(level));
+    }
+}
+
+
+void ParameterBuffer::submit() {
+
+    if(!__state) {
+        std::cerr << "ERROR: ParameterBuffer::submit(): buffer not allocated" << std::endl;
+        throw std::logic_error("ParameterBuffer::submit(): buffer not allocated");
+    }
+
+    state_t& s = *__state;
+
+    s.blocks[s.back] = s.submitted;
+
+    // release the back block content, take the previous shared block
+    s.back = s.shared.exchange(s.back | PARAMETERS_FRESH, std::memory_order_acq_rel) & PARAMETERS_INDEX;
+}
+
+}; // namespace gpu
+}; // namespace flowfilter
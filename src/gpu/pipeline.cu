@@ -88,6 +88,30 @@ namespace flowfilter {
             return __elapsedTime;
         }
 
+        memoryTraffic_t Stage::memoryTraffic() const {
+            memoryTraffic_t traffic;
+            traffic.bytesRead = 0;
+            traffic.bytesWritten = 0;
+            return traffic;
+        }
+
+        float Stage::achievedBandwidth() const {
+
+            if(__elapsedTime <= 0.0f) {
+                return 0.0f;
+            }
+
+            memoryTraffic_t traffic = memoryTraffic();
+            double bytes = double(traffic.bytesRead + traffic.bytesWritten);
+
+            // bytes / (ms * 1e-3) / 1e9
+            return float(bytes / (double(__elapsedTime) * 1e6));
+        }
+
+        void Stage::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+            // nothing to do
+        }
+
 
         //#################################################
         // EmptyStage
@@ -7,12 +7,15 @@
 
 #include <iostream>
 #include <exception>
+#include <stdexcept>
+#include <string>
 
 #include "flowfilter/gpu/util.h"
 #include "flowfilter/gpu/error.h"
 #include "flowfilter/gpu/propagation.h"
 #include "flowfilter/gpu/device/propagation_k.h"
 #include "flowfilter/gpu/device/misc_k.h"
+#include "flowfilter/gpu/footprint.h"
 
 namespace flowfilter {
 namespace gpu {
@@ -26,6 +29,7 @@ FlowPropagator::FlowPropagator() :
     __iterations = 0;
     __border = 3;
     __dt = 0.0f;
+    __timeStep = 1.0f;
 }
 
 
@@ -37,6 +41,7 @@ FlowPropagator::FlowPropagator(GPUImage inputFlow,
     __inputFlowSet = false;
     __invertInputFlow = false;
     __border = 3;
+    __timeStep = 1.0f;
 
     setInputFlow(inputFlow);
     setIterations(iterations);
@@ -134,6 +139,36 @@ void FlowPropagator::compute() {
 }
 
 
+memoryTraffic_t FlowPropagator::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__inputFlow.height()) * __inputFlow.width();
+
+    memoryTraffic_t traffic;
+
+    // each iteration runs one X and one Y pass, each pass
+    // reading and writing a 2-channel flow field
+    traffic.bytesRead = __iterations * 2 * pixels * 2*sizeof(float);
+    traffic.bytesWritten = __iterations * 2 * pixels * 2*sizeof(float);
+
+    if(__invertInputFlow) {
+        traffic.bytesRead += pixels * 2*sizeof(float);
+        traffic.bytesWritten += pixels * 2*sizeof(float);
+    }
+
+    return traffic;
+}
+
+
+void FlowPropagator::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("FlowPropagator", level, "propagatedFlow_X", __propagatedFlow_X));
+    buffers.push_back(describeBuffer("FlowPropagator", level, "propagatedFlow_Y", __propagatedFlow_Y));
+}
+
+
+
 void FlowPropagator::setIterations(const int N) {
 
     if(N <= 0) {
@@ -144,7 +179,7 @@ void FlowPropagator::setIterations(const int N) {
     }
 
     __iterations = N;
-    __dt = 1.0f / float(__iterations);
+    __dt = __timeStep / float(__iterations);
 }
 
 
@@ -157,6 +192,29 @@ float FlowPropagator::getDt() const {
     return __dt;
 }
 
+
+void FlowPropagator::setTimeStep(const float timeStep) {
+
+    if(!(timeStep > 0.0f)) {
+        std::cerr << "ERROR: FlowPropagator::setTimeStep(): time step should be greater than zero: "
+            << timeStep << std::endl;
+
+        throw std::invalid_argument("FlowPropagator::setTimeStep(): time step should be greater than zero, got: "
+            + std::to_string(timeStep));
+    }
+
+    __timeStep = timeStep;
+
+    if(__iterations > 0) {
+        __dt = __timeStep / float(__iterations);
+    }
+}
+
+
+float FlowPropagator::getTimeStep() const {
+    return __timeStep;
+}
+
 void FlowPropagator::setBorder(const int border) {
 
     if(border < 0) {
@@ -219,6 +277,7 @@ FlowPropagatorPayload::FlowPropagatorPayload() :
 
     __iterations = 0;
     __dt = 0.0f;
+    __timeStep = 1.0f;
     __border = 3;
     __configured = false;
 
@@ -237,6 +296,7 @@ FlowPropagatorPayload::FlowPropagatorPayload(GPUImage inputFlow,
 
     __iterations = 0;
     __dt = 0.0f;
+    __timeStep = 1.0f;
     __border = 3;
     __configured = false;
 
@@ -373,6 +433,37 @@ void FlowPropagatorPayload::compute() {
 }
 
 
+memoryTraffic_t FlowPropagatorPayload::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__inputFlow.height()) * __inputFlow.width();
+
+    // flow, scalar and vector payloads
+    std::size_t pixelBytes = 2*sizeof(float) + sizeof(float) + 2*sizeof(float);
+
+    memoryTraffic_t traffic;
+
+    // each iteration runs one X and one Y pass
+    traffic.bytesRead = __iterations * 2 * pixels * pixelBytes;
+    traffic.bytesWritten = __iterations * 2 * pixels * pixelBytes;
+
+    return traffic;
+}
+
+
+void FlowPropagatorPayload::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("FlowPropagatorPayload", level, "propagatedFlow_X", __propagatedFlow_X));
+    buffers.push_back(describeBuffer("FlowPropagatorPayload", level, "propagatedFlow_Y", __propagatedFlow_Y));
+    buffers.push_back(describeBuffer("FlowPropagatorPayload", level, "propagatedScalar_X", __propagatedScalar_X));
+    buffers.push_back(describeBuffer("FlowPropagatorPayload", level, "propagatedScalar_Y", __propagatedScalar_Y));
+    buffers.push_back(describeBuffer("FlowPropagatorPayload", level, "propagatedVector_X", __propagatedVector_X));
+    buffers.push_back(describeBuffer("FlowPropagatorPayload", level, "propagatedVector_Y", __propagatedVector_Y));
+}
+
+
+
 void FlowPropagatorPayload::setIterations(const int N) {
 
     if(N <= 0) {
@@ -383,7 +474,7 @@ void FlowPropagatorPayload::setIterations(const int N) {
     }
 
     __iterations = N;
-    __dt = 1.0f / float(__iterations);
+    __dt = __timeStep / float(__iterations);
 }
 
 int FlowPropagatorPayload::getIterations() const {
@@ -395,6 +486,29 @@ float FlowPropagatorPayload::getDt() const {
 }
 
 
+void FlowPropagatorPayload::setTimeStep(const float timeStep) {
+
+    if(!(timeStep > 0.0f)) {
+        std::cerr << "ERROR: FlowPropagatorPayload::setTimeStep(): time step should be greater than zero: "
+            << timeStep << std::endl;
+
+        throw std::invalid_argument("FlowPropagatorPayload::setTimeStep(): time step should be greater than zero, got: "
+            + std::to_string(timeStep));
+    }
+
+    __timeStep = timeStep;
+
+    if(__iterations > 0) {
+        __dt = __timeStep / float(__iterations);
+    }
+}
+
+
+float FlowPropagatorPayload::getTimeStep() const {
+    return __timeStep;
+}
+
+
 void FlowPropagatorPayload::setBorder(const int border) {
 
     if(border < 0) {
@@ -644,6 +758,32 @@ void LaxWendroffPropagator::compute() {
 }
 
 
+memoryTraffic_t LaxWendroffPropagator::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__inputFlow.height()) * __inputFlow.width();
+    std::size_t imageBytes = __inputImage.depth() * sizeof(float);
+
+    memoryTraffic_t traffic;
+
+    // each iteration runs one Y and one X pass, each pass reads
+    // the flow field and the image, and writes the image
+    traffic.bytesRead = __iterations * 2 * pixels * (2*sizeof(float) + imageBytes);
+    traffic.bytesWritten = __iterations * 2 * pixels * imageBytes;
+
+    return traffic;
+}
+
+
+void LaxWendroffPropagator::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("LaxWendroffPropagator", level, "propagatedImage_X", __propagatedImage_X));
+    buffers.push_back(describeBuffer("LaxWendroffPropagator", level, "propagatedImage_Y", __propagatedImage_Y));
+}
+
+
+
 void LaxWendroffPropagator::setIterations(const int N) {
 
     if(N <= 0) {
@@ -13,6 +13,7 @@
 #include "flowfilter/gpu/error.h"
 #include "flowfilter/gpu/pyramid.h"
 #include "flowfilter/gpu/device/pyramid_k.h"
+#include "flowfilter/gpu/footprint.h"
 
 
 namespace flowfilter {
@@ -167,6 +168,45 @@ void ImagePyramid::compute() {
 }
 
 
+memoryTraffic_t ImagePyramid::memoryTraffic() const {
+
+    memoryTraffic_t traffic;
+    traffic.bytesRead = 0;
+    traffic.bytesWritten = 0;
+
+    std::size_t itemSize = __inputImage.itemSize();
+
+    for(int h = 0; h < int(__pyramidX.size()); h ++) {
+
+        // input of downsampling in X
+        const GPUImage& inputX = h == 0? __inputImage : __pyramidY[h-1];
+
+        std::size_t pixelsIn = std::size_t(inputX.height()) * inputX.width();
+        std::size_t pixelsX = std::size_t(__pyramidX[h].height()) * __pyramidX[h].width();
+        std::size_t pixelsY = std::size_t(__pyramidY[h].height()) * __pyramidY[h].width();
+
+        // downsampling in X and Y
+        traffic.bytesRead += (pixelsIn + pixelsX) * itemSize;
+        traffic.bytesWritten += (pixelsX + pixelsY) * itemSize;
+    }
+
+    return traffic;
+}
+
+
+void ImagePyramid::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    // level 0 of the pyramid is the input image, owned by the caller
+    for(int h = 0; h < int(__pyramidX.size()); h ++) {
+        buffers.push_back(describeBuffer("ImagePyramid", level + h, "pyramidX", __pyramidX[h]));
+        buffers.push_back(describeBuffer("ImagePyramid", level + h + 1, "pyramidY", __pyramidY[h]));
+    }
+}
+
+
+
 //#########################
 // Stage inputs
 //#########################
@@ -5,14 +5,18 @@
  * \license 3-clause BSD, see LICENSE for more details
  */
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <exception>
+#include <stdexcept>
 
 #include "flowfilter/gpu/util.h"
  
 #include "flowfilter/gpu/rotation.h"
 
 #include "flowfilter/gpu/device/rotation_k.h"
+#include "flowfilter/gpu/footprint.h"
 
 
 namespace flowfilter {
@@ -88,6 +92,28 @@ void RotationalFlowImagePredictor::compute() {
 }
 
 
+memoryTraffic_t RotationalFlowImagePredictor::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__opticalFlow.height()) * __opticalFlow.width();
+
+    // rotationalOpticalFlow_k writes the flow field
+    memoryTraffic_t traffic = __propagator.memoryTraffic();
+    traffic.bytesWritten += pixels * 2*sizeof(float);
+
+    return traffic;
+}
+
+
+void RotationalFlowImagePredictor::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("RotationalFlowImagePredictor", level, "opticalFlow", __opticalFlow));
+    __propagator.appendBuffers(buffers, level);
+}
+
+
+
 void RotationalFlowImagePredictor::setInputImage(GPUImage inputImage) {
 
     // TODO: validate
@@ -132,5 +158,151 @@ int RotationalFlowImagePredictor::getIterations() const {
 }
 
 
+
+//###############################################
+// RotationalFlowAdder
+//###############################################
+
+RotationalFlowAdder::RotationalFlowAdder() {
+
+    __configured = false;
+    __inputFlowSet = false;
+    __angularVelocity = make_float3(0.0f, 0.0f, 0.0f);
+}
+
+
+RotationalFlowAdder::RotationalFlowAdder(perspectiveCamera cam,
+        flowfilter::gpu::GPUImage inputFlow) :
+    RotationalFlowAdder() {
+
+    setCamera(cam);
+    setInputFlow(inputFlow);
+    configure();
+}
+
+
+RotationalFlowAdder::~RotationalFlowAdder() {
+    // nothing to do
+}
+
+
+void RotationalFlowAdder::configure() {
+
+    if(!__inputFlowSet) {
+        std::cerr << "ERROR: RotationalFlowAdder::configure(): input flow not set" << std::endl;
+        throw std::logic_error("RotationalFlowAdder::configure(): input flow not set");
+    }
+
+    int height = __inputFlow.height();
+    int width = __inputFlow.width();
+
+    __flow = GPUImage(height, width, 2, sizeof(float));
+
+    // configure block and grid sizes
+    __block = dim3(32, 32, 1);
+    configureKernelGrid(height, width, __block, __grid);
+
+    __configured = true;
+}
+
+
+void RotationalFlowAdder::compute() {
+
+    startTiming();
+
+    if(!__configured) {
+        std::cerr << "ERROR: RotationalFlowAdder::compute(): stage not configured" << std::endl;
+        throw std::logic_error("RotationalFlowAdder::compute(): stage not configured");
+    }
+
+    addRotationalFlow_k<<<__grid, __block, 0, __stream>>>(__camera,
+        __angularVelocity, __inputFlow.wrap<float2>(), __flow.wrap<float2>());
+
+    stopTiming();
+}
+
+
+memoryTraffic_t RotationalFlowAdder::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__inputFlow.height()) * __inputFlow.width();
+
+    // addRotationalFlow_k reads the input flow and writes the sum
+    memoryTraffic_t traffic;
+    traffic.bytesRead = pixels * 2*sizeof(float);
+    traffic.bytesWritten = pixels * 2*sizeof(float);
+
+    return traffic;
+}
+
+
+void RotationalFlowAdder::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("RotationalFlowAdder", level, "flow", __flow));
+}
+
+
+void RotationalFlowAdder::setInputFlow(GPUImage inputFlow) {
+
+    if(inputFlow.depth() != 2 || inputFlow.itemSize() != sizeof(float)) {
+        std::cerr << "ERROR: RotationalFlowAdder::setInputFlow(): input flow should be float with depth 2" << std::endl;
+        throw std::invalid_argument("RotationalFlowAdder::setInputFlow(): input flow should be float with depth 2");
+    }
+
+    __inputFlow = inputFlow;
+    __inputFlowSet = true;
+}
+
+
+GPUImage RotationalFlowAdder::getFlow() {
+    return __flow;
+}
+
+
+void RotationalFlowAdder::setCamera(perspectiveCamera cam) {
+    __camera = cam;
+}
+
+
+void RotationalFlowAdder::setAngularVelocity(const float wx, const float wy, const float wz) {
+
+    __angularVelocity.x = wx;
+    __angularVelocity.y = wy;
+    __angularVelocity.z = wz;
+}
+
+
+float maxRotationalFlow(const perspectiveCamera& cam,
+    const float3& w, const int height, const int width) {
+
+    float maxflow = 0.0f;
+
+    for(int j = 0; j < 3; j ++) {
+        for(int i = 0; i < 3; i ++) {
+
+            // same field as rotationalOpticalFlow_k
+            const float x = 0.5f*i*(width - 1);
+            const float y = 0.5f*j*(height - 1);
+
+            const float px = (x - cam.centerX) / cam.alphaX;
+            const float py = (y - cam.centerY) / cam.alphaY;
+
+            // w x (px, py, 1)
+            const float cx = w.y - w.z*py;
+            const float cy = w.z*px - w.x;
+            const float cz = w.x*py - w.y*px;
+
+            const float flowX = cam.alphaX*cx + (cam.centerX - x)*cz;
+            const float flowY = cam.alphaY*cy + (cam.centerY - y)*cz;
+
+            maxflow = std::max(maxflow, std::sqrt(flowX*flowX + flowY*flowY));
+        }
+    }
+
+    return maxflow;
+}
+
+
 } // namespace gpu
 } // namespace flowfilter
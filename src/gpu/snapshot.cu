@@ -0,0 +1,138 @@
+/**
+ * \file snapshot.cu
+ * \brief Triple buffer of flow snapshots shared with reader threads.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+
+#include "flowfilter/gpu/snapshot.h"
+
+namespace flowfilter {
+namespace gpu {
+
+/** flag of the shared slot index telling it has not been acquired yet */
+const int SNAPSHOT_FRESH = 4;
+
+/** mask of the slot index */
+const int SNAPSHOT_INDEX = 3;
+
+
+struct FlowSnapshotBuffer::state_t {
+
+    flowfilter::gpu::GPUImage slots[3];
+    std::uint64_t sequence[3];
+
+    /** index of the shared slot, plus SNAPSHOT_FRESH if published and not acquired */
+    std::atomic<int> shared;
+
+    /** slot owned by the writer */
+    int back;
+
+    /** slot owned by the reader */
+    int front;
+
+    /** sequence number of the last published snapshot */
+    std::atomic<std::uint64_t> published;
+};
+
+
+FlowSnapshotBuffer::FlowSnapshotBuffer() {
+    // unallocated buffer
+}
+
+
+FlowSnapshotBuffer::FlowSnapshotBuffer(const int height, const int width) :
+    __state(std::make_shared<state_t>()) {
+
+    for(int n = 0; n < 3; n ++) {
+        __state->slots[n] = GPUImage(height, width, 2, sizeof(float));
+        __state->slots[n].clear();
+        __state->sequence[n] = 0;
+    }
+
+    __state->back = 0;
+    __state->shared.store(1);
+    __state->front = 2;
+    __state->published.store(0);
+}
+
+
+void FlowSnapshotBuffer::publish(GPUImage& flow) {
+
+    if(!__state) {
+        std::cerr << "ERROR: FlowSnapshotBuffer::publish(): buffer not allocated" << std::endl;
+        throw std::logic_error("FlowSnapshotBuffer::publish(): buffer not allocated");
+    }
+
+    state_t& s = *__state;
+
+    // synchronous copy, the slot content is complete before publishing
+    s.slots[s.back].copyFrom(flow);
+
+    std::uint64_t sequence = s.published.load(std::memory_order_relaxed) + 1;
+    s.sequence[s.back] = sequence;
+
+    // release the back slot content, take the previous shared slot
+    s.back = s.shared.exchange(s.back | SNAPSHOT_FRESH, std::memory_order_acq_rel) & SNAPSHOT_INDEX;
+    s.published.store(sequence, std::memory_order_release);
+}
+
+
+bool FlowSnapshotBuffer::acquire() {
+
+    if(!__state) {
+        return false;
+    }
+
+    state_t& s = *__state;
+
+    if((s.shared.load(std::memory_order_acquire) & SNAPSHOT_FRESH) == 0) {
+        return false;
+    }
+
+    // acquire the shared slot content, give back the front slot
+    s.front = s.shared.exchange(s.front, std::memory_order_acq_rel) & SNAPSHOT_INDEX;
+    return true;
+}
+
+
+GPUImage FlowSnapshotBuffer::getFlow() {
+
+    if(!__state) {
+        std::cerr << "ERROR: FlowSnapshotBuffer::getFlow(): buffer not allocated" << std::endl;
+        throw std::logic_error("FlowSnapshotBuffer::getFlow(): buffer not allocated");
+    }
+
+    return __state->slots[__state->front];
+}
+
+
+void FlowSnapshotBuffer::downloadFlow(flowfilter::image_t& flow) {
+
+    getFlow().download(flow);
+}
+
+
+std::uint64_t FlowSnapshotBuffer::getSequence() const {
+
+    return __state? __state->sequence[__state->front] : 0;
+}
+
+
+std::uint64_t FlowSnapshotBuffer::getPublished() const {
+
+    return __state? __state->published.load(std::memory_order_acquire) : 0;
+}
+
+
+bool FlowSnapshotBuffer::isAllocated() const {
+
+    return bool(__state);
+}
+
+}; // namespace gpu
+}; // namespace flowfilter
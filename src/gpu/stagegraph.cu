@@ -0,0 +1,486 @@
+/**
+ * \file stagegraph.cu
+ * \brief Declarative assembly of pipeline stages.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "flowfilter/gpu/stagegraph.h"
+#include "flowfilter/gpu/footprint.h"
+
+namespace flowfilter {
+namespace gpu {
+
+
+StageGraph::StageGraph() {
+    // nothing to do
+}
+
+
+StageGraph::~StageGraph() {
+    // nothing to do
+}
+
+
+int StageGraph::addNode(const std::string& name, Stage* stage, const bool configured) {
+
+    if(name.empty() || name.find('.') != std::string::npos) {
+        std::cerr << "ERROR: StageGraph::addNode(): invalid node name: " << name << std::endl;
+        throw std::invalid_argument("StageGraph::addNode(): invalid node name: " + name);
+    }
+
+    if(findNode(name) != -1) {
+        std::cerr << "ERROR: StageGraph::addNode(): node already exists: " << name << std::endl;
+        throw std::invalid_argument("StageGraph::addNode(): node already exists: " + name);
+    }
+
+    if(stage == nullptr) {
+        std::cerr << "ERROR: StageGraph::addNode(): null stage: " << name << std::endl;
+        throw std::invalid_argument("StageGraph::addNode(): null stage: " + name);
+    }
+
+    node_t node;
+    node.name = name;
+    node.stage = stage;
+    node.configured = configured;
+    __nodes.push_back(node);
+
+    return int(__nodes.size()) - 1;
+}
+
+
+void StageGraph::addInput(const std::string& node, const std::string& port,
+    const portType_t& type, inputBinder_t bind, const bool rebindable) {
+
+    const int n = findNode(node);
+    if(n == -1) {
+        std::cerr << "ERROR: StageGraph::addInput(): unknown node: " << node << std::endl;
+        throw std::invalid_argument("StageGraph::addInput(): unknown node: " + node);
+    }
+
+    if(__nodes[n].configured) {
+        std::cerr << "ERROR: StageGraph::addInput(): node is already configured: " << node << std::endl;
+        throw std::invalid_argument("StageGraph::addInput(): node is already configured: " + node);
+    }
+
+    for(const port_t& p : __nodes[n].inputs) {
+        if(p.name == port) {
+            std::cerr << "ERROR: StageGraph::addInput(): port already exists: " << node << "." << port << std::endl;
+            throw std::invalid_argument("StageGraph::addInput(): port already exists: " + node + "." + port);
+        }
+    }
+
+    port_t p;
+    p.name = port;
+    p.type = type;
+    p.bind = bind;
+    p.rebindable = rebindable;
+    p.edge = -1;
+    __nodes[n].inputs.push_back(p);
+}
+
+
+void StageGraph::addOutput(const std::string& node, const std::string& port,
+    const portType_t& type, outputGetter_t get) {
+
+    const int n = findNode(node);
+    if(n == -1) {
+        std::cerr << "ERROR: StageGraph::addOutput(): unknown node: " << node << std::endl;
+        throw std::invalid_argument("StageGraph::addOutput(): unknown node: " + node);
+    }
+
+    for(const port_t& p : __nodes[n].outputs) {
+        if(p.name == port) {
+            std::cerr << "ERROR: StageGraph::addOutput(): port already exists: " << node << "." << port << std::endl;
+            throw std::invalid_argument("StageGraph::addOutput(): port already exists: " + node + "." + port);
+        }
+    }
+
+    port_t p;
+    p.name = port;
+    p.type = type;
+    p.get = get;
+    p.rebindable = false;
+    p.edge = -1;
+    __nodes[n].outputs.push_back(p);
+}
+
+
+void StageGraph::connect(const std::string& output, const std::string& input) {
+    addEdge(output, input, false);
+}
+
+
+void StageGraph::connectLoop(const std::string& output, const std::string& input) {
+    addEdge(output, input, true);
+}
+
+
+void StageGraph::feed(GPUImage image, const std::string& input) {
+
+    int toNode, toPort;
+    findPort(input, true, toNode, toPort);
+
+    edge_t edge;
+    edge.fromNode = -1;
+    edge.fromPort = -1;
+    edge.toNode = toNode;
+    edge.toPort = toPort;
+    edge.loop = false;
+    edge.image = image;
+
+    connectInput(toNode, toPort, int(__edges.size()));
+    __edges.push_back(edge);
+}
+
+
+void StageGraph::require(const std::string& output) {
+
+    int node, port;
+    findPort(output, false, node, port);
+    __required.push_back(std::make_pair(node, port));
+}
+
+
+stagePlan_t StageGraph::plan() const {
+
+    const int N = int(__nodes.size());
+
+    if(__required.empty()) {
+        std::cerr << "ERROR: StageGraph::plan(): no output is required" << std::endl;
+        throw std::logic_error("StageGraph::plan(): no output is required");
+    }
+
+    stagePlan_t plan;
+    plan.live = std::vector<bool>(N, false);
+    for(const node_t& node : __nodes) {
+        plan.names.push_back(node.name);
+    }
+
+    // live nodes, walking edges backwards from the required outputs
+    std::vector<int> pending;
+    for(const std::pair<int, int>& r : __required) {
+        if(!plan.live[r.first]) {
+            plan.live[r.first] = true;
+            pending.push_back(r.first);
+        }
+    }
+
+    while(!pending.empty()) {
+
+        const int n = pending.back();
+        pending.pop_back();
+
+        for(const port_t& p : __nodes[n].inputs) {
+
+            if(p.edge == -1) {
+                std::cerr << "ERROR: StageGraph::plan(): input not connected: "
+                    << __nodes[n].name << "." << p.name << std::endl;
+                throw std::logic_error("StageGraph::plan(): input not connected: "
+                    + __nodes[n].name + "." + p.name);
+            }
+
+            const int from = __edges[p.edge].fromNode;
+            if(from != -1 && !plan.live[from]) {
+                plan.live[from] = true;
+                pending.push_back(from);
+            }
+        }
+    }
+
+    // execution order over regular edges. Among ready nodes, the
+    // one added first runs first. The wave of a node is one plus
+    // the deepest wave among its producers.
+    std::vector<int> wave(N, 0);
+    std::vector<bool> placed(N, false);
+    int liveCount = int(std::count(plan.live.begin(), plan.live.end(), true));
+
+    while(int(plan.order.size()) < liveCount) {
+
+        int next = -1;
+        for(int n = 0; n < N && next == -1; n ++) {
+
+            if(!plan.live[n] || placed[n]) continue;
+
+            bool ready = true;
+            for(const port_t& p : __nodes[n].inputs) {
+                const edge_t& e = __edges[p.edge];
+                if(!e.loop && e.fromNode != -1 && !placed[e.fromNode]) {
+                    ready = false;
+                    break;
+                }
+            }
+
+            if(ready) next = n;
+        }
+
+        if(next == -1) {
+            std::cerr << "ERROR: StageGraph::plan(): regular edges form a cycle" << std::endl;
+            throw std::logic_error("StageGraph::plan(): regular edges form a cycle");
+        }
+
+        for(const port_t& p : __nodes[next].inputs) {
+            const edge_t& e = __edges[p.edge];
+            if(!e.loop && e.fromNode != -1) {
+                wave[next] = std::max(wave[next], wave[e.fromNode] + 1);
+            }
+        }
+
+        placed[next] = true;
+        plan.order.push_back(next);
+
+        if(wave[next] >= int(plan.waves.size())) {
+            plan.waves.resize(wave[next] + 1);
+        }
+        plan.waves[wave[next]].push_back(next);
+    }
+
+    for(const int e : planConfiguration(plan)) {
+        const edge_t& edge = __edges[e];
+        const node_t& node = __nodes[edge.toNode];
+        const port_t& port = node.inputs[edge.toPort];
+
+        placeholder_t placeholder;
+        placeholder.input = node.name + "." + port.name;
+        placeholder.type = port.type;
+        plan.placeholders.push_back(placeholder);
+    }
+
+    return plan;
+}
+
+
+stagePlan_t StageGraph::configure() {
+
+    stagePlan_t plan = this->plan();
+    const std::vector<int> deferred = planConfiguration(plan);
+
+    for(const int n : plan.configureOrder) {
+
+        node_t& node = __nodes[n];
+        if(node.configured) continue;
+
+        for(port_t& port : node.inputs) {
+
+            const edge_t& edge = __edges[port.edge];
+
+            if(std::find(deferred.begin(), deferred.end(), port.edge) != deferred.end()) {
+                // released once the input is set to the producer output
+                port.bind(GPUImage(port.type.height, port.type.width,
+                    port.type.depth, port.type.itemSize));
+
+            } else if(edge.fromNode == -1) {
+                port.bind(edge.image);
+
+            } else {
+                port.bind(edgeOutput(port.edge));
+            }
+        }
+
+        node.stage->configure();
+    }
+
+    for(const int e : deferred) {
+        const edge_t& edge = __edges[e];
+        __nodes[edge.toNode].inputs[edge.toPort].bind(edgeOutput(e));
+    }
+
+    return plan;
+}
+
+
+int StageGraph::findNode(const std::string& name) const {
+
+    for(std::size_t n = 0; n < __nodes.size(); n ++) {
+        if(__nodes[n].name == name) {
+            return int(n);
+        }
+    }
+
+    return -1;
+}
+
+
+void StageGraph::findPort(const std::string& address, const bool input,
+    int& node, int& port) const {
+
+    const std::size_t dot = address.find('.');
+    node = dot == std::string::npos? -1 : findNode(address.substr(0, dot));
+    port = -1;
+
+    if(node != -1) {
+        const std::string name = address.substr(dot + 1);
+        const std::vector<port_t>& ports = input? __nodes[node].inputs : __nodes[node].outputs;
+
+        for(std::size_t p = 0; p < ports.size(); p ++) {
+            if(ports[p].name == name) {
+                port = int(p);
+                break;
+            }
+        }
+    }
+
+    if(port == -1) {
+        const std::string kind = input? "input" : "output";
+        std::cerr << "ERROR: StageGraph::findPort(): unknown " << kind << ": " << address << std::endl;
+        throw std::invalid_argument("StageGraph::findPort(): unknown " + kind + ": " + address);
+    }
+}
+
+
+void StageGraph::addEdge(const std::string& output, const std::string& input, const bool loop) {
+
+    int fromNode, fromPort, toNode, toPort;
+    findPort(output, false, fromNode, fromPort);
+    findPort(input, true, toNode, toPort);
+
+    const portType_t& a = __nodes[fromNode].outputs[fromPort].type;
+    const portType_t& b = __nodes[toNode].inputs[toPort].type;
+
+    if(a.height != b.height || a.width != b.width || a.depth != b.depth || a.itemSize != b.itemSize) {
+        std::cerr << "ERROR: StageGraph::addEdge(): port types do not match: "
+            << output << " -> " << input << std::endl;
+        throw std::invalid_argument("StageGraph::addEdge(): port types do not match: "
+            + output + " -> " + input);
+    }
+
+    edge_t edge;
+    edge.fromNode = fromNode;
+    edge.fromPort = fromPort;
+    edge.toNode = toNode;
+    edge.toPort = toPort;
+    edge.loop = loop;
+
+    connectInput(toNode, toPort, int(__edges.size()));
+    __edges.push_back(edge);
+}
+
+
+void StageGraph::connectInput(const int node, const int port, const int edge) {
+
+    port_t& p = __nodes[node].inputs[port];
+
+    if(p.edge != -1) {
+        std::cerr << "ERROR: StageGraph::connectInput(): input already connected: "
+            << __nodes[node].name << "." << p.name << std::endl;
+        throw std::invalid_argument("StageGraph::connectInput(): input already connected: "
+            + __nodes[node].name + "." + p.name);
+    }
+
+    p.edge = edge;
+}
+
+
+std::vector<int> StageGraph::planConfiguration(stagePlan_t& plan) const {
+
+    const int N = int(__nodes.size());
+
+    std::vector<int> deferred;
+    std::vector<bool> placed(N, false);
+    plan.configureOrder.clear();
+
+    while(plan.configureOrder.size() < plan.order.size()) {
+
+        // first node in execution order whose producers, through
+        // regular and loop carried edges, are configured
+        int next = -1;
+        for(const int n : plan.order) {
+
+            if(placed[n]) continue;
+
+            bool ready = true;
+            for(const port_t& p : __nodes[n].inputs) {
+                const int from = __edges[p.edge].fromNode;
+                if(from != -1 && !placed[from]) {
+                    ready = false;
+                    break;
+                }
+            }
+
+            if(ready) {
+                next = n;
+                break;
+            }
+        }
+
+        // otherwise, the first node whose unconfigured producers
+        // are all connected to rebindable inputs
+        if(next == -1) {
+            for(const int n : plan.order) {
+
+                if(placed[n]) continue;
+
+                bool breakable = true;
+                for(const port_t& p : __nodes[n].inputs) {
+                    const int from = __edges[p.edge].fromNode;
+                    if(from != -1 && !placed[from] && !p.rebindable) {
+                        breakable = false;
+                        break;
+                    }
+                }
+
+                if(breakable) {
+                    next = n;
+                    break;
+                }
+            }
+
+            if(next == -1) {
+                std::cerr << "ERROR: StageGraph::planConfiguration(): cycle without rebindable input" << std::endl;
+                throw std::logic_error("StageGraph::planConfiguration(): cycle without rebindable input");
+            }
+
+            for(const port_t& p : __nodes[next].inputs) {
+                const int from = __edges[p.edge].fromNode;
+                if(from != -1 && !placed[from]) {
+                    deferred.push_back(p.edge);
+                }
+            }
+        }
+
+        placed[next] = true;
+        plan.configureOrder.push_back(next);
+    }
+
+    return deferred;
+}
+
+
+GPUImage StageGraph::edgeOutput(const int edge) {
+
+    const edge_t& e = __edges[edge];
+    const node_t& node = __nodes[e.fromNode];
+    const port_t& port = node.outputs[e.fromPort];
+
+    GPUImage image = port.get();
+
+    if(image.height() != port.type.height || image.width() != port.type.width
+        || image.depth() != port.type.depth || image.itemSize() != port.type.itemSize) {
+
+        std::cerr << "ERROR: StageGraph::edgeOutput(): output does not match its port type: "
+            << node.name << "." << port.name << std::endl;
+        throw std::logic_error("StageGraph::edgeOutput(): output does not match its port type: "
+            + node.name + "." + port.name);
+    }
+
+    return image;
+}
+
+
+void appendPlaceholders(std::vector<bufferInfo_t>& buffers,
+    const stagePlan_t& plan, const std::string& stage, const int level) {
+
+    for(const placeholder_t& p : plan.placeholders) {
+        buffers.push_back(describeConfigureBuffer(stage, level, p.input,
+            p.type.height, p.type.width, p.type.depth, p.type.itemSize));
+    }
+}
+
+
+}; // namespace gpu
+}; // namespace flowfilter
@@ -7,16 +7,62 @@
 
 #include <iostream>
 #include <exception>
+#include <stdexcept>
+#include <string>
 
 #include "flowfilter/gpu/util.h"
 #include "flowfilter/gpu/error.h"
 #include "flowfilter/gpu/update.h"
 #include "flowfilter/gpu/device/update_k.h"
+#include "flowfilter/gpu/footprint.h"
 
 namespace flowfilter {
 namespace gpu {
 
 
+/**
+ * \brief computes residual statistics from the histogram and sum downloaded from the device.
+ */
+static residualStats_t computeResidualStats(GPUImage& residualHistogram,
+    GPUImage& residualSum, const float residualRange, const std::size_t pixels) {
+
+    unsigned int histogram[RESIDUAL_HISTOGRAM_BINS];
+    float sum = 0.0f;
+
+    image_t histogramHost = {1, RESIDUAL_HISTOGRAM_BINS, 1,
+        sizeof(histogram), sizeof(unsigned int), histogram};
+    image_t sumHost = {1, 1, 1, sizeof(float), sizeof(float), &sum};
+
+    residualHistogram.download(histogramHost);
+    residualSum.download(sumHost);
+
+    residualStats_t stats = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    if(pixels == 0) {
+        return stats;
+    }
+
+    const float binWidth = residualRange / RESIDUAL_HISTOGRAM_BINS;
+    const float percentiles[3] = {0.5f, 0.9f, 0.99f};
+    float* outputs[3] = {&stats.p50, &stats.p90, &stats.p99};
+
+    std::size_t accum = 0;
+    int p = 0;
+    for(int b = 0; b < RESIDUAL_HISTOGRAM_BINS && p < 3; b ++) {
+        accum += histogram[b];
+        while(p < 3 && accum >= percentiles[p]*pixels) {
+            // bin center, the last bin reports the range limit
+            *outputs[p] = b == RESIDUAL_HISTOGRAM_BINS - 1? residualRange : (b + 0.5f)*binWidth;
+            p ++;
+        }
+    }
+
+    stats.mean = sum / pixels;
+    stats.saturated = float(histogram[RESIDUAL_HISTOGRAM_BINS - 1]) / pixels;
+
+    return stats;
+}
+
+
 FlowUpdate::FlowUpdate() :
     Stage() {
 
@@ -26,6 +72,9 @@ FlowUpdate::FlowUpdate() :
     __inputImageGradientSet = false;
     __gamma = 1.0;
     __maxflow = 1.0;
+    __timeStep = 1.0f;
+    __computeResidual = false;
+    __residualRange = 1.0f;
 }
 
 
@@ -40,6 +89,9 @@ FlowUpdate::FlowUpdate(GPUImage inputFlow,
     __inputFlowSet = false;
     __inputImageSet = false;
     __inputImageGradientSet = false;
+    __computeResidual = false;
+    __residualRange = 1.0f;
+    __timeStep = 1.0f;
     
     setGamma(gamma);
     setMaxFlow(maxflow);
@@ -86,6 +138,10 @@ void FlowUpdate::configure() {
     __flowUpdated = GPUImage(height, width, 2, sizeof(float));
     __imageUpdated = GPUImage(height, width, 1, sizeof(float));
 
+    // residual histogram and sum
+    __residualHistogram = GPUImage(1, RESIDUAL_HISTOGRAM_BINS, 1, sizeof(unsigned int));
+    __residualSum = GPUImage(1, 1, 1, sizeof(float));
+
     // configure block and grid sizes
     __block = dim3(32, 32, 1);
     configureKernelGrid(height, width, __block, __grid);
@@ -103,6 +159,11 @@ void FlowUpdate::compute() {
         exit(-1);
     }
 
+    if(__computeResidual) {
+        cudaMemsetAsync(__residualHistogram.data(), 0, __residualHistogram.pitch(), __stream);
+        cudaMemsetAsync(__residualSum.data(), 0, __residualSum.pitch(), __stream);
+    }
+
     flowUpdate_k<<<__grid, __block, 0, __stream>>>(
         __inputImage.wrap<float>(),
         __inputImageGradient.wrap<float2>(),
@@ -110,12 +171,40 @@ void FlowUpdate::compute() {
         __inputFlow.wrap<float2>(),
         __imageUpdated.wrap<float>(),
         __flowUpdated.wrap<float2>(),
-        __gamma, __maxflow);
+        __gamma, __maxflow, __timeStep,
+        __computeResidual, __residualRange,
+        __residualHistogram.wrap<unsigned int>(),
+        __residualSum.wrap<float>());
 
     stopTiming();
 }
 
 
+memoryTraffic_t FlowUpdate::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__inputFlow.height()) * __inputFlow.width();
+
+    memoryTraffic_t traffic;
+
+    // flowUpdate_k reads image gradient, image, old image and old flow,
+    // and writes the updated flow and image.
+    traffic.bytesRead = pixels * (2*sizeof(float) + sizeof(float) + sizeof(float) + 2*sizeof(float));
+    traffic.bytesWritten = pixels * (2*sizeof(float) + sizeof(float));
+
+    return traffic;
+}
+
+
+void FlowUpdate::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    // the updated image is read as old image in next call to compute()
+    buffers.push_back(describeBuffer("FlowUpdate", level, "flowUpdated", __flowUpdated));
+    buffers.push_back(describeBuffer("FlowUpdate", level, "imageUpdated", __imageUpdated, true));
+}
+
+
 float FlowUpdate::getGamma() const {
     return __gamma;
 }
@@ -143,6 +232,60 @@ void FlowUpdate::setMaxFlow(const float maxflow) {
 }
 
 
+float FlowUpdate::getTimeStep() const {
+    return __timeStep;
+}
+
+
+void FlowUpdate::setTimeStep(const float timeStep) {
+
+    if(!(timeStep > 0.0f)) {
+        std::cerr << "ERROR: FlowUpdate::setTimeStep(): time step should be greater than zero: " << timeStep << std::endl;
+        throw std::invalid_argument("FlowUpdate::setTimeStep(): time step should be greater than zero, got: " + std::to_string(timeStep));
+    }
+
+    __timeStep = timeStep;
+}
+
+void FlowUpdate::setComputeResidual(const bool computeResidual) {
+    __computeResidual = computeResidual;
+}
+
+
+bool FlowUpdate::getComputeResidual() const {
+    return __computeResidual;
+}
+
+
+void FlowUpdate::setResidualRange(const float residualRange) {
+
+    if(residualRange <= 0) {
+        std::cerr << "ERROR: FlowUpdate::setResidualRange(): residual range should be greater than zero: " << residualRange << std::endl;
+        throw std::exception();
+    }
+
+    __residualRange = residualRange;
+}
+
+
+float FlowUpdate::getResidualRange() const {
+    return __residualRange;
+}
+
+
+residualStats_t FlowUpdate::getResidualStats() {
+
+    if(!__configured || !__computeResidual) {
+        std::cerr << "ERROR: FlowUpdate::getResidualStats(): residual computation not enabled" << std::endl;
+        throw std::exception();
+    }
+
+    std::size_t pixels = std::size_t(__flowUpdated.height()) * __flowUpdated.width();
+    return computeResidualStats(__residualHistogram, __residualSum, __residualRange, pixels);
+}
+
+
+
 void FlowUpdate::setInputFlow(GPUImage inputFlow) {
 
     if(inputFlow.depth() != 2) {
@@ -223,6 +366,9 @@ DeltaFlowUpdate::DeltaFlowUpdate() :
 
     __gamma = 1.0;
     __maxflow = 1.0;
+    __timeStep = 1.0f;
+    __computeResidual = false;
+    __residualRange = 1.0f;
     __configured = false;
     __inputDeltaFlowSet = false;
     __inputImageOldSet = false;
@@ -247,6 +393,9 @@ DeltaFlowUpdate::DeltaFlowUpdate(GPUImage inputFlow,
     __inputFlowSet = false;
     __inputImageSet = false;
     __inputImageGradientSet = false;
+    __computeResidual = false;
+    __residualRange = 1.0f;
+    __timeStep = 1.0f;
 
     setGamma(gamma);
     setMaxFlow(maxflow);
@@ -317,6 +466,10 @@ void DeltaFlowUpdate::configure() {
     __deltaFlowUpdated = GPUImage(height, width, 2, sizeof(float));
     __imageUpdated = GPUImage(height, width, 1, sizeof(float));
 
+    // residual histogram and sum
+    __residualHistogram = GPUImage(1, RESIDUAL_HISTOGRAM_BINS, 1, sizeof(unsigned int));
+    __residualSum = GPUImage(1, 1, 1, sizeof(float));
+
     // configure block and grid sizes
     __block = dim3(32, 32, 1);
     configureKernelGrid(height, width, __block, __grid);
@@ -334,6 +487,11 @@ void DeltaFlowUpdate::compute() {
         exit(-1);
     }
 
+    if(__computeResidual) {
+        cudaMemsetAsync(__residualHistogram.data(), 0, __residualHistogram.pitch(), __stream);
+        cudaMemsetAsync(__residualSum.data(), 0, __residualSum.pitch(), __stream);
+    }
+
     deltaFlowUpdate_k<<<__grid, __block, 0, __stream>>> (
         __inputImage.wrap<float>(),
         __inputImageGradient.wrap<float2>(),
@@ -343,11 +501,42 @@ void DeltaFlowUpdate::compute() {
         __imageUpdated.wrap<float>(),
         __deltaFlowUpdated.wrap<float2>(),
         __flowUpdated.wrap<float2>(),
-        __gamma, __maxflow);
+        __gamma, __maxflow, __timeStep,
+        __computeResidual, __residualRange,
+        __residualHistogram.wrap<unsigned int>(),
+        __residualSum.wrap<float>());
 
     stopTiming();
 }
 
+memoryTraffic_t DeltaFlowUpdate::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__inputDeltaFlow.height()) * __inputDeltaFlow.width();
+    std::size_t pixelsUp = std::size_t(__inputFlow.height()) * __inputFlow.width();
+
+    memoryTraffic_t traffic;
+
+    // deltaFlowUpdate_k reads image gradient, image, old image and old
+    // delta flow at this level plus the flow of the level above. It
+    // writes the updated image, delta flow and flow.
+    traffic.bytesRead = pixels * (2*sizeof(float) + sizeof(float) + sizeof(float) + 2*sizeof(float))
+        + pixelsUp * 2*sizeof(float);
+    traffic.bytesWritten = pixels * (sizeof(float) + 2*sizeof(float) + 2*sizeof(float));
+
+    return traffic;
+}
+
+
+void DeltaFlowUpdate::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("DeltaFlowUpdate", level, "flowUpdated", __flowUpdated));
+    buffers.push_back(describeBuffer("DeltaFlowUpdate", level, "deltaFlowUpdated", __deltaFlowUpdated));
+    buffers.push_back(describeBuffer("DeltaFlowUpdate", level, "imageUpdated", __imageUpdated));
+}
+
+
 float DeltaFlowUpdate::getGamma() const {
     return __gamma;
 }
@@ -374,6 +563,60 @@ void DeltaFlowUpdate::setMaxFlow(const float maxflow) {
 }
 
 
+float DeltaFlowUpdate::getTimeStep() const {
+    return __timeStep;
+}
+
+
+void DeltaFlowUpdate::setTimeStep(const float timeStep) {
+
+    if(!(timeStep > 0.0f)) {
+        std::cerr << "ERROR: DeltaFlowUpdate::setTimeStep(): time step should be greater than zero: " << timeStep << std::endl;
+        throw std::invalid_argument("DeltaFlowUpdate::setTimeStep(): time step should be greater than zero, got: " + std::to_string(timeStep));
+    }
+
+    __timeStep = timeStep;
+}
+
+void DeltaFlowUpdate::setComputeResidual(const bool computeResidual) {
+    __computeResidual = computeResidual;
+}
+
+
+bool DeltaFlowUpdate::getComputeResidual() const {
+    return __computeResidual;
+}
+
+
+void DeltaFlowUpdate::setResidualRange(const float residualRange) {
+
+    if(residualRange <= 0) {
+        std::cerr << "ERROR: DeltaFlowUpdate::setResidualRange(): residual range should be greater than zero: " << residualRange << std::endl;
+        throw std::exception();
+    }
+
+    __residualRange = residualRange;
+}
+
+
+float DeltaFlowUpdate::getResidualRange() const {
+    return __residualRange;
+}
+
+
+residualStats_t DeltaFlowUpdate::getResidualStats() {
+
+    if(!__configured || !__computeResidual) {
+        std::cerr << "ERROR: DeltaFlowUpdate::getResidualStats(): residual computation not enabled" << std::endl;
+        throw std::exception();
+    }
+
+    std::size_t pixels = std::size_t(__flowUpdated.height()) * __flowUpdated.width();
+    return computeResidualStats(__residualHistogram, __residualSum, __residualRange, pixels);
+}
+
+
+
 void DeltaFlowUpdate::setInputFlow(GPUImage inputFlow) {
 
     if(inputFlow.depth() != 2) {
@@ -0,0 +1,209 @@
+/**
+ * \file upsampling.cu
+ * \brief Guided upsampling of optical flow fields.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "flowfilter/gpu/util.h"
+#include "flowfilter/gpu/upsampling.h"
+#include "flowfilter/gpu/device/upsampling_k.h"
+#include "flowfilter/gpu/footprint.h"
+
+
+namespace flowfilter {
+namespace gpu {
+
+
+JointBilateralUpsampler::JointBilateralUpsampler() :
+    Stage() {
+
+    __configured = false;
+    __inputFlowSet = false;
+    __guideCoarseSet = false;
+    __guideSet = false;
+    __sigmaSpace = 1.0f;
+    __sigmaRange = 0.1f;
+}
+
+
+JointBilateralUpsampler::JointBilateralUpsampler(GPUImage inputFlow,
+    GPUImage guideCoarse, GPUImage guide) :
+    JointBilateralUpsampler() {
+
+    setInputFlow(inputFlow);
+    setGuideCoarse(guideCoarse);
+    setGuide(guide);
+    configure();
+}
+
+
+JointBilateralUpsampler::~JointBilateralUpsampler() {
+    // nothing to do
+}
+
+
+void JointBilateralUpsampler::configure() {
+
+    if(!__inputFlowSet) {
+        std::cerr << "ERROR: JointBilateralUpsampler::configure(): input flow not set" << std::endl;
+        throw std::logic_error("JointBilateralUpsampler::configure(): input flow not set");
+    }
+
+    if(!__guideCoarseSet || !__guideSet) {
+        std::cerr << "ERROR: JointBilateralUpsampler::configure(): guide images not set" << std::endl;
+        throw std::logic_error("JointBilateralUpsampler::configure(): guide images not set");
+    }
+
+    if(__guideCoarse.height() != __inputFlow.height() || __guideCoarse.width() != __inputFlow.width()) {
+        std::cerr << "ERROR: JointBilateralUpsampler::configure(): coarse guide and input flow shapes do not match" << std::endl;
+        throw std::invalid_argument("JointBilateralUpsampler::configure(): coarse guide and input flow shapes do not match");
+    }
+
+    __upsampledFlow = GPUImage(__guide.height(), __guide.width(), 2, sizeof(float));
+
+    // configure block and grid sizes
+    __block = dim3(32, 32, 1);
+    configureKernelGrid(__guide.height(), __guide.width(),
+        __block, __grid);
+
+    __configured = true;
+}
+
+
+void JointBilateralUpsampler::compute() {
+
+    startTiming();
+
+    if(!__configured) {
+        std::cerr << "ERROR: JointBilateralUpsampler::compute(): Stage not configured" << std::endl;
+        throw std::logic_error("JointBilateralUpsampler::compute(): stage not configured");
+    }
+
+    const float2 scale = make_float2(float(__guide.width()) / __inputFlow.width(),
+        float(__guide.height()) / __inputFlow.height());
+
+    jointBilateralUpsample_k<<<__grid, __block, 0, __stream>>>(
+        __inputFlow.wrap<float2>(),
+        __guideCoarse.wrap<unsigned char>(),
+        __guide.wrap<unsigned char>(),
+        scale,
+        1.0f / (__sigmaSpace*__sigmaSpace),
+        1.0f / (__sigmaRange*__sigmaRange),
+        __upsampledFlow.wrap<float2>());
+
+    stopTiming();
+}
+
+
+memoryTraffic_t JointBilateralUpsampler::memoryTraffic() const {
+
+    std::size_t pixels = std::size_t(__guide.height()) * __guide.width();
+    std::size_t coarsePixels = std::size_t(__inputFlow.height()) * __inputFlow.width();
+
+    memoryTraffic_t traffic;
+
+    // neighborhoods of adjacent output pixels overlap, each
+    // coarse pixel is read from memory about once
+    traffic.bytesRead = pixels * sizeof(unsigned char)
+        + coarsePixels * (2*sizeof(float) + sizeof(unsigned char));
+
+    traffic.bytesWritten = pixels * 2*sizeof(float);
+
+    return traffic;
+}
+
+
+void JointBilateralUpsampler::appendBuffers(std::vector<bufferInfo_t>& buffers, const int level) {
+
+    if(!__configured) return;
+
+    buffers.push_back(describeBuffer("JointBilateralUpsampler", level, "upsampledFlow", __upsampledFlow));
+}
+
+
+void JointBilateralUpsampler::setInputFlow(GPUImage inputFlow) {
+
+    if(inputFlow.depth() != 2 || inputFlow.itemSize() != sizeof(float)) {
+        std::cerr << "ERROR: JointBilateralUpsampler::setInputFlow(): input flow should be float with depth 2" << std::endl;
+        throw std::invalid_argument("JointBilateralUpsampler::setInputFlow(): input flow should be float with depth 2");
+    }
+
+    __inputFlow = inputFlow;
+    __inputFlowSet = true;
+}
+
+
+void JointBilateralUpsampler::setGuideCoarse(GPUImage guideCoarse) {
+
+    checkGuide("setGuideCoarse", guideCoarse);
+
+    __guideCoarse = guideCoarse;
+    __guideCoarseSet = true;
+}
+
+
+void JointBilateralUpsampler::setGuide(GPUImage guide) {
+
+    checkGuide("setGuide", guide);
+
+    __guide = guide;
+    __guideSet = true;
+}
+
+
+GPUImage JointBilateralUpsampler::getUpsampledFlow() {
+    return __upsampledFlow;
+}
+
+
+float JointBilateralUpsampler::getSigmaSpace() const {
+    return __sigmaSpace;
+}
+
+
+void JointBilateralUpsampler::setSigmaSpace(const float sigma) {
+
+    if(!(sigma > 0.0f)) {
+        std::cerr << "ERROR: JointBilateralUpsampler::setSigmaSpace(): sigma should be greater than zero: " << sigma << std::endl;
+        throw std::invalid_argument("JointBilateralUpsampler::setSigmaSpace(): sigma should be greater than zero, got: "
+            + std::to_string(sigma));
+    }
+
+    __sigmaSpace = sigma;
+}
+
+
+float JointBilateralUpsampler::getSigmaRange() const {
+    return __sigmaRange;
+}
+
+
+void JointBilateralUpsampler::setSigmaRange(const float sigma) {
+
+    if(!(sigma > 0.0f)) {
+        std::cerr << "ERROR: JointBilateralUpsampler::setSigmaRange(): sigma should be greater than zero: " << sigma << std::endl;
+        throw std::invalid_argument("JointBilateralUpsampler::setSigmaRange(): sigma should be greater than zero, got: "
+            + std::to_string(sigma));
+    }
+
+    __sigmaRange = sigma;
+}
+
+
+void JointBilateralUpsampler::checkGuide(const char* method, GPUImage& guide) const {
+
+    if(guide.depth() != 1 || guide.itemSize() != sizeof(unsigned char)) {
+        std::cerr << "ERROR: JointBilateralUpsampler::" << method << "(): guide should be uint8 with depth 1" << std::endl;
+        throw std::invalid_argument(std::string("JointBilateralUpsampler::") + method
+            + "(): guide should be uint8 with depth 1");
+    }
+}
+
+
+}; // namespace gpu
+}; // namespace flowfilter
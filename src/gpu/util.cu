@@ -7,6 +7,8 @@
 
 
 #include "flowfilter/gpu/util.h"
+#include "flowfilter/gpu/error.h"
+#include "flowfilter/gpu/image.h"
 
 namespace flowfilter {
     namespace gpu {
@@ -27,5 +29,41 @@ namespace flowfilter {
             grid.z = 1;
         }
 
+
+        float measurePeakBandwidth(const int height, const int width,
+            const int repetitions) {
+
+            GPUImage src(height, width, 1, sizeof(float));
+            GPUImage dst(height, width, 1, sizeof(float));
+            src.clear();
+
+            // warm up copy, not timed
+            dst.copyFrom(src);
+
+            cudaEvent_t start, stop;
+            checkError(cudaEventCreate(&start));
+            checkError(cudaEventCreate(&stop));
+
+            checkError(cudaEventRecord(start, 0));
+            for(int n = 0; n < repetitions; n ++) {
+                checkError(cudaMemcpy2DAsync(dst.data(), dst.pitch(),
+                    src.data(), src.pitch(), width*sizeof(float), height,
+                    cudaMemcpyDeviceToDevice, 0));
+            }
+            checkError(cudaEventRecord(stop, 0));
+            checkError(cudaEventSynchronize(stop));
+
+            float elapsed = 0.0f;
+            checkError(cudaEventElapsedTime(&elapsed, start, stop));
+
+            checkError(cudaEventDestroy(start));
+            checkError(cudaEventDestroy(stop));
+
+            // each copy reads and writes the whole image
+            double bytes = 2.0 * double(repetitions) * height * width * sizeof(float);
+
+            return elapsed > 0.0f? float(bytes / (double(elapsed) * 1e6)) : 0.0f;
+        }
+
     }; // namespace gpu
 }; // namespace flowfilter
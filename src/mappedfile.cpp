@@ -0,0 +1,91 @@
+/**
+ * \file mappedfile.cpp
+ * \brief Read only memory mapped files.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "flowfilter/mappedfile.h"
+
+namespace flowfilter {
+
+MappedFile::MappedFile(const std::string& path) :
+    __path(path), __fd(-1), __data(nullptr), __size(0) {
+
+#if defined(_WIN32)
+    std::cerr << "ERROR: MappedFile::MappedFile(): memory mapped files not supported on Windows" << std::endl;
+    throw std::logic_error("MappedFile::MappedFile(): memory mapped files not supported on Windows");
+#else
+    __fd = open(path.c_str(), O_RDONLY);
+    if(__fd < 0) {
+        std::cerr << "ERROR: MappedFile::MappedFile(): cannot open " << path << ": " << std::strerror(errno) << std::endl;
+        throw std::runtime_error("MappedFile::MappedFile(): cannot open " + path + ": " + std::string(std::strerror(errno)));
+    }
+
+    struct stat st;
+    if(fstat(__fd, &st) != 0) {
+        std::cerr << "ERROR: MappedFile::MappedFile(): fstat failed: " << std::strerror(errno) << std::endl;
+        close(__fd);
+        throw std::runtime_error("MappedFile::MappedFile(): fstat failed: " + std::string(std::strerror(errno)));
+    }
+
+    __size = static_cast<std::size_t>(st.st_size);
+
+    // mmap of zero bytes is not valid, empty files map to nullptr
+    if(__size > 0) {
+        void* data = mmap(nullptr, __size, PROT_READ, MAP_PRIVATE, __fd, 0);
+        if(data == MAP_FAILED) {
+            std::cerr << "ERROR: MappedFile::MappedFile(): mmap failed: " << std::strerror(errno) << std::endl;
+            close(__fd);
+            throw std::runtime_error("MappedFile::MappedFile(): mmap failed: " + std::string(std::strerror(errno)));
+        }
+
+        // files are read sequentially, from start to end
+        madvise(data, __size, MADV_SEQUENTIAL);
+        __data = data;
+    }
+#endif
+}
+
+
+MappedFile::~MappedFile() {
+
+#if !defined(_WIN32)
+    if(__data != nullptr) {
+        munmap(const_cast<void*>(__data), __size);
+    }
+
+    if(__fd >= 0) {
+        close(__fd);
+    }
+#endif
+}
+
+
+const void* MappedFile::data() const {
+    return __data;
+}
+
+
+std::size_t MappedFile::size() const {
+    return __size;
+}
+
+
+std::string MappedFile::path() const {
+    return __path;
+}
+
+}; // namespace flowfilter
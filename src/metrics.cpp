@@ -0,0 +1,431 @@
+/**
+ * \file metrics.cpp
+ * \brief Live metrics export through a shared memory page.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "flowfilter/metrics.h"
+
+namespace flowfilter {
+
+/**
+ * \brief Layout of the shared memory page.
+ *
+ * sequence is odd while the publisher is writing metrics.
+ */
+typedef struct {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t size;
+    std::atomic<std::uint32_t> sequence;
+    metrics_t metrics;
+} metricsPage_t;
+
+
+static void copyName(char* dst, const std::string& src) {
+    std::strncpy(dst, src.c_str(), METRICS_NAME_LENGTH - 1);
+    dst[METRICS_NAME_LENGTH - 1] = '\0';
+}
+
+
+static float percentile(std::vector<float>& samples, const float p) {
+
+    std::size_t k = std::size_t(p * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+    return samples[k];
+}
+
+
+//#################################################
+// MetricsPublisher
+//#################################################
+MetricsPublisher::MetricsPublisher(const std::string& name,
+    const float publishRate, const int latencySamples) {
+
+    if(name.empty() || name[0] != '/') {
+        std::cerr << "ERROR: MetricsPublisher::MetricsPublisher(): name should start with '/': " << name << std::endl;
+        throw std::invalid_argument("MetricsPublisher::MetricsPublisher(): name should start with '/', got: " + name);
+    }
+
+    if(latencySamples <= 0) {
+        std::cerr << "ERROR: MetricsPublisher::MetricsPublisher(): latencySamples should be greater than zero: " << latencySamples << std::endl;
+        throw std::invalid_argument("MetricsPublisher::MetricsPublisher(): latencySamples should be greater than zero, got: " + std::to_string(latencySamples));
+    }
+
+    __name = name;
+    __fd = -1;
+    __page = nullptr;
+    __latencySamples = latencySamples;
+    __frameCount = 0;
+    __lastFrameCount = 0;
+    __lastPublish = std::chrono::steady_clock::now();
+    std::memset(&__flowStats, 0, sizeof(flowStatistics_t));
+    std::memset(&__metrics, 0, sizeof(metrics_t));
+    setPublishRate(publishRate);
+
+#if defined(_WIN32)
+    std::cerr << "ERROR: MetricsPublisher::MetricsPublisher(): shared memory metrics not supported on Windows" << std::endl;
+    throw std::logic_error("MetricsPublisher::MetricsPublisher(): shared memory metrics not supported on Windows");
+#else
+    __fd = shm_open(__name.c_str(), O_CREAT | O_RDWR, 0644);
+    if(__fd < 0) {
+        std::cerr << "ERROR: MetricsPublisher::MetricsPublisher(): shm_open failed: " << std::strerror(errno) << std::endl;
+        throw std::runtime_error("MetricsPublisher::MetricsPublisher(): shm_open failed: " + std::string(std::strerror(errno)));
+    }
+
+    if(ftruncate(__fd, sizeof(metricsPage_t)) != 0) {
+        std::cerr << "ERROR: MetricsPublisher::MetricsPublisher(): ftruncate failed: " << std::strerror(errno) << std::endl;
+        close(__fd);
+        shm_unlink(__name.c_str());
+        throw std::runtime_error("MetricsPublisher::MetricsPublisher(): ftruncate failed");
+    }
+
+    __page = mmap(nullptr, sizeof(metricsPage_t), PROT_READ | PROT_WRITE, MAP_SHARED, __fd, 0);
+    if(__page == MAP_FAILED) {
+        std::cerr << "ERROR: MetricsPublisher::MetricsPublisher(): mmap failed: " << std::strerror(errno) << std::endl;
+        close(__fd);
+        shm_unlink(__name.c_str());
+        throw std::runtime_error("MetricsPublisher::MetricsPublisher(): mmap failed");
+    }
+
+    metricsPage_t* page = static_cast<metricsPage_t*>(__page);
+    page->sequence.store(0, std::memory_order_relaxed);
+    std::memset(&page->metrics, 0, sizeof(metrics_t));
+    page->version = METRICS_VERSION;
+    page->size = sizeof(metricsPage_t);
+
+    // readers check the magic number before anything else
+    std::atomic_thread_fence(std::memory_order_release);
+    page->magic = METRICS_MAGIC;
+#endif
+}
+
+
+MetricsPublisher::~MetricsPublisher() {
+
+#if !defined(_WIN32)
+    if(__page != nullptr) {
+        munmap(__page, sizeof(metricsPage_t));
+    }
+
+    if(__fd >= 0) {
+        close(__fd);
+        shm_unlink(__name.c_str());
+    }
+#endif
+}
+
+
+void MetricsPublisher::recordFrame() {
+    __frameCount ++;
+}
+
+
+void MetricsPublisher::recordStageLatency(const std::string& stage,
+    const int level, const float latency) {
+
+    for(latencyRing_t& ring : __stages) {
+        if(ring.level == level && ring.name == stage) {
+            ring.samples[ring.next] = latency;
+            ring.next = (ring.next + 1) % ring.samples.size();
+            ring.count = std::min(ring.count + 1, ring.samples.size());
+            return;
+        }
+    }
+
+    // new stage, ignored if the page is full
+    if(int(__stages.size()) == METRICS_MAX_STAGES) {
+        return;
+    }
+
+    latencyRing_t ring;
+    ring.name = stage;
+    ring.level = level;
+    ring.samples.resize(__latencySamples);
+    ring.samples[0] = latency;
+    ring.next = 1 % __latencySamples;
+    ring.count = 1;
+    __stages.push_back(ring);
+}
+
+
+void MetricsPublisher::setQueue(const std::string& name, const int depth,
+    const int capacity, const std::uint64_t drops) {
+
+    for(queueMetrics_t& queue : __queues) {
+        if(name.compare(0, METRICS_NAME_LENGTH - 1, queue.name) == 0) {
+            queue.depth = depth;
+            queue.capacity = capacity;
+            queue.drops = drops;
+            return;
+        }
+    }
+
+    if(int(__queues.size()) == METRICS_MAX_QUEUES) {
+        return;
+    }
+
+    queueMetrics_t queue;
+    copyName(queue.name, name);
+    queue.depth = depth;
+    queue.capacity = capacity;
+    queue.drops = drops;
+    __queues.push_back(queue);
+}
+
+
+void MetricsPublisher::setFlowStatistics(const flowStatistics_t& stats) {
+    __flowStats = stats;
+}
+
+
+bool MetricsPublisher::publishDue() const {
+
+    if(__publishRate <= 0.0f) {
+        return false;
+    }
+
+    std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - __lastPublish;
+    return elapsed.count() * __publishRate >= 1.0f;
+}
+
+
+bool MetricsPublisher::publish() {
+
+    if(!publishDue()) {
+        return false;
+    }
+
+    publishNow();
+    return true;
+}
+
+
+void MetricsPublisher::publishNow() {
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::chrono::duration<float> elapsed = now - __lastPublish;
+
+    // fill metrics in host memory
+    __metrics.publishCount ++;
+    __metrics.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    __metrics.frameCount = __frameCount;
+    __metrics.frameRate = elapsed.count() > 0.0f?
+        (__frameCount - __lastFrameCount) / elapsed.count() : 0.0f;
+
+    __metrics.stageCount = __stages.size();
+    for(std::size_t s = 0; s < __stages.size(); s ++) {
+
+        const latencyRing_t& ring = __stages[s];
+        stageMetrics_t& stage = __metrics.stages[s];
+
+        copyName(stage.name, ring.name);
+        stage.level = ring.level;
+        stage.samples = ring.count;
+
+        __sortBuffer.assign(ring.samples.begin(), ring.samples.begin() + ring.count);
+
+        float sum = 0.0f;
+        for(float v : __sortBuffer) sum += v;
+        stage.mean = sum / ring.count;
+        stage.max = *std::max_element(__sortBuffer.begin(), __sortBuffer.end());
+        stage.p50 = percentile(__sortBuffer, 0.50f);
+        stage.p90 = percentile(__sortBuffer, 0.90f);
+        stage.p99 = percentile(__sortBuffer, 0.99f);
+    }
+
+    __metrics.queueCount = __queues.size();
+    std::copy(__queues.begin(), __queues.end(), __metrics.queues);
+
+    __metrics.flow = __flowStats;
+
+    __lastPublish = now;
+    __lastFrameCount = __frameCount;
+
+    // seqlock write
+    if(__page != nullptr) {
+
+        metricsPage_t* page = static_cast<metricsPage_t*>(__page);
+
+        std::uint32_t seq = page->sequence.load(std::memory_order_relaxed);
+        page->sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::memcpy(&page->metrics, &__metrics, sizeof(metrics_t));
+
+        page->sequence.store(seq + 2, std::memory_order_release);
+    }
+}
+
+
+std::string MetricsPublisher::getName() const {
+    return __name;
+}
+
+
+float MetricsPublisher::getPublishRate() const {
+    return __publishRate;
+}
+
+
+void MetricsPublisher::setPublishRate(const float publishRate) {
+
+    if(publishRate < 0.0f) {
+        std::cerr << "ERROR: MetricsPublisher::setPublishRate(): publish rate should be greater or equal zero: " << publishRate << std::endl;
+        throw std::invalid_argument("MetricsPublisher::setPublishRate(): publish rate should be greater or equal zero, got: " + std::to_string(publishRate));
+    }
+
+    __publishRate = publishRate;
+}
+
+
+//#################################################
+// MetricsReader
+//#################################################
+MetricsReader::MetricsReader(const std::string& name) {
+
+    __name = name;
+    __fd = -1;
+    __page = nullptr;
+
+#if defined(_WIN32)
+    std::cerr << "ERROR: MetricsReader::MetricsReader(): shared memory metrics not supported on Windows" << std::endl;
+    throw std::logic_error("MetricsReader::MetricsReader(): shared memory metrics not supported on Windows");
+#else
+    __fd = shm_open(__name.c_str(), O_RDONLY, 0);
+    if(__fd < 0) {
+        std::cerr << "ERROR: MetricsReader::MetricsReader(): shm_open failed: " << std::strerror(errno) << std::endl;
+        throw std::runtime_error("MetricsReader::MetricsReader(): shm_open failed: " + std::string(std::strerror(errno)));
+    }
+
+    struct stat st;
+    if(fstat(__fd, &st) != 0 || std::size_t(st.st_size) < sizeof(metricsPage_t)) {
+        std::cerr << "ERROR: MetricsReader::MetricsReader(): metrics page too small or uninitialized" << std::endl;
+        close(__fd);
+        throw std::runtime_error("MetricsReader::MetricsReader(): metrics page too small or uninitialized");
+    }
+
+    void* page = mmap(nullptr, sizeof(metricsPage_t), PROT_READ, MAP_SHARED, __fd, 0);
+    if(page == MAP_FAILED) {
+        std::cerr << "ERROR: MetricsReader::MetricsReader(): mmap failed: " << std::strerror(errno) << std::endl;
+        close(__fd);
+        throw std::runtime_error("MetricsReader::MetricsReader(): mmap failed");
+    }
+    __page = page;
+
+    const metricsPage_t* p = static_cast<const metricsPage_t*>(__page);
+    if(p->magic != METRICS_MAGIC || p->version != METRICS_VERSION || p->size != sizeof(metricsPage_t)) {
+        std::cerr << "ERROR: MetricsReader::MetricsReader(): incompatible metrics page version: " << p->version << std::endl;
+        munmap(page, sizeof(metricsPage_t));
+        close(__fd);
+        throw std::runtime_error("MetricsReader::MetricsReader(): incompatible metrics page");
+    }
+#endif
+}
+
+
+MetricsReader::~MetricsReader() {
+
+#if !defined(_WIN32)
+    if(__page != nullptr) {
+        munmap(const_cast<void*>(__page), sizeof(metricsPage_t));
+    }
+
+    if(__fd >= 0) {
+        close(__fd);
+    }
+#endif
+}
+
+
+bool MetricsReader::read(metrics_t& metrics, const int retries) const {
+
+    const metricsPage_t* page = static_cast<const metricsPage_t*>(__page);
+
+    for(int r = 0; r < retries; r ++) {
+
+        std::uint32_t seq0 = page->sequence.load(std::memory_order_acquire);
+        if(seq0 & 1) {
+            // write in progress
+            continue;
+        }
+
+        std::memcpy(&metrics, &page->metrics, sizeof(metrics_t));
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        std::uint32_t seq1 = page->sequence.load(std::memory_order_relaxed);
+        if(seq0 == seq1) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+//#################################################
+// Flow statistics
+//#################################################
+flowStatistics_t computeFlowStatistics(const flowfilter::image_t& flow,
+    const int stride) {
+
+    if(flow.depth != 2 || flow.itemSize != sizeof(float)) {
+        std::cerr << "ERROR: computeFlowStatistics(): expecting float image with depth 2" << std::endl;
+        throw std::invalid_argument("computeFlowStatistics(): expecting float image with depth 2");
+    }
+
+    if(stride <= 0) {
+        std::cerr << "ERROR: computeFlowStatistics(): stride should be greater than zero: " << stride << std::endl;
+        throw std::invalid_argument("computeFlowStatistics(): stride should be greater than zero, got: " + std::to_string(stride));
+    }
+
+    double sumX = 0.0, sumY = 0.0, sumMag = 0.0;
+    float maxMag = 0.0f;
+    std::size_t N = 0;
+
+    for(int r = 0; r < flow.height; r += stride) {
+
+        const float* row = reinterpret_cast<const float*>(
+            static_cast<const unsigned char*>(flow.data) + r*flow.pitch);
+
+        for(int c = 0; c < flow.width; c += stride) {
+
+            float u = row[2*c];
+            float v = row[2*c + 1];
+            float mag = std::sqrt(u*u + v*v);
+
+            sumX += u;
+            sumY += v;
+            sumMag += mag;
+            maxMag = std::max(maxMag, mag);
+            N ++;
+        }
+    }
+
+    flowStatistics_t stats;
+    stats.meanX = N > 0? float(sumX / N) : 0.0f;
+    stats.meanY = N > 0? float(sumY / N) : 0.0f;
+    stats.meanMagnitude = N > 0? float(sumMag / N) : 0.0f;
+    stats.maxMagnitude = maxMag;
+
+    return stats;
+}
+
+}; // namespace flowfilter
@@ -0,0 +1,441 @@
+/**
+ * \file recording.cpp
+ * \brief Recording and replay of timestamped input frames.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "flowfilter/recording.h"
+
+namespace flowfilter {
+
+
+/** offsets of the header fields following the tag */
+static const std::size_t HEADER_VERSION = sizeof(RECORDING_TAG);
+static const std::size_t HEADER_SHAPE = HEADER_VERSION + sizeof(std::int32_t);
+
+
+/**
+ * \brief size of a frame record, padded to RECORDING_ALIGNMENT.
+ */
+static std::size_t recordSize(const int height, const int width,
+    const int depth, const std::size_t itemSize) {
+
+    const std::size_t size = RECORDING_FRAME_HEADER_SIZE
+        + std::size_t(height) * width * depth * itemSize;
+
+    return (size + RECORDING_ALIGNMENT - 1) / RECORDING_ALIGNMENT * RECORDING_ALIGNMENT;
+}
+
+
+//#################################################
+// FrameRecorder
+//#################################################
+FrameRecorder::FrameRecorder(const std::string& path,
+    const int height, const int width,
+    const int depth, const std::size_t itemSize,
+    const int queueLength) :
+    __path(path), __file(nullptr) {
+
+    if(height <= 0 || width <= 0 || depth <= 0 || itemSize == 0) {
+        std::cerr << "ERROR: FrameRecorder::FrameRecorder(): invalid frame shape: [" << height << ", "
+            << width << ", " << depth << "][" << itemSize << "]" << std::endl;
+        throw std::invalid_argument("FrameRecorder::FrameRecorder(): invalid frame shape: [" +
+            std::to_string(height) + ", " + std::to_string(width) + ", " + std::to_string(depth) + "][" +
+            std::to_string(itemSize) + "]");
+    }
+
+    if(queueLength < 1) {
+        std::cerr << "ERROR: FrameRecorder::FrameRecorder(): queue length should be greater than zero: "
+            << queueLength << std::endl;
+        throw std::invalid_argument("FrameRecorder::FrameRecorder(): queue length should be greater than zero, got: "
+            + std::to_string(queueLength));
+    }
+
+    __height = height;
+    __width = width;
+    __depth = depth;
+    __itemSize = itemSize;
+    __recordSize = recordSize(height, width, depth, itemSize);
+
+    __file = std::fopen(path.c_str(), "wb");
+    if(__file == nullptr) {
+        std::cerr << "ERROR: FrameRecorder::FrameRecorder(): cannot create " << path << ": " << std::strerror(errno) << std::endl;
+        throw std::runtime_error("FrameRecorder::FrameRecorder(): cannot create " + path + ": " + std::string(std::strerror(errno)));
+    }
+
+    unsigned char header[RECORDING_HEADER_SIZE] = {0};
+    const std::int32_t fields[5] = {RECORDING_VERSION, height, width, depth, std::int32_t(itemSize)};
+
+    std::memcpy(header, RECORDING_TAG, sizeof(RECORDING_TAG));
+    std::memcpy(header + HEADER_VERSION, fields, sizeof(fields));
+
+    if(std::fwrite(header, 1, RECORDING_HEADER_SIZE, __file) != RECORDING_HEADER_SIZE) {
+        std::cerr << "ERROR: FrameRecorder::FrameRecorder(): cannot write header to " << path << std::endl;
+        std::fclose(__file);
+        throw std::runtime_error("FrameRecorder::FrameRecorder(): cannot write header to " + path);
+    }
+
+    __started = false;
+    __recorded = 0;
+    __dropped = 0;
+
+    __slots.resize(queueLength);
+    for(int n = 0; n < queueLength; n ++) {
+        __slots[n].resize(__recordSize, 0);
+        __free.push_back(n);
+    }
+
+    __closing = false;
+    __closed = false;
+    __failed = false;
+
+    __writer = std::thread(&FrameRecorder::writerLoop, this);
+}
+
+
+FrameRecorder::~FrameRecorder() {
+
+    try {
+        close();
+    } catch(const std::exception&) {
+        // already reported by close()
+    }
+}
+
+
+bool FrameRecorder::record(const image_t& image, const double timestamp) {
+
+    const std::chrono::steady_clock::time_point arrival = std::chrono::steady_clock::now();
+
+    if(image.height != __height || image.width != __width ||
+        image.depth != __depth || image.itemSize != __itemSize) {
+
+        std::cerr << "ERROR: FrameRecorder::record(): shapes do not match. required: [" << __height << ", "
+            << __width << ", " << __depth << "][" << __itemSize << "], passed: [" << image.height << ", "
+            << image.width << ", " << image.depth << "][" << image.itemSize << "]" << std::endl;
+        throw std::invalid_argument("FrameRecorder::record(): shapes do not match. Required: [" +
+            std::to_string(__height) + ", " + std::to_string(__width) + ", " + std::to_string(__depth) + "][" +
+            std::to_string(__itemSize) + "], passed: [" + std::to_string(image.height) + ", " +
+            std::to_string(image.width) + ", " + std::to_string(image.depth) + "][" + std::to_string(image.itemSize) + "]");
+    }
+
+    int slot;
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+
+        if(__closing || __closed) {
+            std::cerr << "ERROR: FrameRecorder::record(): recorder closed" << std::endl;
+            throw std::logic_error("FrameRecorder::record(): recorder closed");
+        }
+
+        // arrival times are relative to the first frame
+        if(!__started) {
+            __start = arrival;
+            __started = true;
+        }
+
+        if(__free.empty()) {
+            __dropped ++;
+            return false;
+        }
+
+        slot = __free.front();
+        __free.pop_front();
+        __recorded ++;
+    }
+
+    // fill the slot without holding the lock
+    unsigned char* record = __slots[slot].data();
+
+    const std::int64_t arrivalTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        arrival - __start).count();
+
+    std::memcpy(record, &timestamp, sizeof(double));
+    std::memcpy(record + sizeof(double), &arrivalTime, sizeof(std::int64_t));
+
+    const std::size_t rowBytes = std::size_t(__width) * __depth * __itemSize;
+    unsigned char* rows = record + RECORDING_FRAME_HEADER_SIZE;
+
+    for(int r = 0; r < __height; r ++) {
+        std::memcpy(rows + r*rowBytes,
+            static_cast<const unsigned char*>(image.data) + r*image.pitch, rowBytes);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+        __queued.push_back(slot);
+    }
+
+    __queuedCondition.notify_one();
+    return true;
+}
+
+
+bool FrameRecorder::record(const image_t& image) {
+
+    const double timestamp = std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    return record(image, timestamp);
+}
+
+
+void FrameRecorder::close() {
+
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+
+        if(__closing || __closed) {
+            return;
+        }
+
+        __closing = true;
+    }
+
+    __queuedCondition.notify_one();
+    __writer.join();
+
+    bool failed = __failed;
+    if(std::fclose(__file) != 0) {
+        failed = true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+        __closed = true;
+        __failed = failed;
+    }
+
+    if(failed) {
+        std::cerr << "ERROR: FrameRecorder::close(): failed writing frames to " << __path << std::endl;
+        throw std::runtime_error("FrameRecorder::close(): failed writing frames to " + __path);
+    }
+}
+
+
+int FrameRecorder::recordedFrames() const {
+
+    std::lock_guard<std::mutex> lock(__mutex);
+    return __recorded;
+}
+
+
+int FrameRecorder::droppedFrames() const {
+
+    std::lock_guard<std::mutex> lock(__mutex);
+    return __dropped;
+}
+
+
+std::string FrameRecorder::path() const {
+    return __path;
+}
+
+
+void FrameRecorder::writerLoop() {
+
+    std::unique_lock<std::mutex> lock(__mutex);
+
+    while(true) {
+
+        __queuedCondition.wait(lock, [this]{ return !__queued.empty() || __closing; });
+
+        // closing and every queued frame written
+        if(__queued.empty()) {
+            return;
+        }
+
+        const int slot = __queued.front();
+        __queued.pop_front();
+        const bool failed = __failed;
+
+        lock.unlock();
+
+        // after a failed write, frames are discarded so that
+        // the file stays valid up to its last complete frame
+        bool written = false;
+        if(!failed) {
+            written = std::fwrite(__slots[slot].data(), 1, __recordSize, __file) == __recordSize;
+        }
+
+        lock.lock();
+
+        if(!failed && !written) {
+            __failed = true;
+        }
+
+        __free.push_back(slot);
+    }
+}
+
+
+//#################################################
+// FrameReplayer
+//#################################################
+FrameReplayer::FrameReplayer(const std::string& path) :
+    __file(path) {
+
+    if(__file.size() < RECORDING_HEADER_SIZE) {
+        std::cerr << "ERROR: FrameReplayer::FrameReplayer(): file too small: " << path << std::endl;
+        throw std::runtime_error("FrameReplayer::FrameReplayer(): file too small: " + path);
+    }
+
+    const unsigned char* header = static_cast<const unsigned char*>(__file.data());
+
+    if(std::memcmp(header, RECORDING_TAG, sizeof(RECORDING_TAG)) != 0) {
+        std::cerr << "ERROR: FrameReplayer::FrameReplayer(): wrong tag in " << path << std::endl;
+        throw std::runtime_error("FrameReplayer::FrameReplayer(): wrong tag in " + path);
+    }
+
+    std::int32_t version;
+    std::int32_t shape[4];
+    std::memcpy(&version, header + HEADER_VERSION, sizeof(std::int32_t));
+    std::memcpy(shape, header + HEADER_SHAPE, sizeof(shape));
+
+    if(version != RECORDING_VERSION) {
+        std::cerr << "ERROR: FrameReplayer::FrameReplayer(): unsupported version in " << path << ": " << version << std::endl;
+        throw std::runtime_error("FrameReplayer::FrameReplayer(): unsupported version in " + path
+            + ": " + std::to_string(version));
+    }
+
+    if(shape[0] <= 0 || shape[1] <= 0 || shape[2] <= 0 || shape[3] <= 0) {
+        std::cerr << "ERROR: FrameReplayer::FrameReplayer(): invalid frame shape in " << path << std::endl;
+        throw std::runtime_error("FrameReplayer::FrameReplayer(): invalid frame shape in " + path);
+    }
+
+    __height = shape[0];
+    __width = shape[1];
+    __depth = shape[2];
+    __itemSize = std::size_t(shape[3]);
+    __recordSize = recordSize(__height, __width, __depth, __itemSize);
+
+    // an incomplete last record is ignored
+    __frames = int((__file.size() - RECORDING_HEADER_SIZE) / __recordSize);
+    __lateFrames = 0;
+}
+
+
+int FrameReplayer::replay(replayCallback_t callback, void* userData, const float speed) {
+
+    if(!(speed >= 0.0f)) {
+        std::cerr << "ERROR: FrameReplayer::replay(): speed should be greater or equal zero: " << speed << std::endl;
+        throw std::invalid_argument("FrameReplayer::replay(): speed should be greater or equal zero, got: "
+            + std::to_string(speed));
+    }
+
+    __lateFrames = 0;
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for(int k = 0; k < __frames; k ++) {
+
+        const unsigned char* record = frameRecord("replay", k);
+
+        if(speed > 0.0f) {
+
+            std::int64_t arrivalTime;
+            std::memcpy(&arrivalTime, record + sizeof(double), sizeof(std::int64_t));
+
+            const std::chrono::steady_clock::time_point arrival = start +
+                std::chrono::nanoseconds(std::int64_t(arrivalTime / double(speed)));
+
+            // the first frame defines the start of the replay
+            if(k > 0 && std::chrono::steady_clock::now() > arrival) {
+                __lateFrames ++;
+            } else {
+                std::this_thread::sleep_until(arrival);
+            }
+        }
+
+        if(!callback(k, frame(k), timestamp(k), userData)) {
+            return k + 1;
+        }
+    }
+
+    return __frames;
+}
+
+
+int FrameReplayer::lateFrames() const {
+    return __lateFrames;
+}
+
+
+image_t FrameReplayer::frame(const int index) const {
+
+    const unsigned char* record = frameRecord("frame", index);
+
+    image_t img;
+    img.height = __height;
+    img.width = __width;
+    img.depth = __depth;
+    img.itemSize = __itemSize;
+    img.pitch = std::size_t(__width) * __depth * __itemSize;
+    img.data = const_cast<unsigned char*>(record + RECORDING_FRAME_HEADER_SIZE);
+
+    return img;
+}
+
+
+double FrameReplayer::timestamp(const int index) const {
+
+    double timestamp;
+    std::memcpy(&timestamp, frameRecord("timestamp", index), sizeof(double));
+
+    return timestamp;
+}
+
+
+double FrameReplayer::arrivalTime(const int index) const {
+
+    std::int64_t arrivalTime;
+    std::memcpy(&arrivalTime, frameRecord("arrivalTime", index) + sizeof(double), sizeof(std::int64_t));
+
+    return arrivalTime * 1e-9;
+}
+
+
+int FrameReplayer::frames() const {
+    return __frames;
+}
+
+
+int FrameReplayer::height() const {
+    return __height;
+}
+
+
+int FrameReplayer::width() const {
+    return __width;
+}
+
+
+int FrameReplayer::depth() const {
+    return __depth;
+}
+
+
+std::size_t FrameReplayer::itemSize() const {
+    return __itemSize;
+}
+
+
+const unsigned char* FrameReplayer::frameRecord(const std::string& method, const int index) const {
+
+    if(index < 0 || index >= __frames) {
+        std::cerr << "ERROR: FrameReplayer::" << method << "(): frame index out of bounds: " << index << std::endl;
+        throw std::invalid_argument("FrameReplayer::" + method + "(): frame index out of bounds, got: "
+            + std::to_string(index) + ", frames: " + std::to_string(__frames));
+    }
+
+    return static_cast<const unsigned char*>(__file.data())
+        + RECORDING_HEADER_SIZE + std::size_t(index) * __recordSize;
+}
+
+}; // namespace flowfilter
@@ -0,0 +1,368 @@
+/**
+ * \file sampler.cpp
+ * \brief Host image sampler with the semantics of GPU textures.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "flowfilter/sampler.h"
+
+namespace flowfilter {
+
+/** number of fractional bits of the linear interpolation weights */
+static const float LINEAR_WEIGHT_STEPS = 256.0f;
+
+
+/**
+ * \brief returns the pixel row y of an image.
+ */
+template<typename T>
+static inline const T* imageRow(const image_t& image, const int y) {
+    return reinterpret_cast<const T*>(static_cast<const char*>(image.data) + y*image.pitch);
+}
+
+
+/**
+ * \brief bounds a coordinate to [-2, n + 1], NaN mapping to -2.
+ *
+ * Beyond these bounds both linear taps fall outside the image on
+ * the same side, so the sample does not change, and the integer
+ * part and the interpolation weight are defined for any float.
+ */
+static inline float boundCoordinate(const float c, const int n) {
+    return c >= -2.0f? std::min(c, float(n + 1)) : -2.0f;
+}
+
+
+/**
+ * \brief rounds a linear interpolation weight to 8 fractional bits,
+ *      as the texture units do.
+ */
+static inline float quantizeWeight(const float w) {
+    return std::floor(w*LINEAR_WEIGHT_STEPS + 0.5f) * (1.0f / LINEAR_WEIGHT_STEPS);
+}
+
+
+/**
+ * \brief gathers count pixels at clamped indices (ix, iy), writing
+ *      zero where valid is zero.
+ */
+template<typename T>
+static void gather(const image_t& image, const int count,
+    const int* ix, const int* iy, const float* valid,
+    const float scale, float* out) {
+
+    const int depth = image.depth;
+
+    for(int k = 0; k < count; k ++) {
+
+        const T* pixel = imageRow<T>(image, iy[k]) + ix[k]*depth;
+
+        for(int c = 0; c < depth; c ++) {
+            out[k*depth + c] = valid[k] != 0.0f? scale*float(pixel[c]) : 0.0f;
+        }
+    }
+}
+
+
+template<typename T>
+static void convert(const T* src, const int count, const float scale, float* out) {
+
+    for(int i = 0; i < count; i ++) {
+        out[i] = scale*float(src[i]);
+    }
+}
+
+
+TextureSampler::TextureSampler() {
+
+    __image.height = 0;
+    __image.width = 0;
+    __image.depth = 0;
+    __image.pitch = 0;
+    __image.itemSize = 0;
+    __image.data = nullptr;
+
+    __addressMode = SAMPLER_ADDRESS_CLAMP;
+    __filterMode = SAMPLER_FILTER_POINT;
+    __readMode = SAMPLER_READ_ELEMENT;
+    __scale = 1.0f;
+}
+
+
+TextureSampler::TextureSampler(const image_t& image,
+    const samplerAddressMode_t addressMode,
+    const samplerFilterMode_t filterMode,
+    const samplerReadMode_t readMode) {
+
+    if(image.itemSize != sizeof(unsigned char) && image.itemSize != sizeof(float)) {
+        std::cerr << "ERROR: TextureSampler::TextureSampler(): item size should be 1 or 4: " << image.itemSize << std::endl;
+        throw std::invalid_argument("TextureSampler::TextureSampler(): item size should be 1 or 4, got: "
+            + std::to_string(image.itemSize));
+    }
+
+    if(image.depth != 1 && image.depth != 2 && image.depth != 4) {
+        std::cerr << "ERROR: TextureSampler::TextureSampler(): depth should be 1, 2 or 4: " << image.depth << std::endl;
+        throw std::invalid_argument("TextureSampler::TextureSampler(): depth should be 1, 2 or 4, got: "
+            + std::to_string(image.depth));
+    }
+
+    if(image.height <= 0 || image.width <= 0) {
+        std::cerr << "ERROR: TextureSampler::TextureSampler(): empty image" << std::endl;
+        throw std::invalid_argument("TextureSampler::TextureSampler(): empty image");
+    }
+
+    if(filterMode == SAMPLER_FILTER_LINEAR && image.itemSize == sizeof(unsigned char)
+        && readMode == SAMPLER_READ_ELEMENT) {
+
+        std::cerr << "ERROR: TextureSampler::TextureSampler(): linear filtering of uint8 images requires normalized reads" << std::endl;
+        throw std::invalid_argument("TextureSampler::TextureSampler(): linear filtering of uint8 images requires normalized reads");
+    }
+
+    __image = image;
+    __addressMode = addressMode;
+    __filterMode = filterMode;
+    __readMode = readMode;
+
+    // normalized reads only apply to integer images
+    __scale = (readMode == SAMPLER_READ_NORMALIZED && image.itemSize == sizeof(unsigned char))?
+        1.0f / 255.0f : 1.0f;
+}
+
+
+void TextureSampler::fetch(const float x, const float y, float* out) const {
+
+    fetch(1, &x, &y, out);
+}
+
+
+void TextureSampler::fetch(const int count, const float* x, const float* y, float* out) const {
+
+    const int depth = __image.depth;
+
+    for(int k = 0; k < count; k += SAMPLER_BATCH) {
+
+        const int batch = std::min(SAMPLER_BATCH, count - k);
+
+        if(__filterMode == SAMPLER_FILTER_LINEAR) {
+            fetchLinear(batch, x + k, y + k, out + k*depth);
+        } else {
+            fetchPoint(batch, x + k, y + k, out + k*depth);
+        }
+    }
+}
+
+
+void TextureSampler::fetchRow(const int x0, const int y, const int count, float* out) const {
+
+    const int height = __image.height;
+    const int width = __image.width;
+    const int depth = __image.depth;
+
+    if(__filterMode == SAMPLER_FILTER_LINEAR) {
+
+        float xs[SAMPLER_BATCH];
+        float ys[SAMPLER_BATCH];
+
+        for(int k = 0; k < count; k += SAMPLER_BATCH) {
+
+            const int batch = std::min(SAMPLER_BATCH, count - k);
+
+            for(int i = 0; i < batch; i ++) {
+                xs[i] = float(x0 + k + i);
+                ys[i] = float(y);
+            }
+
+            fetchLinear(batch, xs, ys, out + k*depth);
+        }
+
+        return;
+    }
+
+    const bool rowInside = y >= 0 && y < height;
+
+    if(!rowInside && __addressMode == SAMPLER_ADDRESS_BORDER) {
+        std::fill(out, out + count*depth, 0.0f);
+        return;
+    }
+
+    const int row = std::min(std::max(y, 0), height - 1);
+
+    // columns [begin, end) of the output are inside the image
+    const int begin = std::min(std::max(-x0, 0), count);
+    const int end = std::max(std::min(width - x0, count), begin);
+
+    // pixels left and right of the image
+    for(int k = 0; k < begin; k ++) {
+        if(__addressMode == SAMPLER_ADDRESS_BORDER) {
+            std::fill(out + k*depth, out + (k + 1)*depth, 0.0f);
+        } else {
+            convertRow(0, row, 1, out + k*depth);
+        }
+    }
+
+    for(int k = end; k < count; k ++) {
+        if(__addressMode == SAMPLER_ADDRESS_BORDER) {
+            std::fill(out + k*depth, out + (k + 1)*depth, 0.0f);
+        } else {
+            convertRow(width - 1, row, 1, out + k*depth);
+        }
+    }
+
+    if(end > begin) {
+        convertRow(x0 + begin, row, end - begin, out + begin*depth);
+    }
+}
+
+
+void TextureSampler::fetchPoint(const int count, const float* x, const float* y, float* out) const {
+
+    const int height = __image.height;
+    const int width = __image.width;
+    const bool border = __addressMode == SAMPLER_ADDRESS_BORDER;
+
+    int ix[SAMPLER_BATCH];
+    int iy[SAMPLER_BATCH];
+    float valid[SAMPLER_BATCH];
+
+    // indices, branch free
+    for(int k = 0; k < count; k ++) {
+
+        const int i = int(std::floor(boundCoordinate(x[k], width)));
+        const int j = int(std::floor(boundCoordinate(y[k], height)));
+
+        const bool inside = i >= 0 && i < width && j >= 0 && j < height;
+        valid[k] = (inside || !border)? 1.0f : 0.0f;
+
+        ix[k] = std::min(std::max(i, 0), width - 1);
+        iy[k] = std::min(std::max(j, 0), height - 1);
+    }
+
+    if(__image.itemSize == sizeof(unsigned char)) {
+        gather<unsigned char>(__image, count, ix, iy, valid, __scale, out);
+    } else {
+        gather<float>(__image, count, ix, iy, valid, __scale, out);
+    }
+}
+
+
+void TextureSampler::fetchLinear(const int count, const float* x, const float* y, float* out) const {
+
+    const int height = __image.height;
+    const int width = __image.width;
+    const int depth = __image.depth;
+    const bool border = __addressMode == SAMPLER_ADDRESS_BORDER;
+
+    // the four taps of each coordinate, in order
+    // (i, j), (i + 1, j), (i, j + 1), (i + 1, j + 1)
+    int ix[4*SAMPLER_BATCH];
+    int iy[4*SAMPLER_BATCH];
+    float valid[4*SAMPLER_BATCH];
+    float alpha[SAMPLER_BATCH];
+    float beta[SAMPLER_BATCH];
+
+    for(int k = 0; k < count; k ++) {
+
+        // texel centers are at half pixel coordinates
+        const float xb = boundCoordinate(x[k] - 0.5f, width);
+        const float yb = boundCoordinate(y[k] - 0.5f, height);
+
+        const float fx = std::floor(xb);
+        const float fy = std::floor(yb);
+
+        // taps are tested for validity before clamping, so both
+        // taps left of the image read zero with border addressing
+        const int i = int(fx);
+        const int j = int(fy);
+
+        alpha[k] = quantizeWeight(xb - fx);
+        beta[k] = quantizeWeight(yb - fy);
+
+        for(int t = 0; t < 4; t ++) {
+
+            const int ti = i + (t & 1);
+            const int tj = j + (t >> 1);
+
+            const bool inside = ti >= 0 && ti < width && tj >= 0 && tj < height;
+            valid[4*k + t] = (inside || !border)? 1.0f : 0.0f;
+
+            ix[4*k + t] = std::min(std::max(ti, 0), width - 1);
+            iy[4*k + t] = std::min(std::max(tj, 0), height - 1);
+        }
+    }
+
+    float taps[4*SAMPLER_BATCH*4];
+
+    if(__image.itemSize == sizeof(unsigned char)) {
+        gather<unsigned char>(__image, 4*count, ix, iy, valid, __scale, taps);
+    } else {
+        gather<float>(__image, 4*count, ix, iy, valid, __scale, taps);
+    }
+
+    for(int k = 0; k < count; k ++) {
+
+        const float a = alpha[k];
+        const float b = beta[k];
+
+        const float* t00 = taps + (4*k)*depth;
+        const float* t10 = t00 + depth;
+        const float* t01 = t10 + depth;
+        const float* t11 = t01 + depth;
+
+        for(int c = 0; c < depth; c ++) {
+            out[k*depth + c] = (1.0f - a)*(1.0f - b)*t00[c] + a*(1.0f - b)*t10[c]
+                + (1.0f - a)*b*t01[c] + a*b*t11[c];
+        }
+    }
+}
+
+
+void TextureSampler::convertRow(const int x0, const int y, const int count, float* out) const {
+
+    const int depth = __image.depth;
+
+    if(__image.itemSize == sizeof(unsigned char)) {
+        convert(imageRow<unsigned char>(__image, y) + x0*depth, count*depth, __scale, out);
+    } else {
+        convert(imageRow<float>(__image, y) + x0*depth, count*depth, __scale, out);
+    }
+}
+
+
+int TextureSampler::height() const {
+    return __image.height;
+}
+
+
+int TextureSampler::width() const {
+    return __image.width;
+}
+
+
+int TextureSampler::depth() const {
+    return __image.depth;
+}
+
+
+samplerAddressMode_t TextureSampler::addressMode() const {
+    return __addressMode;
+}
+
+
+samplerFilterMode_t TextureSampler::filterMode() const {
+    return __filterMode;
+}
+
+
+samplerReadMode_t TextureSampler::readMode() const {
+    return __readMode;
+}
+
+}; // namespace flowfilter
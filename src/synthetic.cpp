@@ -0,0 +1,635 @@
+/**
+ * \file synthetic.cpp
+ * \brief Synthetic image sequences with ground truth optical flow.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "flowfilter/synthetic.h"
+
+namespace flowfilter {
+
+
+//#################################################
+// Rotation helpers, row major 3x3 matrices
+//#################################################
+
+/**
+ * \brief rotation matrix of the axis-angle vector w (Rodrigues formula).
+ */
+static void expSO3(const float* w, float* R) {
+
+    float theta = std::sqrt(w[0]*w[0] + w[1]*w[1] + w[2]*w[2]);
+
+    if(theta < 1e-12f) {
+        const float I[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+        std::memcpy(R, I, sizeof(I));
+        return;
+    }
+
+    float kx = w[0] / theta, ky = w[1] / theta, kz = w[2] / theta;
+    float c = std::cos(theta), s = std::sin(theta), v = 1.0f - c;
+
+    R[0] = c + kx*kx*v;     R[1] = kx*ky*v - kz*s;  R[2] = kx*kz*v + ky*s;
+    R[3] = ky*kx*v + kz*s;  R[4] = c + ky*ky*v;     R[5] = ky*kz*v - kx*s;
+    R[6] = kz*kx*v - ky*s;  R[7] = kz*ky*v + kx*s;  R[8] = c + kz*kz*v;
+}
+
+
+static void matMul(const float* A, const float* B, float* C) {
+
+    for(int r = 0; r < 3; r ++) {
+        for(int c = 0; c < 3; c ++) {
+            C[3*r + c] = A[3*r]*B[c] + A[3*r + 1]*B[3 + c] + A[3*r + 2]*B[6 + c];
+        }
+    }
+}
+
+
+static void matVec(const float* A, const float* x, float* y) {
+
+    y[0] = A[0]*x[0] + A[1]*x[1] + A[2]*x[2];
+    y[1] = A[3]*x[0] + A[4]*x[1] + A[5]*x[2];
+    y[2] = A[6]*x[0] + A[7]*x[1] + A[8]*x[2];
+}
+
+
+static inline float dot3(const float* a, const float* b) {
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+
+static void matTransposeVec(const float* A, const float* x, float* y) {
+
+    y[0] = A[0]*x[0] + A[3]*x[1] + A[6]*x[2];
+    y[1] = A[1]*x[0] + A[4]*x[1] + A[7]*x[2];
+    y[2] = A[2]*x[0] + A[5]*x[1] + A[8]*x[2];
+}
+
+
+//#################################################
+// Value noise
+//#################################################
+
+/** size of the periodic noise lattice of each plane */
+static const int NOISE_LATTICE_SIZE = 64;
+
+/** texels per texture unit of the baked noise textures */
+static const int NOISE_TEXELS_PER_UNIT = 16;
+
+/** side of the baked noise textures, one lattice period */
+static const int NOISE_TEXTURE_SIZE = NOISE_LATTICE_SIZE*NOISE_TEXELS_PER_UNIT;
+
+
+static inline int fastFloor(const float x) {
+    int i = int(x);
+    return x < i? i - 1 : i;
+}
+
+
+static inline float latticeHash(const int x, const int y, const std::uint32_t seed) {
+
+    std::uint32_t h = std::uint32_t(x)*0x8da6b343u ^ std::uint32_t(y)*0xd8163841u ^ seed*0xcb1ab31fu;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return (h & 0xFFFFFF) * (1.0f / 16777215.0f);
+}
+
+
+/**
+ * \brief value noise interpolated from a periodic lattice table.
+ */
+static inline float valueNoise(const float* lattice, const float u, const float v) {
+
+    const int mask = NOISE_LATTICE_SIZE - 1;
+
+    int x0 = fastFloor(u), y0 = fastFloor(v);
+    float tu = u - x0, tv = v - y0;
+
+    // smoothstep interpolation weights
+    tu = tu*tu*(3.0f - 2.0f*tu);
+    tv = tv*tv*(3.0f - 2.0f*tv);
+
+    const float* row0 = lattice + (y0 & mask)*NOISE_LATTICE_SIZE;
+    const float* row1 = lattice + ((y0 + 1) & mask)*NOISE_LATTICE_SIZE;
+
+    float v00 = row0[x0 & mask];
+    float v01 = row0[(x0 + 1) & mask];
+    float v10 = row1[x0 & mask];
+    float v11 = row1[(x0 + 1) & mask];
+
+    float top = v00 + tu*(v01 - v00);
+    float bottom = v10 + tu*(v11 - v10);
+    return top + tv*(bottom - top);
+}
+
+
+//#################################################
+// SyntheticSequence
+//#################################################
+
+SyntheticSequence::SyntheticSequence(const int height, const int width,
+    const flowfilter::gpu::perspectiveCamera& camera, const int threads) {
+
+    if(height <= 0) {
+        std::cerr << "ERROR: SyntheticSequence::SyntheticSequence(): height should be greater than zero: " << height << std::endl;
+        throw std::invalid_argument("SyntheticSequence::SyntheticSequence(): height should be greater than zero, got: " + std::to_string(height));
+    }
+
+    if(width <= 0) {
+        std::cerr << "ERROR: SyntheticSequence::SyntheticSequence(): width should be greater than zero: " << width << std::endl;
+        throw std::invalid_argument("SyntheticSequence::SyntheticSequence(): width should be greater than zero, got: " + std::to_string(width));
+    }
+
+    __height = height;
+    __width = width;
+    __camera = camera;
+    __noiseOctaves = 4;
+    std::memset(&__motion, 0, sizeof(cameraMotion_t));
+
+    __generation = 0;
+    __pending = 0;
+    __stop = false;
+
+    int N = threads > 0? threads : int(std::thread::hardware_concurrency());
+    N = std::max(1, std::min(N, height));
+    __threadCount = N;
+
+    // the calling thread renders the first band
+    for(int i = 1; i < N; i ++) {
+        __workers.push_back(std::thread(&SyntheticSequence::workerLoop, this, i));
+    }
+
+    reset();
+}
+
+
+SyntheticSequence::~SyntheticSequence() {
+
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+        __stop = true;
+    }
+    __startCondition.notify_all();
+
+    for(std::thread& worker : __workers) {
+        worker.join();
+    }
+}
+
+
+void SyntheticSequence::addPlane(const syntheticPlane_t& plane) {
+
+    float n = std::sqrt(plane.normal[0]*plane.normal[0]
+        + plane.normal[1]*plane.normal[1] + plane.normal[2]*plane.normal[2]);
+
+    if(n < 1e-6f) {
+        std::cerr << "ERROR: SyntheticSequence::addPlane(): plane normal should be non zero" << std::endl;
+        throw std::invalid_argument("SyntheticSequence::addPlane(): plane normal should be non zero");
+    }
+
+    syntheticPlane_t p = plane;
+    for(int i = 0; i < 3; i ++) {
+        p.normal[i] /= n;
+    }
+
+    // texture basis orthogonal to the normal, e1 = normalize(a x normal)
+    // with a the canonical axis least aligned with the normal
+    float a[3] = {0, 0, 0};
+    int k = 0;
+    for(int i = 1; i < 3; i ++) {
+        if(std::fabs(p.normal[i]) < std::fabs(p.normal[k])) k = i;
+    }
+    a[k] = 1.0f;
+
+    float e1[3] = {a[1]*p.normal[2] - a[2]*p.normal[1],
+                   a[2]*p.normal[0] - a[0]*p.normal[2],
+                   a[0]*p.normal[1] - a[1]*p.normal[0]};
+    float n1 = std::sqrt(e1[0]*e1[0] + e1[1]*e1[1] + e1[2]*e1[2]);
+    for(int i = 0; i < 3; i ++) e1[i] /= n1;
+
+    float e2[3] = {p.normal[1]*e1[2] - p.normal[2]*e1[1],
+                   p.normal[2]*e1[0] - p.normal[0]*e1[2],
+                   p.normal[0]*e1[1] - p.normal[1]*e1[0]};
+
+    __planes.push_back(p);
+    __planeBasis.insert(__planeBasis.end(), e1, e1 + 3);
+    __planeBasis.insert(__planeBasis.end(), e2, e2 + 3);
+
+    // noise lattice of the plane
+    std::vector<float> lattice(NOISE_LATTICE_SIZE*NOISE_LATTICE_SIZE);
+    for(int y = 0; y < NOISE_LATTICE_SIZE; y ++) {
+        for(int x = 0; x < NOISE_LATTICE_SIZE; x ++) {
+            lattice[y*NOISE_LATTICE_SIZE + x] = latticeHash(x, y, p.seed);
+        }
+    }
+    __noiseLattice.push_back(lattice);
+    __noiseTexture.push_back(std::vector<float>());
+
+    bakeNoise(int(__planes.size()) - 1);
+}
+
+
+void SyntheticSequence::clearPlanes() {
+    __planes.clear();
+    __planeBasis.clear();
+    __noiseLattice.clear();
+    __noiseTexture.clear();
+}
+
+
+void SyntheticSequence::setMotion(const cameraMotion_t& motion) {
+    __motion = motion;
+    reset();
+}
+
+
+cameraMotion_t SyntheticSequence::getMotion() const {
+    return __motion;
+}
+
+
+void SyntheticSequence::setNoiseOctaves(const int octaves) {
+
+    if(octaves <= 0) {
+        std::cerr << "ERROR: SyntheticSequence::setNoiseOctaves(): octaves should be greater than zero: " << octaves << std::endl;
+        throw std::invalid_argument("SyntheticSequence::setNoiseOctaves(): octaves should be greater than zero, got: " + std::to_string(octaves));
+    }
+
+    if(octaves != __noiseOctaves) {
+        __noiseOctaves = octaves;
+
+        for(int k = 0; k < int(__planes.size()); k ++) {
+            bakeNoise(k);
+        }
+    }
+}
+
+
+int SyntheticSequence::getNoiseOctaves() const {
+    return __noiseOctaves;
+}
+
+
+void SyntheticSequence::reset() {
+
+    __frameNumber = 0;
+
+    const float I[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    std::memcpy(__pose.R, I, sizeof(I));
+    std::memset(__pose.C, 0, sizeof(__pose.C));
+
+    // pose at frame -1, such that advancing it gives the pose at frame 0
+    float w[3] = {-__motion.angularVelocity[0], -__motion.angularVelocity[1], -__motion.angularVelocity[2]};
+    expSO3(w, __previousPose.R);
+
+    float RV[3];
+    matVec(__previousPose.R, __motion.linearVelocity, RV);
+    for(int i = 0; i < 3; i ++) {
+        __previousPose.C[i] = __pose.C[i] - RV[i];
+    }
+}
+
+
+void SyntheticSequence::nextFrame(flowfilter::image_t& image) {
+    render(image, nullptr);
+}
+
+
+void SyntheticSequence::nextFrame(flowfilter::image_t& image, flowfilter::image_t& flow) {
+
+    if(flow.height != __height || flow.width != __width
+        || flow.depth != 2 || flow.itemSize != sizeof(float)) {
+        std::cerr << "ERROR: SyntheticSequence::nextFrame(): flow should be a float image of shape ["
+            << __height << ", " << __width << ", 2]" << std::endl;
+        throw std::invalid_argument("SyntheticSequence::nextFrame(): flow shape does not match the sequence");
+    }
+
+    render(image, &flow);
+}
+
+
+int SyntheticSequence::frameNumber() const {
+    return __frameNumber;
+}
+
+
+int SyntheticSequence::height() const {
+    return __height;
+}
+
+
+int SyntheticSequence::width() const {
+    return __width;
+}
+
+
+int SyntheticSequence::threads() const {
+    return __threadCount;
+}
+
+
+void SyntheticSequence::render(flowfilter::image_t& image, flowfilter::image_t* flow) {
+
+    if(image.height != __height || image.width != __width || image.depth != 1
+        || (image.itemSize != sizeof(unsigned char) && image.itemSize != sizeof(float))) {
+        std::cerr << "ERROR: SyntheticSequence::nextFrame(): image should be a uint8 or float image of shape ["
+            << __height << ", " << __width << "]" << std::endl;
+        throw std::invalid_argument("SyntheticSequence::nextFrame(): image shape does not match the sequence");
+    }
+
+    if(__planes.empty()) {
+        syntheticPlane_t plane = {{0.0f, 0.0f, 1.0f}, 10.0f, SYNTHETIC_TEXTURE_NOISE, 1.0f, 0};
+        addPlane(plane);
+    }
+
+    runParallel([&](const int rowStart, const int rowEnd) {
+        renderRows(rowStart, rowEnd, image, flow);
+    });
+
+    // advance the camera
+    __previousPose = __pose;
+
+    float RV[3];
+    matVec(__pose.R, __motion.linearVelocity, RV);
+    for(int i = 0; i < 3; i ++) {
+        __pose.C[i] += RV[i];
+    }
+
+    float dR[9], R[9];
+    expSO3(__motion.angularVelocity, dR);
+    matMul(__pose.R, dR, R);
+    std::memcpy(__pose.R, R, sizeof(R));
+
+    __frameNumber ++;
+}
+
+
+void SyntheticSequence::renderRows(const int rowStart, const int rowEnd,
+    flowfilter::image_t& image, flowfilter::image_t* flow) {
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const bool isUchar8 = image.itemSize == sizeof(unsigned char);
+    const int P = int(__planes.size());
+
+    const cameraPose_t& pose = __pose;
+    const cameraPose_t& prev = __previousPose;
+
+    // Along a row, the viewing ray is dir = dir0 + c*step. Ray-plane
+    // denominators and texture coordinates of the ray direction are
+    // then affine in the column and are stepped instead of recomputed.
+    float step[3];
+    const float unitX[3] = {1.0f / __camera.alphaX, 0.0f, 0.0f};
+    matVec(pose.R, unitX, step);
+
+    // plane offsets relative to the current camera center, ray-plane
+    // denominator steps, and texture coordinates of the camera center
+    // and of the ray step
+    std::vector<float> offset(P), denomStep(P);
+    std::vector<float> uCenter(P), vCenter(P), uStep(P), vStep(P);
+    for(int k = 0; k < P; k ++) {
+        const float* n = __planes[k].normal;
+        const float* e1 = &__planeBasis[6*k];
+        const float* e2 = e1 + 3;
+        const float scale = __planes[k].textureScale;
+
+        offset[k] = __planes[k].distance - dot3(n, pose.C);
+        denomStep[k] = dot3(n, step);
+        uCenter[k] = scale*dot3(e1, pose.C);
+        vCenter[k] = scale*dot3(e2, pose.C);
+        uStep[k] = scale*dot3(e1, step);
+        vStep[k] = scale*dot3(e2, step);
+    }
+
+    // scene points in the previous camera frame are
+    // Xp = prevC + lambda*(prevDir0 + c*prevStep)
+    float prevC[3], prevStep[3];
+    const float dC[3] = {pose.C[0] - prev.C[0], pose.C[1] - prev.C[1], pose.C[2] - prev.C[2]};
+    matTransposeVec(prev.R, dC, prevC);
+    matTransposeVec(prev.R, step, prevStep);
+
+    std::vector<float> denom0(P), u0(P), v0(P);
+
+    // locals, as stores to the uint8 image may alias any member
+    const int width = __width;
+    const float alphaX = __camera.alphaX;
+    const float alphaY = __camera.alphaY;
+    const float centerX = __camera.centerX;
+    const float centerY = __camera.centerY;
+
+    for(int r = rowStart; r < rowEnd; r ++) {
+
+        unsigned char* imgRow = static_cast<unsigned char*>(image.data) + r*image.pitch;
+        float* flowRow = flow == nullptr? nullptr :
+            reinterpret_cast<float*>(static_cast<unsigned char*>(flow->data) + r*flow->pitch);
+
+        // viewing ray of column 0 in camera and world frames
+        const float ray[3] = {-centerX / alphaX, (r - centerY) / alphaY, 1.0f};
+        float dir0[3];
+        matVec(pose.R, ray, dir0);
+
+        for(int k = 0; k < P; k ++) {
+            const float* e1 = &__planeBasis[6*k];
+            const float* e2 = e1 + 3;
+            denom0[k] = dot3(__planes[k].normal, dir0);
+            u0[k] = __planes[k].textureScale*dot3(e1, dir0);
+            v0[k] = __planes[k].textureScale*dot3(e2, dir0);
+        }
+
+        float prevDir0[3];
+        matTransposeVec(prev.R, dir0, prevDir0);
+
+        for(int c = 0; c < width; c ++) {
+
+            // closest plane in front of the camera
+            float lambda = std::numeric_limits<float>::infinity();
+            int plane = -1;
+            for(int k = 0; k < P; k ++) {
+                const float denom = denom0[k] + c*denomStep[k];
+                if(std::fabs(denom) < 1e-9f) continue;
+
+                const float l = offset[k] / denom;
+                if(l > 0.0f && l < lambda) {
+                    lambda = l;
+                    plane = k;
+                }
+            }
+
+            float value = 0.0f;
+            float fx = nan, fy = nan;
+
+            if(plane >= 0) {
+
+                const float u = uCenter[plane] + lambda*(u0[plane] + c*uStep[plane]);
+                const float v = vCenter[plane] + lambda*(v0[plane] + c*vStep[plane]);
+                value = texture(plane, u, v);
+
+                if(flowRow != nullptr) {
+
+                    // scene point in the previous camera frame
+                    const float Xp[3] = {prevC[0] + lambda*(prevDir0[0] + c*prevStep[0]),
+                                         prevC[1] + lambda*(prevDir0[1] + c*prevStep[1]),
+                                         prevC[2] + lambda*(prevDir0[2] + c*prevStep[2])};
+
+                    if(Xp[2] > 0.0f) {
+                        const float invZ = 1.0f / Xp[2];
+                        fx = c - (alphaX*Xp[0]*invZ + centerX);
+                        fy = r - (alphaY*Xp[1]*invZ + centerY);
+                    }
+                }
+            }
+
+            if(isUchar8) {
+                imgRow[c] = (unsigned char)(255.0f*value + 0.5f);
+            } else {
+                reinterpret_cast<float*>(imgRow)[c] = 255.0f*value;
+            }
+
+            if(flowRow != nullptr) {
+                flowRow[2*c] = fx;
+                flowRow[2*c + 1] = fy;
+            }
+        }
+    }
+}
+
+
+float SyntheticSequence::texture(const int planeIndex, float u, float v) const {
+
+    const syntheticPlane_t& plane = __planes[planeIndex];
+
+    if(plane.texture == SYNTHETIC_TEXTURE_CHECKERBOARD) {
+        int parity = (fastFloor(u) + fastFloor(v)) & 1;
+        return parity? 0.8f : 0.2f;
+    }
+
+    // bilinear interpolation of the baked fractal noise
+    const int mask = NOISE_TEXTURE_SIZE - 1;
+    const float* tex = __noiseTexture[planeIndex].data();
+
+    u *= NOISE_TEXELS_PER_UNIT;
+    v *= NOISE_TEXELS_PER_UNIT;
+
+    const int x0 = fastFloor(u), y0 = fastFloor(v);
+    const float tu = u - x0, tv = v - y0;
+
+    const float* row0 = tex + (y0 & mask)*NOISE_TEXTURE_SIZE;
+    const float* row1 = tex + ((y0 + 1) & mask)*NOISE_TEXTURE_SIZE;
+
+    const float v00 = row0[x0 & mask];
+    const float v01 = row0[(x0 + 1) & mask];
+    const float v10 = row1[x0 & mask];
+    const float v11 = row1[(x0 + 1) & mask];
+
+    const float top = v00 + tu*(v01 - v00);
+    const float bottom = v10 + tu*(v11 - v10);
+    return top + tv*(bottom - top);
+}
+
+
+void SyntheticSequence::bakeNoise(const int planeIndex) {
+
+    // fractal value noise normalized to [0, 1], octaves
+    // sample the lattice at shifted coordinates. Each octave
+    // is periodic over the lattice, and so is their sum.
+    const float* lattice = __noiseLattice[planeIndex].data();
+    std::vector<float>& tex = __noiseTexture[planeIndex];
+    tex.resize(NOISE_TEXTURE_SIZE*NOISE_TEXTURE_SIZE);
+
+    for(int y = 0; y < NOISE_TEXTURE_SIZE; y ++) {
+        for(int x = 0; x < NOISE_TEXTURE_SIZE; x ++) {
+
+            float u = float(x) / NOISE_TEXELS_PER_UNIT;
+            float v = float(y) / NOISE_TEXELS_PER_UNIT;
+
+            float value = 0.0f;
+            float amplitude = 1.0f;
+            float norm = 0.0f;
+            for(int o = 0; o < __noiseOctaves; o ++) {
+                value += amplitude*valueNoise(lattice, u + 37.0f*o, v + 91.0f*o);
+                norm += amplitude;
+                amplitude *= 0.5f;
+                u *= 2.0f;
+                v *= 2.0f;
+            }
+
+            tex[y*NOISE_TEXTURE_SIZE + x] = value / norm;
+        }
+    }
+}
+
+
+//#################################################
+// Worker pool
+//#################################################
+
+void SyntheticSequence::runParallel(const std::function<void(int, int)>& task) {
+
+    const int N = threads();
+    const int band = (__height + N - 1) / N;
+
+    if(N > 1) {
+        std::lock_guard<std::mutex> lock(__mutex);
+        __task = task;
+        __pending = N - 1;
+        __generation ++;
+    }
+    __startCondition.notify_all();
+
+    // first band in the calling thread
+    task(0, std::min(band, __height));
+
+    if(N > 1) {
+        std::unique_lock<std::mutex> lock(__mutex);
+        __doneCondition.wait(lock, [this]() { return __pending == 0; });
+    }
+}
+
+
+void SyntheticSequence::workerLoop(const int index) {
+
+    unsigned long generation = 0;
+
+    while(true) {
+
+        std::function<void(int, int)> task;
+        {
+            std::unique_lock<std::mutex> lock(__mutex);
+            __startCondition.wait(lock, [&]() { return __stop || __generation != generation; });
+
+            if(__stop) {
+                return;
+            }
+
+            generation = __generation;
+            task = __task;
+        }
+
+        const int N = threads();
+        const int band = (__height + N - 1) / N;
+        const int rowStart = std::min(index*band, __height);
+        const int rowEnd = std::min(rowStart + band, __height);
+
+        if(rowStart < rowEnd) {
+            task(rowStart, rowEnd);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(__mutex);
+            __pending --;
+        }
+        __doneCondition.notify_one();
+    }
+}
+
+}; // namespace flowfilter
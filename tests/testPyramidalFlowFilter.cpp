@@ -0,0 +1,113 @@
+/**
+ * \file testPyramidalFlowFilter.cpp
+ * \brief Regression tests of PyramidalFlowFilter outputs.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <cmath>
+#include <iostream>
+
+#include "flowfilter/image.h"
+#include "flowfilter/gpu/flowfilter.h"
+
+using namespace flowfilter;
+using namespace flowfilter::gpu;
+
+
+/** returns the largest absolute difference between two float images */
+float maxDifference(const image_t& a, const image_t& b) {
+
+    float diff = 0.0f;
+    for(int r = 0; r < a.height; r ++) {
+
+        const float* rowA = reinterpret_cast<const float*>(
+            static_cast<const unsigned char*>(a.data) + r*a.pitch);
+        const float* rowB = reinterpret_cast<const float*>(
+            static_cast<const unsigned char*>(b.data) + r*b.pitch);
+
+        for(int c = 0; c < a.width*a.depth; c ++) {
+            diff = std::fmax(diff, std::fabs(rowA[c] - rowB[c]));
+        }
+    }
+
+    return diff;
+}
+
+
+/** fills a uint8 image with a sinusoidal pattern shifted by shift pixels */
+void renderPattern(image_t& image, const float shift) {
+
+    for(int r = 0; r < image.height; r ++) {
+
+        unsigned char* row = static_cast<unsigned char*>(image.data) + r*image.pitch;
+        for(int c = 0; c < image.width; c ++) {
+
+            const float x = c - shift;
+            const float value = 0.5f + 0.25f*std::sin(0.4f*x) + 0.25f*std::cos(0.3f*r + 0.2f*x);
+            row[c] = static_cast<unsigned char>(255.0f*value);
+        }
+    }
+}
+
+
+/**
+ * With a single level, downloadFlow() returns the smoothed flow of
+ * the top level filter, not its updated flow.
+ */
+int testSingleLevelDownloadFlow() {
+
+    const int height = 64;
+    const int width = 64;
+
+    PyramidalFlowFilter filter(height, width, 1);
+    filter.setSmoothIterations(0, 4);
+
+    image_t image = createImage(height, width, 1, sizeof(unsigned char));
+    for(int n = 0; n < 5; n ++) {
+        renderPattern(image, float(n));
+        filter.loadImage(image);
+        filter.compute();
+    }
+
+    image_t flow = createImage(height, width, 2, sizeof(float));
+    image_t smoothed = createImage(height, width, 2, sizeof(float));
+    image_t updated = createImage(height, width, 2, sizeof(float));
+
+    filter.downloadFlow(flow);
+    filter.downloadTap(TAP_FLOW, 0, smoothed);
+    filter.downloadTap(TAP_UPDATED_FLOW, 0, updated);
+
+    int failures = 0;
+
+    if(maxDifference(flow, smoothed) != 0.0f) {
+        std::cerr << "FAIL: testSingleLevelDownloadFlow(): output flow differs from the smoothed flow" << std::endl;
+        failures ++;
+    }
+
+    // makes sure the check above tells both buffers apart
+    if(maxDifference(updated, smoothed) == 0.0f) {
+        std::cerr << "FAIL: testSingleLevelDownloadFlow(): smoothing did not change the updated flow" << std::endl;
+        failures ++;
+    }
+
+    destroyImage(image);
+    destroyImage(flow);
+    destroyImage(smoothed);
+    destroyImage(updated);
+
+    return failures;
+}
+
+
+int main(int argc, char** argv) {
+
+    int failures = 0;
+    failures += testSingleLevelDownloadFlow();
+
+    if(failures == 0) {
+        std::cout << "testPyramidalFlowFilter: all tests passed" << std::endl;
+    }
+
+    return failures == 0? 0 : 1;
+}
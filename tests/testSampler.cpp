@@ -0,0 +1,134 @@
+/**
+ * \file testSampler.cpp
+ * \brief Regression tests of TextureSampler addressing.
+ * \copyright 2015, Juan David Adarve, ANU. See AUTHORS for more details
+ * \license 3-clause BSD, see LICENSE for more details
+ */
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "flowfilter/image.h"
+#include "flowfilter/sampler.h"
+
+using namespace flowfilter;
+
+
+/** 4x4 float image with pixel (x, y) equal to 10 + 4*y + x */
+image_t createRamp() {
+
+    image_t image = createImage(4, 4, 1, sizeof(float));
+
+    for(int r = 0; r < image.height; r ++) {
+
+        float* row = reinterpret_cast<float*>(static_cast<unsigned char*>(image.data) + r*image.pitch);
+        for(int c = 0; c < image.width; c ++) {
+            row[c] = 10.0f + 4*r + c;
+        }
+    }
+
+    return image;
+}
+
+
+/** returns 1 if the sample at (x, y) differs from expected */
+int checkFetch(const std::string& name, const TextureSampler& sampler,
+    const float x, const float y, const float expected) {
+
+    float value = 0.0f;
+    sampler.fetch(x, y, &value);
+
+    if(!(std::fabs(value - expected) <= 1e-5f)) {
+        std::cerr << "FAIL: " << name << ": fetch(" << x << ", " << y << ") = "
+            << value << ", expected " << expected << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * With border addressing and linear filtering, coordinates whose
+ * taps are all outside the image read zero.
+ */
+int testBorderLinear() {
+
+    image_t image = createRamp();
+    TextureSampler sampler(image, SAMPLER_ADDRESS_BORDER, SAMPLER_FILTER_LINEAR);
+
+    const std::string name = "testBorderLinear()";
+    int failures = 0;
+
+    // inside, at a pixel center and between two rows
+    failures += checkFetch(name, sampler, 1.5f, 1.5f, 15.0f);
+    failures += checkFetch(name, sampler, 1.5f, 2.0f, 17.0f);
+
+    // one tap inside, weight 0.5
+    failures += checkFetch(name, sampler, 0.0f, 1.5f, 7.0f);
+    failures += checkFetch(name, sampler, 4.0f, 1.5f, 8.5f);
+
+    // all taps outside
+    failures += checkFetch(name, sampler, -0.5f, 1.5f, 0.0f);
+    failures += checkFetch(name, sampler, -1.0f, 1.5f, 0.0f);
+    failures += checkFetch(name, sampler, -5.3f, 1.5f, 0.0f);
+    failures += checkFetch(name, sampler, 4.5f, 1.5f, 0.0f);
+    failures += checkFetch(name, sampler, 9.7f, 1.5f, 0.0f);
+    failures += checkFetch(name, sampler, 1.5f, -7.3f, 0.0f);
+    failures += checkFetch(name, sampler, 1.5f, 12.0f, 0.0f);
+
+    destroyImage(image);
+    return failures;
+}
+
+
+/**
+ * NaN coordinates are outside the image, before its first pixel,
+ * and infinite coordinates are outside on their side.
+ */
+int testNonFiniteCoordinates() {
+
+    image_t image = createRamp();
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+    const std::string name = "testNonFiniteCoordinates()";
+    int failures = 0;
+
+    TextureSampler borderPoint(image, SAMPLER_ADDRESS_BORDER, SAMPLER_FILTER_POINT);
+    failures += checkFetch(name, borderPoint, nan, 1.5f, 0.0f);
+    failures += checkFetch(name, borderPoint, 1.5f, nan, 0.0f);
+    failures += checkFetch(name, borderPoint, inf, 1.5f, 0.0f);
+
+    TextureSampler borderLinear(image, SAMPLER_ADDRESS_BORDER, SAMPLER_FILTER_LINEAR);
+    failures += checkFetch(name, borderLinear, nan, 1.5f, 0.0f);
+    failures += checkFetch(name, borderLinear, 1.5f, -inf, 0.0f);
+
+    TextureSampler clampPoint(image, SAMPLER_ADDRESS_CLAMP, SAMPLER_FILTER_POINT);
+    failures += checkFetch(name, clampPoint, nan, 1.5f, 14.0f);
+    failures += checkFetch(name, clampPoint, inf, 1.5f, 17.0f);
+
+    TextureSampler clampLinear(image, SAMPLER_ADDRESS_CLAMP, SAMPLER_FILTER_LINEAR);
+    failures += checkFetch(name, clampLinear, nan, 1.5f, 14.0f);
+    failures += checkFetch(name, clampLinear, -inf, 1.5f, 14.0f);
+    failures += checkFetch(name, clampLinear, 1.5f, inf, 23.0f);
+
+    destroyImage(image);
+    return failures;
+}
+
+
+int main(int argc, char** argv) {
+
+    int failures = 0;
+    failures += testBorderLinear();
+    failures += testNonFiniteCoordinates();
+
+    if(failures == 0) {
+        std::cout << "testSampler: all tests passed" << std::endl;
+    }
+
+    return failures == 0? 0 : 1;
+}